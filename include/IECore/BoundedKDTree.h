@@ -75,6 +75,15 @@ class BoundedKDTree
 		/// making queries.
 		void init( BoundIterator first, BoundIterator last, int maxLeafSize=4 );
 
+		/// Recomputes the node bounds from the current values of the bounds passed to init(),
+		/// without changing the structure of the tree. This is much cheaper than calling init()
+		/// again, and is intended for deforming geometry where the bounds move but their number
+		/// does not. Queries remain correct, but become less efficient as the bounds move
+		/// further from where they were at init() time.
+		/// \threading This can't be called while other threads are
+		/// making queries.
+		void refit();
+
 		/// Populates the passed vector of iterators with the bounds which intersect "b". Returns the number of bounds found.
 		/// \threading May be called by multiple concurrent threads provided they each use a different vector for the result.
 		/// \todo There should be a form where nearNeighbours is an output iterator, to allow any container to be filled.
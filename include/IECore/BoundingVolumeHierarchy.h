@@ -0,0 +1,214 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef IE_CORE_BOUNDINGVOLUMEHIERARCHY_H
+#define IE_CORE_BOUNDINGVOLUMEHIERARCHY_H
+
+#include <iterator>
+#include <vector>
+
+#include "boost/cstdint.hpp"
+
+#include "tbb/atomic.h"
+
+#include "OpenEXR/ImathBox.h"
+
+#include "IECore/BoxTraits.h"
+#include "IECore/VectorTraits.h"
+
+namespace IECore
+{
+
+/// Builds a bounding volume hierarchy over a set of bounds, to permit fast
+/// intersection, ray and closest point queries. It is an alternative to the
+/// BoundedKDTree - rather than splitting at the median it chooses splits using
+/// the surface area heuristic, which gives considerably tighter bounds and
+/// faster queries for typical geometry, especially where it varies in density.
+/// Construction is performed in parallel using TBB, and nodes are stored
+/// compactly (32 bytes for a Box3f) with sibling nodes adjacent in memory.
+/// Queries are performed iteratively using a small fixed size stack rather
+/// than by recursion.
+/// \ingroup mathGroup
+template<class BoundIterator>
+class BoundingVolumeHierarchy
+{
+	public:
+
+		typedef BoundIterator Iterator;
+		typedef typename std::iterator_traits<BoundIterator>::value_type Bound;
+		typedef typename BoxTraits<Bound>::BaseType BaseType;
+		typedef typename VectorTraits<BaseType>::BaseType Real;
+		class Node;
+		typedef std::vector<Node> NodeVector;
+		typedef typename NodeVector::size_type NodeIndex;
+
+		/// Constructs an uninitialised hierarchy - you must call init() before
+		/// using it.
+		BoundingVolumeHierarchy();
+
+		/// Creates a hierarchy for the fast searching of bounds.
+		/// Note that the hierarchy does not own the passed bounds -
+		/// it is up to you to ensure that they remain valid and
+		/// unchanged as long as the BoundingVolumeHierarchy is in use.
+		BoundingVolumeHierarchy( BoundIterator first, BoundIterator last, int maxLeafSize=4 );
+
+		/// Builds the hierarchy for the specified bounds - the iterator range
+		/// must remain valid and unchanged as long as the hierarchy is in use.
+		/// This method can be called again to rebuild the hierarchy at any time.
+		/// \threading This can't be called while other threads are
+		/// making queries.
+		void init( BoundIterator first, BoundIterator last, int maxLeafSize=4 );
+
+		/// Recomputes the bounds of all nodes from the current values of the bounds
+		/// passed to init(), without changing the structure of the hierarchy. This is much
+		/// cheaper than calling init() again, and is intended for deforming geometry where
+		/// the bounds move but their number does not. Queries remain correct, but become
+		/// less efficient as the bounds move further from where they were at init() time.
+		/// \threading This can't be called while other threads are
+		/// making queries.
+		void refit();
+
+		//! @name Queries
+		/// \threading All queries may be called by multiple concurrent threads.
+		//////////////////////////////////////////////////////////////////////////
+		//@{
+		/// Populates the passed vector of iterators with the bounds which intersect "b". Returns the number of bounds found.
+		template<typename S>
+		unsigned int intersectingBounds( const S &b, std::vector<BoundIterator> &bounds ) const;
+
+		/// Visits the leaves of the hierarchy whose bounds are within sqrt( maxDistanceSquared )
+		/// of the point p, closest first, calling leafFn( first, last, maxDistanceSquared ) for
+		/// each, where [first, last) is the range of bounds in the leaf. The functor should
+		/// reduce maxDistanceSquared as it finds closer primitives, so that the remaining
+		/// leaves may be culled.
+		template<typename LeafFn>
+		void closestLeaves( const BaseType &p, Real &maxDistanceSquared, LeafFn &leafFn ) const;
+
+		/// Visits the leaves of the hierarchy whose bounds are hit by the ray within maxDistance
+		/// of its origin, nearest first, calling leafFn( first, last, maxDistance ) for each.
+		/// The direction need not be normalised, in which case distances are measured in multiples
+		/// of its length. The functor may reduce maxDistance as it finds hits, so that the remaining
+		/// leaves may be culled.
+		template<typename LeafFn>
+		void rayLeaves( const BaseType &origin, const BaseType &direction, Real &maxDistance, LeafFn &leafFn ) const;
+		//@}
+
+		//! @name Low level access
+		/// Provided so clients may implement their own traversals.
+		//////////////////////////////////////////////////////////////////////////
+		//@{
+		/// Returns the number of nodes in the hierarchy.
+		inline NodeIndex numNodes() const;
+
+		/// Retrieve the node associated with a given index
+		inline const Node &node( NodeIndex idx ) const;
+
+		/// Returns the index for the root node
+		inline NodeIndex rootIndex() const;
+
+		/// Retrieve the index of the "low" child node of a branch
+		inline NodeIndex lowChildIndex( NodeIndex index ) const;
+
+		/// Retrieve the index of the "high" child node of a branch
+		inline NodeIndex highChildIndex( NodeIndex index ) const;
+
+		/// Returns the range of bounds held in a leaf node.
+		inline const BoundIterator *permFirst( const Node &node ) const;
+		inline const BoundIterator *permLast( const Node &node ) const;
+		//@}
+
+	private:
+
+		typedef std::vector<BoundIterator> Permutation;
+		typedef typename Permutation::iterator PermutationIterator;
+
+		class BuildTask;
+
+		void build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast, unsigned depth, tbb::atomic<NodeIndex> &numNodes );
+		PermutationIterator split( PermutationIterator permFirst, PermutationIterator permLast, const Bound &centroidBound ) const;
+		static Real halfArea( const Bound &b );
+		static bool rayIntersects( const Bound &b, const BaseType &origin, const BaseType &inverseDirection, Real maxDistance, Real &distance );
+
+		Permutation m_perm;
+		NodeVector m_nodes;
+		int m_maxLeafSize;
+
+		/// Queries use a fixed size stack, so we limit the depth accordingly.
+		static const unsigned maxDepth = 62;
+		/// Subtrees with more bounds than this are built in parallel.
+		static const size_t parallelThreshold = 4096;
+		/// The number of bins used in evaluating the surface area heuristic.
+		static const unsigned numBins = 16;
+};
+
+template<class BoundIterator>
+class BoundingVolumeHierarchy<BoundIterator>::Node
+{
+	public :
+
+		/// Must be default constructible for use as element within std::vector
+		Node();
+
+		inline bool isLeaf() const;
+
+		inline bool isBranch() const;
+
+		inline const Bound &bound() const;
+
+	private :
+
+		friend class BoundingVolumeHierarchy<BoundIterator>;
+
+		static const boost::uint32_t branchCount = 0xffffffff;
+
+		Bound m_bound;
+		/// For leaves, the offset of the first bound in the permutation.
+		/// For branches, the index of the low child - the high child
+		/// immediately follows it.
+		boost::uint32_t m_offset;
+		/// The number of bounds in a leaf, or branchCount for branches.
+		boost::uint32_t m_count;
+};
+
+typedef BoundingVolumeHierarchy<std::vector<Imath::Box2f>::const_iterator> Box2fBVH;
+typedef BoundingVolumeHierarchy<std::vector<Imath::Box2d>::const_iterator> Box2dBVH;
+typedef BoundingVolumeHierarchy<std::vector<Imath::Box3f>::const_iterator> Box3fBVH;
+typedef BoundingVolumeHierarchy<std::vector<Imath::Box3d>::const_iterator> Box3dBVH;
+
+}
+
+#include "BoundingVolumeHierarchy.inl"
+
+#endif // IE_CORE_BOUNDINGVOLUMEHIERARCHY_H
@@ -0,0 +1,713 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "tbb/task_group.h"
+
+#include "OpenEXR/ImathLimits.h"
+
+#include "IECore/VectorTraits.h"
+#include "IECore/BoxOps.h"
+
+namespace IECore
+{
+
+//////////////////////////////////////////////////////////////////////////
+// Node
+//////////////////////////////////////////////////////////////////////////
+
+template<class BoundIterator>
+BoundingVolumeHierarchy<BoundIterator>::Node::Node() : m_offset( 0 ), m_count( 0 )
+{
+	BoxTraits<Bound>::makeEmpty( m_bound );
+}
+
+template<class BoundIterator>
+bool BoundingVolumeHierarchy<BoundIterator>::Node::isLeaf() const
+{
+	return m_count != branchCount;
+}
+
+template<class BoundIterator>
+bool BoundingVolumeHierarchy<BoundIterator>::Node::isBranch() const
+{
+	return m_count == branchCount;
+}
+
+template<class BoundIterator>
+const typename BoundingVolumeHierarchy<BoundIterator>::Bound &BoundingVolumeHierarchy<BoundIterator>::Node::bound() const
+{
+	return m_bound;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Implementation details
+//////////////////////////////////////////////////////////////////////////
+
+namespace Detail
+{
+
+/// Maps centroids onto the bins used when evaluating the surface area heuristic.
+/// The same instance is used to fill the bins and to partition the bounds once
+/// a split has been chosen, so the two always agree.
+template<typename BoundIterator, typename Vec>
+class BVHBinner
+{
+	public :
+
+		typedef typename VectorTraits<Vec>::BaseType Real;
+
+		BVHBinner( unsigned axis, Real min, Real max, unsigned numBins, unsigned split = 0 )
+			:	m_axis( axis ), m_min( min ), m_scale( Real( numBins ) / ( max - min ) ), m_maxBin( numBins - 1 ), m_split( split )
+		{
+		}
+
+		unsigned bin( const Vec &centroid ) const
+		{
+			const Real f = ( VectorTraits<Vec>::get( centroid, m_axis ) - m_min ) * m_scale;
+			return f <= Real( 0 ) ? 0 : std::min( (unsigned)f, m_maxBin );
+		}
+
+		/// Predicate for std::partition.
+		bool operator() ( BoundIterator it ) const
+		{
+			return bin( boxCenter( *it ) ) <= m_split;
+		}
+
+	private :
+
+		unsigned m_axis;
+		Real m_min;
+		Real m_scale;
+		unsigned m_maxBin;
+		unsigned m_split;
+
+};
+
+template<typename BoundIterator, typename Vec>
+class BVHAxisLess
+{
+	public :
+
+		BVHAxisLess( unsigned axis ) : m_axis( axis )
+		{
+		}
+
+		bool operator() ( BoundIterator i, BoundIterator j ) const
+		{
+			return VectorTraits<Vec>::get( boxCenter( *i ), m_axis ) < VectorTraits<Vec>::get( boxCenter( *j ), m_axis );
+		}
+
+	private :
+
+		unsigned m_axis;
+
+};
+
+template<typename Bound>
+typename VectorTraits<typename BoxTraits<Bound>::BaseType>::BaseType bvhDistanceSquared( const Bound &b, const typename BoxTraits<Bound>::BaseType &p )
+{
+	typedef typename BoxTraits<Bound>::BaseType Vec;
+	typedef typename VectorTraits<Vec>::BaseType Real;
+
+	const Vec &min = BoxTraits<Bound>::min( b );
+	const Vec &max = BoxTraits<Bound>::max( b );
+	Real result = 0;
+	for( unsigned i = 0; i < VectorTraits<Vec>::dimensions(); ++i )
+	{
+		const Real v = VectorTraits<Vec>::get( p, i );
+		const Real lo = VectorTraits<Vec>::get( min, i );
+		const Real hi = VectorTraits<Vec>::get( max, i );
+		if( v < lo )
+		{
+			result += ( lo - v ) * ( lo - v );
+		}
+		else if( v > hi )
+		{
+			result += ( v - hi ) * ( v - hi );
+		}
+	}
+	return result;
+}
+
+} // namespace Detail
+
+template<class BoundIterator>
+class BoundingVolumeHierarchy<BoundIterator>::BuildTask
+{
+	public :
+
+		BuildTask( BoundingVolumeHierarchy *bvh, NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast, unsigned depth, tbb::atomic<NodeIndex> &numNodes )
+			:	m_bvh( bvh ), m_nodeIndex( nodeIndex ), m_permFirst( permFirst ), m_permLast( permLast ), m_depth( depth ), m_numNodes( numNodes )
+		{
+		}
+
+		void operator()() const
+		{
+			m_bvh->build( m_nodeIndex, m_permFirst, m_permLast, m_depth, m_numNodes );
+		}
+
+	private :
+
+		BoundingVolumeHierarchy *m_bvh;
+		NodeIndex m_nodeIndex;
+		PermutationIterator m_permFirst;
+		PermutationIterator m_permLast;
+		unsigned m_depth;
+		tbb::atomic<NodeIndex> &m_numNodes;
+
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Construction
+//////////////////////////////////////////////////////////////////////////
+
+template<class BoundIterator>
+BoundingVolumeHierarchy<BoundIterator>::BoundingVolumeHierarchy()
+	:	m_maxLeafSize( 4 )
+{
+}
+
+template<class BoundIterator>
+BoundingVolumeHierarchy<BoundIterator>::BoundingVolumeHierarchy( BoundIterator first, BoundIterator last, int maxLeafSize )
+{
+	init( first, last, maxLeafSize );
+}
+
+template<class BoundIterator>
+void BoundingVolumeHierarchy<BoundIterator>::init( BoundIterator first, BoundIterator last, int maxLeafSize )
+{
+	m_maxLeafSize = std::max( maxLeafSize, 1 );
+
+	m_perm.clear();
+	m_perm.reserve( last - first );
+	for( BoundIterator it = first; it != last; ++it )
+	{
+		m_perm.push_back( it );
+	}
+
+	m_nodes.clear();
+	if( m_perm.empty() )
+	{
+		return;
+	}
+
+	// Every leaf holds at least one bound, so a binary tree can never
+	// need more than 2n-1 nodes. Allocating them all up front means
+	// that parallel builds never need to grow the vector.
+	m_nodes.resize( 2 * m_perm.size() - 1 );
+
+	tbb::atomic<NodeIndex> numNodes;
+	numNodes = 1;
+	build( rootIndex(), m_perm.begin(), m_perm.end(), 0, numNodes );
+
+	NodeVector( m_nodes.begin(), m_nodes.begin() + numNodes ).swap( m_nodes );
+}
+
+template<class BoundIterator>
+void BoundingVolumeHierarchy<BoundIterator>::refit()
+{
+	// Children are always allocated after their parent, so visiting
+	// the nodes in reverse order guarantees that both children of a
+	// branch are refitted before the branch itself.
+	for( typename NodeVector::reverse_iterator it = m_nodes.rbegin(); it != m_nodes.rend(); ++it )
+	{
+		Node &node = *it;
+		BoxTraits<Bound>::makeEmpty( node.m_bound );
+		if( node.isLeaf() )
+		{
+			const BoundIterator *last = permLast( node );
+			for( const BoundIterator *perm = permFirst( node ); perm != last; ++perm )
+			{
+				boxExtend( node.m_bound, **perm );
+			}
+		}
+		else
+		{
+			boxExtend( node.m_bound, m_nodes[node.m_offset].m_bound );
+			boxExtend( node.m_bound, m_nodes[node.m_offset+1].m_bound );
+		}
+	}
+}
+
+template<class BoundIterator>
+void BoundingVolumeHierarchy<BoundIterator>::build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast, unsigned depth, tbb::atomic<NodeIndex> &numNodes )
+{
+	assert( nodeIndex < m_nodes.size() );
+	assert( permLast > permFirst );
+
+	Node &node = m_nodes[nodeIndex];
+
+	Bound centroidBound;
+	BoxTraits<Bound>::makeEmpty( centroidBound );
+	for( PermutationIterator it = permFirst; it != permLast; ++it )
+	{
+		boxExtend( node.m_bound, **it );
+		boxExtend( centroidBound, boxCenter( **it ) );
+	}
+
+	const size_t count = permLast - permFirst;
+	if( count <= (size_t)m_maxLeafSize || depth >= maxDepth )
+	{
+		node.m_offset = permFirst - m_perm.begin();
+		node.m_count = count;
+		return;
+	}
+
+	PermutationIterator permMid = split( permFirst, permLast, centroidBound );
+	assert( permMid > permFirst && permMid < permLast );
+
+	const NodeIndex children = numNodes.fetch_and_add( 2 );
+	assert( children + 1 < m_nodes.size() );
+	node.m_offset = children;
+	node.m_count = Node::branchCount;
+
+	if( count > parallelThreshold )
+	{
+		tbb::task_group taskGroup;
+		taskGroup.run( BuildTask( this, children, permFirst, permMid, depth + 1, numNodes ) );
+		build( children + 1, permMid, permLast, depth + 1, numNodes );
+		taskGroup.wait();
+	}
+	else
+	{
+		build( children, permFirst, permMid, depth + 1, numNodes );
+		build( children + 1, permMid, permLast, depth + 1, numNodes );
+	}
+}
+
+template<class BoundIterator>
+typename BoundingVolumeHierarchy<BoundIterator>::PermutationIterator BoundingVolumeHierarchy<BoundIterator>::split( PermutationIterator permFirst, PermutationIterator permLast, const Bound &centroidBound ) const
+{
+	typedef Detail::BVHBinner<BoundIterator, BaseType> Binner;
+
+	const BaseType &centroidMin = BoxTraits<Bound>::min( centroidBound );
+	const BaseType &centroidMax = BoxTraits<Bound>::max( centroidBound );
+
+	// Find the axis along which the centroids are most spread out. Binning
+	// along this axis alone gives splits almost as good as considering
+	// every axis, at a fraction of the cost.
+
+	unsigned axis = 0;
+	Real extent = 0;
+	for( unsigned i = 0; i < VectorTraits<BaseType>::dimensions(); ++i )
+	{
+		const Real e = VectorTraits<BaseType>::get( centroidMax, i ) - VectorTraits<BaseType>::get( centroidMin, i );
+		if( e > extent )
+		{
+			extent = e;
+			axis = i;
+		}
+	}
+
+	if( extent > Real( 0 ) )
+	{
+		// Bin the centroids, and find the bin boundary with the lowest
+		// surface area heuristic cost.
+
+		const Real min = VectorTraits<BaseType>::get( centroidMin, axis );
+		const Real max = VectorTraits<BaseType>::get( centroidMax, axis );
+		const Binner binner( axis, min, max, numBins );
+
+		Bound binBounds[numBins];
+		size_t binCounts[numBins];
+		for( unsigned i = 0; i < numBins; ++i )
+		{
+			BoxTraits<Bound>::makeEmpty( binBounds[i] );
+			binCounts[i] = 0;
+		}
+
+		for( PermutationIterator it = permFirst; it != permLast; ++it )
+		{
+			const unsigned b = binner.bin( boxCenter( **it ) );
+			boxExtend( binBounds[b], **it );
+			binCounts[b]++;
+		}
+
+		// Sweep from the right to find the cost of everything above
+		// each boundary, then from the left to complete the costs.
+
+		Real rightCosts[numBins];
+		Bound accumulatedBound;
+		BoxTraits<Bound>::makeEmpty( accumulatedBound );
+		size_t accumulatedCount = 0;
+		for( unsigned i = numBins - 1; i > 0; --i )
+		{
+			boxExtend( accumulatedBound, binBounds[i] );
+			accumulatedCount += binCounts[i];
+			rightCosts[i-1] = accumulatedCount ? accumulatedCount * halfArea( accumulatedBound ) : Real( -1 );
+		}
+
+		Real bestCost = Imath::limits<Real>::max();
+		int bestSplit = -1;
+		BoxTraits<Bound>::makeEmpty( accumulatedBound );
+		accumulatedCount = 0;
+		for( unsigned i = 0; i < numBins - 1; ++i )
+		{
+			boxExtend( accumulatedBound, binBounds[i] );
+			accumulatedCount += binCounts[i];
+			if( !accumulatedCount || rightCosts[i] < Real( 0 ) )
+			{
+				continue;
+			}
+			const Real cost = accumulatedCount * halfArea( accumulatedBound ) + rightCosts[i];
+			if( cost < bestCost )
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if( bestSplit >= 0 )
+		{
+			PermutationIterator permMid = std::partition( permFirst, permLast, Binner( axis, min, max, numBins, bestSplit ) );
+			if( permMid != permFirst && permMid != permLast )
+			{
+				return permMid;
+			}
+		}
+	}
+
+	// Either the centroids are coincident, or they're packed too tightly for
+	// the bins to separate them. Fall back to a median split, which always
+	// makes progress.
+	PermutationIterator permMid = permFirst + ( permLast - permFirst ) / 2;
+	std::nth_element( permFirst, permMid, permLast, Detail::BVHAxisLess<BoundIterator, BaseType>( axis ) );
+	return permMid;
+}
+
+template<class BoundIterator>
+typename BoundingVolumeHierarchy<BoundIterator>::Real BoundingVolumeHierarchy<BoundIterator>::halfArea( const Bound &b )
+{
+	if( BoxTraits<Bound>::isEmpty( b ) )
+	{
+		return 0;
+	}
+
+	const BaseType size = boxSize( b );
+	const unsigned dimensions = VectorTraits<BaseType>::dimensions();
+	if( dimensions < 3 )
+	{
+		// Use the perimeter for 2d bounds.
+		Real result = 0;
+		for( unsigned i = 0; i < dimensions; ++i )
+		{
+			result += VectorTraits<BaseType>::get( size, i );
+		}
+		return result;
+	}
+
+	Real result = 0;
+	for( unsigned i = 0; i < dimensions; ++i )
+	{
+		for( unsigned j = i + 1; j < dimensions; ++j )
+		{
+			result += VectorTraits<BaseType>::get( size, i ) * VectorTraits<BaseType>::get( size, j );
+		}
+	}
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Queries
+//////////////////////////////////////////////////////////////////////////
+
+template<class BoundIterator>
+template<typename S>
+unsigned int BoundingVolumeHierarchy<BoundIterator>::intersectingBounds( const S &b, std::vector<BoundIterator> &bounds ) const
+{
+	bounds.clear();
+	if( m_nodes.empty() )
+	{
+		return 0;
+	}
+
+	NodeIndex stack[maxDepth+2];
+	unsigned stackSize = 0;
+	if( boxIntersects( m_nodes[rootIndex()].bound(), b ) )
+	{
+		stack[stackSize++] = rootIndex();
+	}
+
+	while( stackSize )
+	{
+		const Node &node = m_nodes[stack[--stackSize]];
+		if( node.isLeaf() )
+		{
+			const BoundIterator *last = permLast( node );
+			for( const BoundIterator *it = permFirst( node ); it != last; ++it )
+			{
+				if( boxIntersects( **it, b ) )
+				{
+					bounds.push_back( *it );
+				}
+			}
+		}
+		else
+		{
+			for( NodeIndex child = node.m_offset; child < node.m_offset + 2; ++child )
+			{
+				if( boxIntersects( m_nodes[child].bound(), b ) )
+				{
+					stack[stackSize++] = child;
+				}
+			}
+		}
+	}
+
+	return bounds.size();
+}
+
+template<class BoundIterator>
+template<typename LeafFn>
+void BoundingVolumeHierarchy<BoundIterator>::closestLeaves( const BaseType &p, Real &maxDistanceSquared, LeafFn &leafFn ) const
+{
+	if( m_nodes.empty() )
+	{
+		return;
+	}
+
+	// Each entry holds a node along with the squared distance to its bound,
+	// so that nodes may be culled when popped if a closer primitive has been
+	// found in the meantime. Nearer children are always pushed last, so each
+	// level of the hierarchy adds at most one entry to the stack.
+	std::pair<NodeIndex, Real> stack[maxDepth+2];
+	unsigned stackSize = 0;
+
+	const Real rootDistance = Detail::bvhDistanceSquared( m_nodes[rootIndex()].bound(), p );
+	if( rootDistance <= maxDistanceSquared )
+	{
+		stack[stackSize++] = std::pair<NodeIndex, Real>( rootIndex(), rootDistance );
+	}
+
+	while( stackSize )
+	{
+		const std::pair<NodeIndex, Real> entry = stack[--stackSize];
+		if( entry.second > maxDistanceSquared )
+		{
+			continue;
+		}
+
+		const Node &node = m_nodes[entry.first];
+		if( node.isLeaf() )
+		{
+			leafFn( permFirst( node ), permLast( node ), maxDistanceSquared );
+			continue;
+		}
+
+		NodeIndex nearChild = node.m_offset;
+		NodeIndex farChild = node.m_offset + 1;
+		Real nearDistance = Detail::bvhDistanceSquared( m_nodes[nearChild].bound(), p );
+		Real farDistance = Detail::bvhDistanceSquared( m_nodes[farChild].bound(), p );
+		if( farDistance < nearDistance )
+		{
+			std::swap( nearChild, farChild );
+			std::swap( nearDistance, farDistance );
+		}
+
+		if( farDistance <= maxDistanceSquared )
+		{
+			stack[stackSize++] = std::pair<NodeIndex, Real>( farChild, farDistance );
+		}
+		if( nearDistance <= maxDistanceSquared )
+		{
+			stack[stackSize++] = std::pair<NodeIndex, Real>( nearChild, nearDistance );
+		}
+	}
+}
+
+template<class BoundIterator>
+template<typename LeafFn>
+void BoundingVolumeHierarchy<BoundIterator>::rayLeaves( const BaseType &origin, const BaseType &direction, Real &maxDistance, LeafFn &leafFn ) const
+{
+	if( m_nodes.empty() )
+	{
+		return;
+	}
+
+	// Precompute the reciprocal direction so each slab test needs only
+	// multiplies. Zero components are left infinite, and handled by
+	// rayIntersects().
+	BaseType inverseDirection;
+	for( unsigned i = 0; i < VectorTraits<BaseType>::dimensions(); ++i )
+	{
+		const Real d = VectorTraits<BaseType>::get( direction, i );
+		VectorTraits<BaseType>::set( inverseDirection, i, d != Real( 0 ) ? Real( 1 ) / d : Imath::limits<Real>::max() );
+	}
+
+	std::pair<NodeIndex, Real> stack[maxDepth+2];
+	unsigned stackSize = 0;
+
+	Real rootDistance;
+	if( rayIntersects( m_nodes[rootIndex()].bound(), origin, inverseDirection, maxDistance, rootDistance ) )
+	{
+		stack[stackSize++] = std::pair<NodeIndex, Real>( rootIndex(), rootDistance );
+	}
+
+	while( stackSize )
+	{
+		const std::pair<NodeIndex, Real> entry = stack[--stackSize];
+		if( entry.second > maxDistance )
+		{
+			continue;
+		}
+
+		const Node &node = m_nodes[entry.first];
+		if( node.isLeaf() )
+		{
+			leafFn( permFirst( node ), permLast( node ), maxDistance );
+			continue;
+		}
+
+		NodeIndex nearChild = node.m_offset;
+		NodeIndex farChild = node.m_offset + 1;
+		Real nearDistance, farDistance;
+		bool nearHit = rayIntersects( m_nodes[nearChild].bound(), origin, inverseDirection, maxDistance, nearDistance );
+		bool farHit = rayIntersects( m_nodes[farChild].bound(), origin, inverseDirection, maxDistance, farDistance );
+		if( farHit && ( !nearHit || farDistance < nearDistance ) )
+		{
+			std::swap( nearChild, farChild );
+			std::swap( nearDistance, farDistance );
+			std::swap( nearHit, farHit );
+		}
+
+		if( farHit )
+		{
+			stack[stackSize++] = std::pair<NodeIndex, Real>( farChild, farDistance );
+		}
+		if( nearHit )
+		{
+			stack[stackSize++] = std::pair<NodeIndex, Real>( nearChild, nearDistance );
+		}
+	}
+}
+
+template<class BoundIterator>
+bool BoundingVolumeHierarchy<BoundIterator>::rayIntersects( const Bound &b, const BaseType &origin, const BaseType &inverseDirection, Real maxDistance, Real &distance )
+{
+	const BaseType &min = BoxTraits<Bound>::min( b );
+	const BaseType &max = BoxTraits<Bound>::max( b );
+
+	Real tNear = 0;
+	Real tFar = maxDistance;
+	for( unsigned i = 0; i < VectorTraits<BaseType>::dimensions(); ++i )
+	{
+		const Real o = VectorTraits<BaseType>::get( origin, i );
+		const Real lo = VectorTraits<BaseType>::get( min, i );
+		const Real hi = VectorTraits<BaseType>::get( max, i );
+		const Real inv = VectorTraits<BaseType>::get( inverseDirection, i );
+		if( inv == Imath::limits<Real>::max() )
+		{
+			// Ray is parallel to this slab.
+			if( o < lo || o > hi )
+			{
+				return false;
+			}
+			continue;
+		}
+
+		Real t0 = ( lo - o ) * inv;
+		Real t1 = ( hi - o ) * inv;
+		if( t0 > t1 )
+		{
+			std::swap( t0, t1 );
+		}
+		tNear = std::max( tNear, t0 );
+		tFar = std::min( tFar, t1 );
+		if( tNear > tFar )
+		{
+			return false;
+		}
+	}
+
+	distance = tNear;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Low level access
+//////////////////////////////////////////////////////////////////////////
+
+template<class BoundIterator>
+typename BoundingVolumeHierarchy<BoundIterator>::NodeIndex BoundingVolumeHierarchy<BoundIterator>::numNodes() const
+{
+	return m_nodes.size();
+}
+
+template<class BoundIterator>
+const typename BoundingVolumeHierarchy<BoundIterator>::Node &BoundingVolumeHierarchy<BoundIterator>::node( NodeIndex idx ) const
+{
+	assert( idx < m_nodes.size() );
+	return m_nodes[idx];
+}
+
+template<class BoundIterator>
+typename BoundingVolumeHierarchy<BoundIterator>::NodeIndex BoundingVolumeHierarchy<BoundIterator>::rootIndex() const
+{
+	return 0;
+}
+
+template<class BoundIterator>
+typename BoundingVolumeHierarchy<BoundIterator>::NodeIndex BoundingVolumeHierarchy<BoundIterator>::lowChildIndex( NodeIndex index ) const
+{
+	assert( m_nodes[index].isBranch() );
+	return m_nodes[index].m_offset;
+}
+
+template<class BoundIterator>
+typename BoundingVolumeHierarchy<BoundIterator>::NodeIndex BoundingVolumeHierarchy<BoundIterator>::highChildIndex( NodeIndex index ) const
+{
+	assert( m_nodes[index].isBranch() );
+	return m_nodes[index].m_offset + 1;
+}
+
+template<class BoundIterator>
+const BoundIterator *BoundingVolumeHierarchy<BoundIterator>::permFirst( const Node &node ) const
+{
+	assert( node.isLeaf() );
+	return &m_perm[0] + node.m_offset;
+}
+
+template<class BoundIterator>
+const BoundIterator *BoundingVolumeHierarchy<BoundIterator>::permLast( const Node &node ) const
+{
+	assert( node.isLeaf() );
+	return &m_perm[0] + node.m_offset + node.m_count;
+}
+
+} // namespace IECore
@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef IECORE_CATMULLCLARKREFINER_H
+#define IECORE_CATMULLCLARKREFINER_H
+
+#include <vector>
+
+#include "IECore/Export.h"
+#include "IECore/RefCounted.h"
+#include "IECore/MurmurHash.h"
+#include "IECore/MeshPrimitive.h"
+
+namespace IECore
+{
+
+IE_CORE_FORWARDDECLARE( CatmullClarkRefiner )
+
+/// Performs Catmull-Clark subdivision of MeshPrimitives. Construction analyses the topology
+/// of a mesh to build a refinement plan - a table of stencils expressing each refined value as
+/// a weighted sum of unrefined values, with all levels of refinement composed into a single
+/// table. Because the plan depends only on the topology, it may be reused to refine any number
+/// of meshes sharing that topology, such as the frames of a deforming mesh, and refining each
+/// primitive variable then costs only a single parallel pass over the stencils. The shared()
+/// method maintains a cache of plans keyed on MeshPrimitive::topologyHash(), so that this reuse
+/// comes for free.
+///
+/// Each level of refinement splits every n-sided face into n quads. Boundary and non-manifold
+/// edges are treated as creases, and boundary vertices belonging to a single face as corners.
+/// Varying and facevarying primitive variables are interpolated bilinearly within each face, so
+/// discontinuities such as uv seams are preserved exactly. Uniform primitive variables are copied
+/// to each child face, and primitive variables whose type can't be interpolated take the value of
+/// the most heavily weighted source.
+/// \ingroup geometryProcessingGroup
+class IECORE_API CatmullClarkRefiner : public RefCounted
+{
+
+	public :
+
+		IE_CORE_DECLAREMEMBERPTR( CatmullClarkRefiner );
+
+		/// Builds a plan for refining meshes with the topology of mesh by
+		/// the specified number of levels.
+		CatmullClarkRefiner( const MeshPrimitive *mesh, unsigned levels = 1 );
+		virtual ~CatmullClarkRefiner();
+
+		unsigned levels() const;
+		/// Returns the hash of the topology this refiner was built for, as
+		/// computed by MeshPrimitive::topologyHash().
+		const MurmurHash &topologyHash() const;
+
+		/// Returns a new mesh containing the refined topology and all of the
+		/// refined primitive variables of mesh. Throws if the topology of mesh
+		/// differs from the one the refiner was built for.
+		/// \threading May be called concurrently by multiple threads.
+		MeshPrimitivePtr refine( const MeshPrimitive *mesh ) const;
+		/// Returns a refined copy of a single primitive variable, which must
+		/// belong to a mesh with the topology the refiner was built for.
+		/// \threading May be called concurrently by multiple threads.
+		PrimitiveVariable refine( const PrimitiveVariable &primitiveVariable ) const;
+
+		/// Returns a refiner for the topology of mesh, reusing a previously built one
+		/// if possible. The memory used by the cache may be specified in megabytes using
+		/// the IECORE_CATMULLCLARKREFINER_CACHE_MEMORY environment variable, and defaults
+		/// to 500.
+		/// \threading May be called concurrently by multiple threads.
+		static ConstCatmullClarkRefinerPtr shared( const MeshPrimitive *mesh, unsigned levels = 1 );
+
+		/// Returns the approximate number of bytes used by the refinement plan.
+		size_t memoryUsage() const;
+
+	private :
+
+		/// A sparse matrix mapping unrefined values onto refined ones, stored
+		/// as one row of indices and weights per refined value.
+		struct Stencils
+		{
+			Stencils();
+			/// Resets to the identity mapping for numValues values.
+			void setIdentity( size_t numValues );
+			void addWeight( int index, float weight );
+			void endRow();
+			size_t numRows() const;
+
+			std::vector<int> offsets;
+			std::vector<int> indices;
+			std::vector<float> weights;
+		};
+
+		struct Level;
+		struct ApplyStencils;
+
+		/// Replaces stencils, which map numValues unrefined values onto the values of some
+		/// level, with stencils mapping the unrefined values onto the values of the level
+		/// below, as described by levelStencils.
+		static void composeStencils( const Stencils &levelStencils, size_t numValues, Stencils &stencils );
+
+		MurmurHash m_topologyHash;
+		unsigned m_levels;
+
+		size_t m_numVertices;
+		size_t m_numFaces;
+		size_t m_numFaceVertices;
+
+		IntVectorDataPtr m_refinedVerticesPerFace;
+		IntVectorDataPtr m_refinedVertexIds;
+		size_t m_numRefinedVertices;
+
+		Stencils m_vertexStencils;
+		Stencils m_varyingStencils;
+		Stencils m_faceVaryingStencils;
+		/// Maps each unrefined face onto its descendants, using a single
+		/// weight of 1 per refined face.
+		Stencils m_uniformStencils;
+
+};
+
+} // namespace IECore
+
+#endif // IECORE_CATMULLCLARKREFINER_H
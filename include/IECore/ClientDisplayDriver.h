@@ -49,6 +49,10 @@ namespace IECore
 /// This client class works synchronously.
 /// It forwards all parameters to the server and also includes one called "clientPID" to help grouping AOVs from the same render.
 /// You must set the parameter 'remoteDisplayType' with a registered display driver to be instantiated in the server side.
+/// The optional StringData parameter 'bucketEncoding' controls how pixel data is sent to the server, and may be one of
+/// "float" (the default), "half", "compressedFloat" or "compressedHalf". The half encodings halve the bandwidth at the
+/// expense of precision, and the compressed encodings trade a little cpu time for bandwidth. Servers which predate
+/// bucketEncoding are always sent uncompressed floats.
 /// \ingroup renderingGroup
 class IECORE_API ClientDisplayDriver : public DisplayDriver
 {
@@ -57,7 +61,8 @@ class IECORE_API ClientDisplayDriver : public DisplayDriver
 		IE_CORE_DECLARERUNTIMETYPED( ClientDisplayDriver, DisplayDriver );
 
 		// Constructor.
-		// Expects two StringData parameters: displayHost and displayPort.
+		// Expects two StringData parameters: displayHost and displayPort, and
+		// optionally a StringData bucketEncoding parameter.
 		ClientDisplayDriver( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow, const std::vector<std::string> &channelNames, ConstCompoundDataPtr parameters );
 
 		virtual ~ClientDisplayDriver();
@@ -45,7 +45,8 @@ namespace IECore
 /// The ColorTransformOp defines a base class for Ops which
 /// transform the colors of a Primitive. By default the "Cs" or "R",
 /// "G", and "B" channels are transformed but this can be changed
-/// using the appropriate parameters.
+/// using the appropriate parameters. Large primitives are transformed in parallel
+/// batches of colors, using transformRange().
 /// \ingroup imageProcessingGroup
 class IECORE_API ColorTransformOp : public PrimitiveOp
 {
@@ -82,6 +83,15 @@ class IECORE_API ColorTransformOp : public PrimitiveOp
 		/// Called once per color element (pixel for ImagePrimitives).
 		/// Must be implemented by subclasses to transform color in place.
 		virtual void transform( Imath::Color3f &color ) const = 0;
+		/// Transforms a contiguous batch of colors in place. The colors have already been
+		/// unpremultiplied if necessary. The default implementation calls transform() for each
+		/// color in turn, but subclasses may reimplement it to hoist per-operation work out of
+		/// the loop, or to process the colors in a form suitable for vectorisation.
+		virtual void transformRange( Imath::Color3f *begin, Imath::Color3f *end ) const;
+		/// Returns true if transformRange() may be called concurrently from several threads,
+		/// which is the case for the default implementation, as transform() is const. Subclasses
+		/// which depend on non-threadsafe state should reimplement this to return false.
+		virtual bool canTransformConcurrently() const;
 		/// Called once per operation, after all calls to transform() have been made - even if
 		// /transform() throws an exception. This is an opportunity to perform any cleanup necessary.
 		virtual void end();
@@ -99,6 +109,13 @@ class IECORE_API ColorTransformOp : public PrimitiveOp
 		template <typename T>
 		void transformInterleaved( Primitive * primitive, const CompoundObject * operands, T * colors );
 
+		/// Transforms numElements colors whose components are found at r[i*stride], g[i*stride] and b[i*stride],
+		/// calling begin() and end() around the calls to transformRange().
+		template<typename T>
+		void transformElements( const CompoundObject * operands, T *r, T *g, T *b, size_t stride, const T *alpha, size_t numElements );
+		template<typename T>
+		struct TransformElements;
+
 		StringParameterPtr m_colorPrimVarParameter;
 		StringParameterPtr m_redPrimVarParameter;
 		StringParameterPtr m_greenPrimVarParameter;
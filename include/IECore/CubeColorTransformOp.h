@@ -69,6 +69,8 @@ class IECORE_API CubeColorTransformOp : public ColorTransformOp
 
 		virtual void transform( Imath::Color3f &color ) const ;
 
+		virtual void transformRange( Imath::Color3f *begin, Imath::Color3f *end ) const;
+
 	private :
 
 		CubeColorLookupfParameterPtr m_cubeParameter;
@@ -40,6 +40,7 @@
 #include "IECore/Export.h"
 #include "IECore/PrimitiveEvaluator.h"
 #include "IECore/BoundedKDTree.h"
+#include "IECore/BoundingVolumeHierarchy.h"
 
 namespace IECore
 {
@@ -110,7 +111,9 @@ class IECORE_API CurvesPrimitiveEvaluator : public PrimitiveEvaluator
 		};
 		IE_CORE_DECLAREPTR( Result );
 
-		CurvesPrimitiveEvaluator( ConstCurvesPrimitivePtr curves );
+		/// The accelerationStructure argument chooses the hierarchy which is built
+		/// over the curve segments to accelerate closestPoint() queries.
+		CurvesPrimitiveEvaluator( ConstCurvesPrimitivePtr curves, AccelerationStructure accelerationStructure = BoundedKDTreeAcceleration );
 		virtual ~CurvesPrimitiveEvaluator();
 
 		virtual ConstPrimitivePtr primitive() const;
@@ -183,15 +186,19 @@ class IECORE_API CurvesPrimitiveEvaluator : public PrimitiveEvaluator
 		PrimitiveVariable m_p;
 		
 		void buildTree();
+		AccelerationStructure m_accelerationStructure;
 		bool m_haveTree;
 		typedef tbb::mutex TreeMutex;
 		TreeMutex m_treeMutex;
 		Box3fTree m_tree;
+		Box3fBVH m_bvh;
 		std::vector<Imath::Box3f> m_treeBounds;
 		struct Line;
 		std::vector<Line> m_treeLines;
 		
 		void closestPointWalk( Box3fTree::NodeIndex nodeIndex, const Imath::V3f &p, unsigned &curveIndex, float &v, float &closestDistSquared ) const;
+		void closestPointLeaf( const Box3fTree::Iterator *permFirst, const Box3fTree::Iterator *permLast, const Imath::V3f &p, unsigned &curveIndex, float &v, float &closestDistSquared ) const;
+		struct ClosestPointLeafFn;
 		
 };
 
@@ -45,7 +45,9 @@ IE_CORE_FORWARDDECLARE( FileNameParameter );
 
 /// The DeepImageConverter provides a simplified process for converting deep image files
 /// from one format to another. It reads any file supported by DeepImageReader and writes
-/// the data to any file supported by DeepImageWriter.
+/// the data to any file supported by DeepImageWriter. DeepImageWriter always writes
+/// images with their data window at the origin, so an input data window which is offset
+/// from the origin is moved there, with the pixel at its min corner written to ( 0, 0 ).
 /// \todo: should this operate on a FileSequence rather than a single file?
 /// \ingroup deepCompositingGroup
 /// \ingroup ioGroup
@@ -40,6 +40,7 @@
 
 #include "IECore/Export.h"
 #include "IECore/DeepPixel.h"
+#include "IECore/DeepScanline.h"
 #include "IECore/Reader.h"
 
 namespace IECore
@@ -84,6 +85,11 @@ class IECORE_API DeepImageReader : public Reader
 		/// be specified as if the origin is in the upper left corner of the displayWindow.
 		/// It is up to the derived classes to account for that fact if necessary.
 		DeepPixelPtr readPixel( int x, int y );
+		/// Reads every pixel in row y of the dataWindow into the passed scanline, which
+		/// is resized to the width of the dataWindow. Pixel x of the scanline corresponds
+		/// to column dataWindow().min.x + x of the image. This is much cheaper than calling
+		/// readPixel() for each pixel in turn, and should be preferred for bulk access.
+		void readScanline( int y, DeepScanline &scanline );
 
 	protected :
 
@@ -97,6 +103,12 @@ class IECORE_API DeepImageReader : public Reader
 		/// upper left corner of the displayWindow. It is up to the derived classes to account
 		/// for that fact if necessary.
 		virtual DeepPixelPtr doReadPixel( int x, int y ) = 0;
+		/// Reads a row of pixels. This is called by the public readScanline() method, which
+		/// guarantees that y is within the dataWindow and that the scanline has already been
+		/// resized appropriately. The default implementation calls doReadPixel() for each
+		/// pixel - derived classes are encouraged to override it with something more
+		/// efficient where the file format allows.
+		virtual void doReadScanline( int y, DeepScanline &scanline );
 
 };
 
@@ -37,6 +37,7 @@
 
 #include "IECore/Export.h"
 #include "IECore/DeepPixel.h"
+#include "IECore/DeepScanline.h"
 #include "IECore/Parameterised.h"
 #include "IECore/SimpleTypedParameter.h"
 #include "IECore/VectorTypedParameter.h"
@@ -95,6 +96,12 @@ class IECORE_API DeepImageWriter : public Parameterised
 		/// as if the origin is in the upper left corner of the displayWindow. It is up to
 		/// the derived classes to account for that fact if necessary.
 		void writePixel( int x, int y, const DeepPixel *pixel );
+		/// Writes an entire row of pixels to the file. The scanline must have the same
+		/// width as the resolution, the same number of channels as channelNamesParameter(),
+		/// and must have had its samples allocated to match its sample counts. This is much
+		/// cheaper than calling writePixel() for each pixel in turn, and should be preferred
+		/// for bulk access.
+		void writeScanline( int y, const DeepScanline &scanline );
 
 		/// Fills the passed vector with all the extensions for which a DeepImageWriter is
 		/// available. Extensions are of the form "exr" - ie without a preceding '.'.
@@ -116,6 +123,12 @@ class IECORE_API DeepImageWriter : public Parameterised
 		/// the upper left corner of the displayWindow. It is up to the derived classes to
 		/// account for that fact if necessary.
 		virtual void doWritePixel( int x, int y, const DeepPixel *pixel ) = 0;
+		/// Writes a row of pixels. This is called by the public writeScanline() method, which
+		/// guarantees that y is within the resolution and that the scanline is valid. The
+		/// default implementation calls doWritePixel() for each pixel with samples - derived
+		/// classes are encouraged to override it with something more efficient where the file
+		/// format allows.
+		virtual void doWriteScanline( int y, const DeepScanline &scanline );
 		
 		/// Definition of a function which can create a DeepImageWriter when given a fileName.
 		typedef DeepImageWriterPtr (*CreatorFn)( const std::string &fileName );
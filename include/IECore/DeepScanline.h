@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef IECORE_DEEPSCANLINE_H
+#define IECORE_DEEPSCANLINE_H
+
+#include <vector>
+
+#include "IECore/Export.h"
+
+namespace IECore
+{
+
+/// A DeepScanline holds all the deep samples for a single row of a deep image
+/// in flat arrays, allowing whole rows to be read and written without the cost
+/// of constructing a DeepPixel for every pixel. The samples for pixel x start at
+/// sampleOffsets[x] and there are sampleCounts[x] of them. Each sample has an
+/// entry in depths, and numChannels() consecutive values in channelData, so the
+/// data for channel c of sample s of pixel x lives at
+/// channelData[( sampleOffsets[x] + s ) * numChannels() + c]. Unlike DeepPixel,
+/// samples are not sorted by depth, but are kept in the order they were read.
+/// \ingroup deepCompositingGroup
+class IECORE_API DeepScanline
+{
+
+	public :
+
+		DeepScanline( unsigned width = 0, unsigned numChannels = 0 );
+
+		/// Resizes the scanline, setting all sample counts to 0 and
+		/// discarding all samples.
+		void resize( unsigned width, unsigned numChannels );
+		/// Computes sampleOffsets from sampleCounts, and resizes depths and
+		/// channelData to hold the required number of samples. This must be
+		/// called after filling sampleCounts and before filling the sample data.
+		void allocateSamples();
+
+		unsigned width() const;
+		unsigned numChannels() const;
+		/// Returns the total number of samples in the scanline, as allocated
+		/// by the last call to allocateSamples().
+		unsigned numSamples() const;
+
+		std::vector<unsigned> sampleCounts;
+		std::vector<unsigned> sampleOffsets;
+		std::vector<float> depths;
+		std::vector<float> channelData;
+
+	private :
+
+		unsigned m_numChannels;
+
+};
+
+} // namespace IECore
+
+#endif // IECORE_DEEPSCANLINE_H
@@ -52,7 +52,9 @@ namespace IECore
 /// Server class that receives images from ClientDisplayDriver connections and forwards the data to local display drivers.
 /// The type of the local display drivers is defined by the 'remoteDisplayType' parameter.
 ///
-/// The server object creates a thread to control the socket connection. The thread dies when the object is destroyed.
+/// The server object creates a pool of threads to service the socket connections. The threads die when the object is destroyed.
+/// Data for separate connections may be processed concurrently on different threads, but the data for any one connection
+/// is always processed serially, so each display driver only receives one call at a time.
 /// \ingroup renderingGroup
 class IECORE_API DisplayDriverServer : public RunTimeTyped
 {
@@ -62,8 +64,12 @@ class IECORE_API DisplayDriverServer : public RunTimeTyped
 
 		/// A port number of 0 causes a free port to be chosen
 		/// automatically. Call `portNumber()` after construction
-		/// to retrieve the actual number.
-		DisplayDriverServer( int portNumber = 0 );
+		/// to retrieve the actual number. The numThreads argument
+		/// specifies how many threads will service connections, with
+		/// 0 meaning one per hardware thread. Display drivers which
+		/// share state between instances must protect it themselves
+		/// when numThreads is not 1.
+		DisplayDriverServer( int portNumber = 0, int numThreads = 1 );
 		virtual ~DisplayDriverServer();
 
 		int portNumber();
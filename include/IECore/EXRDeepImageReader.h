@@ -70,6 +70,9 @@ class IECORE_API EXRDeepImageReader : public DeepImageReader
 	protected :
 
 		virtual DeepPixelPtr doReadPixel( int x, int y );
+		/// Reads the scanline directly into the DeepScanline arrays via an Imf::DeepFrameBuffer,
+		/// bypassing the cache used by doReadPixel().
+		virtual void doReadScanline( int y, DeepScanline &scanline );
 
 	private :
 
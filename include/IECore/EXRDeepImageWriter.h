@@ -74,6 +74,9 @@ class IECORE_API EXRDeepImageWriter : public DeepImageWriter
 	protected :
 		
 		virtual void doWritePixel( int x, int y, const DeepPixel *pixel );
+		/// Writes the scanline directly from the DeepScanline arrays via an Imf::DeepFrameBuffer.
+		/// Any pixels already written to the scanline using writePixel() are discarded.
+		virtual void doWriteScanline( int y, const DeepScanline &scanline );
 		
 		Imf::Compression compression() const;
 
@@ -81,7 +84,11 @@ class IECORE_API EXRDeepImageWriter : public DeepImageWriter
 		
 		void clearScanlineBuffer();
 		void appendParameters();
-		void writeScanline();
+		/// Writes the buffered scanline and advances to the next one.
+		void flushScanline();
+		/// Flushes scanlines until y is the current one, throwing if y has
+		/// already been written or is outside the image.
+		void seekScanline( int y );
 		unsigned int numberOfChannels() const;
 		const std::string &channelName( unsigned int index ) const;
 
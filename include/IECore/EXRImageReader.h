@@ -36,6 +36,7 @@
 #define IE_CORE_EXRIMAGEREADER_H
 
 #include "OpenEXR/ImfInputFile.h"
+#include "OpenEXR/ImfTiledInputFile.h"
 #include "OpenEXR/ImfChannelList.h"
 
 #include "IECore/Export.h"
@@ -73,10 +74,10 @@ class IECORE_API EXRImageReader : public ImageReader
 
 	private:
 
-		template<class T>
-		DataPtr readTypedChannel( const std::string &name, const Imath::Box2i &dataWindow, const Imf::Channel *channel );
-
 		virtual DataPtr readChannel( const std::string &name, const Imath::Box2i &dataWindow, bool raw );
+		/// Reads all the channels through a single FrameBuffer, so that each scanline
+		/// is decompressed only once regardless of the number of channels requested.
+		virtual void readChannels( const std::vector<std::string> &names, const Imath::Box2i &dataWindow, bool raw, std::vector<DataPtr> &channels );
 
 		static const ReaderDescription<EXRImageReader> g_readerDescription;
 
@@ -85,6 +86,11 @@ class IECORE_API EXRImageReader : public ImageReader
 		/// Exception is thrown rather than false being returned.
 		bool open( bool throwOnFailure = false );
 		Imf::InputFile *m_inputFile;
+		/// Returns a TiledInputFile for reading regions of tiled files. This is opened
+		/// on first use and kept until the file is changed, so that repeated region
+		/// reads don't need to reopen the file.
+		Imf::TiledInputFile *tiledInputFile();
+		Imf::TiledInputFile *m_tiledInputFile;
 
 };
 
@@ -53,7 +53,9 @@ class IECORE_API FileIndexedIO : public StreamIndexedIO
 
 		static bool canRead( const std::string &path );
 
-		/// Open or create an file at the given root location
+		/// Open or create an file at the given root location. Read only files opened with the
+		/// IndexedIO::MemoryMapped flag are mapped into memory, and data is then copied straight
+		/// from the mapping rather than read through the file stream.
 		FileIndexedIO(const std::string &path, const IndexedIO::EntryIDList &root, IndexedIO::OpenMode mode);
 
 		virtual ~FileIndexedIO();
@@ -91,6 +91,8 @@ class IECORE_API Grade : public ColorTransformOp
 		/// initializes temporary values A, B and 1/gamma.
 		virtual void begin( const CompoundObject * operands );
 		virtual void transform( Imath::Color3f &color ) const;
+		/// Reimplemented to read the clamping parameters once per batch rather than once per color.
+		virtual void transformRange( Imath::Color3f *begin, Imath::Color3f *end ) const;
 
 	private :
 
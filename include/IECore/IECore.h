@@ -249,7 +249,8 @@ IECORE_API bool withDeepEXR();
 ///
 /// \section mainPageAlgorithmsSection Algorithms
 ///
-/// \link IECore::KDTree KDTree \endlink and \link IECore::BoundedKDTree BoundedKDTree \endlink
+/// \link IECore::KDTree KDTree \endlink, \link IECore::BoundedKDTree BoundedKDTree \endlink and
+/// \link IECore::BoundingVolumeHierarchy BoundingVolumeHierarchy \endlink
 /// structures allow for fast spatial queries on large data sets.
 ///
 /// \link IECore::PerlinNoise PerlinNoise \endlink implements the classic noise function for arbitrary dimensions.
@@ -111,9 +111,9 @@ class IECORE_API ImageCompositeOp : public ImagePrimitiveOp
 
 	private :
 		struct ChannelConverter;
+		struct CompositeRows;
 
 		FloatVectorDataPtr getChannelData( ImagePrimitive * image, const std::string &channelName, bool mustExist = true );
-		float readChannelData( const ImagePrimitive * image, const FloatVectorData * data, const Imath::V2i &pixel );
 
 };
 
@@ -38,6 +38,8 @@
 #ifndef IE_CORE_IMAGEDISPLAYDRIVER
 #define IE_CORE_IMAGEDISPLAYDRIVER
 
+#include "tbb/spin_rw_mutex.h"
+
 #include "IECore/Export.h"
 #include "IECore/DisplayDriver.h"
 #include "IECore/ImagePrimitive.h"
@@ -61,11 +63,14 @@ class IECORE_API ImageDisplayDriver : public DisplayDriver
 
 		virtual bool scanLineOrderOnly() const;
 		virtual bool acceptsRepeatedData() const;
+		/// May be called concurrently from multiple threads, provided that
+		/// the boxes passed to the concurrent calls don't overlap.
 		virtual void imageData( const Imath::Box2i &box, const float *data, size_t dataSize );
 		virtual void imageClose();
 
-		/// Access to the image being created. This should always be valid for reading, even
-		/// before imageClose() has been called.
+		/// Access to the image being created. This may be called at any time, including
+		/// concurrently with imageData(), and returns a copy of the image holding all the
+		/// buckets received so far. The copy is not affected by buckets received later.
 		ConstImagePrimitivePtr image() const;
 		
 		//! @name Image pool
@@ -76,11 +81,11 @@ class IECORE_API ImageDisplayDriver : public DisplayDriver
 		/// stored and can be retrieved using the methods below.
 		///////////////////////////////////////////////////////////////////////
 		//@{
-		/// Returns the image stored with the specified handle, or 0 if no
-		/// such image exists.
+		/// Returns a copy of the image stored with the specified handle, or 0
+		/// if no such image exists.
 		static ConstImagePrimitivePtr storedImage( const std::string &handle );
 		/// Removes the image stored with the specified handle from the pool. Returns
-		/// the image, or 0 if no such image existed.
+		/// a copy of the image, or 0 if no such image existed.
 		static ConstImagePrimitivePtr removeStoredImage( const std::string &handle );
 		//@}
 		
@@ -89,6 +94,17 @@ class IECORE_API ImageDisplayDriver : public DisplayDriver
 		static const DisplayDriverDescription<ImageDisplayDriver> g_description;
 		
 		ImagePrimitivePtr m_image;
+		// The data for each channel, in the same order as channelNames().
+		std::vector<FloatVectorData *> m_channels;
+		// Pointers returned by writable() for each of m_channels, so that
+		// concurrent imageData() calls needn't call it themselves. They are
+		// invalidated whenever image() shares the data with a copy.
+		std::vector<float *> m_channelData;
+		mutable bool m_channelDataValid;
+		// Held for reading while imageData() writes through m_channelData, and
+		// for writing while m_channelData is updated or the image is copied.
+		typedef tbb::spin_rw_mutex Mutex;
+		mutable Mutex m_mutex;
 		
 };
 
@@ -122,6 +122,22 @@ class IECORE_API ImageReader : public Reader
 
 		//@}
 
+		//! @name Banded reading
+		/// These functions allow an image to be read as a series of horizontal bands, so that
+		/// images too large to hold in memory can be processed one band at a time. Readers which
+		/// can decode a region of a file efficiently (such as the EXR and TIFF readers) only read
+		/// the data needed for each band.
+		///////////////////////////////////////////////////////////////
+		//@{
+		/// Returns the number of bands of at most bandHeight scanlines which are needed to
+		/// cover the data window that read() would load.
+		int numBands( int bandHeight );
+		/// Loads the specified band, returning an ImagePrimitive whose data window spans the full
+		/// width of the data window that read() would load, and at most bandHeight scanlines of it.
+		/// All other parameters are obeyed exactly as they are by read().
+		ImagePrimitivePtr readBand( int bandIndex, int bandHeight );
+		//@}
+
 	protected:
 
 		/// Fills the passed vector with the intersection of channelNames() and
@@ -141,6 +157,13 @@ class IECORE_API ImageReader : public Reader
 		/// invalid names or dataWindows which are not wholly within the dataWindow in the file.
 		virtual DataPtr readChannel( const std::string &name, const Imath::Box2i &dataWindow, bool raw ) = 0;
 
+		/// Reads the specified area from all the named channels at once, filling channels with
+		/// one DataPtr per name, in the same order. This is called by doOperation(), and the
+		/// default implementation simply calls readChannel() for each name in turn. Derived
+		/// classes for formats which store channels interleaved should reimplement it so that
+		/// the file is decoded only once. The same guarantees apply as for readChannel().
+		virtual void readChannels( const std::vector<std::string> &names, const Imath::Box2i &dataWindow, bool raw, std::vector<DataPtr> &channels );
+
 	private :
 
 		Box2iParameterPtr m_dataWindowParameter;
@@ -69,6 +69,14 @@ class IECORE_API IndexedIO : public RunTimeTyped
 
 			Shared    = 1L << 3,
 			Exclusive = 1L << 4,
+
+			/// May be combined with Read to request that the file is memory mapped rather
+			/// than accessed through a stream. Implementations that don't support it ignore it.
+			MemoryMapped = 1L << 5,
+
+			/// May be combined with Write or Append to request that data entries are stored
+			/// compressed. Implementations that don't support it ignore it.
+			Compressed = 1L << 6,
 		} ;
 
 		typedef unsigned OpenMode;
@@ -48,6 +48,10 @@ namespace IECore
 /// The KDTree class provides accelerated searching of pointsets. It is
 /// templated so that it can operate on a wide variety of datatypes, and uses
 /// the VectorTraits.h and VectorOps.h functionality to assist in this.
+/// Construction is performed in parallel using TBB. Nodes are stored in a
+/// single contiguous array, and the tree keeps its own copy of the points in
+/// leaf order, so that queries need not chase iterators back into the
+/// source container.
 /// \ingroup mathGroup
 template<class PointIterator>
 class KDTree
@@ -101,6 +105,19 @@ class KDTree
 		/// \threading May be called by multiple concurrent threads provided they are each using a different vector for the result.
 		unsigned int nearestNNeighbours( const Point &p, unsigned int numNeighbours, std::vector<Neighbour> &nearNeighbours ) const;
 
+		/// Batch form of nearestNeighbours(), performing a query for each point in the range
+		/// [first, last) in parallel. The results for the ith query point are placed in
+		/// nearNeighbours[i].
+		/// \threading May be called by multiple concurrent threads provided they are each using a different vector for the result.
+		template<typename QueryIterator>
+		void nearestNeighbours( QueryIterator first, QueryIterator last, BaseType r, std::vector<std::vector<PointIterator> > &nearNeighbours ) const;
+		/// Batch form of nearestNNeighbours(), performing a query for each point in the range
+		/// [first, last) in parallel. The results for the ith query point are placed in
+		/// nearNeighbours[i].
+		/// \threading May be called by multiple concurrent threads provided they are each using a different vector for the result.
+		template<typename QueryIterator>
+		void nearestNNeighbours( QueryIterator first, QueryIterator last, unsigned int numNeighbours, std::vector<std::vector<Neighbour> > &nearNeighbours ) const;
+
 		/// Finds all the points contained by the specified bound, outputting them to the specified iterator.
 		/// \threading May be called by multiple concurrent threads.
 		template<typename Box, typename OutputIterator>
@@ -127,11 +144,22 @@ class KDTree
 		typedef typename Permutation::iterator PermutationIterator;
 		typedef typename Permutation::const_iterator PermutationConstIterator;
 
+		typedef std::vector<Point> PointVector;
+
 		class AxisSort;
+		class BuildTask;
+		template<typename QueryIterator>
+		class NearestNeighboursFn;
+		template<typename QueryIterator>
+		class NearestNNeighboursFn;
 
-		unsigned char majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast );
+		unsigned char majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast ) const;
 		void build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast );
 
+		/// Returns our copy of the point referenced by the specified
+		/// element of m_perm.
+		inline const Point &point( const PointIterator *perm ) const;
+
 		void nearestNeighbourWalk( NodeIndex nodeIndex, const Point &p, PointIterator &closestPoint, BaseType &distSquared ) const;
 
 		void nearestNeighboursWalk( NodeIndex nodeIndex, const Point &p, BaseType r2, std::vector<PointIterator> &nearNeighbours ) const;
@@ -142,10 +170,15 @@ class KDTree
 		void nearestNNeighboursWalk( NodeIndex nodeIndex, const Point &p, unsigned int numNeighbours, std::vector<Neighbour> &nearNeighbours, BaseType &maxDistSquared ) const;
 
 		Permutation m_perm;
+		/// Copies of the points, in the same order as m_perm.
+		PointVector m_points;
 		NodeVector m_nodes;
 		int m_maxLeafSize;
 		PointIterator m_lastPoint;
 
+		/// Subtrees with more points than this are built in parallel.
+		static const size_t parallelThreshold = 4096;
+
 };
 
 /// The Node class which is used to implement the branching structure in the KDTree.
@@ -33,6 +33,11 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <algorithm>
+
+#include "tbb/task_group.h"
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+
 #include "OpenEXR/ImathLimits.h"
 #include "IECore/VectorOps.h"
 #include "IECore/BoxOps.h"
@@ -108,6 +113,86 @@ class KDTree<PointIterator>::AxisSort
 		const unsigned int m_axis;
 };
 
+template<class PointIterator>
+class KDTree<PointIterator>::BuildTask
+{
+	public :
+
+		BuildTask( KDTree *tree, NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast )
+			:	m_tree( tree ), m_nodeIndex( nodeIndex ), m_permFirst( permFirst ), m_permLast( permLast )
+		{
+		}
+
+		void operator()() const
+		{
+			m_tree->build( m_nodeIndex, m_permFirst, m_permLast );
+		}
+
+	private :
+
+		KDTree *m_tree;
+		NodeIndex m_nodeIndex;
+		PermutationIterator m_permFirst;
+		PermutationIterator m_permLast;
+
+};
+
+template<class PointIterator>
+template<typename QueryIterator>
+class KDTree<PointIterator>::NearestNeighboursFn
+{
+	public :
+
+		NearestNeighboursFn( const KDTree *tree, QueryIterator first, BaseType r, std::vector<std::vector<PointIterator> > &nearNeighbours )
+			:	m_tree( tree ), m_first( first ), m_r( r ), m_nearNeighbours( nearNeighbours )
+		{
+		}
+
+		void operator()( const tbb::blocked_range<size_t> &r ) const
+		{
+			for( size_t i=r.begin(); i!=r.end(); ++i )
+			{
+				m_tree->nearestNeighbours( *(m_first + i), m_r, m_nearNeighbours[i] );
+			}
+		}
+
+	private :
+
+		const KDTree *m_tree;
+		QueryIterator m_first;
+		BaseType m_r;
+		std::vector<std::vector<PointIterator> > &m_nearNeighbours;
+
+};
+
+template<class PointIterator>
+template<typename QueryIterator>
+class KDTree<PointIterator>::NearestNNeighboursFn
+{
+	public :
+
+		NearestNNeighboursFn( const KDTree *tree, QueryIterator first, unsigned int numNeighbours, std::vector<std::vector<Neighbour> > &nearNeighbours )
+			:	m_tree( tree ), m_first( first ), m_numNeighbours( numNeighbours ), m_nearNeighbours( nearNeighbours )
+		{
+		}
+
+		void operator()( const tbb::blocked_range<size_t> &r ) const
+		{
+			for( size_t i=r.begin(); i!=r.end(); ++i )
+			{
+				m_tree->nearestNNeighbours( *(m_first + i), m_numNeighbours, m_nearNeighbours[i] );
+			}
+		}
+
+	private :
+
+		const KDTree *m_tree;
+		QueryIterator m_first;
+		unsigned int m_numNeighbours;
+		std::vector<std::vector<Neighbour> > &m_nearNeighbours;
+
+};
+
 // initialisation
 
 template<class PointIterator>
@@ -124,7 +209,7 @@ KDTree<PointIterator>::KDTree( PointIterator first, PointIterator last, int maxL
 template<class PointIterator>
 void KDTree<PointIterator>::init( PointIterator first, PointIterator last, int maxLeafSize  )
 {
-	m_maxLeafSize = maxLeafSize;
+	m_maxLeafSize = std::max( maxLeafSize, 1 );
 	m_lastPoint = last;
 	m_perm.resize( last - first );
 	unsigned int i=0;
@@ -132,13 +217,28 @@ void KDTree<PointIterator>::init( PointIterator first, PointIterator last, int m
 	{
 		m_perm[i++] = it;
 	}
+	m_points.resize( m_perm.size() );
+
+	// Because we always split at the median, the shape of the tree depends
+	// only on the number of points. The high child always receives the larger
+	// half, so the deepest and rightmost leaf is found by following high children
+	// from the root. Sizing m_nodes to hold it up front means that parallel
+	// builds never need to grow the vector.
+	NodeIndex maxIndex = rootIndex();
+	size_t count = m_perm.size();
+	while( count > (size_t)m_maxLeafSize )
+	{
+		count -= count / 2;
+		maxIndex = highChildIndex( maxIndex );
+	}
+	m_nodes.clear();
+	m_nodes.resize( maxIndex + 1 );
 
-	/// \todo Can we reserve() enough space for m_nodes before doing this?
 	build( rootIndex(), m_perm.begin(), m_perm.end() );
 }
 
 template<class PointIterator>
-unsigned char KDTree<PointIterator>::majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast )
+unsigned char KDTree<PointIterator>::majorAxis( PermutationConstIterator permFirst, PermutationConstIterator permLast ) const
 {
 	Point min, max;
 	for( unsigned char i=0; i<VectorTraits<Point>::dimensions(); i++ ) {
@@ -174,11 +274,7 @@ unsigned char KDTree<PointIterator>::majorAxis( PermutationConstIterator permFir
 template<class PointIterator>
 void KDTree<PointIterator>::build( NodeIndex nodeIndex, PermutationIterator permFirst, PermutationIterator permLast )
 {
-	// make room for the new node
-	if( nodeIndex>=m_nodes.size() )
-	{
-		m_nodes.resize( nodeIndex+1 );
-	}
+	assert( nodeIndex < m_nodes.size() );
 
 	if( permLast - permFirst > m_maxLeafSize )
 	{
@@ -189,16 +285,39 @@ void KDTree<PointIterator>::build( NodeIndex nodeIndex, PermutationIterator perm
 		// insert node
 		m_nodes[nodeIndex].makeBranch( cutAxis, cutValue );
 
-		build( lowChildIndex( nodeIndex ), permFirst, permMid );
-		build( highChildIndex( nodeIndex ), permMid, permLast );
+		if( (size_t)( permLast - permFirst ) > parallelThreshold )
+		{
+			tbb::task_group taskGroup;
+			taskGroup.run( BuildTask( this, lowChildIndex( nodeIndex ), permFirst, permMid ) );
+			build( highChildIndex( nodeIndex ), permMid, permLast );
+			taskGroup.wait();
+		}
+		else
+		{
+			build( lowChildIndex( nodeIndex ), permFirst, permMid );
+			build( highChildIndex( nodeIndex ), permMid, permLast );
+		}
 	}
 	else
 	{
 		// leaf node
 		m_nodes[nodeIndex].makeLeaf( permFirst, permLast );
+		// the permutation is now final for this range, so we
+		// can take our copies of the points.
+		typename PointVector::iterator pointIt = m_points.begin() + ( permFirst - m_perm.begin() );
+		for( PermutationIterator it = permFirst; it != permLast; ++it )
+		{
+			*pointIt++ = **it;
+		}
 	}
 }
 
+template<class PointIterator>
+inline const typename KDTree<PointIterator>::Point &KDTree<PointIterator>::point( const PointIterator *perm ) const
+{
+	return m_points[perm - &(m_perm[0])];
+}
+
 // nearest neighbour searching
 
 template<class PointIterator>
@@ -235,6 +354,22 @@ void KDTree<PointIterator>::enclosedPoints( const Box &bound, OutputIterator it
 	enclosedPointsWalk( rootIndex(), bound, it );
 }
 
+template<class PointIterator>
+template<typename QueryIterator>
+void KDTree<PointIterator>::nearestNeighbours( QueryIterator first, QueryIterator last, BaseType r, std::vector<std::vector<PointIterator> > &nearNeighbours ) const
+{
+	nearNeighbours.resize( last - first );
+	tbb::parallel_for( tbb::blocked_range<size_t>( 0, last - first ), NearestNeighboursFn<QueryIterator>( this, first, r, nearNeighbours ) );
+}
+
+template<class PointIterator>
+template<typename QueryIterator>
+void KDTree<PointIterator>::nearestNNeighbours( QueryIterator first, QueryIterator last, unsigned int numNeighbours, std::vector<std::vector<Neighbour> > &nearNeighbours ) const
+{
+	nearNeighbours.resize( last - first );
+	tbb::parallel_for( tbb::blocked_range<size_t>( 0, last - first ), NearestNNeighboursFn<QueryIterator>( this, first, numNeighbours, nearNeighbours ) );
+}
+
 template<class PointIterator>
 unsigned int KDTree<PointIterator>::nearestNNeighbours( const Point &p, unsigned int numNeighbours, std::vector<Neighbour> &nearNeighbours ) const
 {
@@ -259,7 +394,7 @@ void KDTree<PointIterator>::nearestNeighbourWalk( NodeIndex nodeIndex, const Poi
 		PointIterator *permLast = node.permLast();
 		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
 		{
-			const Point &pp = **perm;
+			const Point &pp = point( perm );
 			BaseType dist2 = vecDistance2( p, pp );
 
 			if( dist2 < distSquared )
@@ -302,7 +437,7 @@ void KDTree<PointIterator>::nearestNeighboursWalk( NodeIndex nodeIndex, const Po
 		PointIterator *permLast = node.permLast();
 		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
 		{
-			const Point &pp = **perm;
+			const Point &pp = point( perm );
 			BaseType dist2 = vecDistance2( p, pp );
 
 			if (dist2 < r2 )
@@ -344,7 +479,7 @@ void KDTree<PointIterator>::nearestNNeighboursWalk( NodeIndex nodeIndex, const P
 		PointIterator *permLast = node.permLast();
 		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
 		{
-			const Point &pp = **perm;
+			const Point &pp = point( perm );
 			BaseType dist2 = vecDistance2( p, pp );
 
 			if( dist2 < maxDistSquared || nearNeighbours.size() < numNeighbours )
@@ -408,7 +543,7 @@ void KDTree<PointIterator>::enclosedPointsWalk( NodeIndex nodeIndex, const Box &
 		PointIterator *permLast = node.permLast();
 		for( PointIterator *perm = node.permFirst(); perm!=permLast; perm++ )
 		{
-			const Point &pp = **perm;
+			const Point &pp = point( perm );
 			if( boxIntersects( bound, pp ) )
 			{
 				*it++ = *perm;
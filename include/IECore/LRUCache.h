@@ -35,7 +35,9 @@
 #ifndef IECORE_LRUCACHE_H
 #define IECORE_LRUCACHE_H
 
+#include "tbb/atomic.h"
 #include "tbb/spin_mutex.h"
+#include "tbb/spin_rw_mutex.h"
 #include "tbb/concurrent_unordered_map.h"
 
 #include "boost/noncopyable.hpp"
@@ -49,6 +51,12 @@ namespace IECore
 /// subsequent lookups. Each value has a cost associated with it, and the cache has
 /// a maximum total cost above which it will remove the least recently accessed items. 
 ///
+/// The least recently accessed items are determined using the "Second Chance"
+/// approximation to LRU, so that cache hits never need to take a lock shared
+/// between items - they simply take a read lock on the item itself, flag it as
+/// recently used and copy the value. The flag is consulted when items need to
+/// be removed to meet the cost limit.
+///
 /// The Key type must have a tbb_hasher implementation.
 ///
 /// The Value type must be default constructible, copy constructible and assignable.
@@ -175,11 +183,20 @@ class LRUCache : private boost::noncopyable
 			MapValue *next;
 			
 			char status; // status of this item
+			// Set when a Cached item is accessed, so that it
+			// gets a second chance before being removed by
+			// limitCost(). This is atomic so that it may be set
+			// while holding only a read lock on the mutex below.
+			tbb::atomic<bool> recentlyUsed;
 			// Mutex - must be held before accessing any
 			// fields other than the list fields (previous
 			// and next). To access the list fields, m_listMutex
-			// must be held instead.
-			tbb::spin_mutex mutex;
+			// must be held instead. Cache hits only read the
+			// value, so they take a read lock, allowing any number
+			// of concurrent hits for the same item. All other
+			// accesses must take a write lock.
+			typedef tbb::spin_rw_mutex Mutex;
+			mutable Mutex mutex;
 		};
 
 		// Dummy MapValues to represent the start and end of our LRU list.
@@ -193,6 +210,8 @@ class LRUCache : private boost::noncopyable
 		// before the list fields of _any_ MapValue may be accessed.
 		typedef tbb::spin_mutex ListMutex;
 		ListMutex m_listMutex;
+		// Number of items in the list. Protected by m_listMutex.
+		size_t m_listSize;
 		
 		// Total cost. We store the current cost atomically so it can be updated
 		// concurrently by multiple threads.
@@ -222,7 +241,9 @@ class LRUCache : private boost::noncopyable
 		// must _not_ hold the mutex for the cache entry.
 		bool eraseInternal( MapValue *mapValue );
 
-		// Caller must not hold any locks.
+		// Removes items from the start of the list until the cost limit
+		// is met, moving recently used items to the end of the list
+		// instead of removing them. Caller must not hold any locks.
 		void limitCost();
 
 		// Either erases the item from the list, or moves it to
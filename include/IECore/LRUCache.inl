@@ -48,17 +48,19 @@ template<typename Key, typename Value>
 LRUCache<Key, Value>::CacheEntry::CacheEntry()
 	:	value(), cost( 0 ), previous( NULL ), next( NULL ), status( New ), mutex()
 {
+	recentlyUsed = false;
 }
 
 template<typename Key, typename Value>
 LRUCache<Key, Value>::CacheEntry::CacheEntry( const CacheEntry &other )
 	:	value( other.value ), cost( other.cost ), previous( other.previous ), next( other.next ), status( other.status ), mutex()
 {
+	recentlyUsed = other.recentlyUsed;
 }
 
 template<typename Key, typename Value>
 LRUCache<Key, Value>::LRUCache( GetterFunction getter )
-	:	m_getter( getter ), m_removalCallback( nullRemovalCallback ), m_maxCost( 500 )
+	:	m_getter( getter ), m_removalCallback( nullRemovalCallback ), m_listSize( 0 ), m_maxCost( 500 )
 {
 	m_currentCost = 0;
 	
@@ -71,7 +73,7 @@ LRUCache<Key, Value>::LRUCache( GetterFunction getter )
 
 template<typename Key, typename Value>
 LRUCache<Key, Value>::LRUCache( GetterFunction getter, Cost maxCost )
-	:	m_getter( getter ), m_removalCallback( nullRemovalCallback ), m_maxCost( maxCost )
+	:	m_getter( getter ), m_removalCallback( nullRemovalCallback ), m_listSize( 0 ), m_maxCost( maxCost )
 {
 	m_currentCost = 0;
 	
@@ -84,7 +86,7 @@ LRUCache<Key, Value>::LRUCache( GetterFunction getter, Cost maxCost )
 
 template<typename Key, typename Value>
 LRUCache<Key, Value>::LRUCache( GetterFunction getter, RemovalCallback removalCallback, Cost maxCost )
-	:	m_getter( getter ), m_removalCallback( removalCallback ), m_maxCost( maxCost )
+	:	m_getter( getter ), m_removalCallback( removalCallback ), m_listSize( 0 ), m_maxCost( maxCost )
 {
 	m_currentCost = 0;
 	
@@ -132,11 +134,38 @@ typename LRUCache<Key, Value>::Cost LRUCache<Key, Value>::currentCost() const
 template<typename Key, typename Value>
 Value LRUCache<Key, Value>::get( const Key& key )
 {
+	// Most calls are expected to be hits, so we try a find() first
+	// to avoid constructing a new CacheEntry for the insert().
+	MapIterator it = m_map.find( key );
+	if( it != m_map.end() )
+	{
+		// This is our fastest code path, so rather than manipulating
+		// the list (which would require m_listMutex) we just flag the
+		// item so that limitCost() will give it a second chance. We
+		// only need a read lock to do that, so concurrent hits on the
+		// same item don't wait for each other.
+		CacheEntry &cacheEntry = it->second;
+		typename CacheEntry::Mutex::scoped_lock readLock( cacheEntry.mutex, /* write = */ false );
+		if( cacheEntry.status==Cached )
+		{
+			// Only store when the flag isn't already set, so that hits on
+			// a hot item just read the cache line rather than bouncing it
+			// between cores.
+			if( !cacheEntry.recentlyUsed )
+			{
+				cacheEntry.recentlyUsed = true;
+			}
+			return cacheEntry.value;
+		}
+	}
+	else
+	{
+		it = m_map.insert( MapValue( key, CacheEntry() ) ).first;
+	}
 
-	MapIterator it = m_map.insert( MapValue( key, CacheEntry() ) ).first;
 	CacheEntry &cacheEntry = it->second;
-	tbb::spin_mutex::scoped_lock lock( cacheEntry.mutex );
-		
+	typename CacheEntry::Mutex::scoped_lock lock( cacheEntry.mutex );
+
 	if( cacheEntry.status==New || cacheEntry.status==Erased || cacheEntry.status==TooCostly )
 	{
 		assert( cacheEntry.value==Value() );
@@ -163,10 +192,6 @@ Value LRUCache<Key, Value>::get( const Key& key )
 	
 		lock.release();
 		
-		/// \todo We might want to consider ways of avoiding having to manipulate the
-		/// list for cache hits, because we want this to be our fastest code path.
-		/// Adopting an approximate LRU heuristic like Second Chance would be one way
-		/// of doing this.
 		updateListPosition( &*it );
 		limitCost();
 	
@@ -174,10 +199,9 @@ Value LRUCache<Key, Value>::get( const Key& key )
 	}
 	else if( cacheEntry.status==Cached )
 	{
-		Value result = cacheEntry.value;
-		lock.release();
-		updateListPosition( &*it );
-		return result;
+		// Another thread cached the item while we were waiting for the lock.
+		cacheEntry.recentlyUsed = true;
+		return cacheEntry.value;
 	}
 	else
 	{
@@ -191,7 +215,7 @@ bool LRUCache<Key, Value>::set( const Key &key, const Value &value, Cost cost )
 {
 	MapIterator it = m_map.insert( MapValue( key, CacheEntry() ) ).first;
 	CacheEntry &cacheEntry = it->second;
-	tbb::spin_mutex::scoped_lock lock( cacheEntry.mutex );
+	typename CacheEntry::Mutex::scoped_lock lock( cacheEntry.mutex );
 
 	const bool result = setInternal( &*it, value, cost );
 	
@@ -219,6 +243,7 @@ bool LRUCache<Key, Value>::setInternal( MapValue *mapValue, const Value &value,
 		cacheEntry.value = value;
 		cacheEntry.cost = cost;
 		cacheEntry.status = Cached;
+		cacheEntry.recentlyUsed = false;
 		m_currentCost += cost;
 	}
 	else
@@ -238,7 +263,7 @@ bool LRUCache<Key, Value>::cached( const Key &key ) const
 	{
 		return false;
 	}
-	tbb::spin_mutex::scoped_lock lock( it->second.mutex );
+	typename CacheEntry::Mutex::scoped_lock lock( it->second.mutex, /* write = */ false );
 	return it->second.status==Cached;
 }
 
@@ -259,12 +284,13 @@ template<typename Key, typename Value>
 bool LRUCache<Key, Value>::eraseInternal( MapValue *mapValue )
 {	
 	CacheEntry &cacheEntry = mapValue->second;
-	tbb::spin_mutex::scoped_lock lock( cacheEntry.mutex );
+	typename CacheEntry::Mutex::scoped_lock lock( cacheEntry.mutex );
 		
 	const Status originalStatus = (Status)cacheEntry.status;
 
 	listErase( mapValue );
 	cacheEntry.status = Erased;
+	cacheEntry.recentlyUsed = false;
 	
 	if( originalStatus != Cached ) 
 	{
@@ -289,9 +315,28 @@ void LRUCache<Key, Value>::limitCost()
 	// because another thread may have cached an item and incremented
 	// m_currentCost, but still be waiting to add the item to the list,
 	// because we hold m_listMutex.
+	//
+	// Items which have been used since they were last considered are
+	// given a second chance by moving them to the end of the list. We
+	// limit the number of second chances to the length of the list, so
+	// that concurrent hits can't keep us here indefinitely.
+	size_t secondChances = m_listSize;
 	while( m_currentCost > m_maxCost && m_listStart.second.next != &m_listEnd )
 	{
-		eraseInternal( m_listStart.second.next );
+		MapValue *mapValue = m_listStart.second.next;
+		if( secondChances )
+		{
+			typename CacheEntry::Mutex::scoped_lock mapValueLock( mapValue->second.mutex );
+			if( mapValue->second.recentlyUsed )
+			{
+				mapValue->second.recentlyUsed = false;
+				listErase( mapValue );
+				listInsertAtEnd( mapValue );
+				secondChances--;
+				continue;
+			}
+		}
+		eraseInternal( mapValue );
 	}
 }
 
@@ -302,7 +347,7 @@ void LRUCache<Key, Value>::updateListPosition( MapValue *mapValue )
 	
 	listErase( mapValue );
 	
-	tbb::spin_mutex::scoped_lock mapValueMutex( mapValue->second.mutex );
+	typename CacheEntry::Mutex::scoped_lock mapValueMutex( mapValue->second.mutex );
 	if( mapValue->second.status == Cached )
 	{
 		listInsertAtEnd( mapValue );
@@ -321,6 +366,7 @@ void LRUCache<Key, Value>::listErase( MapValue *mapValue )
 	previous->second.next = mapValue->second.next;
 	mapValue->second.next->second.previous = previous;
 	mapValue->second.next = mapValue->second.previous = NULL;
+	m_listSize--;
 }
 
 template<typename Key, typename Value>
@@ -335,6 +381,7 @@ void LRUCache<Key, Value>::listInsertAtEnd( MapValue *mapValue )
 	
 	mapValue->second.next = &m_listEnd;
 	m_listEnd.second.previous = mapValue;
+	m_listSize++;
 }
 
 template<typename Key, typename Value>
@@ -57,8 +57,6 @@ class IECORE_API LinearToAlexaLogcOp : public ChannelOp
 
 		virtual void modifyChannels( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow, ChannelVector &channels );
 
-		struct Converter;
-
 	private :
 
 		static ColorSpaceTransformOp::ColorSpaceDescription<LinearToAlexaLogcOp> g_colorSpaceDescription;
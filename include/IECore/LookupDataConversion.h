@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef IE_CORE_LOOKUPDATACONVERSION_H
+#define IE_CORE_LOOKUPDATACONVERSION_H
+
+#include <vector>
+
+#include "boost/type_traits.hpp"
+
+#include "IECore/DataConversion.h"
+#include "IECore/Lookup.h"
+
+namespace IECore
+{
+
+/// Accelerates another DataConversion by tabulating its results over the range [min, max].
+/// For integral FromTypes the table holds the exact result for every value in the range. For
+/// floating point FromTypes the result is interpolated linearly between numSamples values
+/// spanning the range. Values outside the range are passed to the original conversion.
+template<typename C>
+class LookupDataConversion : public DataConversion< typename C::FromType, typename C::ToType >
+{
+	public:
+
+		typedef typename C::FromType FromType;
+		typedef typename C::ToType ToType;
+
+		/// numSamples is ignored for integral FromTypes, where the table has an entry for every
+		/// value in [min, max].
+		LookupDataConversion( const C &conversion = C(), FromType min = FromType( 0 ), FromType max = FromType( 1 ), unsigned numSamples = 16384 );
+
+		/// Perform the conversion
+		inline ToType operator()( FromType f ) const;
+
+	private :
+
+		void initTable( unsigned numSamples, boost::true_type isIntegral );
+		void initTable( unsigned numSamples, boost::false_type isIntegral );
+
+		inline ToType lookup( FromType f, boost::true_type isIntegral ) const;
+		inline ToType lookup( FromType f, boost::false_type isIntegral ) const;
+
+		struct Sampler;
+
+		C m_conversion;
+		FromType m_min;
+		FromType m_max;
+		// Used for integral FromTypes
+		std::vector<ToType> m_table;
+		// Used for floating point FromTypes
+		Lookupdd m_lookup;
+
+};
+
+/// Applies the conversion in place to the values in the range [begin, end). A LookupDataConversion
+/// over [min, max] is used when the range is long enough to amortise the cost of building the table,
+/// otherwise the conversion is applied directly.
+template<typename C, typename Iterator>
+void convertWithLookup( const C &conversion, Iterator begin, Iterator end, typename C::FromType min = typename C::FromType( 0 ), typename C::FromType max = typename C::FromType( 1 ) );
+
+/// As above, but converts every element of each TypedData in the range [begin, end), for instance
+/// all the channels of an image. A single table is shared between them, and is only built when
+/// their combined length is enough to amortise it.
+template<typename C, typename DataIterator>
+void convertDataWithLookup( const C &conversion, DataIterator begin, DataIterator end, typename C::FromType min = typename C::FromType( 0 ), typename C::FromType max = typename C::FromType( 1 ) );
+
+} // namespace IECore
+
+#include "LookupDataConversion.inl"
+
+#endif // IE_CORE_LOOKUPDATACONVERSION_H
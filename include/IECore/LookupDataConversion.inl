@@ -0,0 +1,174 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef IE_CORE_LOOKUPDATACONVERSION_INL
+#define IE_CORE_LOOKUPDATACONVERSION_INL
+
+#include <iterator>
+#include <algorithm>
+
+namespace IECore
+{
+
+template<typename C>
+struct LookupDataConversion<C>::Sampler
+{
+	Sampler( const C &conversion )
+		:	m_conversion( conversion )
+	{
+	}
+
+	double operator()( double x ) const
+	{
+		return double( m_conversion( FromType( x ) ) );
+	}
+
+	const C &m_conversion;
+};
+
+template<typename C>
+LookupDataConversion<C>::LookupDataConversion( const C &conversion, FromType min, FromType max, unsigned numSamples )
+	:	m_conversion( conversion ), m_min( min ), m_max( max )
+{
+	initTable( numSamples, typename boost::is_integral<FromType>::type() );
+}
+
+template<typename C>
+void LookupDataConversion<C>::initTable( unsigned numSamples, boost::true_type isIntegral )
+{
+	if( m_max < m_min )
+	{
+		return;
+	}
+
+	m_table.reserve( size_t( m_max - m_min ) + 1 );
+	for( FromType f = m_min; ; ++f )
+	{
+		m_table.push_back( m_conversion( f ) );
+		// checking before incrementing avoids overflow when m_max is the largest representable value
+		if( f == m_max )
+		{
+			break;
+		}
+	}
+}
+
+template<typename C>
+void LookupDataConversion<C>::initTable( unsigned numSamples, boost::false_type isIntegral )
+{
+	m_lookup.init( Sampler( m_conversion ), double( m_min ), double( m_max ), std::max( numSamples, 2u ) );
+}
+
+template<typename C>
+inline typename LookupDataConversion<C>::ToType LookupDataConversion<C>::operator()( FromType f ) const
+{
+	// written so that NaNs also fail the test and are passed to the original conversion
+	if( !( f >= m_min && f <= m_max ) )
+	{
+		return m_conversion( f );
+	}
+	return lookup( f, typename boost::is_integral<FromType>::type() );
+}
+
+template<typename C>
+inline typename LookupDataConversion<C>::ToType LookupDataConversion<C>::lookup( FromType f, boost::true_type isIntegral ) const
+{
+	return m_table[size_t( f - m_min )];
+}
+
+template<typename C>
+inline typename LookupDataConversion<C>::ToType LookupDataConversion<C>::lookup( FromType f, boost::false_type isIntegral ) const
+{
+	return ToType( m_lookup( double( f ) ) );
+}
+
+namespace Detail
+{
+
+// below this many values it is cheaper to apply a conversion directly than
+// to build a table first
+static const size_t g_minLookupSize = 65536;
+
+template<typename C, typename Iterator>
+void applyConversion( const C &conversion, Iterator begin, Iterator end )
+{
+	for( Iterator it = begin; it != end; ++it )
+	{
+		*it = conversion( *it );
+	}
+}
+
+} // namespace Detail
+
+template<typename C, typename Iterator>
+void convertWithLookup( const C &conversion, Iterator begin, Iterator end, typename C::FromType min, typename C::FromType max )
+{
+	if( size_t( std::distance( begin, end ) ) < Detail::g_minLookupSize )
+	{
+		Detail::applyConversion( conversion, begin, end );
+		return;
+	}
+
+	LookupDataConversion<C> lookupConversion( conversion, min, max );
+	Detail::applyConversion( lookupConversion, begin, end );
+}
+
+template<typename C, typename DataIterator>
+void convertDataWithLookup( const C &conversion, DataIterator begin, DataIterator end, typename C::FromType min, typename C::FromType max )
+{
+	size_t size = 0;
+	for( DataIterator it = begin; it != end; ++it )
+	{
+		size += (*it)->readable().size();
+	}
+
+	if( size < Detail::g_minLookupSize )
+	{
+		for( DataIterator it = begin; it != end; ++it )
+		{
+			Detail::applyConversion( conversion, (*it)->writable().begin(), (*it)->writable().end() );
+		}
+		return;
+	}
+
+	LookupDataConversion<C> lookupConversion( conversion, min, max );
+	for( DataIterator it = begin; it != end; ++it )
+	{
+		Detail::applyConversion( lookupConversion, (*it)->writable().begin(), (*it)->writable().end() );
+	}
+}
+
+} // namespace IECore
+
+#endif // IE_CORE_LOOKUPDATACONVERSION_INL
@@ -42,7 +42,9 @@
 #include "IECore/Export.h"
 #include "IECore/PrimitiveEvaluator.h"
 #include "IECore/MeshPrimitive.h"
+#include "IECore/MurmurHash.h"
 #include "IECore/BoundedKDTree.h"
+#include "IECore/BoundingVolumeHierarchy.h"
 
 namespace IECore
 {
@@ -104,13 +106,26 @@ class IECORE_API MeshPrimitiveEvaluator : public PrimitiveEvaluator
 
 		static PrimitiveEvaluatorPtr create( ConstPrimitivePtr primitive );
 
-		MeshPrimitiveEvaluator( ConstMeshPrimitivePtr mesh );
+		/// The acceleration structure used for closest point and ray queries may be chosen
+		/// using the accelerationStructure argument.
+		MeshPrimitiveEvaluator( ConstMeshPrimitivePtr mesh, AccelerationStructure accelerationStructure = BoundedKDTreeAcceleration );
 
 		virtual ~MeshPrimitiveEvaluator();
 
 		virtual ConstPrimitivePtr primitive() const;
 		MeshPrimitive::ConstPtr mesh() const;
 
+		/// Updates the evaluator to reflect a new version of the mesh, which must have the same
+		/// topology (as determined by MeshPrimitive::topologyHash()) as the current one - typically
+		/// the next frame of a deforming mesh. Rather than being rebuilt from scratch, the existing
+		/// acceleration structures are refitted to the new positions, and any cached normals are
+		/// recomputed without recomputing connectivity. Returns false, leaving the evaluator
+		/// unchanged, if the topology or the availability of uvs differs, in which case a new
+		/// evaluator must be constructed instead. Note that query performance degrades as the
+		/// mesh deforms further from its shape at construction.
+		/// \threading This can't be called while other threads are making queries.
+		bool updatePositions( ConstMeshPrimitivePtr mesh );
+
 		virtual PrimitiveEvaluator::ResultPtr createResult() const;
 
 		virtual void validateResult( PrimitiveEvaluator::Result *result ) const;
@@ -128,6 +143,29 @@ class IECORE_API MeshPrimitiveEvaluator : public PrimitiveEvaluator
 		/// A query specific to the MeshPrimitiveEvaluator, this just chooses a barycentric position on a specific triangle.
 		bool barycentricPosition( unsigned int triangleIndex, const Imath::V3f &barycentricCoordinates, PrimitiveEvaluator::Result *result ) const;
 
+		//! @name Batched queries
+		/// These perform many queries in a single call, distributing them across all available
+		/// threads using TBB. Rather than filling a Result per query they fill flat arrays, one
+		/// element per query, with the index and barycentric coordinates of the triangle found -
+		/// barycentricPosition() may subsequently be used to evaluate primitive variables from
+		/// these. Queries which fail are given a triangle index of -1, and the remaining outputs
+		/// for them are left untouched. Any of the output arrays may be passed as 0 if they are
+		/// not required.
+		//////////////////////////////////////////////////////////////////////////
+		//@{
+		/// Performs closestPoint() for each of the numPoints query points. The distances
+		/// array receives the distance from each query point to its closest point. The
+		/// resultPoints array may be the same as the points array, in which case the
+		/// query points are replaced with their closest points.
+		void closestPoints( const Imath::V3f *points, size_t numPoints, int *triangleIndices,
+			Imath::V3f *barycentricCoordinates, float *distances = 0, Imath::V3f *resultPoints = 0 ) const;
+		/// Performs intersectionPoint() for each of the numRays rays. The distances array
+		/// receives the distance from the origin of each ray to its intersection.
+		void rayIntersections( const Imath::V3f *origins, const Imath::V3f *directions, size_t numRays, int *triangleIndices,
+			Imath::V3f *barycentricCoordinates, float *distances = 0, Imath::V3f *resultPoints = 0,
+			float maxDistance = Imath::limits<float>::max() ) const;
+		//@}
+
 		virtual bool signedDistance( const Imath::V3f &p, float &distance ) const;
 
 		virtual float volume() const;
@@ -141,8 +179,8 @@ class IECORE_API MeshPrimitiveEvaluator : public PrimitiveEvaluator
 		const Imath::Box2f uvBound() const;
 
 		//! @name Internal KDTrees.
-		/// The MeshPrimitiveEvaluator uses internal KDTrees to perform many of
-		/// its queries. Const access is provided to these so that clients can use them
+		/// The MeshPrimitiveEvaluator uses internal KDTrees or BoundingVolumeHierarchies
+		/// to perform many of its queries. Const access is provided to these so that clients can use them
 		/// in implementing their own algorithms.
 		//////////////////////////////////////////////////////////////////////////
 		//@{
@@ -156,7 +194,14 @@ class IECORE_API MeshPrimitiveEvaluator : public PrimitiveEvaluator
 		const TriangleBoundVector *triangleBounds() const;
 		/// Returns a pointer to a tree that can be used for performing fast spacial queries.
 		///  The iterators in this tree point to elements in the vector returned by triangleBounds().
+		/// Returns 0 if the evaluator was constructed with BVHAcceleration.
 		const TriangleBoundTree *triangleBoundTree() const;
+		/// A BoundingVolumeHierarchy providing accelerated lookups of triangles using their bounding boxes.
+		typedef BoundingVolumeHierarchy<TriangleBoundVector::iterator> TriangleBVH;
+		/// Returns a pointer to a hierarchy that can be used for performing fast spatial queries.
+		/// The iterators in this hierarchy point to elements in the vector returned by triangleBounds().
+		/// Returns 0 unless the evaluator was constructed with BVHAcceleration.
+		const TriangleBVH *triangleBVH() const;
 		
 		/// A type for storing the uv bounding box for a triangle.
 		typedef Imath::Box2f UVBound;
@@ -178,9 +223,11 @@ class IECORE_API MeshPrimitiveEvaluator : public PrimitiveEvaluator
 		ConstMeshPrimitivePtr m_mesh;
 		ConstV3fVectorDataPtr m_verts;
 		const std::vector<int> *m_meshVertexIds;
+		MurmurHash m_topologyHash;
 
 		TriangleBoundVector m_triangles;
 		TriangleBoundTree *m_tree;
+		TriangleBVH *m_bvh;
 
 		UVBoundVector m_uvTriangles;		
 		UVBoundTree *m_uvTree;
@@ -190,8 +237,34 @@ class IECORE_API MeshPrimitiveEvaluator : public PrimitiveEvaluator
 		bool intersectionPointWalk( TriangleBoundTree::NodeIndex nodeIndex, const Imath::Line3f &ray, float &maxDistSqrd, Result *result, bool &hit ) const;
 		void intersectionPointsWalk( TriangleBoundTree::NodeIndex nodeIndex, const Imath::Line3f &ray, float maxDistSqrd, std::vector<PrimitiveEvaluator::ResultPtr> &results ) const;
 
+		/// Perform queries using whichever of m_tree and m_bvh is in use.
+		void closestPointQuery( const Imath::V3f &p, float &closestDistanceSqrd, Result *result ) const;
+		bool intersectionPointQuery( const Imath::Line3f &ray, float &maxDistSqrd, Result *result ) const;
+		void intersectionPointsQuery( const Imath::Line3f &ray, float maxDistSqrd, std::vector<PrimitiveEvaluator::ResultPtr> &results ) const;
+
+		/// Test the triangles in a leaf of m_tree or m_bvh.
+		void closestPointLeaf( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, const Imath::V3f &p, float &closestDistanceSqrd, Result *result ) const;
+		bool intersectionPointLeaf( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, const Imath::Line3f &ray, float &maxDistSqrd, Result *result ) const;
+		void intersectionPointsLeaf( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, const Imath::Line3f &ray, float maxDistSqrd, std::vector<PrimitiveEvaluator::ResultPtr> &results ) const;
+
+		struct ClosestPointLeafFn;
+		struct IntersectionPointLeafFn;
+		struct IntersectionPointsLeafFn;
+
+		struct ClosestPointsFn;
+		struct RayIntersectionsFn;
+
+		/// Sets m_mesh to a copy of mesh, and initialises the members which
+		/// reference its primitive variables.
+		void initMesh( ConstMeshPrimitivePtr mesh );
+		/// Computes m_triangles and m_uvTriangles from the current mesh.
+		void calculateTriangleBounds();
+
 		void calculateMassProperties() const;
 		void calculateAverageNormals() const;
+		/// Recomputes m_vertexAngleWeightedNormals and m_edgeAverageNormals from the current
+		/// positions, using the edges already stored in m_edgeAverageNormals by calculateAverageNormals().
+		void updateAverageNormals() const;
 		
 		void triangleUVs( size_t triangleIndex, const Imath::V3i &vertexIds, Imath::V2f uv[3] ) const;
 		PrimitiveVariable m_u;
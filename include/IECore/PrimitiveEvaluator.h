@@ -62,6 +62,17 @@ class IECORE_API PrimitiveEvaluator : public RunTimeTyped
 
 		IE_CORE_DECLARERUNTIMETYPED( PrimitiveEvaluator, RunTimeTyped );
 
+		/// The spatial hierarchies which may be used to accelerate queries. Derived classes
+		/// which build such a hierarchy may accept one of these at construction.
+		enum AccelerationStructure
+		{
+			/// A BoundedKDTree, split at the median of the primitive bounds.
+			BoundedKDTreeAcceleration,
+			/// A BoundingVolumeHierarchy, split using the surface area heuristic. This
+			/// is typically faster to query, particularly for unevenly tessellated geometry.
+			BVHAcceleration
+		};
+
 		/// An interface defining the possible results returned from a query. Attempting to read back the results of a failed
 		/// query will yield undefined behaviour.
 		/// \threading Implementations should ensure that it's safe to call multiple Result methods concurrently.
@@ -132,6 +132,11 @@ class IECORE_API SceneCache : public SampledSceneInterface
 		virtual SceneInterfacePtr scene( const Path &path, MissingBehaviour missingBehaviour = ThrowIfMissing );
 		virtual ConstSceneInterfacePtr scene( const Path &path, SceneInterface::MissingBehaviour missingBehaviour = ThrowIfMissing ) const;
 		
+		/// Queues the reading of objects and transforms on a background task, which runs the
+		/// reads in parallel and stores the results in the same caches used by readObject() and
+		/// readTransform(). Has no effect on files opened for writing.
+		virtual void prefetch( const std::vector<Path> &paths, const std::vector<double> &times ) const;
+
 		virtual void hash( HashType hashType, double time, MurmurHash &h ) const;
 
 		/// tells you if this scene cache is read only or writable:
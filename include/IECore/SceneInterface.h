@@ -243,6 +243,16 @@ class IECORE_API SceneInterface : public RunTimeTyped
 		/// Returns a const interface for querying the scene at the given path (full path). 
 		virtual ConstSceneInterfacePtr scene( const Path &path, MissingBehaviour missingBehaviour = ThrowIfMissing ) const = 0;
 
+		/*
+		 * Prefetch
+		 */
+
+		/// Hints that the objects and transforms at the given locations (full paths) will soon be read
+		/// at the given times, so that implementations may start loading them in the background. The
+		/// function returns immediately, and the results are obtained with the usual read methods.
+		/// The base class implementation does nothing.
+		virtual void prefetch( const std::vector<Path> &paths, const std::vector<double> &times ) const;
+
 		/*
 		 * Hash
 		 */
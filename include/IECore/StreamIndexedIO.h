@@ -39,6 +39,7 @@
 #include <iostream>
 #include <fstream>
 #include "tbb/recursive_mutex.h"
+#include "tbb/enumerable_thread_specific.h"
 #include "boost/optional.hpp"
 #include "boost/iostreams/filtering_stream.hpp"
 
@@ -95,6 +96,13 @@ class IECORE_API StreamIndexedIO : public IndexedIO
 
 		void commit();
 
+		/// Loads the index for the whole hierarchy below the current directory, so that
+		/// later traversals don't have to wait for subindexes to be read from the file.
+		/// Subindexes are decompressed and parsed in parallel. If wait is false, the
+		/// loading happens in the background and the function returns immediately.
+		/// Has no effect unless the file is opened for reading.
+		void prefetchIndex( bool wait = true ) const;
+
 		void write(const IndexedIO::EntryID &name, const float *x, unsigned long arrayLength);
 		void write(const IndexedIO::EntryID &name, const double *x, unsigned long arrayLength);
 		void write(const IndexedIO::EntryID &name, const half *x, unsigned long arrayLength);
@@ -167,6 +175,16 @@ class IECORE_API StreamIndexedIO : public IndexedIO
 				void seekp( size_t pos, std::ios_base::seekdir dir );
 				void read( char *buffer, size_t size );
 				void write( const char *buffer, size_t size );
+				/// Reads size bytes starting at the absolute position pos, without affecting the
+				/// current stream position. This function is thread safe - the default implementation
+				/// serialises on mutex(), but derived classes may override it with positional reads
+				/// that allow concurrent access to different parts of the file.
+				virtual void read( char *buffer, size_t size, size_t pos );
+				/// Returns a pointer to size bytes of the file starting at the absolute position pos.
+				/// The default implementation reads the data into threadIOBuffer(), but memory mapped
+				/// files return a pointer straight into the mapping. Thread safe, and the
+				/// pointer remains valid until the next call to threadIOBuffer() from the same thread.
+				virtual const char *readBuffer( size_t size, size_t pos );
 				Imf::Int64 tellg();
 				Imf::Int64 tellp();
 
@@ -180,6 +198,10 @@ class IECORE_API StreamIndexedIO : public IndexedIO
 				// utility function that returns a temporary buffer for io operations (not thread safe).
 				char *ioBuffer( unsigned long size );
 
+				// utility function that returns a temporary buffer owned by the calling thread.
+				// Used by the read operations, so that concurrent reads never share storage.
+				char *threadIOBuffer( unsigned long size );
+
 				/// called after the main index is saved to disk, ready to close the file.
 				virtual void flush( size_t endPosition );
 
@@ -198,6 +220,9 @@ class IECORE_API StreamIndexedIO : public IndexedIO
 
 				unsigned long m_ioBufferLen;
 				char *m_ioBuffer;
+
+				typedef tbb::enumerable_thread_specific< std::vector<char> > ThreadIOBuffers;
+				ThreadIOBuffers m_threadIOBuffers;
 		};
 		IE_CORE_DECLAREPTR( StreamFile );
 
@@ -130,9 +130,11 @@ class IECORE_API TIFFImageReader : public ImageReader
 		bool m_haveDirectory;
 
 		std::vector<unsigned char> m_buffer;
+		Imath::Box2i m_bufferWindow;
 
-		// Reads the interlaced data from the current directory into the buffer
-		void readBuffer();
+		// Reads the interlaced data for the specified region of the current directory into the buffer,
+		// decoding only the tiles or strips which overlap it.
+		void readBuffer( const Imath::Box2i &region );
 
 		Imath::Box2i m_displayWindow;
 		Imath::Box2i m_dataWindow;
@@ -38,6 +38,7 @@
 #include "IECore/Export.h"
 #include "IECore/TypedPrimitiveOp.h"
 #include "IECore/NumericParameter.h"
+#include "IECore/SimpleTypedParameter.h"
 
 namespace IECore
 {
@@ -47,6 +48,10 @@ namespace IECore
 /// The display window does not change in this process, but the data window may change.
 /// The mapping is determined by the derived classes. The base class is responsible for resizing the
 /// data window and applying filter on the colors based on the floating point positions returned by warp method.
+/// The positions and filter weights are computed once per operation into a warp map, which is then applied
+/// to all channels. If the cacheWarpMap parameter is on, the map is kept and reused by subsequent operations
+/// for which all parameters other than the input are unchanged, and for which the input image has the same
+/// data and display windows - this is useful when processing sequences of frames with the same warp.
 /// \ingroup imageProcessingGroup
 class IECORE_API WarpOp : public ImagePrimitiveOp
 {
@@ -61,6 +66,9 @@ class IECORE_API WarpOp : public ImagePrimitiveOp
 		IntParameter * filterParameter();
 		const IntParameter * filterParameter() const;
 
+		BoolParameter * cacheWarpMapParameter();
+		const BoolParameter * cacheWarpMapParameter() const;
+
 		IE_CORE_DECLARERUNTIMETYPED( WarpOp, ImagePrimitiveOp );
 
 	protected :
@@ -79,7 +87,7 @@ class IECORE_API WarpOp : public ImagePrimitiveOp
 		/// Called once per element (pixel for ImagePrimitives).
 		/// Must be implemented by subclasses to determine where the color will come from.
 		/// The returned coordinate is on pixel space of the input image and the given V2f coordinates are on the
-		/// output image pixel space.
+		/// output image pixel space. This may be called concurrently from several threads.
 		virtual Imath::V2f warp( const Imath::V2f &p ) const = 0;
 		/// Called once per operation, after all calls to transform() have been made. This is
 		/// an opportunity to perform any cleanup necessary.
@@ -89,6 +97,17 @@ class IECORE_API WarpOp : public ImagePrimitiveOp
 
 		IntParameterPtr m_filterParameter;
 		IntParameterPtr m_boundModeParameter;
+		BoolParameterPtr m_cacheWarpMapParameter;
+
+		IE_CORE_FORWARDDECLARE( WarpMap );
+		WarpMapPtr m_warpMap;
+
+		/// Returns the warp map for the image, either computing it using begin(), warpedDataWindow(),
+		/// warp() and end(), or returning m_warpMap if it is suitable.
+		ConstWarpMapPtr warpMap( const ImagePrimitive *image, const CompoundObject *operands );
+
+		struct ComputeWarpMap;
+		friend struct ComputeWarpMap;
 		struct Warp;
 		friend struct Warp;
 };
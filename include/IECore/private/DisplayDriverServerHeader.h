@@ -35,6 +35,10 @@
 #ifndef IE_CORE_DISPLAYDRIVERSERVERHEADER
 #define IE_CORE_DISPLAYDRIVERSERVERHEADER
 
+#include <vector>
+
+#include "OpenEXR/ImathBox.h"
+
 #include "IECore/DisplayDriverServer.h"
 
 namespace IECore
@@ -43,22 +47,29 @@ namespace IECore
 /* Header block used by back and forth messages with the server.
 * 7 bytes long:
 * [0] - magic number ( 0x82 )
-* [1] - protocol version ( 1 )
-* [2] - message type ( imageOpen, imageData, imageClose )
+* [1] - protocol version ( 1 or 2 )
+* [2] - message type ( imageOpen, imageData, imageClose, exception, imageDataBucket )
 * [3-6] - length of following data block.
+*
+* Version 2 of the protocol adds the imageDataBucket message, which is sent in place of
+* imageData. Servers which only understand version 1 reject any other version outright, so
+* clients send imageOpen as version 1, with a "clientProtocolVersion" IntData in its parameters
+* giving the highest version they support. The server replies to imageOpen using the highest
+* version both support, which the client then uses for the rest of the session. Servers which
+* predate version 2 ignore the parameter and reply with version 1.
 */
 class DisplayDriverServerHeader
 {
 	public:
 
-		enum MessageType { imageOpen = 1, imageData = 2, imageClose = 3, exception = 4 };
+		enum MessageType { imageOpen = 1, imageData = 2, imageClose = 3, exception = 4, imageDataBucket = 5 };
 
 		static const unsigned char headerLength = 7;
 		static const unsigned char magicNumber = 0x82;
-		static const unsigned char currentProtocolVersion = 1;
+		static const unsigned char currentProtocolVersion = 2;
 
 		DisplayDriverServerHeader();
-		DisplayDriverServerHeader( MessageType msg, size_t dataSize );
+		DisplayDriverServerHeader( MessageType msg, size_t dataSize, unsigned char protocolVersion = currentProtocolVersion );
 
 		// returns internal buffer ( length = headerLength constant )
 		unsigned char *buffer();
@@ -75,6 +86,37 @@ class DisplayDriverServerHeader
 		// returns the message type defined in the header.
 		MessageType messageType();
 
+		// returns the protocol version defined in the header.
+		unsigned char protocolVersion();
+
+		/* Data block following an imageDataBucket header.
+		* [0-15] - box min.x, min.y, max.x and max.y as little endian 32 bit integers.
+		* [16] - encoding of the pixel data ( see BucketEncoding ).
+		* [17-19] - unused, so that the pixel data is aligned for reading in place.
+		* [20-] - interleaved pixel data, in little endian byte order.
+		*/
+		enum BucketEncoding { floatBucket = 0, halfBucket = 1, compressedFloatBucket = 2, compressedHalfBucket = 3 };
+
+		static const unsigned char bucketHeaderLength = 20;
+
+		// writes the bucket header into dst, which must have room for bucketHeaderLength bytes.
+		static void writeBucketHeader( const Imath::Box2i &box, BucketEncoding encoding, char *dst );
+
+		// reads a bucket header written by writeBucketHeader(), returning false if it is invalid.
+		static bool readBucketHeader( const char *src, Imath::Box2i &box, BucketEncoding &encoding );
+
+		// encodes numValues floats as pixel data for a bucket.
+		static void encodeBucketData( const float *data, size_t numValues, BucketEncoding encoding, std::vector<char> &encoded );
+
+		// returns the largest number of values that size bytes of pixel data could decode to.
+		static size_t maxBucketValues( size_t size, BucketEncoding encoding );
+
+		// decodes size bytes of pixel data, which must contain exactly numValues floats once decoded.
+		// Throws if numValues is more than maxBucketValues( size, encoding ).
+		// Uncompressed float data is returned in place where possible, otherwise it is decoded
+		// into decoded and a pointer to that is returned.
+		static const float *decodeBucketData( const char *data, size_t size, size_t numValues, BucketEncoding encoding, std::vector<float> &decoded );
+
 	private:
 
 		unsigned char m_header[ headerLength ];
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef IECORE_PARALLELIMAGEROWS_H
+#define IECORE_PARALLELIMAGEROWS_H
+
+#include "OpenEXR/ImathBox.h"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
+namespace IECore
+{
+
+namespace Detail
+{
+
+template<typename RowFunctor>
+struct ParallelImageRows
+{
+	ParallelImageRows( size_t numChannels, const RowFunctor &f )
+		:	m_numChannels( numChannels ), m_f( f )
+	{
+	}
+
+	void operator()( const tbb::blocked_range<int> &r ) const
+	{
+		for( size_t c = 0; c < m_numChannels; ++c )
+		{
+			m_f( r.begin(), r.end(), c );
+		}
+	}
+
+	size_t m_numChannels;
+	const RowFunctor &m_f;
+};
+
+} // namespace Detail
+
+/// Processes the rows of an image in parallel, for ops which treat each row of each of
+/// a set of planar channels independently. The rows of dataWindow are divided into blocks
+/// which are distributed between threads, and each block is processed by calling
+/// f( yBegin, yEnd, channelIndex ) for every channel in turn, with yEnd being exclusive.
+/// Processing all the channels of a block together keeps any data they share, such as an
+/// alpha channel, in cache. RowFunctor::operator() must be const and safe to call concurrently.
+template<typename RowFunctor>
+void parallelForImageRows( const Imath::Box2i &dataWindow, size_t numChannels, const RowFunctor &f )
+{
+	if( dataWindow.isEmpty() || !numChannels )
+	{
+		return;
+	}
+
+	tbb::parallel_for(
+		tbb::blocked_range<int>( dataWindow.min.y, dataWindow.max.y + 1 ),
+		Detail::ParallelImageRows<RowFunctor>( numChannels, f )
+	);
+}
+
+} // namespace IECore
+
+#endif // IECORE_PARALLELIMAGEROWS_H
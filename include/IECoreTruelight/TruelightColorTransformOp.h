@@ -75,6 +75,8 @@ class TruelightColorTransformOp : public IECore::ColorTransformOp
 
 		virtual void begin( const IECore::CompoundObject * operands );
 		virtual void transform( Imath::Color3f &color ) const;
+		/// Returns false, as the truelight instance can't be shared between threads.
+		virtual bool canTransformConcurrently() const;
 
 	private :
 
@@ -33,9 +33,8 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECore/AlexaLogcToLinearOp.h"
-#include "IECore/TypeTraits.h"
-#include "IECore/DespatchTypedData.h"
 #include "IECore/AlexaLogcToLinearDataConversion.h"
+#include "IECore/LookupDataConversion.h"
 
 using namespace IECore;
 using namespace std;
@@ -54,30 +53,7 @@ AlexaLogcToLinearOp::~AlexaLogcToLinearOp()
 {
 }
 
-struct AlexaLogcToLinearOp::Converter
-{
-	typedef void ReturnType;
-
-	template<typename T>
-	ReturnType operator()( T * data )
-	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type V;
-		typedef typename Container::iterator It;
-		AlexaLogcToLinearDataConversion< V, V > converter;
-		It end = data->writable().end();
-		for ( It it = data->writable().begin(); it != end; it++ )
-		{
-			*it = converter( *it );
-		}
-	}
-};
-
 void AlexaLogcToLinearOp::modifyChannels( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow, ChannelVector &channels )
 {
-	AlexaLogcToLinearOp::Converter converter;
-	for ( ChannelVector::iterator it = channels.begin(); it != channels.end(); it++ )
-	{
-		despatchTypedData<AlexaLogcToLinearOp::Converter, TypeTraits::IsFloatVectorTypedData>( it->get(), converter );
-	}
+	convertDataWithLookup( AlexaLogcToLinearDataConversion<float, float>(), channels.begin(), channels.end() );
 }
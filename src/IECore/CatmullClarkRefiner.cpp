@@ -0,0 +1,862 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "boost/format.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/mpl/and.hpp"
+#include "boost/mpl/not.hpp"
+#include "boost/mpl/or.hpp"
+#include "boost/type_traits/is_floating_point.hpp"
+#include "boost/type_traits/is_same.hpp"
+#include "boost/utility/enable_if.hpp"
+
+#include "tbb/atomic.h"
+#include "tbb/blocked_range.h"
+#include "tbb/mutex.h"
+#include "tbb/parallel_for.h"
+
+#include "IECore/CatmullClarkRefiner.h"
+#include "IECore/DataAlgo.h"
+#include "IECore/DespatchTypedData.h"
+#include "IECore/Exception.h"
+#include "IECore/LRUCache.h"
+#include "IECore/MessageHandler.h"
+#include "IECore/TypeTraits.h"
+
+using namespace std;
+using namespace IECore;
+
+//////////////////////////////////////////////////////////////////////////
+// Internal utilities
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Vector data which we know how to refine. We exclude BoolVectorData
+/// because the elements of std::vector<bool> can't be written safely
+/// from concurrent threads.
+template<typename T>
+struct IsRefinable : boost::mpl::and_<
+	TypeTraits::IsVectorTypedData<T>,
+	boost::mpl::not_< boost::is_same< typename TypeTraits::VectorValueType<T>::type, bool > >
+>
+{
+};
+
+/// Types which are refined by taking weighted sums. All other types take
+/// the value of the most heavily weighted source.
+template<typename T>
+struct IsInterpolable : boost::mpl::or_<
+	boost::is_floating_point<T>,
+	boost::is_same<T, half>,
+	TypeTraits::IsFloatVec2<T>,
+	TypeTraits::IsFloatVec3<T>,
+	TypeTraits::IsColor<T>
+>
+{
+};
+
+template<typename T, typename Enable = void>
+class StencilFn
+{
+
+	public :
+
+		StencilFn( const vector<int> &offsets, const vector<int> &indices, const vector<float> &weights, const vector<T> &source, vector<T> &destination )
+			:	m_offsets( offsets ), m_indices( indices ), m_weights( weights ), m_source( source ), m_destination( destination )
+		{
+		}
+
+		void operator()( const tbb::blocked_range<size_t> &range ) const
+		{
+			for( size_t i = range.begin(); i != range.end(); ++i )
+			{
+				const int first = m_offsets[i];
+				const int last = m_offsets[i+1];
+				if( first == last )
+				{
+					continue;
+				}
+				int best = first;
+				for( int j = first + 1; j < last; ++j )
+				{
+					if( m_weights[j] > m_weights[best] )
+					{
+						best = j;
+					}
+				}
+				m_destination[i] = m_source[m_indices[best]];
+			}
+		}
+
+	private :
+
+		const vector<int> &m_offsets;
+		const vector<int> &m_indices;
+		const vector<float> &m_weights;
+		const vector<T> &m_source;
+		vector<T> &m_destination;
+
+};
+
+template<typename T>
+class StencilFn<T, typename boost::enable_if<IsInterpolable<T> >::type>
+{
+
+	public :
+
+		StencilFn( const vector<int> &offsets, const vector<int> &indices, const vector<float> &weights, const vector<T> &source, vector<T> &destination )
+			:	m_offsets( offsets ), m_indices( indices ), m_weights( weights ), m_source( source ), m_destination( destination )
+		{
+		}
+
+		void operator()( const tbb::blocked_range<size_t> &range ) const
+		{
+			for( size_t i = range.begin(); i != range.end(); ++i )
+			{
+				T result( 0 );
+				const int last = m_offsets[i+1];
+				for( int j = m_offsets[i]; j < last; ++j )
+				{
+					result += m_source[m_indices[j]] * m_weights[j];
+				}
+				m_destination[i] = result;
+			}
+		}
+
+	private :
+
+		const vector<int> &m_offsets;
+		const vector<int> &m_indices;
+		const vector<float> &m_weights;
+		const vector<T> &m_source;
+		vector<T> &m_destination;
+
+};
+
+/// Used when sorting the edges of each face, so as to find
+/// the faces which share each edge.
+struct FaceEdge
+{
+	FaceEdge( int a, int b, int fv )
+		:	v0( std::min( a, b ) ), v1( std::max( a, b ) ), faceVertex( fv )
+	{
+	}
+
+	bool operator < ( const FaceEdge &other ) const
+	{
+		if( v0 != other.v0 )
+		{
+			return v0 < other.v0;
+		}
+		if( v1 != other.v1 )
+		{
+			return v1 < other.v1;
+		}
+		return faceVertex < other.faceVertex;
+	}
+
+	int v0;
+	int v1;
+	int faceVertex;
+};
+
+/// Converts per-element counts into offsets in place, appending the total.
+void countsToOffsets( vector<int> &counts )
+{
+	int offset = 0;
+	for( vector<int>::iterator it = counts.begin(); it != counts.end(); ++it )
+	{
+		const int count = *it;
+		*it = offset;
+		offset += count;
+	}
+	counts.push_back( offset );
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////
+// Stencils
+//////////////////////////////////////////////////////////////////////////
+
+CatmullClarkRefiner::Stencils::Stencils()
+{
+	offsets.push_back( 0 );
+}
+
+void CatmullClarkRefiner::Stencils::setIdentity( size_t numValues )
+{
+	offsets.resize( numValues + 1 );
+	indices.resize( numValues );
+	weights.resize( numValues );
+	for( size_t i = 0; i < numValues; ++i )
+	{
+		offsets[i] = i;
+		indices[i] = i;
+		weights[i] = 1.0f;
+	}
+	offsets[numValues] = numValues;
+}
+
+void CatmullClarkRefiner::Stencils::addWeight( int index, float weight )
+{
+	indices.push_back( index );
+	weights.push_back( weight );
+}
+
+void CatmullClarkRefiner::Stencils::endRow()
+{
+	offsets.push_back( indices.size() );
+}
+
+size_t CatmullClarkRefiner::Stencils::numRows() const
+{
+	return offsets.size() - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Level
+//////////////////////////////////////////////////////////////////////////
+
+/// The topology of a single level of refinement.
+struct CatmullClarkRefiner::Level
+{
+
+	int numVertices;
+	vector<int> verticesPerFace;
+	vector<int> vertexIds;
+
+	/// Computes the topology of the next level of refinement, along with stencils
+	/// expressing its values in terms of the values of this level. Refined vertices are
+	/// numbered with the vertex points first, so that they keep the indices of their
+	/// parents, followed by the edge points and then the face points.
+	void refine( Level &refined, Stencils &vertexStencils, Stencils &varyingStencils, Stencils &faceVaryingStencils, Stencils &uniformStencils ) const
+	{
+		const int numFaces = verticesPerFace.size();
+		const int numFaceVertices = vertexIds.size();
+
+		vector<int> faceOffsets( verticesPerFace );
+		countsToOffsets( faceOffsets );
+
+		vector<int> faceVertexFaces( numFaceVertices );
+		for( int f = 0; f < numFaces; ++f )
+		{
+			std::fill( faceVertexFaces.begin() + faceOffsets[f], faceVertexFaces.begin() + faceOffsets[f+1], f );
+		}
+
+		// Find the edges, and the faces adjacent to each. Each face vertex
+		// is the start of an edge running to the next vertex in the face.
+
+		vector<FaceEdge> faceEdges;
+		faceEdges.reserve( numFaceVertices );
+		for( int f = 0; f < numFaces; ++f )
+		{
+			const int first = faceOffsets[f];
+			const int n = verticesPerFace[f];
+			for( int i = 0; i < n; ++i )
+			{
+				faceEdges.push_back( FaceEdge( vertexIds[first+i], vertexIds[first+(i+1)%n], first + i ) );
+			}
+		}
+		std::sort( faceEdges.begin(), faceEdges.end() );
+
+		vector<int> edgeVertices;
+		vector<int> edgeFaceOffsets;
+		vector<int> edgeFaces;
+		vector<int> faceVertexEdges( numFaceVertices );
+		edgeFaces.reserve( numFaceVertices );
+		for( vector<FaceEdge>::const_iterator it = faceEdges.begin(); it != faceEdges.end(); ++it )
+		{
+			if( it == faceEdges.begin() || it->v0 != (it-1)->v0 || it->v1 != (it-1)->v1 )
+			{
+				edgeVertices.push_back( it->v0 );
+				edgeVertices.push_back( it->v1 );
+				edgeFaceOffsets.push_back( edgeFaces.size() );
+			}
+			edgeFaces.push_back( faceVertexFaces[it->faceVertex] );
+			faceVertexEdges[it->faceVertex] = edgeFaceOffsets.size() - 1;
+		}
+		edgeFaceOffsets.push_back( edgeFaces.size() );
+		const int numEdges = edgeVertices.size() / 2;
+
+		// Find the faces and edges adjacent to each vertex.
+
+		vector<int> vertexFaceOffsets( numVertices, 0 );
+		for( int i = 0; i < numFaceVertices; ++i )
+		{
+			vertexFaceOffsets[vertexIds[i]]++;
+		}
+		countsToOffsets( vertexFaceOffsets );
+		vector<int> vertexFaces( numFaceVertices );
+		{
+			vector<int> next( vertexFaceOffsets.begin(), vertexFaceOffsets.end() - 1 );
+			for( int i = 0; i < numFaceVertices; ++i )
+			{
+				vertexFaces[next[vertexIds[i]]++] = faceVertexFaces[i];
+			}
+		}
+
+		vector<int> vertexEdgeOffsets( numVertices, 0 );
+		for( int e = 0; e < numEdges; ++e )
+		{
+			vertexEdgeOffsets[edgeVertices[e*2]]++;
+			vertexEdgeOffsets[edgeVertices[e*2+1]]++;
+		}
+		countsToOffsets( vertexEdgeOffsets );
+		vector<int> vertexEdges( numEdges * 2 );
+		{
+			vector<int> next( vertexEdgeOffsets.begin(), vertexEdgeOffsets.end() - 1 );
+			for( int e = 0; e < numEdges; ++e )
+			{
+				vertexEdges[next[edgeVertices[e*2]]++] = e;
+				vertexEdges[next[edgeVertices[e*2+1]]++] = e;
+			}
+		}
+
+		// Vertex points
+
+		for( int v = 0; v < numVertices; ++v )
+		{
+			const int numAdjacentFaces = vertexFaceOffsets[v+1] - vertexFaceOffsets[v];
+			const int numAdjacentEdges = vertexEdgeOffsets[v+1] - vertexEdgeOffsets[v];
+
+			int numBoundaryEdges = 0;
+			int boundaryNeighbours[2] = { v, v };
+			for( int i = vertexEdgeOffsets[v]; i < vertexEdgeOffsets[v+1]; ++i )
+			{
+				const int e = vertexEdges[i];
+				if( edgeFaceOffsets[e+1] - edgeFaceOffsets[e] != 2 )
+				{
+					if( numBoundaryEdges < 2 )
+					{
+						boundaryNeighbours[numBoundaryEdges] = edgeVertices[e*2] == v ? edgeVertices[e*2+1] : edgeVertices[e*2];
+					}
+					numBoundaryEdges++;
+				}
+			}
+
+			if( numAdjacentFaces == 0 )
+			{
+				vertexStencils.addWeight( v, 1.0f );
+			}
+			else if( numBoundaryEdges == 0 )
+			{
+				// Smooth vertex - ( Q + 2R + ( n - 3 ) S ) / n, where Q is the average of the
+				// adjacent face points, R the average of the adjacent edge midpoints and S the
+				// original vertex.
+				const float n = numAdjacentEdges;
+				vertexStencils.addWeight( v, ( n - 3.0f ) / n );
+				const float edgeWeight = 1.0f / ( n * n );
+				for( int i = vertexEdgeOffsets[v]; i < vertexEdgeOffsets[v+1]; ++i )
+				{
+					const int e = vertexEdges[i];
+					vertexStencils.addWeight( edgeVertices[e*2], edgeWeight );
+					vertexStencils.addWeight( edgeVertices[e*2+1], edgeWeight );
+				}
+				for( int i = vertexFaceOffsets[v]; i < vertexFaceOffsets[v+1]; ++i )
+				{
+					const int f = vertexFaces[i];
+					const float faceWeight = 1.0f / ( n * numAdjacentFaces * verticesPerFace[f] );
+					for( int j = faceOffsets[f]; j < faceOffsets[f+1]; ++j )
+					{
+						vertexStencils.addWeight( vertexIds[j], faceWeight );
+					}
+				}
+			}
+			else if( numBoundaryEdges == 2 && numAdjacentFaces > 1 )
+			{
+				// Crease vertex
+				vertexStencils.addWeight( v, 0.75f );
+				vertexStencils.addWeight( boundaryNeighbours[0], 0.125f );
+				vertexStencils.addWeight( boundaryNeighbours[1], 0.125f );
+			}
+			else
+			{
+				// Corner vertex
+				vertexStencils.addWeight( v, 1.0f );
+			}
+			vertexStencils.endRow();
+
+			varyingStencils.addWeight( v, 1.0f );
+			varyingStencils.endRow();
+		}
+
+		// Edge points
+
+		for( int e = 0; e < numEdges; ++e )
+		{
+			const int v0 = edgeVertices[e*2];
+			const int v1 = edgeVertices[e*2+1];
+			if( edgeFaceOffsets[e+1] - edgeFaceOffsets[e] == 2 && v0 != v1 )
+			{
+				// Smooth edge - the average of the end points and
+				// the adjacent face points.
+				vertexStencils.addWeight( v0, 0.25f );
+				vertexStencils.addWeight( v1, 0.25f );
+				for( int i = edgeFaceOffsets[e]; i < edgeFaceOffsets[e+1]; ++i )
+				{
+					const int f = edgeFaces[i];
+					const float faceWeight = 0.25f / verticesPerFace[f];
+					for( int j = faceOffsets[f]; j < faceOffsets[f+1]; ++j )
+					{
+						vertexStencils.addWeight( vertexIds[j], faceWeight );
+					}
+				}
+			}
+			else
+			{
+				// Crease edge
+				vertexStencils.addWeight( v0, 0.5f );
+				vertexStencils.addWeight( v1, 0.5f );
+			}
+			vertexStencils.endRow();
+
+			varyingStencils.addWeight( v0, 0.5f );
+			varyingStencils.addWeight( v1, 0.5f );
+			varyingStencils.endRow();
+		}
+
+		// Face points
+
+		for( int f = 0; f < numFaces; ++f )
+		{
+			const float weight = 1.0f / verticesPerFace[f];
+			for( int j = faceOffsets[f]; j < faceOffsets[f+1]; ++j )
+			{
+				vertexStencils.addWeight( vertexIds[j], weight );
+				varyingStencils.addWeight( vertexIds[j], weight );
+			}
+			vertexStencils.endRow();
+			varyingStencils.endRow();
+		}
+
+		// Refined faces. Each face is split into a quad per corner, running from the
+		// corner to the following edge point, the face point and the preceding edge point.
+
+		refined.numVertices = numVertices + numEdges + numFaces;
+		refined.verticesPerFace.assign( numFaceVertices, 4 );
+		refined.vertexIds.clear();
+		refined.vertexIds.reserve( numFaceVertices * 4 );
+		for( int f = 0; f < numFaces; ++f )
+		{
+			const int first = faceOffsets[f];
+			const int n = verticesPerFace[f];
+			const float faceWeight = 1.0f / n;
+			for( int i = 0; i < n; ++i )
+			{
+				const int corner = first + i;
+				const int next = first + ( i + 1 ) % n;
+				const int previous = first + ( i + n - 1 ) % n;
+
+				refined.vertexIds.push_back( vertexIds[corner] );
+				refined.vertexIds.push_back( numVertices + faceVertexEdges[corner] );
+				refined.vertexIds.push_back( numVertices + numEdges + f );
+				refined.vertexIds.push_back( numVertices + faceVertexEdges[previous] );
+
+				faceVaryingStencils.addWeight( corner, 1.0f );
+				faceVaryingStencils.endRow();
+
+				faceVaryingStencils.addWeight( corner, 0.5f );
+				faceVaryingStencils.addWeight( next, 0.5f );
+				faceVaryingStencils.endRow();
+
+				for( int j = first; j < first + n; ++j )
+				{
+					faceVaryingStencils.addWeight( j, faceWeight );
+				}
+				faceVaryingStencils.endRow();
+
+				faceVaryingStencils.addWeight( previous, 0.5f );
+				faceVaryingStencils.addWeight( corner, 0.5f );
+				faceVaryingStencils.endRow();
+
+				uniformStencils.addWeight( f, 1.0f );
+				uniformStencils.endRow();
+			}
+		}
+	}
+
+};
+
+//////////////////////////////////////////////////////////////////////////
+// ApplyStencils
+//////////////////////////////////////////////////////////////////////////
+
+struct CatmullClarkRefiner::ApplyStencils
+{
+	typedef DataPtr ReturnType;
+
+	ApplyStencils( const Stencils &stencils, size_t expectedSize )
+		:	m_stencils( stencils ), m_expectedSize( expectedSize )
+	{
+	}
+
+	template<typename T>
+	ReturnType operator()( const T *data ) const
+	{
+		typedef typename T::ValueType::value_type ValueType;
+
+		const typename T::ValueType &source = data->readable();
+		if( source.size() != m_expectedSize )
+		{
+			throw InvalidArgumentException(
+				boost::str( boost::format( "CatmullClarkRefiner : Primitive variable has %d elements but %d were expected." ) % source.size() % m_expectedSize )
+			);
+		}
+
+		typename T::Ptr result = new T;
+		typename T::ValueType &destination = result->writable();
+		destination.resize( m_stencils.numRows() );
+		setGeometricInterpretation( result.get(), getGeometricInterpretation( data ) );
+
+		tbb::parallel_for(
+			tbb::blocked_range<size_t>( 0, destination.size() ),
+			StencilFn<ValueType>( m_stencils.offsets, m_stencils.indices, m_stencils.weights, source, destination )
+		);
+
+		return result;
+	}
+
+	private :
+
+		const Stencils &m_stencils;
+		size_t m_expectedSize;
+
+};
+
+//////////////////////////////////////////////////////////////////////////
+// CatmullClarkRefiner
+//////////////////////////////////////////////////////////////////////////
+
+CatmullClarkRefiner::CatmullClarkRefiner( const MeshPrimitive *mesh, unsigned levels )
+	:	m_levels( levels )
+{
+	if( !mesh )
+	{
+		throw InvalidArgumentException( "No mesh given to CatmullClarkRefiner" );
+	}
+
+	mesh->topologyHash( m_topologyHash );
+
+	Level level;
+	level.numVertices = mesh->variableSize( PrimitiveVariable::Vertex );
+	level.verticesPerFace = mesh->verticesPerFace()->readable();
+	level.vertexIds = mesh->vertexIds()->readable();
+
+	m_numVertices = level.numVertices;
+	m_numFaces = level.verticesPerFace.size();
+	m_numFaceVertices = level.vertexIds.size();
+
+	m_vertexStencils.setIdentity( m_numVertices );
+	m_varyingStencils.setIdentity( m_numVertices );
+	m_faceVaryingStencils.setIdentity( m_numFaceVertices );
+	m_uniformStencils.setIdentity( m_numFaces );
+
+	for( unsigned i = 0; i < levels; ++i )
+	{
+		Level refined;
+		Stencils vertexStencils, varyingStencils, faceVaryingStencils, uniformStencils;
+		level.refine( refined, vertexStencils, varyingStencils, faceVaryingStencils, uniformStencils );
+
+		composeStencils( vertexStencils, m_numVertices, m_vertexStencils );
+		composeStencils( varyingStencils, m_numVertices, m_varyingStencils );
+		composeStencils( faceVaryingStencils, m_numFaceVertices, m_faceVaryingStencils );
+		composeStencils( uniformStencils, m_numFaces, m_uniformStencils );
+
+		level.numVertices = refined.numVertices;
+		level.verticesPerFace.swap( refined.verticesPerFace );
+		level.vertexIds.swap( refined.vertexIds );
+	}
+
+	m_numRefinedVertices = level.numVertices;
+	m_refinedVerticesPerFace = new IntVectorData;
+	m_refinedVerticesPerFace->writable().swap( level.verticesPerFace );
+	m_refinedVertexIds = new IntVectorData;
+	m_refinedVertexIds->writable().swap( level.vertexIds );
+}
+
+CatmullClarkRefiner::~CatmullClarkRefiner()
+{
+}
+
+unsigned CatmullClarkRefiner::levels() const
+{
+	return m_levels;
+}
+
+const MurmurHash &CatmullClarkRefiner::topologyHash() const
+{
+	return m_topologyHash;
+}
+
+void CatmullClarkRefiner::composeStencils( const Stencils &levelStencils, size_t numValues, Stencils &stencils )
+{
+	Stencils result;
+	result.offsets.reserve( levelStencils.offsets.size() );
+
+	vector<float> accumulatedWeights( numValues, 0.0f );
+	vector<int> lastRow( numValues, -1 );
+	vector<int> touched;
+
+	const int numRows = levelStencils.numRows();
+	for( int row = 0; row < numRows; ++row )
+	{
+		for( int i = levelStencils.offsets[row]; i < levelStencils.offsets[row+1]; ++i )
+		{
+			const int parent = levelStencils.indices[i];
+			const float parentWeight = levelStencils.weights[i];
+			for( int j = stencils.offsets[parent]; j < stencils.offsets[parent+1]; ++j )
+			{
+				const int index = stencils.indices[j];
+				if( lastRow[index] != row )
+				{
+					lastRow[index] = row;
+					accumulatedWeights[index] = 0.0f;
+					touched.push_back( index );
+				}
+				accumulatedWeights[index] += parentWeight * stencils.weights[j];
+			}
+		}
+
+		std::sort( touched.begin(), touched.end() );
+		for( vector<int>::const_iterator it = touched.begin(); it != touched.end(); ++it )
+		{
+			if( accumulatedWeights[*it] != 0.0f )
+			{
+				result.addWeight( *it, accumulatedWeights[*it] );
+			}
+		}
+		result.endRow();
+		touched.clear();
+	}
+
+	std::swap( stencils.offsets, result.offsets );
+	std::swap( stencils.indices, result.indices );
+	std::swap( stencils.weights, result.weights );
+}
+
+MeshPrimitivePtr CatmullClarkRefiner::refine( const MeshPrimitive *mesh ) const
+{
+	MurmurHash topologyHash;
+	mesh->topologyHash( topologyHash );
+	if( topologyHash != m_topologyHash )
+	{
+		throw InvalidArgumentException( "CatmullClarkRefiner::refine : Mesh topology differs from the topology the refiner was built for." );
+	}
+
+	MeshPrimitivePtr result = new MeshPrimitive;
+	result->setTopologyUnchecked( m_refinedVerticesPerFace, m_refinedVertexIds, m_numRefinedVertices, mesh->interpolation() );
+
+	for( PrimitiveVariableMap::const_iterator it = mesh->variables.begin(); it != mesh->variables.end(); ++it )
+	{
+		if( !it->second.data )
+		{
+			continue;
+		}
+		if( it->second.interpolation != PrimitiveVariable::Constant && !despatchTraitsTest<IsRefinable>( it->second.data.get() ) )
+		{
+			msg( Msg::Warning, "CatmullClarkRefiner::refine", boost::format( "Primitive variable \"%s\" has unsupported type \"%s\" and will be omitted." ) % it->first % it->second.data->typeName() );
+			continue;
+		}
+		result->variables[it->first] = refine( it->second );
+	}
+
+	return result;
+}
+
+PrimitiveVariable CatmullClarkRefiner::refine( const PrimitiveVariable &primitiveVariable ) const
+{
+	if( !primitiveVariable.data )
+	{
+		throw InvalidArgumentException( "CatmullClarkRefiner::refine : Primitive variable has no data." );
+	}
+
+	const Stencils *stencils = 0;
+	size_t expectedSize = 0;
+	switch( primitiveVariable.interpolation )
+	{
+		case PrimitiveVariable::Constant :
+			return PrimitiveVariable( primitiveVariable.interpolation, primitiveVariable.data->copy() );
+		case PrimitiveVariable::Uniform :
+			stencils = &m_uniformStencils;
+			expectedSize = m_numFaces;
+			break;
+		case PrimitiveVariable::Vertex :
+			stencils = &m_vertexStencils;
+			expectedSize = m_numVertices;
+			break;
+		case PrimitiveVariable::Varying :
+			stencils = &m_varyingStencils;
+			expectedSize = m_numVertices;
+			break;
+		case PrimitiveVariable::FaceVarying :
+			stencils = &m_faceVaryingStencils;
+			expectedSize = m_numFaceVertices;
+			break;
+		default :
+			throw InvalidArgumentException( "CatmullClarkRefiner::refine : Primitive variable has invalid interpolation." );
+	}
+
+	ApplyStencils applyStencils( *stencils, expectedSize );
+	DataPtr data = despatchTypedData<ApplyStencils, IsRefinable>( const_cast<Data *>( primitiveVariable.data.get() ), applyStencils );
+
+	return PrimitiveVariable( primitiveVariable.interpolation, data );
+}
+
+size_t CatmullClarkRefiner::memoryUsage() const
+{
+	size_t result = sizeof( CatmullClarkRefiner );
+	const Stencils *stencils[] = { &m_vertexStencils, &m_varyingStencils, &m_faceVaryingStencils, &m_uniformStencils };
+	for( size_t i = 0; i < 4; ++i )
+	{
+		result += stencils[i]->offsets.capacity() * sizeof( int );
+		result += stencils[i]->indices.capacity() * sizeof( int );
+		result += stencils[i]->weights.capacity() * sizeof( float );
+	}
+	result += m_refinedVerticesPerFace->readable().capacity() * sizeof( int );
+	result += m_refinedVertexIds->readable().capacity() * sizeof( int );
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Cache
+//////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+struct RefinerCacheKey
+{
+
+	RefinerCacheKey()
+		:	mesh( 0 ), levels( 0 )
+	{
+	}
+
+	RefinerCacheKey( const MeshPrimitive *m, unsigned l )
+		:	mesh( m ), levels( l )
+	{
+		mesh->topologyHash( hash );
+		hash.append( levels );
+	}
+
+	bool operator == ( const RefinerCacheKey &other ) const
+	{
+		return hash == other.hash;
+	}
+
+	mutable const MeshPrimitive *mesh;
+	unsigned levels;
+	MurmurHash hash;
+
+};
+
+inline size_t tbb_hasher( const RefinerCacheKey &key )
+{
+	return tbb_hasher( key.hash );
+}
+
+ConstCatmullClarkRefinerPtr refinerGetter( const RefinerCacheKey &key, size_t &cost )
+{
+	ConstCatmullClarkRefinerPtr result = new CatmullClarkRefiner( key.mesh, key.levels );
+	// The mesh is only guaranteed to be alive for the duration of the
+	// call to shared(), so we zero it out to make sure it isn't used again.
+	key.mesh = 0;
+	cost = result->memoryUsage();
+	return result;
+}
+
+typedef LRUCache<RefinerCacheKey, ConstCatmullClarkRefinerPtr> RefinerCache;
+
+size_t refinerCacheMemory()
+{
+	const size_t defaultMB = 500;
+	const char *m = getenv( "IECORE_CATMULLCLARKREFINER_CACHE_MEMORY" );
+	if( !m )
+	{
+		return 1024 * 1024 * defaultMB;
+	}
+
+	try
+	{
+		return 1024 * 1024 * boost::lexical_cast<size_t>( m );
+	}
+	catch( const boost::bad_lexical_cast & )
+	{
+		msg( Msg::Warning, "CatmullClarkRefiner", boost::format( "Invalid IECORE_CATMULLCLARKREFINER_CACHE_MEMORY value \"%s\". Using the default of %dMB." ) % m % defaultMB );
+		return 1024 * 1024 * defaultMB;
+	}
+}
+
+// Function-local statics aren't guaranteed to be initialised safely
+// when several threads get to them at once, so we create the cache
+// ourselves, under a mutex. It is never destroyed, so it is still usable
+// during static destruction. The atomic is zero initialised before any
+// code runs, so is safe to check at any time.
+tbb::atomic<RefinerCache *> g_refinerCache;
+tbb::mutex g_refinerCacheMutex;
+
+RefinerCache &refinerCache()
+{
+	RefinerCache *c = g_refinerCache;
+	if( !c )
+	{
+		tbb::mutex::scoped_lock lock( g_refinerCacheMutex );
+		c = g_refinerCache;
+		if( !c )
+		{
+			c = new RefinerCache( refinerGetter, refinerCacheMemory() );
+			g_refinerCache = c;
+		}
+	}
+	return *c;
+}
+
+} // namespace
+
+ConstCatmullClarkRefinerPtr CatmullClarkRefiner::shared( const MeshPrimitive *mesh, unsigned levels )
+{
+	if( !mesh )
+	{
+		throw InvalidArgumentException( "No mesh given to CatmullClarkRefiner::shared" );
+	}
+
+	return refinerCache().get( RefinerCacheKey( mesh, levels ) );
+}
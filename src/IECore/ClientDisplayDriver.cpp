@@ -39,7 +39,9 @@
 #include "IECore/ClientDisplayDriver.h"
 #include "IECore/private/DisplayDriverServerHeader.h"
 #include "IECore/SimpleTypedData.h"
+#include "IECore/VectorTypedData.h"
 #include "IECore/MemoryIndexedIO.h"
+#include "IECore/ByteOrder.h"
 
 using namespace boost;
 using namespace std;
@@ -51,7 +53,8 @@ class ClientDisplayDriver::PrivateData : public RefCounted
 {
 	public :
 		PrivateData() :
-		m_service(), m_host(""), m_port(""), m_scanLineOrderOnly(false), m_acceptsRepeatedData(false), m_socket( m_service )
+		m_service(), m_host(""), m_port(""), m_scanLineOrderOnly(false), m_acceptsRepeatedData(false), m_socket( m_service ),
+		m_bucketEncoding( DisplayDriverServerHeader::floatBucket ), m_protocolVersion( 1 )
 		{
 		}
 
@@ -66,6 +69,9 @@ class ClientDisplayDriver::PrivateData : public RefCounted
 		bool m_scanLineOrderOnly;
 		bool m_acceptsRepeatedData;
 		boost::asio::ip::tcp::socket m_socket;
+		DisplayDriverServerHeader::BucketEncoding m_bucketEncoding;
+		std::vector<char> m_bucketBuffer;
+		unsigned char m_protocolVersion;
 };
 
 IE_CORE_DEFINERUNTIMETYPED( ClientDisplayDriver );
@@ -82,6 +88,31 @@ ClientDisplayDriver::ClientDisplayDriver( const Imath::Box2i &displayWindow, con
 	
 	m_data->m_host = displayHostData->readable();
 	m_data->m_port = displayPortData->readable();
+
+	if( const StringData *bucketEncodingData = parameters->member<StringData>( "bucketEncoding" ) )
+	{
+		const std::string &bucketEncoding = bucketEncodingData->readable();
+		if( bucketEncoding == "float" )
+		{
+			m_data->m_bucketEncoding = DisplayDriverServerHeader::floatBucket;
+		}
+		else if( bucketEncoding == "half" )
+		{
+			m_data->m_bucketEncoding = DisplayDriverServerHeader::halfBucket;
+		}
+		else if( bucketEncoding == "compressedFloat" )
+		{
+			m_data->m_bucketEncoding = DisplayDriverServerHeader::compressedFloatBucket;
+		}
+		else if( bucketEncoding == "compressedHalf" )
+		{
+			m_data->m_bucketEncoding = DisplayDriverServerHeader::compressedHalfBucket;
+		}
+		else
+		{
+			throw InvalidArgumentException( "Unknown bucketEncoding \"" + bucketEncoding + "\"" );
+		}
+	}
 	
 	tcp::resolver resolver(m_data->m_service);
 	tcp::resolver::query query(m_data->m_host, m_data->m_port);
@@ -110,6 +141,10 @@ ClientDisplayDriver::ClientDisplayDriver( const Imath::Box2i &displayWindow, con
 
 	IECore::CompoundDataPtr tmpParameters = parameters->copy();
 	tmpParameters->writable()[ "clientPID" ] = new IntData( getpid() );
+	// the open message is sent using the first version of the protocol, so that
+	// older servers accept it, and the server replies using the latest version
+	// we both support.
+	tmpParameters->writable()[ "clientProtocolVersion" ] = new IntData( DisplayDriverServerHeader::currentProtocolVersion );
 
 	// build the data block
 	io = new MemoryIndexedIO( ConstCharVectorDataPtr(), IndexedIO::rootPath, IndexedIO::Exclusive | IndexedIO::Write );
@@ -164,7 +199,7 @@ bool ClientDisplayDriver::acceptsRepeatedData() const
 
 void ClientDisplayDriver::sendHeader( int msg, size_t dataSize )
 {
-	DisplayDriverServerHeader header( (DisplayDriverServerHeader::MessageType)msg, dataSize );
+	DisplayDriverServerHeader header( (DisplayDriverServerHeader::MessageType)msg, dataSize, m_data->m_protocolVersion );
 	m_data->m_socket.send( boost::asio::buffer( header.buffer(), header.headerLength ) );
 }
 
@@ -189,27 +224,61 @@ size_t ClientDisplayDriver::receiveHeader( int msg )
 	{
 		throw Exception( "Unexpected message type on display driver socket package." );
 	}
+	if ( msg == DisplayDriverServerHeader::imageOpen )
+	{
+		m_data->m_protocolVersion = header.protocolVersion();
+	}
 	return bytesAhead;
 }
 
 void ClientDisplayDriver::imageData( const Box2i &box, const float *data, size_t dataSize )
 {
-	MemoryIndexedIOPtr io;
-	ConstCharVectorDataPtr buf;
+	if( m_data->m_protocolVersion < 2 )
+	{
+		// the server predates imageDataBucket, so we send the bucket the old way
+		MemoryIndexedIOPtr io;
+		ConstCharVectorDataPtr buf;
 
-	// build the data block
-	Box2iDataPtr boxData = new Box2iData( box );
-	FloatVectorDataPtr dataData = new FloatVectorData( std::vector<float>( data, data+dataSize ) );
+		// build the data block
+		Box2iDataPtr boxData = new Box2iData( box );
+		FloatVectorDataPtr dataData = new FloatVectorData( std::vector<float>( data, data+dataSize ) );
 
-	io = new MemoryIndexedIO( ConstCharVectorDataPtr(), IndexedIO::rootPath, IndexedIO::Exclusive | IndexedIO::Write );
-	boost::static_pointer_cast<Object>(boxData)->save( io, "box" );
-	boost::static_pointer_cast<Object>(dataData)->save( io, "data" );
-	buf = io->buffer();
-	size_t blockSize = buf->readable().size();
+		io = new MemoryIndexedIO( ConstCharVectorDataPtr(), IndexedIO::rootPath, IndexedIO::Exclusive | IndexedIO::Write );
+		boost::static_pointer_cast<Object>(boxData)->save( io, "box" );
+		boost::static_pointer_cast<Object>(dataData)->save( io, "data" );
+		buf = io->buffer();
+		size_t blockSize = buf->readable().size();
+
+		sendHeader( DisplayDriverServerHeader::imageData, blockSize );
+
+		m_data->m_socket.send( boost::asio::buffer( &(buf->readable()[0]), blockSize) );
+		return;
+	}
+
+	char bucketHeader[DisplayDriverServerHeader::bucketHeaderLength];
+	DisplayDriverServerHeader::writeBucketHeader( box, m_data->m_bucketEncoding, bucketHeader );
+
+	// uncompressed floats are sent straight from the renderer's buffer where possible,
+	// otherwise we encode them into our own.
+	boost::asio::const_buffer pixelData;
+	if( m_data->m_bucketEncoding == DisplayDriverServerHeader::floatBucket && littleEndian() )
+	{
+		pixelData = boost::asio::buffer( data, dataSize * sizeof( float ) );
+	}
+	else
+	{
+		DisplayDriverServerHeader::encodeBucketData( data, dataSize, m_data->m_bucketEncoding, m_data->m_bucketBuffer );
+		pixelData = boost::asio::buffer( m_data->m_bucketBuffer );
+	}
 
-	sendHeader( DisplayDriverServerHeader::imageData, blockSize );
+	const size_t pixelDataSize = boost::asio::buffer_size( pixelData );
+	DisplayDriverServerHeader header( DisplayDriverServerHeader::imageDataBucket, sizeof( bucketHeader ) + pixelDataSize, m_data->m_protocolVersion );
 
-	m_data->m_socket.send( boost::asio::buffer( &(buf->readable()[0]), blockSize) );
+	std::vector<boost::asio::const_buffer> buffers;
+	buffers.push_back( boost::asio::buffer( header.buffer(), header.headerLength ) );
+	buffers.push_back( boost::asio::buffer( bucketHeader, sizeof( bucketHeader ) ) );
+	buffers.push_back( pixelData );
+	boost::asio::write( m_data->m_socket, buffers );
 }
 
 void ClientDisplayDriver::imageClose()
@@ -39,6 +39,11 @@
 #include "IECore/VectorTypedData.h"
 #include "IECore/Primitive.h"
 
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+
+#include <algorithm>
+
 using namespace IECore;
 using namespace Imath;
 
@@ -198,76 +203,79 @@ const typename T::BaseType *ColorTransformOp::alphaData( Primitive * primitive,
 	return d->baseReadable();
 }
 
-template <typename T>
-void ColorTransformOp::transformSeparate( Primitive * primitive, const CompoundObject * operands, T * r, T * g, T * b )
-{
-	size_t n = r->baseSize();
-	const typename T::BaseType *alpha = alphaData<T>( primitive, n );
+// The number of colors gathered into a contiguous buffer for each call to transformRange().
+static const size_t g_batchSize = 1024;
 
-	typename T::BaseType *rw = r->baseWritable();
-	typename T::BaseType *gw = g->baseWritable();
-	typename T::BaseType *bw = b->baseWritable();
+template<typename T>
+struct ColorTransformOp::TransformElements
+{
 
-	begin( operands );
+	TransformElements( const ColorTransformOp *op, T *r, T *g, T *b, size_t stride, const T *alpha )
+		:	m_op( op ), m_r( r ), m_g( g ), m_b( b ), m_stride( stride ), m_alpha( alpha )
+	{
+	}
 
-	try
+	void operator()( const tbb::blocked_range<size_t> &range ) const
 	{
-		for( size_t i=0; i<n; i++ )
+		Color3f buffer[g_batchSize];
+		for( size_t batchBegin = range.begin(); batchBegin < range.end(); batchBegin += g_batchSize )
 		{
-			Color3f c( *rw, *gw, *bw );
-			if( alpha && *alpha > 0 )
+			const size_t batchEnd = std::min( batchBegin + g_batchSize, range.end() );
+
+			Color3f *c = buffer;
+			for( size_t i = batchBegin; i < batchEnd; ++i, ++c )
 			{
-				c /= *alpha;
+				const size_t offset = i * m_stride;
+				*c = Color3f( m_r[offset], m_g[offset], m_b[offset] );
+				if( m_alpha && m_alpha[i] > 0 )
+				{
+					*c /= m_alpha[i];
+				}
 			}
-			transform( c );
-			if( alpha )
+
+			m_op->transformRange( buffer, c );
+
+			c = buffer;
+			for( size_t i = batchBegin; i < batchEnd; ++i, ++c )
 			{
-				c *= *alpha++;
+				if( m_alpha )
+				{
+					*c *= m_alpha[i];
+				}
+				const size_t offset = i * m_stride;
+				m_r[offset] = (*c)[0];
+				m_g[offset] = (*c)[1];
+				m_b[offset] = (*c)[2];
 			}
-			
-			*rw++ = c[0];
-			*gw++ = c[1];
-			*bw++ = c[2];
 		}
 	}
-	catch ( ... )
-	{
-		end();
-		throw;
-	}
 
-	end();
-}
+	private :
 
-template<typename T>
-void ColorTransformOp::transformInterleaved( Primitive * primitive, const CompoundObject * operands, T * colors )
-{
-	assert( colors->baseSize() %3 == 0 );
-	size_t numElements = colors->baseSize() / 3;
+		const ColorTransformOp *m_op;
+		T *m_r;
+		T *m_g;
+		T *m_b;
+		size_t m_stride;
+		const T *m_alpha;
 
-	const typename T::BaseType *alpha = alphaData<TypedData<std::vector<typename T::BaseType> > >( primitive, numElements );
+};
 
+template<typename T>
+void ColorTransformOp::transformElements( const CompoundObject * operands, T *r, T *g, T *b, size_t stride, const T *alpha, size_t numElements )
+{
 	begin( operands );
+
 	try
 	{
-
-		size_t i = 0;
-		typename T::BaseType *data = colors->baseWritable();
-		for( i=0; i<numElements; i++ )
+		TransformElements<T> transformer( this, r, g, b, stride, alpha );
+		if( canTransformConcurrently() )
 		{
-			Color3f c( data[0], data[1], data[2] );
-			if( alpha && *alpha > 0 )
-			{
-				c /= *alpha;
-			}
-			transform( c );
-			if( alpha )
-			{
-				c *= *alpha++;
-			}
-			*data++ = c[0];
-			*data++ = c[1];
-			*data++ = c[2];
+			tbb::parallel_for( tbb::blocked_range<size_t>( 0, numElements, g_batchSize ), transformer );
+		}
+		else
+		{
+			transformer( tbb::blocked_range<size_t>( 0, numElements ) );
 		}
 	}
 	catch ( ... )
@@ -279,6 +287,27 @@ void ColorTransformOp::transformInterleaved( Primitive * primitive, const Compou
 	end();
 }
 
+template <typename T>
+void ColorTransformOp::transformSeparate( Primitive * primitive, const CompoundObject * operands, T * r, T * g, T * b )
+{
+	size_t n = r->baseSize();
+	const typename T::BaseType *alpha = alphaData<T>( primitive, n );
+
+	transformElements( operands, r->baseWritable(), g->baseWritable(), b->baseWritable(), 1, alpha, n );
+}
+
+template<typename T>
+void ColorTransformOp::transformInterleaved( Primitive * primitive, const CompoundObject * operands, T * colors )
+{
+	assert( colors->baseSize() %3 == 0 );
+	size_t numElements = colors->baseSize() / 3;
+
+	const typename T::BaseType *alpha = alphaData<TypedData<std::vector<typename T::BaseType> > >( primitive, numElements );
+
+	typename T::BaseType *data = colors->baseWritable();
+	transformElements( operands, data, data + 1, data + 2, 3, alpha, numElements );
+}
+
 void ColorTransformOp::modifyPrimitive( Primitive * primitive, const CompoundObject * operands )
 {
 	PrimitiveVariableMap::iterator colorIt = primitive->variables.find( m_colorPrimVarParameter->getTypedValue() );
@@ -369,6 +398,19 @@ void ColorTransformOp::begin( const CompoundObject * operands )
 {
 }
 
+void ColorTransformOp::transformRange( Imath::Color3f *begin, Imath::Color3f *end ) const
+{
+	for( Imath::Color3f *it = begin; it != end; ++it )
+	{
+		transform( *it );
+	}
+}
+
+bool ColorTransformOp::canTransformConcurrently() const
+{
+	return true;
+}
+
 void ColorTransformOp::end()
 {
 }
@@ -88,3 +88,13 @@ void CubeColorTransformOp::transform( Imath::Color3f &color ) const
 	assert( m_data );
 	color = m_data->readable().operator()( color );
 }
+
+void CubeColorTransformOp::transformRange( Imath::Color3f *begin, Imath::Color3f *end ) const
+{
+	assert( m_data );
+	const CubeColorLookupf &lookup = m_data->readable();
+	for( Imath::Color3f *it = begin; it != end; ++it )
+	{
+		*it = lookup( *it );
+	}
+}
@@ -322,13 +322,31 @@ struct CurvesPrimitiveEvaluator::Line
 		float m_vMax;
 		
 };
+
+struct CurvesPrimitiveEvaluator::ClosestPointLeafFn
+{
+	ClosestPointLeafFn( const CurvesPrimitiveEvaluator *evaluator, const V3f &p, unsigned &curveIndex, float &v )
+		:	m_evaluator( evaluator ), m_p( p ), m_curveIndex( curveIndex ), m_v( v )
+	{
+	}
+
+	void operator()( const Box3fBVH::Iterator *permFirst, const Box3fBVH::Iterator *permLast, float &closestDistSquared )
+	{
+		m_evaluator->closestPointLeaf( permFirst, permLast, m_p, m_curveIndex, m_v, closestDistSquared );
+	}
+
+	const CurvesPrimitiveEvaluator *m_evaluator;
+	const V3f &m_p;
+	unsigned &m_curveIndex;
+	float &m_v;
+};
 				
 //////////////////////////////////////////////////////////////////////////
 // Implementation of Evaluator
 //////////////////////////////////////////////////////////////////////////
 
-CurvesPrimitiveEvaluator::CurvesPrimitiveEvaluator( ConstCurvesPrimitivePtr curves )
-	:	m_curvesPrimitive( curves->copy() ), m_verticesPerCurve( m_curvesPrimitive->verticesPerCurve()->readable() ), m_haveTree( false )
+CurvesPrimitiveEvaluator::CurvesPrimitiveEvaluator( ConstCurvesPrimitivePtr curves, AccelerationStructure accelerationStructure )
+	:	m_curvesPrimitive( curves->copy() ), m_verticesPerCurve( m_curvesPrimitive->verticesPerCurve()->readable() ), m_accelerationStructure( accelerationStructure ), m_haveTree( false )
 {
 	m_vertexDataOffsets.reserve( m_verticesPerCurve.size() );
 	m_varyingDataOffsets.reserve( m_verticesPerCurve.size() );
@@ -412,7 +430,15 @@ bool CurvesPrimitiveEvaluator::closestPoint( const Imath::V3f &p, PrimitiveEvalu
 	unsigned curveIndex = 0;
 	float v = -1;
 	float distSquared = Imath::limits<float>::max();
-	closestPointWalk( m_tree.rootIndex(), p, curveIndex, v, distSquared );
+	if( m_accelerationStructure == BVHAcceleration )
+	{
+		ClosestPointLeafFn fn( this, p, curveIndex, v );
+		m_bvh.closestLeaves( p, distSquared, fn );
+	}
+	else
+	{
+		closestPointWalk( m_tree.rootIndex(), p, curveIndex, v, distSquared );
+	}
 	(typedResult->*typedResult->m_init)( curveIndex, v, this );
 	
 	return true;
@@ -425,22 +451,7 @@ void CurvesPrimitiveEvaluator::closestPointWalk( Box3fTree::NodeIndex nodeIndex,
 	const Box3fTree::Node &node = m_tree.node( nodeIndex );
 	if( node.isLeaf() )
 	{
-		Box3fTree::Iterator *permLast = node.permLast();
-		for( Box3fTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
-		{
-			const Line &line = m_treeLines[*perm - m_treeBounds.begin()];
-			
-			float t;
-			V3f cp = line.lineSegment().closestPointTo( p, t );
-			float d2 = (cp - p).length2();
-			
-			if( d2 < closestDistSquared )
-			{
-				closestDistSquared = d2;
-				curveIndex = line.curveIndex();
-				v = lerp( line.vMin(), line.vMax(), t );
-			}
-		}
+		closestPointLeaf( node.permFirst(), node.permLast(), p, curveIndex, v, closestDistSquared );
 	}
 	else
 	{
@@ -471,6 +482,25 @@ void CurvesPrimitiveEvaluator::closestPointWalk( Box3fTree::NodeIndex nodeIndex,
 	}
 }
 
+void CurvesPrimitiveEvaluator::closestPointLeaf( const Box3fTree::Iterator *permFirst, const Box3fTree::Iterator *permLast, const Imath::V3f &p, unsigned &curveIndex, float &v, float &closestDistSquared ) const
+{
+	for( const Box3fTree::Iterator *perm = permFirst; perm!=permLast; perm++ )
+	{
+		const Line &line = m_treeLines[*perm - m_treeBounds.begin()];
+
+		float t;
+		V3f cp = line.lineSegment().closestPointTo( p, t );
+		float d2 = (cp - p).length2();
+
+		if( d2 < closestDistSquared )
+		{
+			closestDistSquared = d2;
+			curveIndex = line.curveIndex();
+			v = lerp( line.vMin(), line.vMax(), t );
+		}
+	}
+}
+
 bool CurvesPrimitiveEvaluator::pointAtUV( const Imath::V2f &uv, PrimitiveEvaluator::Result *result ) const
 {
 	return pointAtV( 0, uv[1], result );
@@ -700,7 +730,14 @@ void CurvesPrimitiveEvaluator::buildTree()
 		}
 	}
 	
-	m_tree.init( m_treeBounds.begin(), m_treeBounds.end() );
+	if( m_accelerationStructure == BVHAcceleration )
+	{
+		m_bvh.init( m_treeBounds.begin(), m_treeBounds.end() );
+	}
+	else
+	{
+		m_tree.init( m_treeBounds.begin(), m_treeBounds.end() );
+	}
 	m_haveTree = true;
 }
 
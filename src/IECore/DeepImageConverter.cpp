@@ -114,13 +114,13 @@ ObjectPtr DeepImageConverter::doOperation( const CompoundObject *operands )
 		writer->worldToNDCParameter()->setValue( worldToNDC );
 	}
 	
+	// the writer's data window starts at the origin, so we shift
+	// the input data window there as we copy it.
+	DeepScanline scanline;
 	for ( int y=dataWindow.min.y; y <= dataWindow.max.y; ++y )
 	{
-		for ( int x=dataWindow.min.x; x <= dataWindow.max.x; ++x )
-		{
-			DeepPixelPtr pixel = reader->readPixel( x, y );
-			writer->writePixel( x, y, pixel.get() );
-		}
+		reader->readScanline( y, scanline );
+		writer->writeScanline( y - dataWindow.min.y, scanline );
 	}
 	
 	return new StringData( writer->fileName() );
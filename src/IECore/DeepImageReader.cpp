@@ -32,6 +32,8 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+
 #include "IECore/DeepImageReader.h"
 #include "IECore/FileNameParameter.h"
 #include "IECore/ImagePrimitive.h"
@@ -42,6 +44,28 @@
 
 using namespace IECore;
 
+namespace
+{
+
+// The same ordering as DeepPixel::DepthComparison. Used with the same
+// heap operations, so that samples at equal depths come out in the same
+// order as they would from DeepPixel::composite().
+struct DepthLess
+{
+	DepthLess( const float *depths ) : m_depths( depths )
+	{
+	}
+	
+	bool operator()( unsigned a, unsigned b ) const
+	{
+		return m_depths[a] < m_depths[b];
+	}
+	
+	const float *m_depths;
+};
+
+} // namespace
+
 IE_CORE_DEFINERUNTIMETYPED( DeepImageReader );
 
 DeepImageReader::DeepImageReader( const std::string &description )
@@ -75,22 +99,66 @@ ObjectPtr DeepImageReader::doOperation( const CompoundObject *operands )
 		image->variables[*cIt] = PrimitiveVariable( PrimitiveVariable::Vertex, data );
 	}
 
-	DeepPixelPtr pixel = 0;
-	float channelData[channels.size()];
+	int alphaChannel = std::find( channels.begin(), channels.end(), "A" ) - channels.begin();
+	if ( alphaChannel == (int)numChannels )
+	{
+		alphaChannel = -1;
+	}
+	
+	DeepScanline scanline;
+	std::vector<unsigned> order;
+	float channelData[numChannels];
 	
 	unsigned p = 0;
 	for ( int y=dataWind.min.y; y < dataWind.max.y + 1; ++y )
 	{
-		for ( int x=dataWind.min.x; x < dataWind.max.x + 1; ++x, ++p )
+		readScanline( y, scanline );
+		
+		for ( unsigned x=0; x < (unsigned)pixelDimensions.x; ++x, ++p )
 		{
-			pixel = readPixel( x, y );
+			unsigned numSamples = scanline.sampleCounts[x];
+			if ( !numSamples )
+			{
+				continue;
+			}
 			
-			if ( !pixel )
+			// Composite front to back, in the same manner as DeepPixel::composite().
+			const unsigned offset = scanline.sampleOffsets[x];
+			const DepthLess depthLess( &scanline.depths[0] );
+			order.clear();
+			for ( unsigned i=0; i < numSamples; ++i )
 			{
+				order.push_back( offset + i );
+				std::push_heap( order.begin(), order.end(), depthLess );
+			}
+			std::sort_heap( order.begin(), order.end(), depthLess );
+			
+			if ( alphaChannel < 0 )
+			{
+				const float *data = &scanline.channelData[ order[0] * numChannels ];
+				for ( unsigned c=0; c < numChannels; ++c )
+				{
+					(*primVarData[c])[p] = data[c];
+				}
 				continue;
 			}
 			
-			pixel->composite( channelData );
+			for ( unsigned c=0; c < numChannels; ++c )
+			{
+				channelData[c] = 0.0;
+			}
+			
+			float alpha = 1.0;
+			for ( unsigned i=0; i < numSamples && channelData[alphaChannel] < 1.0; ++i )
+			{
+				const float *data = &scanline.channelData[ order[i] * numChannels ];
+				for ( unsigned c=0; c < numChannels; ++c )
+				{
+					channelData[c] += data[c] * alpha;
+				}
+				
+				alpha = std::max( 1 - channelData[alphaChannel], 0.0f );
+			}
 			
 			for ( unsigned c=0; c < numChannels; ++c )
 			{
@@ -113,6 +181,48 @@ DeepPixelPtr DeepImageReader::readPixel( int x, int y )
 	return doReadPixel( x, y );
 }
 
+void DeepImageReader::readScanline( int y, DeepScanline &scanline )
+{
+	const Imath::Box2i dataWind = dataWindow();
+	if( y < dataWind.min.y || y > dataWind.max.y )
+	{
+		throw Exception( "Requested scanline not in available data window." );
+	}
+	
+	std::vector<std::string> channels;
+	channelNames( channels );
+	
+	scanline.resize( dataWind.max.x - dataWind.min.x + 1, channels.size() );
+	doReadScanline( y, scanline );
+}
+
+void DeepImageReader::doReadScanline( int y, DeepScanline &scanline )
+{
+	const int minX = dataWindow().min.x;
+	const unsigned width = scanline.width();
+	const unsigned numChannels = scanline.numChannels();
+	
+	std::vector<DeepPixelPtr> pixels( width );
+	for ( unsigned x=0; x < width; ++x )
+	{
+		pixels[x] = doReadPixel( minX + x, y );
+		scanline.sampleCounts[x] = pixels[x] ? pixels[x]->numSamples() : 0;
+	}
+	
+	scanline.allocateSamples();
+	
+	for ( unsigned x=0; x < width; ++x )
+	{
+		const DeepPixel *pixel = pixels[x].get();
+		for ( unsigned i=0, s=scanline.sampleOffsets[x]; i < scanline.sampleCounts[x]; ++i, ++s )
+		{
+			scanline.depths[s] = pixel->getDepth( i );
+			const float *data = pixel->channelData( i );
+			std::copy( data, data + numChannels, scanline.channelData.begin() + s * numChannels );
+		}
+	}
+}
+
 CompoundObjectPtr DeepImageReader::readHeader()
 {
 	std::vector<std::string> names;
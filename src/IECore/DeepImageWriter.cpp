@@ -125,6 +125,65 @@ void DeepImageWriter::writePixel( int x, int y, const DeepPixel *pixel )
 	doWritePixel( x, y, pixel );
 }
 
+void DeepImageWriter::writeScanline( int y, const DeepScanline &scanline )
+{
+	const Imath::V2i &resolution = m_resolutionParameter->getTypedValue();
+	if ( y < 0 || y >= resolution.y )
+	{
+		throw InvalidArgumentException( "DeepScanline is not within the resolution of the image." );
+	}
+	
+	if ( scanline.width() != (unsigned)resolution.x )
+	{
+		throw InvalidArgumentException( "DeepScanline does not have the correct width." );
+	}
+	
+	if ( scanline.numChannels() != m_channelsParameter->getTypedValue().size() )
+	{
+		throw InvalidArgumentException( "DeepScanline does not have the correct channels." );
+	}
+	
+	unsigned numSamples = 0;
+	for ( std::vector<unsigned>::const_iterator it = scanline.sampleCounts.begin(); it != scanline.sampleCounts.end(); ++it )
+	{
+		numSamples += *it;
+	}
+	
+	if (
+		scanline.sampleOffsets.size() != scanline.width() ||
+		scanline.numSamples() != numSamples ||
+		scanline.channelData.size() != numSamples * scanline.numChannels()
+	)
+	{
+		throw InvalidArgumentException( "DeepScanline samples have not been allocated to match the sample counts." );
+	}
+	
+	doWriteScanline( y, scanline );
+}
+
+void DeepImageWriter::doWriteScanline( int y, const DeepScanline &scanline )
+{
+	const std::vector<std::string> &channels = m_channelsParameter->getTypedValue();
+	const unsigned numChannels = scanline.numChannels();
+	
+	for ( unsigned x=0; x < scanline.width(); ++x )
+	{
+		const unsigned numSamples = scanline.sampleCounts[x];
+		if ( !numSamples )
+		{
+			continue;
+		}
+		
+		DeepPixelPtr pixel = new DeepPixel( channels, numSamples );
+		for ( unsigned s=scanline.sampleOffsets[x], end=s+numSamples; s < end; ++s )
+		{
+			pixel->addSample( scanline.depths[s], &scanline.channelData[ s * numChannels ] );
+		}
+		
+		doWritePixel( x, y, pixel.get() );
+	}
+}
+
 void DeepImageWriter::registerDeepImageWriter( const std::string &extensions, CanWriteFn canWrite, CreatorFn creator, TypeId typeId )
 {
 	assert( canWrite );
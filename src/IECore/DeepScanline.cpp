@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "IECore/DeepScanline.h"
+
+using namespace IECore;
+
+DeepScanline::DeepScanline( unsigned width, unsigned numChannels )
+{
+	resize( width, numChannels );
+}
+
+void DeepScanline::resize( unsigned width, unsigned numChannels )
+{
+	m_numChannels = numChannels;
+	sampleCounts.assign( width, 0 );
+	sampleOffsets.assign( width, 0 );
+	depths.clear();
+	channelData.clear();
+}
+
+void DeepScanline::allocateSamples()
+{
+	unsigned width = sampleCounts.size();
+	sampleOffsets.resize( width );
+
+	unsigned offset = 0;
+	for ( unsigned x=0; x < width; ++x )
+	{
+		sampleOffsets[x] = offset;
+		offset += sampleCounts[x];
+	}
+
+	depths.resize( offset );
+	channelData.resize( offset * m_numChannels );
+}
+
+unsigned DeepScanline::width() const
+{
+	return sampleCounts.size();
+}
+
+unsigned DeepScanline::numChannels() const
+{
+	return m_numChannels;
+}
+
+unsigned DeepScanline::numSamples() const
+{
+	return depths.size();
+}
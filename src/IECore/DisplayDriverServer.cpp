@@ -35,8 +35,12 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "boost/asio.hpp"
 #include "boost/bind.hpp"
+#include "boost/shared_ptr.hpp"
 #include "tbb/tbb_thread.h"
 
 #include "IECore/DisplayDriverServer.h"
@@ -44,6 +48,7 @@
 #include "IECore/SimpleTypedData.h"
 #include "IECore/MemoryIndexedIO.h"
 #include "IECore/MessageHandler.h"
+#include "IECore/Exception.h"
 
 using namespace IECore;
 using boost::asio::ip::tcp;
@@ -66,14 +71,21 @@ class DisplayDriverServer::Session : public RefCounted
 		void handleReadHeader( const boost::system::error_code& error );
 		void handleReadOpenParameters( const boost::system::error_code& error );
 		void handleReadDataParameters( const boost::system::error_code& error );
+		void handleReadBucket( const boost::system::error_code& error );
+		void readHeader();
 		void sendResult( DisplayDriverServerHeader::MessageType msg, size_t dataSize );
 		void sendException( const char *message );
 
 	private:
 		boost::asio::ip::tcp::socket m_socket;
+		// All the handlers for a session are dispatched through this strand, so
+		// that they're serialised even when the server has several threads.
+		boost::asio::io_service::strand m_strand;
 		DisplayDriverPtr m_displayDriver;
 		DisplayDriverServerHeader m_header;
 		CharVectorDataPtr m_buffer;
+		std::vector<float> m_decodeBuffer;
+		unsigned char m_protocolVersion;
 };
 
 class DisplayDriverServer::PrivateData : public RefCounted
@@ -85,14 +97,13 @@ class DisplayDriverServer::PrivateData : public RefCounted
 		boost::asio::ip::tcp::endpoint m_endpoint;
 		boost::asio::io_service m_service;
 		boost::asio::ip::tcp::acceptor m_acceptor;
-		tbb::tbb_thread m_thread;
+		std::vector<boost::shared_ptr<tbb::tbb_thread> > m_threads;
 
 		PrivateData( int portNumber ) :
 			m_success(false),
 			m_endpoint(tcp::v4(), portNumber),
 			m_service(),
-			m_acceptor( m_service ),
-			m_thread()
+			m_acceptor( m_service )
 		{
 			m_acceptor.open(  m_endpoint.protocol() );
 			m_acceptor.set_option( boost::asio::ip::tcp::acceptor::reuse_address(true));
@@ -107,7 +118,10 @@ class DisplayDriverServer::PrivateData : public RefCounted
 			{
 				m_acceptor.cancel();
 				m_acceptor.close();
-				m_thread.join();
+				for( std::vector<boost::shared_ptr<tbb::tbb_thread> >::const_iterator it = m_threads.begin(); it != m_threads.end(); ++it )
+				{
+					(*it)->join();
+				}
 			}
 		}
 
@@ -123,9 +137,18 @@ static void fixSocketFlags( int socketDesc )
 	}
 }
 
-DisplayDriverServer::DisplayDriverServer( int portNumber ) :
+DisplayDriverServer::DisplayDriverServer( int portNumber, int numThreads ) :
 		m_data( 0 )
 {
+	if( numThreads < 0 )
+	{
+		throw InvalidArgumentException( "DisplayDriverServer : numThreads must not be negative" );
+	}
+	if( numThreads == 0 )
+	{
+		numThreads = std::max( 1u, tbb::tbb_thread::hardware_concurrency() );
+	}
+
 	m_data = new DisplayDriverServer::PrivateData( portNumber );
 
 	DisplayDriverServer::SessionPtr newSession( new DisplayDriverServer::Session( m_data->m_service ) );
@@ -133,8 +156,10 @@ DisplayDriverServer::DisplayDriverServer( int portNumber ) :
 			boost::bind( &DisplayDriverServer::handleAccept, this, newSession,
 			boost::asio::placeholders::error));
 	fixSocketFlags( m_data->m_acceptor.native() );
-	tbb::tbb_thread newThread( boost::bind(&DisplayDriverServer::serverThread, this) );
-	m_data->m_thread = newThread;
+	for( int i = 0; i < numThreads; ++i )
+	{
+		m_data->m_threads.push_back( boost::shared_ptr<tbb::tbb_thread>( new tbb::tbb_thread( boost::bind( &DisplayDriverServer::serverThread, this ) ) ) );
+	}
 }
 
 DisplayDriverServer::~DisplayDriverServer()
@@ -175,7 +200,7 @@ void DisplayDriverServer::handleAccept( DisplayDriverServer::SessionPtr session,
  */
 
 DisplayDriverServer::Session::Session( boost::asio::io_service& io_service ) :
-	m_socket( io_service ), m_displayDriver(0), m_buffer( new CharVectorData( ) )
+	m_socket( io_service ), m_strand( io_service ), m_displayDriver(0), m_buffer( new CharVectorData( ) ), m_protocolVersion( DisplayDriverServerHeader::currentProtocolVersion )
 {
 }
 
@@ -190,15 +215,22 @@ boost::asio::ip::tcp::socket& DisplayDriverServer::Session::socket()
 }
 
 void DisplayDriverServer::Session::start()
+{
+	readHeader();
+	fixSocketFlags( m_socket.native() );
+}
+
+void DisplayDriverServer::Session::readHeader()
 {
 	boost::asio::async_read( m_socket,
 			boost::asio::buffer( m_header.buffer(), m_header.headerLength),
-			boost::bind(
-				&DisplayDriverServer::Session::handleReadHeader, SessionPtr(this),
-				boost::asio::placeholders::error
+			m_strand.wrap(
+				boost::bind(
+					&DisplayDriverServer::Session::handleReadHeader, SessionPtr(this),
+					boost::asio::placeholders::error
+				)
 			)
 	);
-	fixSocketFlags( m_socket.native() );
 }
 
 void DisplayDriverServer::Session::handleReadHeader( const boost::system::error_code& error )
@@ -220,6 +252,13 @@ void DisplayDriverServer::Session::handleReadHeader( const boost::system::error_
 	// get number of bytes ahead (unsigned int value)
 	size_t bytesAhead = m_header.getDataSize();
 
+	if ( m_header.messageType() == DisplayDriverServerHeader::imageOpen )
+	{
+		// reply to the client using the protocol it speaks, unless it
+		// tells us it can speak a later version in the open parameters.
+		m_protocolVersion = m_header.protocolVersion();
+	}
+
 	CharVectorData::ValueType &data = m_buffer->writable();
 	data.resize( bytesAhead );
 
@@ -229,15 +268,22 @@ void DisplayDriverServer::Session::handleReadHeader( const boost::system::error_
 	case DisplayDriverServerHeader::imageOpen:
 		boost::asio::async_read( m_socket,
 				boost::asio::buffer( &data[0], bytesAhead ),
-				boost::bind( &DisplayDriverServer::Session::handleReadOpenParameters, SessionPtr(this), boost::asio::placeholders::error)
+				m_strand.wrap( boost::bind( &DisplayDriverServer::Session::handleReadOpenParameters, SessionPtr(this), boost::asio::placeholders::error) )
 		);
 		break;
 
 	case DisplayDriverServerHeader::imageData:
 		boost::asio::async_read( m_socket,
 				boost::asio::buffer( &data[0], bytesAhead ),
-				boost::bind(&DisplayDriverServer::Session::handleReadDataParameters, SessionPtr(this),
-				boost::asio::placeholders::error));
+				m_strand.wrap( boost::bind(&DisplayDriverServer::Session::handleReadDataParameters, SessionPtr(this),
+				boost::asio::placeholders::error) ) );
+		break;
+
+	case DisplayDriverServerHeader::imageDataBucket:
+		boost::asio::async_read( m_socket,
+				boost::asio::buffer( &data[0], bytesAhead ),
+				m_strand.wrap( boost::bind(&DisplayDriverServer::Session::handleReadBucket, SessionPtr(this),
+				boost::asio::placeholders::error) ) );
 		break;
 
 	case DisplayDriverServerHeader::imageClose:
@@ -303,6 +349,18 @@ void DisplayDriverServer::Session::handleReadOpenParameters( const boost::system
 		channelNames = boost::static_pointer_cast<StringVectorData>( Object::load( io, "channelNames" ) );
 		parameters = boost::static_pointer_cast<CompoundData>( Object::load( io, "parameters" ) );
 
+		// negotiate the protocol version, and remove the parameter used to do it,
+		// as it isn't meant for the display driver.
+		CompoundDataMap::iterator versionIt = parameters->writable().find( "clientProtocolVersion" );
+		if( versionIt != parameters->writable().end() )
+		{
+			if( const IntData *clientProtocolVersion = runTimeCast<const IntData>( versionIt->second.get() ) )
+			{
+				m_protocolVersion = std::max<int>( m_protocolVersion, std::min<int>( clientProtocolVersion->readable(), DisplayDriverServerHeader::currentProtocolVersion ) );
+			}
+			parameters->writable().erase( versionIt );
+		}
+
 		const StringData *displayType = parameters->member<StringData>( "remoteDisplayType", true /* throw if missing */ );
 
 		// create a displayDriver using the factory function.
@@ -329,13 +387,7 @@ void DisplayDriverServer::Session::handleReadOpenParameters( const boost::system
 		m_socket.send( boost::asio::buffer( &acceptsRepeatedData, sizeof(acceptsRepeatedData) ) );
 
 		// prepare for getting imageData packages
-		boost::asio::async_read( m_socket,
-			boost::asio::buffer( m_header.buffer(), m_header.headerLength),
-			boost::bind(
-				&DisplayDriverServer::Session::handleReadHeader, SessionPtr(this),
-				boost::asio::placeholders::error
-			)
-		);
+		readHeader();
 	}
 	catch( std::exception &e )
 	{
@@ -376,13 +428,7 @@ void DisplayDriverServer::Session::handleReadDataParameters( const boost::system
 		m_displayDriver->imageData( box->readable(), &(data->readable()[0]), data->readable().size() );
 
 		// prepare for getting more imageData packages or a imageClose.
-		boost::asio::async_read( m_socket,
-			boost::asio::buffer( m_header.buffer(), m_header.headerLength),
-			boost::bind(
-				&DisplayDriverServer::Session::handleReadHeader, SessionPtr(this),
-				boost::asio::placeholders::error
-			)
-		);
+		readHeader();
 	}
 	catch( std::exception &e )
 	{
@@ -392,9 +438,83 @@ void DisplayDriverServer::Session::handleReadDataParameters( const boost::system
 	}
 }
 
+void DisplayDriverServer::Session::handleReadBucket( const boost::system::error_code& error )
+{
+	if (error)
+	{
+		msg( Msg::Error, "DisplayDriverServer::Session::handleReadBucket", error.message().c_str() );
+		m_socket.close();
+		return;
+	}
+
+	// sanity check: check DisplayDriver object
+	if (! m_displayDriver )
+	{
+		msg( Msg::Error, "DisplayDriverServer::Session::handleReadBucket", "No display drivers!" );
+		m_socket.close();
+		return;
+	}
+
+	try
+	{
+		const CharVectorData::ValueType &buffer = m_buffer->readable();
+		if ( buffer.size() < DisplayDriverServerHeader::bucketHeaderLength )
+		{
+			throw IOException( "Bucket data block too short." );
+		}
+
+		Imath::Box2i box;
+		DisplayDriverServerHeader::BucketEncoding encoding;
+		if ( !DisplayDriverServerHeader::readBucketHeader( &buffer[0], box, encoding ) || box.isEmpty() )
+		{
+			throw IOException( "Invalid bucket header." );
+		}
+
+		// The box comes from the client, so we validate it before trusting it to
+		// size the decoded data. The arithmetic is unsigned so that it can't overflow
+		// for boxes spanning most of the range of an int.
+		const Imath::Box2i dataWindow = m_displayDriver->dataWindow();
+		if(
+			box.min.x < dataWindow.min.x || box.min.y < dataWindow.min.y ||
+			box.max.x > dataWindow.max.x || box.max.y > dataWindow.max.y
+		)
+		{
+			throw IOException( "Bucket is outside the data window." );
+		}
+
+		const size_t dataSize = buffer.size() - DisplayDriverServerHeader::bucketHeaderLength;
+		const size_t maxValues = DisplayDriverServerHeader::maxBucketValues( dataSize, encoding );
+		const size_t width = size_t( (unsigned int)box.max.x - (unsigned int)box.min.x ) + 1;
+		const size_t height = size_t( (unsigned int)box.max.y - (unsigned int)box.min.y ) + 1;
+		const size_t numChannels = m_displayDriver->channelNames().size();
+		if( height > maxValues / width || numChannels > maxValues / ( width * height ) )
+		{
+			throw IOException( "Bucket data is too small for the bucket." );
+		}
+		const size_t numValues = width * height * numChannels;
+
+		// uncompressed float data is passed to the driver directly from our receive buffer
+		const float *data = DisplayDriverServerHeader::decodeBucketData(
+			&buffer[0] + DisplayDriverServerHeader::bucketHeaderLength,
+			dataSize, numValues, encoding, m_decodeBuffer
+		);
+
+		m_displayDriver->imageData( box, data, numValues );
+
+		// prepare for getting more imageData packages or a imageClose.
+		readHeader();
+	}
+	catch( std::exception &e )
+	{
+		msg( Msg::Error, "DisplayDriverServer::Session::handleReadBucket", e.what() );
+		m_socket.close();
+		return;
+	}
+}
+
 void DisplayDriverServer::Session::sendResult( DisplayDriverServerHeader::MessageType msg, size_t dataSize )
 {
-	DisplayDriverServerHeader header( msg, dataSize );
+	DisplayDriverServerHeader header( msg, dataSize, m_protocolVersion );
 	m_socket.send( boost::asio::buffer( header.buffer(), header.headerLength ) );
 }
 
@@ -32,9 +32,23 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include <cstring>
+#include <limits>
+
+#include "boost/iostreams/filtering_stream.hpp"
+#include "boost/iostreams/filter/zlib.hpp"
+#include "boost/iostreams/device/array.hpp"
+#include "boost/iostreams/device/back_inserter.hpp"
+
+#include "OpenEXR/half.h"
+
 #include "IECore/private/DisplayDriverServerHeader.h"
+#include "IECore/ByteOrder.h"
+#include "IECore/Exception.h"
 
 using namespace IECore;
+using namespace Imath;
+namespace io = boost::iostreams;
 
 enum byteOrder {
 	orderMagicNumber = 0,
@@ -51,10 +65,10 @@ DisplayDriverServerHeader::DisplayDriverServerHeader()
 	memset( &m_header[0], 0, sizeof(m_header) );
 }
 
-DisplayDriverServerHeader::DisplayDriverServerHeader( MessageType msg, size_t dataSize )
+DisplayDriverServerHeader::DisplayDriverServerHeader( MessageType msg, size_t dataSize, unsigned char protocolVersion )
 {
 	m_header[orderMagicNumber] = magicNumber;
-	m_header[orderProtocolVersion] = currentProtocolVersion;
+	m_header[orderProtocolVersion] = protocolVersion;
 	m_header[orderMessageType] = msg;
 	setDataSize( dataSize );
 }
@@ -67,11 +81,17 @@ unsigned char *DisplayDriverServerHeader::buffer()
 bool DisplayDriverServerHeader::valid()
 {
 	if ( m_header[orderMagicNumber] != magicNumber || 
-		 m_header[orderProtocolVersion] != currentProtocolVersion ||
+		 m_header[orderProtocolVersion] < 1 ||
+		 m_header[orderProtocolVersion] > currentProtocolVersion ||
 		( m_header[orderMessageType] != imageOpen && 
 			m_header[orderMessageType] != imageData &&
 			m_header[orderMessageType] != imageClose && 
-			m_header[orderMessageType] != exception ) )
+			m_header[orderMessageType] != exception &&
+			m_header[orderMessageType] != imageDataBucket ) )
+	{
+		return false;
+	}
+	if ( m_header[orderMessageType] == imageDataBucket && m_header[orderProtocolVersion] < 2 )
 	{
 		return false;
 	}
@@ -96,3 +116,175 @@ DisplayDriverServerHeader::MessageType DisplayDriverServerHeader::messageType()
 {
 	return (MessageType)m_header[2];
 }
+
+unsigned char DisplayDriverServerHeader::protocolVersion()
+{
+	return m_header[orderProtocolVersion];
+}
+
+static void writeInt32( int value, char *dst )
+{
+	unsigned int v = value;
+	dst[0] = v & 0xff;
+	dst[1] = ( v >> 8 ) & 0xff;
+	dst[2] = ( v >> 16 ) & 0xff;
+	dst[3] = ( v >> 24 ) & 0xff;
+}
+
+static int readInt32( const char *src )
+{
+	const unsigned char *s = reinterpret_cast<const unsigned char *>( src );
+	return (int)( (unsigned int)s[0] | ((unsigned int)s[1] << 8) | ((unsigned int)s[2] << 16) | ((unsigned int)s[3] << 24) );
+}
+
+void DisplayDriverServerHeader::writeBucketHeader( const Box2i &box, BucketEncoding encoding, char *dst )
+{
+	writeInt32( box.min.x, dst );
+	writeInt32( box.min.y, dst + 4 );
+	writeInt32( box.max.x, dst + 8 );
+	writeInt32( box.max.y, dst + 12 );
+	dst[16] = encoding;
+	dst[17] = dst[18] = dst[19] = 0;
+}
+
+bool DisplayDriverServerHeader::readBucketHeader( const char *src, Box2i &box, BucketEncoding &encoding )
+{
+	box.min.x = readInt32( src );
+	box.min.y = readInt32( src + 4 );
+	box.max.x = readInt32( src + 8 );
+	box.max.y = readInt32( src + 12 );
+	if( src[16] < floatBucket || src[16] > compressedHalfBucket )
+	{
+		return false;
+	}
+	encoding = (BucketEncoding)src[16];
+	return true;
+}
+
+void DisplayDriverServerHeader::encodeBucketData( const float *data, size_t numValues, BucketEncoding encoding, std::vector<char> &encoded )
+{
+	const bool useHalf = encoding == halfBucket || encoding == compressedHalfBucket;
+	const bool compress = encoding == compressedFloatBucket || encoding == compressedHalfBucket;
+
+	// convert to the right type and byte order
+	std::vector<char> converted;
+	std::vector<char> &raw = compress ? converted : encoded;
+	if( useHalf )
+	{
+		raw.resize( numValues * sizeof( half ) );
+		unsigned short *dst = reinterpret_cast<unsigned short *>( &raw[0] );
+		for( size_t i = 0; i < numValues; ++i )
+		{
+			const unsigned short bits = half( data[i] ).bits();
+			dst[i] = littleEndian() ? bits : reverseBytes( bits );
+		}
+	}
+	else
+	{
+		raw.resize( numValues * sizeof( float ) );
+		float *dst = reinterpret_cast<float *>( &raw[0] );
+		for( size_t i = 0; i < numValues; ++i )
+		{
+			dst[i] = littleEndian() ? data[i] : reverseBytes( data[i] );
+		}
+	}
+
+	if( !compress )
+	{
+		return;
+	}
+
+	encoded.clear();
+	io::filtering_ostream compressingStream;
+	compressingStream.push( io::zlib_compressor( io::zlib::best_speed ) );
+	compressingStream.push( io::back_inserter( encoded ) );
+	assert( compressingStream.is_complete() );
+
+	compressingStream.write( &raw[0], raw.size() );
+
+	compressingStream.pop();
+	compressingStream.pop();
+}
+
+size_t DisplayDriverServerHeader::maxBucketValues( size_t size, BucketEncoding encoding )
+{
+	const bool useHalf = encoding == halfBucket || encoding == compressedHalfBucket;
+	const bool compressed = encoding == compressedFloatBucket || encoding == compressedHalfBucket;
+
+	// deflate can't compress by more than a factor of 1032
+	static const size_t maxCompressionRatio = 1032;
+	size_t maxRawSize = size;
+	if( compressed )
+	{
+		maxRawSize = size <= std::numeric_limits<size_t>::max() / maxCompressionRatio ? size * maxCompressionRatio : std::numeric_limits<size_t>::max();
+	}
+
+	return maxRawSize / ( useHalf ? sizeof( half ) : sizeof( float ) );
+}
+
+const float *DisplayDriverServerHeader::decodeBucketData( const char *data, size_t size, size_t numValues, BucketEncoding encoding, std::vector<float> &decoded )
+{
+	// numValues comes from the box sent by the client, so we must check it
+	// before using it to size any allocations.
+	if( numValues > maxBucketValues( size, encoding ) )
+	{
+		throw IOException( "DisplayDriverServerHeader: Bucket data is too small for the bucket." );
+	}
+
+	const bool useHalf = encoding == halfBucket || encoding == compressedHalfBucket;
+	const bool compressed = encoding == compressedFloatBucket || encoding == compressedHalfBucket;
+	const size_t rawSize = numValues * ( useHalf ? sizeof( half ) : sizeof( float ) );
+
+	std::vector<char> decompressed;
+	if( compressed )
+	{
+		decompressed.resize( rawSize );
+		io::filtering_istream decompressingStream;
+		decompressingStream.push( io::zlib_decompressor() );
+		decompressingStream.push( io::array_source( data, size ) );
+		assert( decompressingStream.is_complete() );
+
+		decompressingStream.read( &decompressed[0], rawSize );
+		if( decompressingStream.gcount() != (std::streamsize)rawSize )
+		{
+			throw IOException( "DisplayDriverServerHeader: Failed to decompress bucket data." );
+		}
+		data = &decompressed[0];
+	}
+	else if( size != rawSize )
+	{
+		throw IOException( "DisplayDriverServerHeader: Invalid bucket data size." );
+	}
+
+	if( !useHalf && !compressed && littleEndian() && reinterpret_cast<size_t>( data ) % sizeof( float ) == 0 )
+	{
+		// the data can be used as is
+		return reinterpret_cast<const float *>( data );
+	}
+
+	decoded.resize( numValues );
+	if( useHalf )
+	{
+		for( size_t i = 0; i < numValues; ++i )
+		{
+			unsigned short bits;
+			memcpy( &bits, data + i * sizeof( half ), sizeof( half ) );
+			half h;
+			h.setBits( littleEndian() ? bits : reverseBytes( bits ) );
+			decoded[i] = h;
+		}
+	}
+	else
+	{
+		memcpy( &decoded[0], data, rawSize );
+		if( !littleEndian() )
+		{
+			for( size_t i = 0; i < numValues; ++i )
+			{
+				decoded[i] = reverseBytes( decoded[i] );
+			}
+		}
+	}
+
+	return numValues ? &decoded[0] : 0;
+}
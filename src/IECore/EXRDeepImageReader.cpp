@@ -235,6 +235,74 @@ DeepPixelPtr EXRDeepImageReader::doReadPixel( int x, int y )
 	return pixel;
 }
 
+void EXRDeepImageReader::doReadScanline( int y, DeepScanline &scanline )
+{
+	open( true );
+	
+	const Imath::Box2i &dataWindow = m_inputFile->header().dataWindow();
+	const size_t width = scanline.width();
+	const size_t numChannels = scanline.numChannels();
+	
+	Imf::DeepFrameBuffer frameBuffer;
+	frameBuffer.insertSampleCountSlice(
+		Imf::Slice(
+			Imf::UINT, reinterpret_cast< char * >( &scanline.sampleCounts[0] - dataWindow.min.x - y * width ),
+			sizeof( unsigned ), sizeof( unsigned ) * width
+		)
+	);
+	
+	m_inputFile->setFrameBuffer( frameBuffer );
+	m_inputFile->readPixelSampleCounts( y );
+	
+	scanline.allocateSamples();
+	if ( !scanline.numSamples() )
+	{
+		return;
+	}
+	
+	// Point each channel of each pixel directly at its place in the flat arrays.
+	// Channel data is interleaved per sample, so the sample stride covers all the
+	// channels. We always ask for FLOAT data, and leave OpenEXR to convert any HALF
+	// channels for us.
+	std::vector<float *> pointers( width * ( numChannels + 1 ) );
+	float *depths = &scanline.depths[0];
+	float *channelData = &scanline.channelData[0];
+	
+	unsigned c = 0;
+	const Imf::ChannelList &channels = m_inputFile->header().channels();
+	for ( Imf::ChannelList::ConstIterator it = channels.begin(); it != channels.end(); ++it, ++c )
+	{
+		float **channelPointers = &pointers[ width * c ];
+		size_t sampleStride = sizeof( float );
+		
+		if ( (int)c == m_depthChannel )
+		{
+			for ( size_t i=0; i < width; ++i )
+			{
+				channelPointers[i] = depths + scanline.sampleOffsets[i];
+			}
+		}
+		else
+		{
+			const size_t cIndex = (int)c > m_depthChannel ? c - 1 : c;
+			for ( size_t i=0; i < width; ++i )
+			{
+				channelPointers[i] = channelData + scanline.sampleOffsets[i] * numChannels + cIndex;
+			}
+			sampleStride *= numChannels;
+		}
+		
+		Imf::DeepSlice slice(
+			Imf::FLOAT, reinterpret_cast< char * >( channelPointers - dataWindow.min.x - y * width ),
+			sizeof( float * ), sizeof( float * ) * width, sampleStride
+		);
+		frameBuffer.insert( it.name(), slice );
+	}
+	
+	m_inputFile->setFrameBuffer( frameBuffer );
+	m_inputFile->readPixels( y );
+}
+
 EXRDeepImageReader::Scanline::Scanline( size_t width, size_t numChannels )
 	: sampleCount( width ), pointers( width * numChannels ), data()
 {
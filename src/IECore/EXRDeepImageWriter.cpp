@@ -98,7 +98,7 @@ EXRDeepImageWriter::~EXRDeepImageWriter()
 	// Write any remaining scanlines.
 	while( m_currentSlice <= m_lastSlice )
 	{
-		writeScanline();
+		flushScanline();
 	}
 	
 	// Free our memory.	
@@ -153,7 +153,7 @@ void EXRDeepImageWriter::clearScanlineBuffer()
 	}
 }
 
-void EXRDeepImageWriter::writeScanline()
+void EXRDeepImageWriter::flushScanline()
 {
 	Imath::Box2i dataWindow( m_outputFile->header().dataWindow() );
 	if ( m_currentSlice <= m_lastSlice )
@@ -203,10 +203,8 @@ void EXRDeepImageWriter::writeScanline()
 	clearScanlineBuffer();
 }
 
-void EXRDeepImageWriter::doWritePixel( int x, int y, const DeepPixel *pixel )
+void EXRDeepImageWriter::seekScanline( int y )
 {
-	open();
-	
 	if ( y < m_currentSlice )
 	{
 		throw Exception( "Deep slices have to be written sequentially and the pixel to be written belongs to a slice that has already been written." );
@@ -216,7 +214,7 @@ void EXRDeepImageWriter::doWritePixel( int x, int y, const DeepPixel *pixel )
 	{
 		do
 		{
-			writeScanline();
+			flushScanline();
 		} while( m_currentSlice < std::min( y, m_lastSlice ) );
 	}
 		
@@ -224,6 +222,12 @@ void EXRDeepImageWriter::doWritePixel( int x, int y, const DeepPixel *pixel )
 	{
 		throw Exception( "Cannot write past the bounds of the deep image." );
 	}
+}
+
+void EXRDeepImageWriter::doWritePixel( int x, int y, const DeepPixel *pixel )
+{
+	open();
+	seekScanline( y );
 
 	// Write the number of samples.
 	const unsigned int numSamples = pixel->numSamples();
@@ -276,6 +280,64 @@ void EXRDeepImageWriter::doWritePixel( int x, int y, const DeepPixel *pixel )
 	}
 }
 
+void EXRDeepImageWriter::doWriteScanline( int y, const DeepScanline &scanline )
+{
+	open();
+	seekScanline( y );
+	
+	Imath::Box2i dataWindow( m_outputFile->header().dataWindow() );
+	const unsigned numChannels = numberOfChannels();
+	
+	// Point each channel of each pixel directly at its place in the flat arrays,
+	// rather than copying into our own buffers. Channel data is interleaved per
+	// sample, so the sample stride covers all the channels. The data is always
+	// FLOAT, and OpenEXR converts it for any HALF channels in the file.
+	const float *depths = scanline.numSamples() ? &scanline.depths[0] : 0;
+	const float *channelData = scanline.numSamples() ? &scanline.channelData[0] : 0;
+	for ( int i = 0; i < m_width; ++i )
+	{
+		const unsigned offset = scanline.sampleOffsets[i];
+		m_depthPointers[i] = depths + offset;
+		for ( unsigned c = 0; c < numChannels; ++c )
+		{
+			m_samplePointers[ m_width * c + i ] = channelData + offset * numChannels + c;
+		}
+	}
+	
+	Imf::DeepFrameBuffer frameBuffer;
+	
+	frameBuffer.insertSampleCountSlice(
+			Imf::Slice( Imf::UINT, reinterpret_cast< char * >( const_cast< unsigned * >( &scanline.sampleCounts[0] ) - dataWindow.min.x - m_currentSlice * m_width ),
+				sizeof( unsigned int ) * 1,
+				sizeof( unsigned int ) * m_width
+				)
+			);
+	
+	for ( unsigned int c = 0; c < numChannels; ++c )
+	{
+		Imf::DeepSlice slice(
+				Imf::FLOAT, reinterpret_cast< char * >( &m_samplePointers[ m_width * c ] - dataWindow.min.x - m_currentSlice * m_width ),
+				sizeof( void * ), sizeof( void * ) * m_width, sizeof( float ) * numChannels
+				);
+		frameBuffer.insert( channelName( c ), slice );
+	}
+	
+	Imf::DeepSlice slice(
+			Imf::FLOAT, reinterpret_cast< char * >( &m_depthPointers[0] - dataWindow.min.x - m_currentSlice * m_width ),
+			sizeof( float * ), sizeof( float * ) * m_width, sizeof( float )
+			);
+	frameBuffer.insert( "Z", slice );
+	
+	m_outputFile->setFrameBuffer( frameBuffer );
+	m_outputFile->writePixels( 1 );
+	
+	++m_currentSlice;
+	
+	// Discard anything buffered for this scanline by doWritePixel(),
+	// as the whole scanline has been replaced.
+	clearScanlineBuffer();
+}
+
 Imf::Compression EXRDeepImageWriter::compression() const
 {
 	return static_cast< Imf::Compression >( parameters()->parameter<IECore::IntParameter>("compression")->getNumericValue() );
@@ -49,6 +49,7 @@
 
 #include "OpenEXR/Iex.h"
 #include "OpenEXR/ImfTestFile.h"
+#include "OpenEXR/ImfTiledInputFile.h"
 #include "OpenEXR/ImfFloatAttribute.h"
 #include "OpenEXR/ImfDoubleAttribute.h"
 #include "OpenEXR/ImfIntAttribute.h"
@@ -81,19 +82,20 @@ const Reader::ReaderDescription<EXRImageReader> EXRImageReader::g_readerDescript
 
 EXRImageReader::EXRImageReader() :
 		ImageReader( "Reads ILM OpenEXR file format." ),
-		m_inputFile( 0 )
+		m_inputFile( 0 ), m_tiledInputFile( 0 )
 {
 }
 
 EXRImageReader::EXRImageReader(const string &fileName) :
 		ImageReader( "Reads ILM OpenEXR file format." ),
-		m_inputFile( 0 )
+		m_inputFile( 0 ), m_tiledInputFile( 0 )
 {
 	m_fileNameParameter->setTypedValue( fileName );
 }
 
 EXRImageReader::~EXRImageReader()
 {
+	delete m_tiledInputFile;
 	delete m_inputFile;
 }
 
@@ -176,134 +178,248 @@ std::string EXRImageReader::sourceColorSpace() const
 	return "linear";
 }
 
-template<class T>
-DataPtr EXRImageReader::readTypedChannel( const std::string &name, const Imath::Box2i &dataWindow, const Imf::Channel *channel )
+namespace
 {
-	assert( channel );
-	Imath::V2i pixelDimensions = dataWindow.size() + Imath::V2i( 1 );
-	unsigned numPixels = pixelDimensions.x * pixelDimensions.y;
 
+// The number of scanlines decoded per readPixels() call when the requested
+// data window is narrower than the file and we must go via temporary buffers.
+// Reading whole bands rather than single scanlines lets the library decode
+// each compressed block in one go.
+const int g_bandHeight = 64;
+
+template<typename T>
+DataPtr createChannelData( size_t numPixels, char *&buffer, size_t &pixelSize )
+{
 	typedef TypedData<vector<T> > DataType;
 	typename DataType::Ptr data = new DataType;
 	data->writable().resize( numPixels );
+	buffer = (char *)data->baseWritable();
+	pixelSize = sizeof( T );
+	return data;
+}
 
-	Imath::Box2i fullDataWindow = this->dataWindow();
-	if( fullDataWindow.min.x==dataWindow.min.x && fullDataWindow.max.x==dataWindow.max.x )
+// Copies the scanlines from firstY to lastY, from a band of full width scanlines
+// starting at bandStart, into the result buffers for a window starting at windowMinY.
+void transferScanlines(
+	const vector<vector<char> > &bandBuffers, int bandWidth, int bandStart, ptrdiff_t transferOffset, const vector<size_t> &pixelSizes,
+	const vector<char *> &buffers, int width, int windowMinY, int firstY, int lastY
+)
+{
+	for( size_t i = 0; i < buffers.size(); ++i )
 	{
-		// the width we want to read matches the width in the file, so we can read straight
-		// into the result buffer
-		FrameBuffer frameBuffer;
-		T *buffer00 = data->baseWritable() - dataWindow.min.y * pixelDimensions.x - fullDataWindow.min.x;
-		Slice slice( channel->type, (char *)buffer00, sizeof(T), sizeof(T) * pixelDimensions.x );
-		frameBuffer.insert( name.c_str(), slice );
-		m_inputFile->setFrameBuffer( frameBuffer );
-		// exr library will choose the best order to read scanlines automatically (increasing or decreasing)
-		try
-		{
-			m_inputFile->readPixels( dataWindow.min.y, dataWindow.max.y );
-		}
-		catch( Iex::InputExc &e )
+		const size_t pixelSize = pixelSizes[i];
+		const size_t transferLength = width * pixelSize;
+		const char *transferSource = &(bandBuffers[i][0]) + ( (size_t)( firstY - bandStart ) * bandWidth + transferOffset ) * pixelSize;
+		char *transferDestination = buffers[i] + (size_t)( firstY - windowMinY ) * transferLength;
+		for( int y = firstY; y <= lastY; ++y )
 		{
-			// so we can read incomplete files
-			msg( Msg::Warning, "EXRImageReader::readChannel", e.what() );
-			return data;
+			memcpy( transferDestination, transferSource, transferLength );
+			transferSource += bandWidth * pixelSize;
+			transferDestination += transferLength;
 		}
 	}
-	else
+}
+
+DataPtr convertChannelData( DataPtr data, PixelType type )
+{
+	switch( type )
 	{
-		// widths don't match, we need to read into a temporary buffer and then transfer just
-		// the bits we need into the result buffer.
-		int numTmpPixels = fullDataWindow.size().x + 1;
-		vector<T> tmpBuffer( numTmpPixels );
-		T *tmpBufferTransferStart = &(tmpBuffer[0]) + dataWindow.min.x - fullDataWindow.min.x;
-		size_t tmpBufferTransferLength = pixelDimensions.x * sizeof( T );
-		T *transferDestination = &(data->writable()[0]);
-
-		// slice has yStride of 0 so each successive scanline just overwrites the previous one
-		Slice slice( channel->type, (char *)(&(tmpBuffer[0]) - fullDataWindow.min.x), sizeof(T), 0 );
-		FrameBuffer frameBuffer;
-		frameBuffer.insert( name.c_str(), slice );
-		m_inputFile->setFrameBuffer( frameBuffer );
-
-		int yStart = dataWindow.min.y;
-		int yEnd = dataWindow.max.y;
-		int yStep = 1;
-		try
+		case UINT :
 		{
-			for( int y=yStart; y!=(yEnd+yStep); y+=yStep )
-			{
-				m_inputFile->readPixels( y );
-				memcpy( (char *)transferDestination, (const char *)tmpBufferTransferStart, tmpBufferTransferLength );
-				transferDestination += pixelDimensions.x;
-			}
+			DataConvert< UIntVectorData, FloatVectorData, ScaledDataConversion< unsigned int, float > > converter;
+			ConstUIntVectorDataPtr vec = boost::static_pointer_cast< UIntVectorData >( data );
+			return converter( vec );
 		}
-		catch( Iex::InputExc &e )
+		case HALF :
 		{
-			// so we can read incomplete files
-			msg( Msg::Warning, "EXRImageReader::readChannel", e.what() );
-			return data;
+			DataConvert< HalfVectorData, FloatVectorData, ScaledDataConversion< half, float > > converter;
+			ConstHalfVectorDataPtr vec = boost::static_pointer_cast< HalfVectorData >( data );
+			return converter( vec );
 		}
+		default :
+			return data;
 	}
+}
 
-#ifndef NDEBUG
-	for ( typename DataType::ValueType::const_iterator it = data->readable().begin(); it != data->readable().end(); ++it )
-	{
-		assert( *it == *it ); // Will fail iff NaN
-	}
-#endif
+} // namespace
 
-	return data;
+DataPtr EXRImageReader::readChannel( const string &name, const Imath::Box2i &dataWindow, bool raw )
+{
+	vector<string> names( 1, name );
+	vector<DataPtr> channels;
+	readChannels( names, dataWindow, raw, channels );
+	return channels[0];
 }
 
-DataPtr EXRImageReader::readChannel( const string &name, const Imath::Box2i &dataWindow, bool raw )
+void EXRImageReader::readChannels( const std::vector<std::string> &names, const Imath::Box2i &dataWindow, bool raw, std::vector<DataPtr> &channels )
 {
 	open( true );
 
 	try
 	{
+		const Imath::V2i pixelDimensions = dataWindow.size() + Imath::V2i( 1 );
+		const size_t numPixels = (size_t)pixelDimensions.x * pixelDimensions.y;
+		const Imath::Box2i fullDataWindow = this->dataWindow();
+		const bool fullWidth = fullDataWindow.min.x==dataWindow.min.x && fullDataWindow.max.x==dataWindow.max.x;
+
+		// allocate the result buffers for all channels up front, so they
+		// can all be filled from a single FrameBuffer.
+
+		vector<PixelType> types( names.size() );
+		vector<char *> buffers( names.size() );
+		vector<size_t> pixelSizes( names.size() );
+		channels.resize( names.size() );
+		for( size_t i = 0; i < names.size(); ++i )
+		{
+			const Channel *channel = m_inputFile->header().channels().findChannel( names[i].c_str() );
+			assert( channel );
+			assert( channel->xSampling==1 ); /// \todo Support subsampling when we have a need for it
+			assert( channel->ySampling==1 );
 
-		const Channel *channel = m_inputFile->header().channels().findChannel( name.c_str() );
-		assert( channel );
-		assert( channel->xSampling==1 ); /// \todo Support subsampling when we have a need for it
-		assert( channel->ySampling==1 );
+			switch( channel->type )
+			{
+				case UINT :
+					BOOST_STATIC_ASSERT( sizeof( unsigned int ) == 4 );
+					channels[i] = createChannelData<unsigned int>( numPixels, buffers[i], pixelSizes[i] );
+					break;
+				case HALF :
+					channels[i] = createChannelData<half>( numPixels, buffers[i], pixelSizes[i] );
+					break;
+				case FLOAT :
+					BOOST_STATIC_ASSERT( sizeof( float ) == 4 );
+					channels[i] = createChannelData<float>( numPixels, buffers[i], pixelSizes[i] );
+					break;
+				default:
+					throw IOException( ( boost::format( "EXRImageReader : Unsupported data type for channel \"%s\"" ) % names[i] ).str() );
+			}
+			types[i] = channel->type;
+		}
 
-		DataPtr res;
-		switch( channel->type )
+		try
 		{
-			case UINT :
-				BOOST_STATIC_ASSERT( sizeof( unsigned int ) == 4 );
-				res = readTypedChannel<unsigned int>( name, dataWindow, channel );
-				if ( raw )
+			if( fullWidth )
+			{
+				// the width we want to read matches the width in the file, so we can read straight
+				// into the result buffers
+				FrameBuffer frameBuffer;
+				for( size_t i = 0; i < names.size(); ++i )
 				{
-					return res;
+					const ptrdiff_t offset = (ptrdiff_t)dataWindow.min.y * pixelDimensions.x + fullDataWindow.min.x;
+					char *buffer00 = buffers[i] - offset * (ptrdiff_t)pixelSizes[i];
+					frameBuffer.insert( names[i].c_str(), Slice( types[i], buffer00, pixelSizes[i], pixelSizes[i] * pixelDimensions.x ) );
 				}
-				else
+				m_inputFile->setFrameBuffer( frameBuffer );
+				// exr library will choose the best order to read scanlines automatically (increasing or decreasing)
+				m_inputFile->readPixels( dataWindow.min.y, dataWindow.max.y );
+			}
+			else if( m_inputFile->header().hasTileDescription() )
+			{
+				// the file is tiled, so we can decode just the tiles overlapping the window
+				// we want into temporary buffers, and then transfer the bits we need into the
+				// result buffers.
+				TiledInputFile &tiledFile = *tiledInputFile();
+				const int tileWidth = tiledFile.tileXSize();
+				const int tileHeight = tiledFile.tileYSize();
+				const Imath::V2i minTile( ( dataWindow.min.x - fullDataWindow.min.x ) / tileWidth, ( dataWindow.min.y - fullDataWindow.min.y ) / tileHeight );
+				const Imath::V2i maxTile( ( dataWindow.max.x - fullDataWindow.min.x ) / tileWidth, ( dataWindow.max.y - fullDataWindow.min.y ) / tileHeight );
+
+				const Imath::V2i tileWindowMin( fullDataWindow.min.x + minTile.x * tileWidth, fullDataWindow.min.y + minTile.y * tileHeight );
+				const Imath::V2i tileWindowMax(
+					std::min( fullDataWindow.min.x + ( maxTile.x + 1 ) * tileWidth - 1, fullDataWindow.max.x ),
+					std::min( fullDataWindow.min.y + ( maxTile.y + 1 ) * tileHeight - 1, fullDataWindow.max.y )
+				);
+				const Imath::V2i tileWindowSize = tileWindowMax - tileWindowMin + Imath::V2i( 1 );
+
+				vector<vector<char> > tmpBuffers( names.size() );
+				FrameBuffer frameBuffer;
+				for( size_t i = 0; i < names.size(); ++i )
 				{
-					DataConvert< UIntVectorData, FloatVectorData, ScaledDataConversion< unsigned int, float > > converter;
-					ConstUIntVectorDataPtr vec = boost::static_pointer_cast< UIntVectorData >(res);
-					return converter( vec );
+					tmpBuffers[i].resize( (size_t)tileWindowSize.x * tileWindowSize.y * pixelSizes[i] );
+					const ptrdiff_t offset = (ptrdiff_t)tileWindowMin.y * tileWindowSize.x + tileWindowMin.x;
+					char *buffer00 = &(tmpBuffers[i][0]) - offset * (ptrdiff_t)pixelSizes[i];
+					frameBuffer.insert( names[i].c_str(), Slice( types[i], buffer00, pixelSizes[i], pixelSizes[i] * tileWindowSize.x ) );
 				}
+				tiledFile.setFrameBuffer( frameBuffer );
+				tiledFile.readTiles( minTile.x, maxTile.x, minTile.y, maxTile.y, 0, 0 );
 
-			case HALF :
-				res = readTypedChannel<half>( name, dataWindow, channel );
-				if ( raw )
+				for( size_t i = 0; i < names.size(); ++i )
 				{
-					return res;
+					const size_t pixelSize = pixelSizes[i];
+					const size_t transferLength = pixelDimensions.x * pixelSize;
+					const size_t sourceOffset = (size_t)( dataWindow.min.y - tileWindowMin.y ) * tileWindowSize.x + ( dataWindow.min.x - tileWindowMin.x );
+					const char *transferSource = &(tmpBuffers[i][0]) + sourceOffset * pixelSize;
+					char *transferDestination = buffers[i];
+					for( int y = dataWindow.min.y; y <= dataWindow.max.y; ++y )
+					{
+						memcpy( transferDestination, transferSource, transferLength );
+						transferSource += tileWindowSize.x * pixelSize;
+						transferDestination += transferLength;
+					}
 				}
-				else
+			}
+			else
+			{
+				// widths don't match, we need to read bands of scanlines into temporary buffers
+				// and then transfer just the bits we need into the result buffers.
+				const int fullWidthPixels = fullDataWindow.size().x + 1;
+				const int bandHeight = std::min( g_bandHeight, pixelDimensions.y );
+				const ptrdiff_t transferOffset = dataWindow.min.x - fullDataWindow.min.x;
+
+				vector<vector<char> > tmpBuffers( names.size() );
+				for( size_t i = 0; i < names.size(); ++i )
 				{
-					DataConvert< HalfVectorData, FloatVectorData, ScaledDataConversion< half, float > > converter;
-					ConstHalfVectorDataPtr vec = boost::static_pointer_cast< HalfVectorData >(res);
-					return converter( vec );
+					tmpBuffers[i].resize( (size_t)fullWidthPixels * bandHeight * pixelSizes[i] );
 				}
 
-			case FLOAT :
-				BOOST_STATIC_ASSERT( sizeof( float ) == 4 );
-				return readTypedChannel<float>( name, dataWindow, channel );
-
-			default:
-				throw IOException( ( boost::format( "EXRImageReader : Unsupported data type for channel \"%s\"" ) % name ).str() );
+				for( int bandStart = dataWindow.min.y; bandStart <= dataWindow.max.y; bandStart += bandHeight )
+				{
+					const int bandEnd = std::min( bandStart + bandHeight - 1, dataWindow.max.y );
+
+					FrameBuffer frameBuffer;
+					for( size_t i = 0; i < names.size(); ++i )
+					{
+						const ptrdiff_t offset = (ptrdiff_t)bandStart * fullWidthPixels + fullDataWindow.min.x;
+						char *buffer00 = &(tmpBuffers[i][0]) - offset * (ptrdiff_t)pixelSizes[i];
+						frameBuffer.insert( names[i].c_str(), Slice( types[i], buffer00, pixelSizes[i], pixelSizes[i] * fullWidthPixels ) );
+					}
+					m_inputFile->setFrameBuffer( frameBuffer );
+
+					try
+					{
+						m_inputFile->readPixels( bandStart, bandEnd );
+					}
+					catch( Iex::InputExc & )
+					{
+						// the file is incomplete. read the band again a scanline at a time,
+						// transferring each one as we go, so that we keep all the scanlines
+						// preceding the missing one before passing the exception on.
+						for( int y = bandStart; y <= bandEnd; ++y )
+						{
+							m_inputFile->readPixels( y );
+							transferScanlines( tmpBuffers, fullWidthPixels, bandStart, transferOffset, pixelSizes, buffers, pixelDimensions.x, dataWindow.min.y, y, y );
+						}
+					}
+
+					transferScanlines( tmpBuffers, fullWidthPixels, bandStart, transferOffset, pixelSizes, buffers, pixelDimensions.x, dataWindow.min.y, bandStart, bandEnd );
+				}
+			}
+		}
+		catch( Iex::InputExc &e )
+		{
+			// so we can read incomplete files. we warn once per channel, as
+			// each of them is missing data.
+			for( size_t i = 0; i < names.size(); ++i )
+			{
+				msg( Msg::Warning, "EXRImageReader::readChannel", e.what() );
+			}
+		}
 
+		if( !raw )
+		{
+			for( size_t i = 0; i < names.size(); ++i )
+			{
+				channels[i] = convertChannelData( channels[i], types[i] );
+			}
 		}
 	}
 	catch ( Exception &e )
@@ -334,6 +450,8 @@ bool EXRImageReader::open( bool throwOnFailure )
 		return true;
 	}
 
+	delete m_tiledInputFile;
+	m_tiledInputFile = 0;
 	delete m_inputFile;
 	m_inputFile = 0;
 
@@ -358,6 +476,15 @@ bool EXRImageReader::open( bool throwOnFailure )
 	return true;
 }
 
+Imf::TiledInputFile *EXRImageReader::tiledInputFile()
+{
+	if( !m_tiledInputFile )
+	{
+		m_tiledInputFile = new Imf::TiledInputFile( m_inputFile->fileName() );
+	}
+	return m_tiledInputFile;
+}
+
 static DataPtr attributeToData( const Imf::Attribute &attr )
 {
 	if ( !strcmp( "float", attr.typeName() ) )
@@ -32,7 +32,15 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "boost/filesystem/operations.hpp"
+#include "boost/format.hpp"
 
 #include "IECore/MessageHandler.h"
 #include "IECore/FileIndexedIO.h"
@@ -66,9 +74,30 @@ class FileIndexedIO::StreamFile : public StreamIndexedIO::StreamFile
 
 		void flush( size_t endPosition );
 
+		/// Uses pread() on read-only files, so concurrent reads don't serialise on the stream mutex.
+		/// Memory mapped files are copied straight from the mapping.
+		virtual void read( char *buffer, size_t size, size_t pos );
+
+		/// Returns a pointer into the mapping for memory mapped files.
+		virtual const char *readBuffer( size_t size, size_t pos );
+
+		using StreamIndexedIO::StreamFile::read;
+
+	private :
+
+		void checkRange( size_t size, size_t pos ) const;
+
+		/// File descriptor used for positional reads. Only opened in Read mode,
+		/// as otherwise the data may still be pending in the fstream buffers.
+		int m_fd;
+
+		/// The whole file, when opened with the MemoryMapped flag.
+		const char *m_mappedData;
+		size_t m_mappedSize;
+
 };
 
-FileIndexedIO::StreamFile::StreamFile( const std::string &filename, IndexedIO::OpenMode mode ) : StreamIndexedIO::StreamFile(mode), m_filename( filename ), m_endPosition(0)
+FileIndexedIO::StreamFile::StreamFile( const std::string &filename, IndexedIO::OpenMode mode ) : StreamIndexedIO::StreamFile(mode), m_filename( filename ), m_endPosition(0), m_fd(-1), m_mappedData(0), m_mappedSize(0)
 {
 	if (mode & IndexedIO::Write)
 	{
@@ -143,6 +172,85 @@ FileIndexedIO::StreamFile::StreamFile( const std::string &filename, IndexedIO::O
 			throw IOException( "FileIndexedIO: Caught error reading file '" + filename + "'" );
 		}
 
+		m_fd = ::open( filename.c_str(), O_RDONLY );
+		if ( m_fd < 0 )
+		{
+			throw IOException( "FileIndexedIO: Cannot open file '" + filename + "' for read" );
+		}
+
+		if ( mode & IndexedIO::MemoryMapped )
+		{
+			struct stat s;
+			if ( ::fstat( m_fd, &s ) != 0 )
+			{
+				::close( m_fd );
+				throw IOException( "FileIndexedIO: Cannot determine size of file '" + filename + "'" );
+			}
+
+			m_mappedSize = s.st_size;
+			void *data = ::mmap( 0, m_mappedSize, PROT_READ, MAP_SHARED, m_fd, 0 );
+			if ( data == MAP_FAILED )
+			{
+				::close( m_fd );
+				throw IOException( "FileIndexedIO: Cannot memory map file '" + filename + "'" );
+			}
+			m_mappedData = static_cast<const char *>( data );
+		}
+	}
+}
+
+void FileIndexedIO::StreamFile::checkRange( size_t size, size_t pos ) const
+{
+	if ( pos > m_mappedSize || size > m_mappedSize - pos )
+	{
+		throw IOException( ( boost::format( "FileIndexedIO: Unexpected end of file reading %d bytes at offset %d from file '%s'" ) % size % pos % m_filename ).str() );
+	}
+}
+
+const char *FileIndexedIO::StreamFile::readBuffer( size_t size, size_t pos )
+{
+	if ( !m_mappedData )
+	{
+		return StreamIndexedIO::StreamFile::readBuffer( size, pos );
+	}
+
+	checkRange( size, pos );
+	return m_mappedData + pos;
+}
+
+void FileIndexedIO::StreamFile::read( char *buffer, size_t size, size_t pos )
+{
+	if ( m_mappedData )
+	{
+		checkRange( size, pos );
+		memcpy( buffer, m_mappedData + pos, size );
+		return;
+	}
+
+	if ( m_fd < 0 )
+	{
+		StreamIndexedIO::StreamFile::read( buffer, size, pos );
+		return;
+	}
+
+	while ( size )
+	{
+		ssize_t n = ::pread( m_fd, buffer, size, pos );
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+			{
+				continue;
+			}
+			throw IOException( ( boost::format( "FileIndexedIO: Error reading %d bytes at offset %d from file '%s'" ) % size % pos % m_filename ).str() );
+		}
+		else if ( n == 0 )
+		{
+			throw IOException( ( boost::format( "FileIndexedIO: Unexpected end of file reading %d bytes at offset %d from file '%s'" ) % size % pos % m_filename ).str() );
+		}
+		buffer += n;
+		size -= n;
+		pos += n;
 	}
 }
 
@@ -153,6 +261,16 @@ void FileIndexedIO::StreamFile::flush( size_t endPosition )
 
 FileIndexedIO::StreamFile::~StreamFile()
 {
+	if ( m_mappedData )
+	{
+		::munmap( const_cast<char *>( m_mappedData ), m_mappedSize );
+	}
+
+	if ( m_fd >= 0 )
+	{
+		::close( m_fd );
+	}
+
 	if ( m_openmode == IndexedIO::Write || m_openmode == IndexedIO::Append )
 	{
 		std::fstream *f = static_cast< std::fstream * >( m_stream );
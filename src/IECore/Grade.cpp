@@ -232,22 +232,43 @@ void Grade::begin( const CompoundObject * operands )
 
 void Grade::transform( Imath::Color3f &color ) const
 {
-	Imath::V3d c = m_A * Imath::V3d(color) + m_B;
-	color.x = ( c.x >= 0.0 ? (float)pow( c.x, m_invGamma.x ) : c.x );
-	color.y = ( c.y >= 0.0 ? (float)pow( c.y, m_invGamma.y ) : c.y );
-	color.z = ( c.z >= 0.0 ? (float)pow( c.z, m_invGamma.z ) : c.z );
+	transformRange( &color, &color + 1 );
+}
 
-	if ( m_blackClampParameter->getTypedValue() )
-	{
-		if ( color.x < 0.0 ) color.x = 0.0;
-		if ( color.y < 0.0 ) color.y = 0.0;
-		if ( color.z < 0.0 ) color.z = 0.0;
-	}
+void Grade::transformRange( Imath::Color3f *begin, Imath::Color3f *end ) const
+{
+	const bool blackClamp = m_blackClampParameter->getTypedValue();
+	const bool whiteClamp = m_whiteClampParameter->getTypedValue();
+	// pow() dominates the cost of grading, and is unnecessary for the common case of unit gamma
+	const bool unitGamma = m_invGamma == Imath::V3d( 1.0 );
 
-	if ( m_whiteClampParameter->getTypedValue() )
+	for( Imath::Color3f *it = begin; it != end; ++it )
 	{
-		if ( color.x > 1.0 ) color.x = 1.0;
-		if ( color.y > 1.0 ) color.y = 1.0;
-		if ( color.z > 1.0 ) color.z = 1.0;
+		Imath::Color3f &color = *it;
+		Imath::V3d c = m_A * Imath::V3d(color) + m_B;
+		if( unitGamma )
+		{
+			color.setValue( (float)c.x, (float)c.y, (float)c.z );
+		}
+		else
+		{
+			color.x = ( c.x >= 0.0 ? (float)pow( c.x, m_invGamma.x ) : c.x );
+			color.y = ( c.y >= 0.0 ? (float)pow( c.y, m_invGamma.y ) : c.y );
+			color.z = ( c.z >= 0.0 ? (float)pow( c.z, m_invGamma.z ) : c.z );
+		}
+
+		if ( blackClamp )
+		{
+			if ( color.x < 0.0 ) color.x = 0.0;
+			if ( color.y < 0.0 ) color.y = 0.0;
+			if ( color.z < 0.0 ) color.z = 0.0;
+		}
+
+		if ( whiteClamp )
+		{
+			if ( color.x > 1.0 ) color.x = 1.0;
+			if ( color.y > 1.0 ) color.y = 1.0;
+			if ( color.z > 1.0 ) color.z = 1.0;
+		}
 	}
 }
@@ -33,6 +33,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <cassert>
+#include <algorithm>
 
 #include "IECore/ImageCompositeOp.h"
 #include "IECore/DespatchTypedData.h"
@@ -46,6 +47,7 @@
 #include "IECore/ScaledDataConversion.h"
 #include "IECore/TypeTraits.h"
 #include "IECore/DespatchTypedData.h"
+#include "IECore/private/ParallelImageRows.h"
 
 #include "OpenEXR/ImathVec.h"
 #include "OpenEXR/ImathBox.h"
@@ -242,31 +244,103 @@ FloatVectorDataPtr ImageCompositeOp::getChannelData( ImagePrimitive * image, con
 		>( it->second.data.get(), converter );
 }
 
-float ImageCompositeOp::readChannelData( const ImagePrimitive * image, const FloatVectorData * data, const V2i &pixel )
+struct ImageCompositeOp::CompositeRows
 {
-	assert( image );
-	assert( data );
-
-	V2i offset = pixel - image->getDataWindow().min;
-	if ( offset.x < 0 || offset.y < 0 )
+	typedef std::vector<FloatVectorDataPtr> Channels;
+
+	CompositeRows(
+		CompositeFn fn,
+		const Channels &aChannels, const FloatVectorData *aAlphaData, const Box2i &aDataWindow,
+		const Channels &bChannels, const FloatVectorData *bAlphaData, const Box2i &bDataWindow,
+		Channels &resultChannels, const Box2i &resultDataWindow
+	)
+		:	m_fn( fn ),
+			m_aAlphaData( readable( aAlphaData ) ), m_aDataWindow( aDataWindow ),
+			m_bAlphaData( readable( bAlphaData ) ), m_bDataWindow( bDataWindow ),
+			m_resultDataWindow( resultDataWindow )
 	{
-		return 0.0f;
+		assert( aChannels.size() == bChannels.size() && bChannels.size() == resultChannels.size() );
+		for( size_t c = 0; c < resultChannels.size(); ++c )
+		{
+			m_aData.push_back( readable( aChannels[c].get() ) );
+			m_bData.push_back( readable( bChannels[c].get() ) );
+			// writable() isn't safe to call concurrently, so we call it once up front
+			m_result.push_back( &resultChannels[c]->writable()[0] );
+		}
 	}
 
-	const int width = image->getDataWindow().size().x + 1;
-	const int height = image->getDataWindow().size().y + 1;
-
-	if ( offset.x >= width || offset.y >= height )
+	void operator()( int yBegin, int yEnd, size_t channel ) const
 	{
-		return 0.0f;
+		const int width = m_resultDataWindow.size().x + 1;
+
+		std::vector<float> rows( width * 4 );
+		float *aRow = &rows[0];
+		float *aAlphaRow = aRow + width;
+		float *bRow = aAlphaRow + width;
+		float *bAlphaRow = bRow + width;
+
+		for( int y = yBegin; y != yEnd; ++y )
+		{
+			readRow( m_aData[channel], m_aDataWindow, y, 0.0f, aRow );
+			readRow( m_aAlphaData, m_aDataWindow, y, 1.0f, aAlphaRow );
+			readRow( m_bData[channel], m_bDataWindow, y, 0.0f, bRow );
+			readRow( m_bAlphaData, m_bDataWindow, y, 1.0f, bAlphaRow );
+
+			float *out = m_result[channel] + ( y - m_resultDataWindow.min.y ) * width;
+			for( int x = 0; x < width; ++x )
+			{
+				out[x] = m_fn( aRow[x], aAlphaRow[x], bRow[x], bAlphaRow[x] );
+			}
+		}
 	}
 
-	const int idx = offset.y * width + offset.x;
+	private :
 
-	assert( idx >= 0 );
-	assert( idx < (int)data->readable().size() );
-	return data->readable()[ idx ];
-}
+		static const std::vector<float> *readable( const FloatVectorData *data )
+		{
+			return data ? &data->readable() : 0;
+		}
+
+		// Fills row with the values of data for row y of the result data window. Pixels
+		// outside dataWindow are 0, and if data is 0 then all pixels take the default value.
+		void readRow( const std::vector<float> *data, const Box2i &dataWindow, int y, float defaultValue, float *row ) const
+		{
+			const int width = m_resultDataWindow.size().x + 1;
+			if( !data )
+			{
+				std::fill( row, row + width, defaultValue );
+				return;
+			}
+
+			std::fill( row, row + width, 0.0f );
+			if( y < dataWindow.min.y || y > dataWindow.max.y )
+			{
+				return;
+			}
+
+			const int xMin = std::max( dataWindow.min.x, m_resultDataWindow.min.x );
+			const int xMax = std::min( dataWindow.max.x, m_resultDataWindow.max.x );
+			if( xMin > xMax )
+			{
+				return;
+			}
+
+			const int dataWidth = dataWindow.size().x + 1;
+			const float *src = &(*data)[0] + ( y - dataWindow.min.y ) * dataWidth + ( xMin - dataWindow.min.x );
+			std::copy( src, src + ( xMax - xMin + 1 ), row + ( xMin - m_resultDataWindow.min.x ) );
+		}
+
+		CompositeFn m_fn;
+		std::vector<const std::vector<float> *> m_aData;
+		const std::vector<float> *m_aAlphaData;
+		const Box2i &m_aDataWindow;
+		std::vector<const std::vector<float> *> m_bData;
+		const std::vector<float> *m_bAlphaData;
+		const Box2i &m_bDataWindow;
+		std::vector<float *> m_result;
+		const Box2i &m_resultDataWindow;
+
+};
 
 void ImageCompositeOp::composite( CompositeFn fn, DataWindowResult dwr, ImagePrimitive * imageB, const CompoundObject * operands )
 {
@@ -363,6 +437,9 @@ void ImageCompositeOp::composite( CompositeFn fn, DataWindowResult dwr, ImagePri
 
 	assert( newArea == (int)imageB->variableSize( PrimitiveVariable::Vertex ) );
 
+	const Box2i aDataWindow = imageA->getDataWindow();
+
+	CompositeRows::Channels aChannels, bChannels, newBChannels;
 	for( unsigned i=0; i<channelNames.size(); i++ )
 	{
 		const StringVectorParameter::ValueType::value_type &channelName = channelNames[i];
@@ -376,22 +453,21 @@ void ImageCompositeOp::composite( CompositeFn fn, DataWindowResult dwr, ImagePri
 		newBData->writable().resize( newArea );
 		imageB->variables[ channelName ].data = newBData;
 
-		for ( int y = newDataWindow.min.y; y <= newDataWindow.max.y; y++ )
-		{
-			int offset = (y - newDataWindow.min.y ) * newWidth;
-			for ( int x = newDataWindow.min.x; x <= newDataWindow.max.x; x++, offset++ )
-			{
-				float aVal = readChannelData( imageA.get(), aData.get(), V2i( x, y ) );
-				float bVal = readChannelData( imageB, bData.get(), V2i( x, y ) );
-
-				float aAlpha = aAlphaData ? readChannelData( imageA.get(), aAlphaData.get(), V2i( x, y ) ) : 1.0f;
-				float bAlpha = bAlphaData ? readChannelData( imageB, bAlphaData.get(), V2i( x, y ) ) : 1.0f;
+		aChannels.push_back( aData );
+		bChannels.push_back( bData );
+		newBChannels.push_back( newBData );
+	}
 
-				assert( offset >= 0 );
-				assert( offset < (int)newBData->readable().size() );
-				newBData->writable()[ offset  ] = fn( aVal, aAlpha, bVal, bAlpha );
-			}
-		}
+	if( newArea )
+	{
+		// the rows are independent, so we composite blocks of them in parallel
+		CompositeRows compositeRows(
+			fn,
+			aChannels, aAlphaData.get(), aDataWindow,
+			bChannels, bAlphaData.get(), newDataWindow,
+			newBChannels, newDataWindow
+		);
+		parallelForImageRows( newDataWindow, newBChannels.size(), compositeRows );
 	}
 
 	/// displayWindow should be unchanged
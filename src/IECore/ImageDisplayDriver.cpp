@@ -45,18 +45,21 @@ IE_CORE_DEFINERUNTIMETYPED( ImageDisplayDriver );
 
 const DisplayDriver::DisplayDriverDescription<ImageDisplayDriver> ImageDisplayDriver::g_description;
 
-typedef std::map<std::string, ConstImagePrimitivePtr> ImagePool;
+// We store the drivers rather than the images, so that copies of the
+// images can be made safely while the drivers are still receiving data.
+typedef std::map<std::string, ConstImageDisplayDriverPtr> ImagePool;
 static ImagePool g_pool;
 static tbb::mutex g_poolMutex;
 
 ImageDisplayDriver::ImageDisplayDriver( const Box2i &displayWindow, const Box2i &dataWindow, const vector<string> &channelNames, ConstCompoundDataPtr parameters ) :
 		DisplayDriver( displayWindow, dataWindow, channelNames, parameters ),
-		m_image( new ImagePrimitive( dataWindow, displayWindow ) )
+		m_image( new ImagePrimitive( dataWindow, displayWindow ) ), m_channelDataValid( false )
 {
 	for ( vector<string>::const_iterator it = channelNames.begin(); it != channelNames.end(); it++ )
 	{
-		m_image->createChannel<float>( *it );
+		m_channels.push_back( m_image->createChannel<float>( *it ) );
 	}
+	m_channelData.resize( m_channels.size(), 0 );
 	if( parameters )
 	{
 		CompoundDataMap &xData = m_image->blindData()->writable();
@@ -71,7 +74,7 @@ ImageDisplayDriver::ImageDisplayDriver( const Box2i &displayWindow, const Box2i
 		if( handle )
 		{
 			tbb::mutex::scoped_lock lock( g_poolMutex );
-			g_pool[handle->readable()] = m_image;
+			g_pool[handle->readable()] = this;
 		}
 	}
 }
@@ -92,44 +95,61 @@ bool ImageDisplayDriver::acceptsRepeatedData() const
 
 void ImageDisplayDriver::imageData( const Box2i &box, const float *data, size_t dataSize )
 {
-	Box2i tmpBox = box;
-	Box2i dataWindow = m_image->getDataWindow();
-	tmpBox.extendBy( dataWindow );
-	if ( tmpBox != dataWindow )
+	const Box2i &dataWindow = m_image->getDataWindow();
+	if(
+		box.min.x < dataWindow.min.x || box.min.y < dataWindow.min.y ||
+		box.max.x > dataWindow.max.x || box.max.y > dataWindow.max.y ||
+		box.min.x > box.max.x || box.min.y > box.max.y
+	)
 	{
 		throw Exception("The box is outside image data window.");
 	}
 
-	int pixelSize = channelNames().size();
-	if ( dataSize != (box.max.x - box.min.x + 1) * (box.max.y - box.min.y + 1) * channelNames().size() )
+	const size_t pixelSize = m_channels.size();
+	const int sourceWidth = box.max.x - box.min.x + 1;
+	const int sourceHeight = box.max.y - box.min.y + 1;
+	if ( dataSize != sourceWidth * sourceHeight * pixelSize )
 	{
 		throw Exception("Invalid dataSize value.");
 	}
 
-	int channel, targetX, targetY, sourceWidth, sourceHeight, targetWidth;
-	sourceWidth = box.max.x - box.min.x + 1;
-	sourceHeight = box.max.y - box.min.y + 1;
-	targetWidth = dataWindow.max.x - dataWindow.min.x + 1;
-	channel = 0;
-	targetX = box.min.x - dataWindow.min.x;
-	targetY = box.min.y - dataWindow.min.y;
-
-	for ( vector<string>::const_iterator it = channelNames().begin(); it != channelNames().end(); it++, channel++ )
+	// Buckets don't overlap, so they can be written concurrently while holding
+	// a read lock. If image() has shared the data with a copy since the last
+	// bucket, we must first call writable() to give ourselves our own copy
+	// to write to, which requires a write lock.
+	Mutex::scoped_lock lock( m_mutex, /* write = */ false );
+	if( !m_channelDataValid )
 	{
-		vector< float > &target = boost::static_pointer_cast< FloatVectorData >(m_image->variables[ *it ].data)->writable();
-		vector< float >::iterator targetIt;
-		const float *sourceIt = data+channel;
-		targetIt = target.begin()+targetWidth*targetY+targetX;
+		lock.upgrade_to_writer();
+		// we may have been beaten to it while upgrading
+		if( !m_channelDataValid )
+		{
+			for( size_t i = 0; i < m_channels.size(); ++i )
+			{
+				m_channelData[i] = &m_channels[i]->writable()[0];
+			}
+			m_channelDataValid = true;
+		}
+		lock.downgrade_to_reader();
+	}
 
-		for ( int y = 0; y < sourceHeight; y++ )
+	const int targetWidth = dataWindow.max.x - dataWindow.min.x + 1;
+	size_t targetOffset = targetWidth * ( box.min.y - dataWindow.min.y ) + ( box.min.x - dataWindow.min.x );
+	const size_t sourceRowSize = sourceWidth * pixelSize;
+
+	// We de-interleave a row at a time, so although each channel makes a strided pass
+	// over the source row, the row stays in cache and the source is only fetched from
+	// memory once. The writes for each channel are contiguous.
+	for ( int y = 0; y < sourceHeight; y++, data += sourceRowSize, targetOffset += targetWidth )
+	{
+		for ( size_t channel = 0; channel < pixelSize; channel++ )
 		{
+			const float *source = data + channel;
+			float *target = m_channelData[channel] + targetOffset;
 			for ( int x = 0; x < sourceWidth; x++ )
 			{
-				*targetIt = *sourceIt;
-				sourceIt += pixelSize;
-				targetIt++;
+				target[x] = source[x * pixelSize];
 			}
-			targetIt += targetWidth - sourceWidth;
 		}
 	}
 }
@@ -140,7 +160,12 @@ void ImageDisplayDriver::imageClose()
 
 ConstImagePrimitivePtr ImageDisplayDriver::image() const
 {
-	return m_image;
+	// The write lock waits for any buckets being written to complete. The
+	// copy shares the channel data with m_image, so the next imageData()
+	// call must call writable() again before writing.
+	Mutex::scoped_lock lock( m_mutex, /* write = */ true );
+	m_channelDataValid = false;
+	return m_image->copy();
 }
 
 ConstImagePrimitivePtr ImageDisplayDriver::storedImage( const std::string &handle )
@@ -149,7 +174,7 @@ ConstImagePrimitivePtr ImageDisplayDriver::storedImage( const std::string &handl
 	ImagePool::const_iterator it = g_pool.find( handle );
 	if( it != g_pool.end() )
 	{
-		return it->second;
+		return it->second->image();
 	}
 	return 0;
 }
@@ -161,7 +186,7 @@ ConstImagePrimitivePtr ImageDisplayDriver::removeStoredImage( const std::string
 	ImagePool::iterator it = g_pool.find( handle );
 	if( it != g_pool.end() )
 	{
-		result = it->second;
+		result = it->second->image();
 		g_pool.erase( it );
 	}
 	return result;
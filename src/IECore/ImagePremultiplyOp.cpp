@@ -39,6 +39,7 @@
 #include "IECore/CompoundParameter.h"
 #include "IECore/DataConvert.h"
 #include "IECore/ScaledDataConversion.h"
+#include "IECore/private/ParallelImageRows.h"
 
 using namespace IECore;
 
@@ -82,34 +83,28 @@ struct ImagePremultiplyOp::ToFloatVectorData
 
 struct ImagePremultiplyOp::PremultFn
 {
-	typedef void ReturnType;
+	const std::vector<float *> &m_channels;
+	const float *m_alpha;
+	const Imath::Box2i &m_dataWindow;
 
-	const FloatVectorData *m_alphaChannel;
-
-	PremultFn( const FloatVectorData *alphaChannel ) : m_alphaChannel( alphaChannel )
+	PremultFn( const std::vector<float *> &channels, const float *alpha, const Imath::Box2i &dataWindow )
+		:	m_channels( channels ), m_alpha( alpha ), m_dataWindow( dataWindow )
 	{
-		assert( m_alphaChannel );
+		assert( m_alpha );
 	}
 
-	template<typename T>
-	ReturnType operator()( T *dataPtr )
+	void operator()( int yBegin, int yEnd, size_t channel ) const
 	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type ValueType;
-
-		ScaledDataConversion< ValueType, float > toFloat;
-		ScaledDataConversion< float, ValueType > fromFloat;
-
-		FloatVectorData::ValueType::const_iterator alphaIt = m_alphaChannel->readable().begin();
-
-		Container &data = dataPtr->writable();
-		for ( typename Container::iterator it = data.begin(); it != data.end(); ++it, ++alphaIt )
+		const size_t width = m_dataWindow.size().x + 1;
+		const size_t begin = ( yBegin - m_dataWindow.min.y ) * width;
+		const size_t end = ( yEnd - m_dataWindow.min.y ) * width;
+
+		// a simple loop over raw pointers, which the compiler is free to vectorise
+		const float *alpha = m_alpha;
+		float *data = m_channels[channel];
+		for( size_t i = begin; i != end; ++i )
 		{
-			float channelValue = toFloat( *it );
-
-			channelValue *= *alphaIt;
-
-			*it = fromFloat( channelValue );
+			data[i] *= alpha[i];
 		}
 	}
 };
@@ -135,9 +130,24 @@ void ImagePremultiplyOp::modifyChannels( const Imath::Box2i &displayWindow, cons
 
 	FloatVectorDataPtr alphaData = despatchTypedData< ToFloatVectorData, TypeTraits::IsNumericVectorTypedData >( it->second.data.get() );
 
-	ImagePremultiplyOp::PremultFn fn( alphaData.get() );
+	std::vector<float *> channelData;
 	for ( ChannelVector::iterator it = channels.begin(); it != channels.end(); it++ )
 	{
-		despatchTypedData<ImagePremultiplyOp::PremultFn, TypeTraits::IsNumericVectorTypedData>( it->get(), fn );
+		if( (*it)->readable().size() != alphaData->readable().size() )
+		{
+			throw InvalidArgumentException( "ImagePremultiplyOp: Alpha channel has wrong size" );
+		}
+		if( (*it)->readable().size() )
+		{
+			channelData.push_back( &(*it)->writable()[0] );
+		}
 	}
+
+	if( !channelData.size() )
+	{
+		return;
+	}
+
+	ImagePremultiplyOp::PremultFn fn( channelData, &alphaData->readable()[0], dataWindow );
+	parallelForImageRows( dataWindow, channelData.size(), fn );
 }
@@ -43,6 +43,10 @@
 #include "IECore/BoxOps.h"
 #include "IECore/ColorSpaceTransformOp.h"
 
+#include "boost/format.hpp"
+
+#include <algorithm>
+
 using namespace std;
 using namespace IECore;
 using namespace boost;
@@ -130,24 +134,25 @@ ObjectPtr ImageReader::doOperation( const CompoundObject *operands )
 	ImagePrimitivePtr image = new ImagePrimitive( dataWind, displayWind );
 
 	// fetch all the user-desired channels with
-
-	// the derived class' readChannel() implementation
+	// the derived class' readChannels() implementation
 
 	vector<string> channelNames;
 	channelsToRead( channelNames );
 
-	vector<string>::const_iterator ci = channelNames.begin();
-	while( ci != channelNames.end() )
+	vector<DataPtr> channels;
+	readChannels( channelNames, dataWind, rawChannels, channels );
+	assert( channels.size() == channelNames.size() );
+
+	for( size_t i = 0; i < channelNames.size(); ++i )
 	{
-		DataPtr d = readChannel( *ci, dataWind, rawChannels );
+		DataPtr d = channels[i];
 		assert( d  );
 		assert( rawChannels || d->typeId()==FloatVectorDataTypeId );
 
 		PrimitiveVariable p( PrimitiveVariable::Vertex, d );
 		assert( image->isPrimitiveVariableValid( p ) );
 
-		image->variables[*ci] = p;
-		ci++;
+		image->variables[channelNames[i]] = p;
 	}
 
 	if ( colorspace != "linear" && !rawChannels )
@@ -187,6 +192,57 @@ DataPtr ImageReader::readChannel( const std::string &name, bool raw )
 	return readChannel( name, d, raw );
 }
 
+int ImageReader::numBands( int bandHeight )
+{
+	if( bandHeight < 1 )
+	{
+		throw InvalidArgumentException( "ImageReader : Band height must be greater than 0" );
+	}
+
+	Box2i d = dataWindowToRead();
+	return ( d.size().y + bandHeight ) / bandHeight;
+}
+
+ImagePrimitivePtr ImageReader::readBand( int bandIndex, int bandHeight )
+{
+	if( bandIndex < 0 || bandIndex >= numBands( bandHeight ) )
+	{
+		throw InvalidArgumentException( ( boost::format( "ImageReader : Band %d is out of range" ) % bandIndex ).str() );
+	}
+
+	const Box2i d = dataWindowToRead();
+	const int minY = d.min.y + bandIndex * bandHeight;
+	const Box2i band( V2i( d.min.x, minY ), V2i( d.max.x, std::min( minY + bandHeight - 1, d.max.y ) ) );
+
+	// we read the band by temporarily changing the dataWindow parameter, so that
+	// we go through exactly the same code path as read() does.
+	const Box2i originalDataWindow = m_dataWindowParameter->getTypedValue();
+	m_dataWindowParameter->setTypedValue( band );
+	ObjectPtr result;
+	try
+	{
+		result = read();
+	}
+	catch( ... )
+	{
+		m_dataWindowParameter->setTypedValue( originalDataWindow );
+		throw;
+	}
+	m_dataWindowParameter->setTypedValue( originalDataWindow );
+
+	return boost::static_pointer_cast<ImagePrimitive>( result );
+}
+
+void ImageReader::readChannels( const std::vector<std::string> &names, const Imath::Box2i &dataWindow, bool raw, std::vector<DataPtr> &channels )
+{
+	channels.clear();
+	channels.reserve( names.size() );
+	for( vector<string>::const_iterator it = names.begin(); it != names.end(); ++it )
+	{
+		channels.push_back( readChannel( *it, dataWindow, raw ) );
+	}
+}
+
 void ImageReader::channelsToRead( vector<string> &names )
 {
 	vector<string> allNames;
@@ -39,6 +39,7 @@
 #include "IECore/CompoundParameter.h"
 #include "IECore/DataConvert.h"
 #include "IECore/ScaledDataConversion.h"
+#include "IECore/private/ParallelImageRows.h"
 
 using namespace IECore;
 
@@ -82,37 +83,28 @@ struct ImageUnpremultiplyOp::ToFloatVectorData
 
 struct ImageUnpremultiplyOp::UnpremultFn
 {
-	typedef void ReturnType;
+	const std::vector<float *> &m_channels;
+	const float *m_alpha;
+	const Imath::Box2i &m_dataWindow;
 
-	const FloatVectorData * m_alphaChannel;
-
-	UnpremultFn( const FloatVectorData * alphaChannel ) : m_alphaChannel( alphaChannel )
+	UnpremultFn( const std::vector<float *> &channels, const float *alpha, const Imath::Box2i &dataWindow )
+		:	m_channels( channels ), m_alpha( alpha ), m_dataWindow( dataWindow )
 	{
-		assert( m_alphaChannel );
+		assert( m_alpha );
 	}
 
-	template<typename T>
-	ReturnType operator()( T *dataPtr )
+	void operator()( int yBegin, int yEnd, size_t channel ) const
 	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type ValueType;
-
-		ScaledDataConversion< ValueType, float > toFloat;
-		ScaledDataConversion< float, ValueType > fromFloat;
-
-		FloatVectorData::ValueType::const_iterator alphaIt = m_alphaChannel->readable().begin();
-
-		Container &data = dataPtr->writable();
-		for ( typename Container::iterator it = data.begin(); it != data.end(); ++it, ++alphaIt )
+		const size_t width = m_dataWindow.size().x + 1;
+		const size_t begin = ( yBegin - m_dataWindow.min.y ) * width;
+		const size_t end = ( yEnd - m_dataWindow.min.y ) * width;
+
+		// a simple loop over raw pointers, which the compiler is free to vectorise
+		const float *alpha = m_alpha;
+		float *data = m_channels[channel];
+		for( size_t i = begin; i != end; ++i )
 		{
-			float channelValue = toFloat( *it );
-
-			if ( fabsf(*alphaIt) > 0.0f )
-			{
-				channelValue /= *alphaIt;
-			}
-
-			*it = fromFloat( channelValue );
+			data[i] = fabsf( alpha[i] ) > 0.0f ? data[i] / alpha[i] : data[i];
 		}
 	}
 };
@@ -138,9 +130,24 @@ void ImageUnpremultiplyOp::modifyChannels( const Imath::Box2i &displayWindow, co
 
 	FloatVectorDataPtr alphaData = despatchTypedData< ToFloatVectorData, TypeTraits::IsNumericVectorTypedData >( it->second.data.get() );
 
-	ImageUnpremultiplyOp::UnpremultFn fn( alphaData.get() );
+	std::vector<float *> channelData;
 	for ( ChannelVector::iterator it = channels.begin(); it != channels.end(); it++ )
 	{
-		despatchTypedData<ImageUnpremultiplyOp::UnpremultFn, TypeTraits::IsNumericVectorTypedData>( it->get(), fn );
+		if( (*it)->readable().size() != alphaData->readable().size() )
+		{
+			throw InvalidArgumentException( "ImageUnpremultiplyOp: Alpha channel has wrong size" );
+		}
+		if( (*it)->readable().size() )
+		{
+			channelData.push_back( &(*it)->writable()[0] );
+		}
 	}
+
+	if( !channelData.size() )
+	{
+		return;
+	}
+
+	ImageUnpremultiplyOp::UnpremultFn fn( channelData, &alphaData->readable()[0], dataWindow );
+	parallelForImageRows( dataWindow, channelData.size(), fn );
 }
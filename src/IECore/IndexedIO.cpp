@@ -104,7 +104,8 @@ void IndexedIO::validateOpenMode(IndexedIO::OpenMode &mode)
 {
 	// Clear 'other' bits
 	mode &= IndexedIO::Read | IndexedIO::Write | IndexedIO::Append
-			| IndexedIO::Shared | IndexedIO::Exclusive;
+			| IndexedIO::Shared | IndexedIO::Exclusive | IndexedIO::MemoryMapped
+			| IndexedIO::Compressed;
 
 	// Check for mutual exclusivity
 	if ((mode & IndexedIO::Shared)
@@ -119,6 +120,12 @@ void IndexedIO::validateOpenMode(IndexedIO::OpenMode &mode)
 		throw InvalidArgumentException("Incorrect IndexedIO open mode specified");
 	}
 
+	if ((mode & IndexedIO::MemoryMapped)
+		&& (mode & (IndexedIO::Write | IndexedIO::Append)))
+	{
+		throw InvalidArgumentException("Incorrect IndexedIO open mode specified");
+	}
+
 	// Set up default as 'read'
 	if (!(mode & IndexedIO::Read
 		|| mode & IndexedIO::Write
@@ -34,11 +34,13 @@
 
 #include <string.h>
 
-#include "tbb/spin_rw_mutex.h"
+#include <vector>
+
+#include "tbb/spin_mutex.h"
+#include "tbb/atomic.h"
 #include "tbb/concurrent_hash_map.h"
 
-#include "boost/multi_index_container.hpp"
-#include "boost/multi_index/hashed_index.hpp"
+#include "boost/scoped_array.hpp"
 #include "boost/lexical_cast.hpp"
 
 #include "IECore/InternedString.h"
@@ -49,150 +51,217 @@ namespace IECore
 namespace Detail
 {
 
-// Simple type for specifying a range of characters, to
-// represent non-null-terminated strings.
-typedef std::pair<const char *, const char *> CharRange;
+// Dan Bernstein's original string hash, followed by a finalisation
+// step to spread the bits, as we use the low bits to choose both the
+// shard and the slot within it.
+static inline size_t hash( const char *value, size_t length )
+{
+	size_t hash = 5381;
+	for( const char *s = value, *e = value + length; s != e; ++s )
+	{
+		hash = ( ( hash << 5 ) + hash ) + *s;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+	return hash;
+}
 
-// Hash for strings of various types.
-// By overloading it for multiple types, we are able to do
-// lookups into HashSet using any type as a key, and without
-// needing to construct a temporary std::string when the type
-// is a raw c string.
-struct Hash
+// A unique string, along with its hash so that lookups can
+// reject most mismatches without comparing the strings.
+struct Entry
 {
 
-	// Dan Bernstein's original string hash
-	size_t operator()( const char *s ) const
+	Entry( const char *value, size_t length, size_t hash )
+		:	value( value, length ), hash( hash )
 	{
-		size_t hash = 5381;
-		while( *s )
+	}
+
+	const std::string value;
+	const size_t hash;
+
+};
+
+// An open addressing hash table of Entries, using linear probing.
+// Entries are only ever added, so it is safe to call find() concurrently
+// with insert(), provided insert() itself is serialised.
+class Table
+{
+
+	public :
+
+		Table( size_t capacity )
+			:	m_mask( capacity - 1 ), m_slots( new tbb::atomic<Entry *>[capacity] )
 		{
-			hash = ( ( hash << 5 ) + hash ) + *s++;
+			for( size_t i = 0; i < capacity; ++i )
+			{
+				m_slots[i] = 0;
+			}
 		}
 
-		return hash;
-	}
+		size_t capacity() const
+		{
+			return m_mask + 1;
+		}
 
-	size_t operator()( const std::string &s ) const
-	{
-		return (*this)( s.c_str() );
-	}
+		const Entry *find( const char *value, size_t length, size_t hash ) const
+		{
+			for( size_t i = hash & m_mask; ; i = ( i + 1 ) & m_mask )
+			{
+				// tbb::atomic loads have acquire semantics, so the
+				// Entry is guaranteed to be fully constructed.
+				const Entry *entry = m_slots[i];
+				if( !entry )
+				{
+					return 0;
+				}
+				if( entry->hash == hash && entry->value.size() == length && memcmp( entry->value.data(), value, length ) == 0 )
+				{
+					return entry;
+				}
+			}
+		}
 
-	size_t operator()( const CharRange &range ) const
-	{
-		size_t hash = 5381;
-		for( const char *s = range.first; s != range.second; ++s )
+		// The table must have room for the new entry.
+		void insert( Entry *entry )
 		{
-			hash = ( ( hash << 5 ) + hash ) + *s;
+			for( size_t i = entry->hash & m_mask; ; i = ( i + 1 ) & m_mask )
+			{
+				if( !m_slots[i] )
+				{
+					m_slots[i] = entry;
+					return;
+				}
+			}
 		}
 
-		return hash;
-	}
+		// Inserts all the entries from other.
+		void insert( const Table &other )
+		{
+			for( size_t i = 0; i <= other.m_mask; ++i )
+			{
+				if( Entry *entry = other.m_slots[i] )
+				{
+					insert( entry );
+				}
+			}
+		}
+
+	private :
+
+		const size_t m_mask;
+		boost::scoped_array< tbb::atomic<Entry *> > m_slots;
 
 };
 
-// Equality operator between strings of various types.
-// As above, this allows HashSet lookups to be performed
-// using any type, without the overhead of constructing
-// temporary std::strings.
-struct Equal
+// One of several independent tables, chosen by hash. Lookups of existing
+// strings are lock free and don't write to any shared memory. Insertions
+// are serialised by a mutex per shard.
+class Shard
 {
 
-	bool operator()( const std::string &s1, const std::string &s2 ) const
-	{
-		return s1 == s2;
-	}
+	public :
 
-	bool operator()( const char *c, const std::string &s ) const
-	{
-		return strcmp( c, s.c_str() )==0;
-	}
+		Shard()
+		{
+			m_size = 0;
+			m_table = new Table( 64 );
+			m_tables.push_back( m_table );
+		}
 
-	bool operator()( const std::string &s, const char *c ) const
-	{
-		return strcmp( c, s.c_str() )==0;
-	}
+		const std::string *internedString( const char *value, size_t length, size_t hash )
+		{
+			Table *table = m_table;
+			if( const Entry *entry = table->find( value, length, hash ) )
+			{
+				return &entry->value;
+			}
+
+			Mutex::scoped_lock lock( m_mutex );
+
+			// check again, as another thread may have inserted the string
+			// or grown the table since our lookup.
+			table = m_table;
+			if( const Entry *entry = table->find( value, length, hash ) )
+			{
+				return &entry->value;
+			}
+
+			if( ( m_size + 1 ) * 2 > table->capacity() )
+			{
+				// Grow the table. Other threads may still be searching the old
+				// table, so we must keep it alive - it will fail to find any
+				// strings inserted after this point, but those lookups fall back
+				// to the locked search above.
+				Table *newTable = new Table( table->capacity() * 2 );
+				newTable->insert( *table );
+				m_tables.push_back( newTable );
+				m_table = table = newTable;
+			}
+
+			Entry *entry = new Entry( value, length, hash );
+			table->insert( entry );
+			++m_size;
+
+			return &entry->value;
+		}
 
-	bool operator()( const CharRange &c, const std::string &s ) const
-	{
-		return s.compare( 0, std::string::npos, c.first, c.second - c.first )==0;
-	}
+		size_t size() const
+		{
+			return m_size;
+		}
 
-	bool operator()( const std::string &s, const CharRange &c ) const
-	{
-		return s.compare( 0, std::string::npos, c.first, c.second - c.first )==0;
-	}
+	private :
+
+		typedef tbb::spin_mutex Mutex;
+		Mutex m_mutex;
+
+		tbb::atomic<Table *> m_table;
+		tbb::atomic<size_t> m_size;
+		// All the tables ever used, including the current one. Entries
+		// and tables are never deleted, as the strings live forever.
+		std::vector<Table *> m_tables;
 
 };
 
-typedef boost::multi_index::multi_index_container<
-	std::string,
-	boost::multi_index::indexed_by<
-		boost::multi_index::hashed_unique<
-			boost::multi_index::identity<std::string>,
-			Hash,
-			Equal
-		>
-	>
-> HashSet;
-
-typedef HashSet::nth_index<0>::type Index;
-typedef HashSet::nth_index_const_iterator<0>::type ConstIterator;
-typedef tbb::spin_rw_mutex Mutex;
-
-static HashSet *hashSet()
+static const size_t g_numShards = 64;
+
+static Shard *shards()
 {
-	static HashSet g_hashSet;
-	return &g_hashSet;
+	static Shard g_shards[g_numShards];
+	return g_shards;
 }
 
-static Mutex *mutex()
+static inline const std::string *internedString( const char *value, size_t length )
 {
-	static Detail::Mutex g_mutex;
-	return &g_mutex;
+	const size_t h = hash( value, length );
+	return shards()[h % g_numShards].internedString( value, length, h / g_numShards );
 }
 
 } // namespace Detail
 
 const std::string *InternedString::internedString( const char *value )
 {
-	Detail::HashSet *hashSet = Detail::hashSet();
-	Detail::Index &hashIndex = hashSet->get<0>();
-	Detail::Mutex::scoped_lock lock( *Detail::mutex(), false ); // read-only lock
-	Detail::HashSet::const_iterator it = hashIndex.find( value );
-	if( it!=hashIndex.end() )
-	{
-		return &(*it);
-	}
-	else
-	{
-		lock.upgrade_to_writer();
-		return &(*(hashSet->insert( std::string( value ) ).first ) );
-	}
+	return Detail::internedString( value, strlen( value ) );
 }
 
 const std::string *InternedString::internedString( const char *value, size_t length )
 {
-	Detail::HashSet *hashSet = Detail::hashSet();
-	Detail::Index &hashIndex = hashSet->get<0>();
-	Detail::Mutex::scoped_lock lock( *Detail::mutex(), false ); // read-only lock
-	Detail::HashSet::const_iterator it = hashIndex.find( Detail::CharRange( value, value + length ) );
-	if( it!=hashIndex.end() )
-	{
-		return &(*it);
-	}
-	else
-	{
-		lock.upgrade_to_writer();
-		return &(*(hashSet->insert( std::string( value, length ) ).first ) );
-	}
+	return Detail::internedString( value, length );
 }
 
 size_t InternedString::numUniqueStrings()
 {
-	Detail::Mutex::scoped_lock lock( *Detail::mutex(), false ); // read-only lock
-	Detail::HashSet *hashSet = Detail::hashSet();
-	return hashSet->size();
+	size_t result = 0;
+	Detail::Shard *shards = Detail::shards();
+	for( size_t i = 0; i < Detail::g_numShards; ++i )
+	{
+		result += shards[i].size();
+	}
+	return result;
 }
 
 static InternedString g_emptyString("");
@@ -213,6 +282,15 @@ const InternedString &InternedString::numberString( int64_t number )
 	{
 		g_numbers = new NumbersMap;
 	}
+	{
+		// try a read-only lookup first, so that concurrent
+		// lookups of existing numbers don't block each other.
+		NumbersMap::const_accessor it;
+		if ( g_numbers->find( it, number ) )
+		{
+			return it->second;
+		}
+	}
 	NumbersMap::accessor it;
 	if ( g_numbers->insert( it, number ) )
 	{
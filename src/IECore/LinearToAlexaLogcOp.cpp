@@ -33,10 +33,9 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECore/LinearToAlexaLogcOp.h"
-#include "IECore/TypeTraits.h"
-#include "IECore/DespatchTypedData.h"
 #include "IECore/CompoundParameter.h"
 #include "IECore/LinearToAlexaLogcDataConversion.h"
+#include "IECore/LookupDataConversion.h"
 
 using namespace IECore;
 using namespace std;
@@ -55,30 +54,7 @@ LinearToAlexaLogcOp::~LinearToAlexaLogcOp()
 {
 }
 
-struct LinearToAlexaLogcOp::Converter
-{
-	typedef void ReturnType;
-
-	template<typename T>
-	ReturnType operator()( T * data )
-	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type V;
-		typedef typename Container::iterator It;
-		LinearToAlexaLogcDataConversion< V, V > converter;
-		It end = data->writable().end();
-		for ( It it = data->writable().begin(); it != end; it++ )
-		{
-			*it = converter( *it );
-		}
-	}
-};
-
 void LinearToAlexaLogcOp::modifyChannels( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow, ChannelVector &channels )
 {
-	LinearToAlexaLogcOp::Converter converter;
-	for ( ChannelVector::iterator it = channels.begin(); it != channels.end(); it++ )
-	{
-		despatchTypedData<LinearToAlexaLogcOp::Converter, TypeTraits::IsFloatVectorTypedData>( it->get(), converter );
-	}
+	convertDataWithLookup( LinearToAlexaLogcDataConversion<float, float>(), channels.begin(), channels.end() );
 }
@@ -33,10 +33,9 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECore/LinearToRec709Op.h"
-#include "IECore/TypeTraits.h"
-#include "IECore/DespatchTypedData.h"
 #include "IECore/CompoundParameter.h"
 #include "IECore/LinearToRec709DataConversion.h"
+#include "IECore/LookupDataConversion.h"
 
 using namespace IECore;
 using namespace std;
@@ -55,30 +54,7 @@ LinearToRec709Op::~LinearToRec709Op()
 {
 }
 
-struct LinearToRec709Op::Converter
-{
-	typedef void ReturnType;
-
-	template<typename T>
-	ReturnType operator()( T * data )
-	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type V;
-		typedef typename Container::iterator It;
-		LinearToRec709DataConversion< V, V > converter;
-		It end = data->writable().end();
-		for ( It it = data->writable().begin(); it != end; it++ )
-		{
-			*it = converter( *it );
-		}
-	}
-};
-
 void LinearToRec709Op::modifyChannels( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow, ChannelVector &channels )
 {
-	LinearToRec709Op::Converter converter;
-	for ( ChannelVector::iterator it = channels.begin(); it != channels.end(); it++ )
-	{
-		despatchTypedData<LinearToRec709Op::Converter, TypeTraits::IsFloatVectorTypedData>( it->get(), converter );
-	}
+	convertDataWithLookup( LinearToRec709DataConversion<float, float>(), channels.begin(), channels.end() );
 }
@@ -33,10 +33,9 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "IECore/LinearToSRGBOp.h"
-#include "IECore/TypeTraits.h"
-#include "IECore/DespatchTypedData.h"
 #include "IECore/CompoundParameter.h"
 #include "IECore/LinearToSRGBDataConversion.h"
+#include "IECore/LookupDataConversion.h"
 
 using namespace IECore;
 using namespace std;
@@ -55,30 +54,7 @@ LinearToSRGBOp::~LinearToSRGBOp()
 {
 }
 
-struct LinearToSRGBOp::Converter
-{
-	typedef void ReturnType;
-
-	template<typename T>
-	ReturnType operator()( T * data )
-	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type V;
-		typedef typename Container::iterator It;
-		LinearToSRGBDataConversion< V, V > converter;
-		It end = data->writable().end();
-		for ( It it = data->writable().begin(); it != end; it++ )
-		{
-			*it = converter( *it );
-		}
-	}
-};
-
 void LinearToSRGBOp::modifyChannels( const Imath::Box2i &displayWindow, const Imath::Box2i &dataWindow, ChannelVector &channels )
 {
-	LinearToSRGBOp::Converter converter;
-	for ( ChannelVector::iterator it = channels.begin(); it != channels.end(); it++ )
-	{
-		despatchTypedData<LinearToSRGBOp::Converter, TypeTraits::IsFloatVectorTypedData>( it->get(), converter );
-	}
+	convertDataWithLookup( LinearToSRGBDataConversion<float, float>(), channels.begin(), channels.end() );
 }
@@ -32,12 +32,17 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 #include "OpenEXR/ImathBoxAlgo.h"
 #include "OpenEXR/ImathLineAlgo.h"
 #include "OpenEXR/ImathMatrix.h"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
 #include "IECore/BoxOps.h"
 #include "IECore/PrimitiveVariable.h"
 #include "IECore/Exception.h"
@@ -205,7 +210,7 @@ const V3i &MeshPrimitiveEvaluator::Result::vertexIds() const
 	return m_vertexIds;
 }
 
-MeshPrimitiveEvaluator::MeshPrimitiveEvaluator( ConstMeshPrimitivePtr mesh ) : m_uvTree(0), m_haveMassProperties( false ), m_haveSurfaceArea( false ), m_haveAverageNormals( false )
+MeshPrimitiveEvaluator::MeshPrimitiveEvaluator( ConstMeshPrimitivePtr mesh, AccelerationStructure accelerationStructure ) : m_tree(0), m_bvh(0), m_uvTree(0), m_haveMassProperties( false ), m_haveSurfaceArea( false ), m_haveAverageNormals( false )
 {
 	if (! mesh )
 	{
@@ -217,24 +222,57 @@ MeshPrimitiveEvaluator::MeshPrimitiveEvaluator( ConstMeshPrimitivePtr mesh ) : m
 		throw InvalidArgumentException( "Mesh with invalid primitive variables given to MeshPrimitiveEvaluator");
 	}
 
-	m_mesh = mesh->copy();
+	initMesh( mesh );
+	m_mesh->topologyHash( m_topologyHash );
 
+	const std::vector<int> &verticesPerFace = m_mesh->verticesPerFace()->readable();
+	for ( IntVectorData::ValueType::const_iterator it = verticesPerFace.begin(); it != verticesPerFace.end(); ++it )
+	{
+		if (*it != 3 )
+		{
+			throw InvalidArgumentException( "Non-triangular mesh given to MeshPrimitiveEvaluator");
+		}
+	}
+
+	calculateTriangleBounds();
 
-	PrimitiveVariableMap::const_iterator primVarIt = m_mesh->variables.find("P");
-	if ( primVarIt == m_mesh->variables.end() )
+	if( accelerationStructure == BVHAcceleration )
 	{
-		throw InvalidArgumentException( "Mesh given to MeshPrimitiveEvaluator has no \"P\"");
+		m_bvh = new TriangleBVH( m_triangles.begin(), m_triangles.end() );
+	}
+	else
+	{
+		m_tree = new TriangleBoundTree( m_triangles.begin(), m_triangles.end() );
 	}
 
-	m_verts = runTimeCast< const V3fVectorData > ( primVarIt->second.data );
+	if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
+	{
+		m_uvTree = new UVBoundTree( m_uvTriangles.begin(), m_uvTriangles.end() );
+	}
+	else
+	{
+		m_uvTree = 0;
+	}
+}
 
-	if (! m_verts )
+void MeshPrimitiveEvaluator::initMesh( ConstMeshPrimitivePtr mesh )
+{
+	PrimitiveVariableMap::const_iterator primVarIt = mesh->variables.find("P");
+	if ( primVarIt == mesh->variables.end() )
+	{
+		throw InvalidArgumentException( "Mesh given to MeshPrimitiveEvaluator has no \"P\"");
+	}
+
+	if (! runTimeCast< const V3fVectorData > ( primVarIt->second.data ) )
 	{
 		throw InvalidArgumentException( "Mesh given to MeshPrimitiveEvaluator has no \"P\" primvar of type V3fVectorData");
 	}
 
+	m_mesh = mesh->copy();
+	m_verts = runTimeCast< const V3fVectorData > ( m_mesh->variables.find("P")->second.data );
 	m_meshVertexIds = &(m_mesh->vertexIds()->readable());
 
+	m_u = PrimitiveVariable();
 	m_u.interpolation = PrimitiveVariable::Invalid;
 	primVarIt = m_mesh->variables.find("s");
 	if ( primVarIt != m_mesh->variables.end() )
@@ -242,69 +280,108 @@ MeshPrimitiveEvaluator::MeshPrimitiveEvaluator( ConstMeshPrimitivePtr mesh ) : m
 		m_u = primVarIt->second;
 	}
 
+	m_v = PrimitiveVariable();
 	m_v.interpolation = PrimitiveVariable::Invalid;
 	primVarIt = m_mesh->variables.find("t");
 	if ( primVarIt != m_mesh->variables.end() )
 	{
 		m_v = primVarIt->second;
 	}
+}
 
-	const std::vector<int> &verticesPerFace = m_mesh->verticesPerFace()->readable();
-	m_triangles.reserve( verticesPerFace.size() );
-	m_uvTriangles.reserve( verticesPerFace.size() );
-	unsigned int triangleIdx = 0;
-	IntVectorData::ValueType::const_iterator vertexIdIt = m_meshVertexIds->begin();
-	for ( IntVectorData::ValueType::const_iterator it = verticesPerFace.begin();
-		it != verticesPerFace.end(); ++it, ++triangleIdx)
-	{
+void MeshPrimitiveEvaluator::calculateTriangleBounds()
+{
+	const size_t numTriangles = m_mesh->verticesPerFace()->readable().size();
+	const bool haveUVs = m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid;
 
-		if (*it != 3 )
-		{
-			throw InvalidArgumentException( "Non-triangular mesh given to MeshPrimitiveEvaluator");
-		}
+	// resizing to the same size never reallocates, so when we're updating
+	// an existing mesh the iterators held by the trees remain valid.
+	m_triangles.resize( numTriangles );
+	m_uvTriangles.resize( haveUVs ? numTriangles : 0 );
 
+	const std::vector<V3f> &p = m_verts->readable();
+	IntVectorData::ValueType::const_iterator vertexIdIt = m_meshVertexIds->begin();
+	for ( size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx )
+	{
 		Imath::V3i triangleVertexIds;
 
 		triangleVertexIds[0] = *vertexIdIt++;
-		assert( triangleVertexIds[0] < (int)( m_verts->readable().size() ) );
+		assert( triangleVertexIds[0] < (int)( p.size() ) );
 		triangleVertexIds[1] = *vertexIdIt++;
-		assert( triangleVertexIds[1] < (int)( m_verts->readable().size() ) );
+		assert( triangleVertexIds[1] < (int)( p.size() ) );
 		triangleVertexIds[2] = *vertexIdIt++;
-		assert( triangleVertexIds[2] < (int)( m_verts->readable().size() ) );
-
-		const V3f &p0 = m_verts->readable()[ triangleVertexIds[0] ];
-		const V3f &p1 = m_verts->readable()[ triangleVertexIds[1] ];
-		const V3f &p2 = m_verts->readable()[ triangleVertexIds[2] ];
-
-		Box3f bound( p0 );
-		bound.extendBy( p1 );
-		bound.extendBy( p2 );
+		assert( triangleVertexIds[2] < (int)( p.size() ) );
 
-		m_triangles.push_back( bound );
+		Box3f &bound = m_triangles[triangleIdx];
+		bound.makeEmpty();
+		bound.extendBy( p[ triangleVertexIds[0] ] );
+		bound.extendBy( p[ triangleVertexIds[1] ] );
+		bound.extendBy( p[ triangleVertexIds[2] ] );
 
-		if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
+		if ( haveUVs )
 		{
 			Imath::V2f uv[3];
 			triangleUVs( triangleIdx, triangleVertexIds, uv );
 
-			Box2f uvBound( uv[0] );
+			Box2f &uvBound = m_uvTriangles[triangleIdx];
+			uvBound.makeEmpty();
+			uvBound.extendBy( uv[0] );
 			uvBound.extendBy( uv[1] );
 			uvBound.extendBy( uv[2] );
-
-			m_uvTriangles.push_back( uvBound );
 		}
 	}
-	
-	m_tree = new TriangleBoundTree( m_triangles.begin(), m_triangles.end() );
+}
 
-	if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
+bool MeshPrimitiveEvaluator::updatePositions( ConstMeshPrimitivePtr mesh )
+{
+	if (! mesh )
 	{
-		m_uvTree = new UVBoundTree( m_uvTriangles.begin(), m_uvTriangles.end() );
+		throw InvalidArgumentException( "No mesh given to MeshPrimitiveEvaluator::updatePositions");
+	}
+
+	MurmurHash topologyHash;
+	mesh->topologyHash( topologyHash );
+	if( topologyHash != m_topologyHash )
+	{
+		return false;
+	}
+
+	const bool haveUVs = mesh->variables.find( "s" ) != mesh->variables.end() && mesh->variables.find( "t" ) != mesh->variables.end();
+	if( haveUVs != ( m_uvTree != 0 ) )
+	{
+		return false;
+	}
+
+	if (! mesh->arePrimitiveVariablesValid() )
+	{
+		throw InvalidArgumentException( "Mesh with invalid primitive variables given to MeshPrimitiveEvaluator::updatePositions");
+	}
+
+	initMesh( mesh );
+	calculateTriangleBounds();
+
+	if( m_bvh )
+	{
+		m_bvh->refit();
 	}
 	else
 	{
-		m_uvTree = 0;
+		m_tree->refit();
+	}
+
+	if( m_uvTree )
+	{
+		m_uvTree->refit();
+	}
+
+	m_haveMassProperties = false;
+	m_haveSurfaceArea = false;
+	if( m_haveAverageNormals )
+	{
+		updateAverageNormals();
 	}
+
+	return true;
 }
 
 PrimitiveEvaluatorPtr MeshPrimitiveEvaluator::create( ConstPrimitivePtr primitive )
@@ -317,11 +394,14 @@ PrimitiveEvaluatorPtr MeshPrimitiveEvaluator::create( ConstPrimitivePtr primitiv
 
 MeshPrimitiveEvaluator::~MeshPrimitiveEvaluator()
 {
-	assert( m_tree );
+	assert( m_tree || m_bvh );
 
 	delete m_tree;
 	m_tree = 0;
 
+	delete m_bvh;
+	m_bvh = 0;
+
 	delete m_uvTree;
 	m_uvTree = 0;
 }
@@ -491,101 +571,13 @@ void MeshPrimitiveEvaluator::calculateAverageNormals() const
 	}
 #endif
 
-	/// Build vertex connectivity. We want to be able to quickly find the list of triangles connected to each vertex.
-	typedef std::map< VertexIndex, std::set<TriangleIndex> > VertexConnectivity;
-	VertexConnectivity vertexConnectivity;
-
-	IntVectorData::ValueType::const_iterator it = m_meshVertexIds->begin();
-	int triangleIndex = 0;
-	while ( it != m_meshVertexIds->end() )
-	{
-		VertexIndex v0 = *it ++;
-		VertexIndex v1 = *it ++;
-		VertexIndex v2 = *it ++;
-
-		vertexConnectivity[ v0 ].insert( triangleIndex );
-		vertexConnectivity[ v1 ].insert( triangleIndex );
-		vertexConnectivity[ v2 ].insert( triangleIndex );
-
-		triangleIndex++;
-	}
-
-	assert( triangleIndex == (int)(verticesPerFace->readable().size()) );
-
-	/// Calculate "Angle-weighted pseudo-normal" for each vertex. A description of this, and proof of its validity for use in signed distance functions
-	/// can be found here: www.ann.jussieu.fr/~frey/papiers/PsNormTVCG.pdf
-	m_vertexAngleWeightedNormals = new V3fVectorData( );
-	m_vertexAngleWeightedNormals->writable().reserve( m_verts->readable().size() );
-
-	int numVertices = m_verts->readable().size();
-
-	for ( VertexIndex vertexIndex = 0; vertexIndex < numVertices; vertexIndex++)
-	{
-		Imath::V3f n( 0.0, 0.0, 0.0 );
-
-		const std::set<TriangleIndex> &connectedTriangles = vertexConnectivity[ vertexIndex ];
-
-		double angleTotal = 0.0;
-		for (std::set<TriangleIndex>::const_iterator faceIt = connectedTriangles.begin(); faceIt != connectedTriangles.end(); ++faceIt)
-		{
-
-			/// Find the vertices associated with this triangle
-			VertexIndex v0 = (*m_meshVertexIds)[ (*faceIt) * 3 + 0 ];
-			assert( vertexConnectivity[ v0 ].find( *faceIt ) != vertexConnectivity[ v0 ].end() );
-
-			VertexIndex v1 = (*m_meshVertexIds)[ (*faceIt) * 3 + 1 ];
-			assert( vertexConnectivity[ v1 ].find( *faceIt ) != vertexConnectivity[ v1 ].end() );
-
-			VertexIndex v2 = (*m_meshVertexIds)[ (*faceIt) * 3 + 2 ];
-			assert( vertexConnectivity[ v2 ].find( *faceIt ) != vertexConnectivity[ v2 ].end() );
-
-			/// Find the two edges that go from the current vertex (i) to the other	two triangle vertices
-			Imath::V3f e0, e1;
-			if ( v2 == vertexIndex )
-			{
-				e0 = (m_verts->readable()[ v1 ] - m_verts->readable()[ v2 ]).normalized();
-				e1 = (m_verts->readable()[ v0 ] - m_verts->readable()[ v2 ]).normalized();
-			}
-			else if ( v1 == vertexIndex )
-			{
-				e0 = (m_verts->readable()[ v2 ] - m_verts->readable()[ v1 ]).normalized();
-				e1 = (m_verts->readable()[ v0 ] - m_verts->readable()[ v1 ]).normalized();
-			}
-			else
-			{
-				assert( v0 == vertexIndex );
-
-				e0 = (m_verts->readable()[ v1 ] - m_verts->readable()[ v0 ]).normalized();
-				e1 = (m_verts->readable()[ v2 ] - m_verts->readable()[ v0 ]).normalized();
-			}
-
-			double cosAngle = e0.dot( e1 );
-			double angle = acos( cosAngle );
-			assert( angle >= -Imath::limits<double>::epsilon() );
-			angleTotal += angle;
-
-			const Imath::V3f &p0 = m_verts->readable()[ v0 ];
-			const Imath::V3f &p1 = m_verts->readable()[ v1 ];
-			const Imath::V3f &p2 = m_verts->readable()[ v2 ];
-			n += triangleNormal( p0, p1, p2 ) * angle;
-		}
-
-		n.normalize();
-
-		assert(m_vertexAngleWeightedNormals);
-
-		m_vertexAngleWeightedNormals->writable().push_back( n );
-	}
-
-	assert( m_vertexAngleWeightedNormals->readable().size() == m_verts->readable().size()  );
-
 	/// Calculate edge connectivity. For any given pair of (connected) vertices we want to be able to find the faces connected to that edge.
 	typedef std::map<Edge, std::vector<int> > EdgeConnectivity;
 
 	EdgeConnectivity edgeConnectivity;
 
-	it = m_meshVertexIds->begin();
-	triangleIndex = 0;
+	IntVectorData::ValueType::const_iterator it = m_meshVertexIds->begin();
+	int triangleIndex = 0;
 	while ( it != m_meshVertexIds->end() )
 	{
 		VertexIndex v0 = *it ++;
@@ -604,7 +596,8 @@ void MeshPrimitiveEvaluator::calculateAverageNormals() const
 		triangleIndex ++;
 	}
 
-	/// Calculate the average edge normals
+	/// Validate the edges and store them ready for the average edge normals
+	m_edgeAverageNormals.clear();
 	for (EdgeConnectivity::const_iterator it = edgeConnectivity.begin(); it != edgeConnectivity.end(); ++it)
 	{
 		if (it->second.size() > 2)
@@ -622,29 +615,75 @@ void MeshPrimitiveEvaluator::calculateAverageNormals() const
 			assert( it->second.size() == 2 );
 		}
 
-		TriangleIndex triangle0 = it->second[0];
-		TriangleIndex triangle1 = it->second[1];
+		/// The normals themselves are computed by updateAverageNormals(), which can
+		/// reuse these edges when the mesh is deformed.
+		m_edgeAverageNormals.insert( m_edgeAverageNormals.end(), EdgeAverageNormals::value_type( it->first, V3f( 0 ) ) );
+	}
+
+	updateAverageNormals();
+
+	m_haveAverageNormals = true;
+}
+
+void MeshPrimitiveEvaluator::updateAverageNormals() const
+{
+	const std::vector<V3f> &p = m_verts->readable();
 
-		VertexIndex v00 = (*m_meshVertexIds)[ triangle0 * 3 + 0 ];
-		VertexIndex v01 = (*m_meshVertexIds)[ triangle0 * 3 + 1 ];
-		VertexIndex v02 = (*m_meshVertexIds)[ triangle0 * 3 + 2 ];
+	if( !m_vertexAngleWeightedNormals )
+	{
+		m_vertexAngleWeightedNormals = new V3fVectorData();
+	}
+	std::vector<V3f> &vertexNormals = m_vertexAngleWeightedNormals->writable();
+	vertexNormals.assign( p.size(), V3f( 0 ) );
 
-		VertexIndex v10 = (*m_meshVertexIds)[ triangle1 * 3 + 0 ];
-		VertexIndex v11 = (*m_meshVertexIds)[ triangle1 * 3 + 1 ];
-		VertexIndex v12 = (*m_meshVertexIds)[ triangle1 * 3 + 2 ];
+	for( EdgeAverageNormals::iterator it = m_edgeAverageNormals.begin(); it != m_edgeAverageNormals.end(); ++it )
+	{
+		it->second = V3f( 0 );
+	}
 
-		const Imath::V3f &p00 = m_verts->readable()[ v00 ];
-		const Imath::V3f &p01 = m_verts->readable()[ v01 ];
-		const Imath::V3f &p02 = m_verts->readable()[ v02 ];
+	IntVectorData::ValueType::const_iterator it = m_meshVertexIds->begin();
+	while ( it != m_meshVertexIds->end() )
+	{
+		VertexIndex v0 = *it ++;
+		VertexIndex v1 = *it ++;
+		VertexIndex v2 = *it ++;
 
-		const Imath::V3f &p10 = m_verts->readable()[ v10 ];
-		const Imath::V3f &p11 = m_verts->readable()[ v11 ];
-		const Imath::V3f &p12 = m_verts->readable()[ v12 ];
+		const Imath::V3f &p0 = p[ v0 ];
+		const Imath::V3f &p1 = p[ v1 ];
+		const Imath::V3f &p2 = p[ v2 ];
+		const Imath::V3f n = triangleNormal( p0, p1, p2 );
 
-		m_edgeAverageNormals[ it->first ] = ( triangleNormal( p00, p01, p02 ) + triangleNormal( p10, p11, p12 ) ) / 2.0f;
+		/// Accumulate the "Angle-weighted pseudo-normal" for each vertex. A description of this, and proof of its validity for use
+		/// in signed distance functions can be found here: www.ann.jussieu.fr/~frey/papiers/PsNormTVCG.pdf
+		/// A triangle contributes only once to each distinct vertex, even if it is degenerate.
+		if( v0 != v1 && v0 != v2 )
+		{
+			vertexNormals[v0] += n * acos( (double)( (p1 - p0).normalized().dot( (p2 - p0).normalized() ) ) );
+		}
+		if( v1 != v2 )
+		{
+			vertexNormals[v1] += n * acos( (double)( (p2 - p1).normalized().dot( (p0 - p1).normalized() ) ) );
+		}
+		vertexNormals[v2] += n * acos( (double)( (p1 - p2).normalized().dot( (p0 - p2).normalized() ) ) );
+
+		/// Each edge is shared by exactly two triangles, and is stored in both directions
+		m_edgeAverageNormals.find( Edge( v0, v1 ) )->second += n;
+		m_edgeAverageNormals.find( Edge( v0, v2 ) )->second += n;
+		m_edgeAverageNormals.find( Edge( v1, v2 ) )->second += n;
+		m_edgeAverageNormals.find( Edge( v1, v0 ) )->second += n;
+		m_edgeAverageNormals.find( Edge( v2, v0 ) )->second += n;
+		m_edgeAverageNormals.find( Edge( v2, v1 ) )->second += n;
 	}
 
-	m_haveAverageNormals = true;
+	for( std::vector<V3f>::iterator nIt = vertexNormals.begin(); nIt != vertexNormals.end(); ++nIt )
+	{
+		nIt->normalize();
+	}
+
+	for( EdgeAverageNormals::iterator eIt = m_edgeAverageNormals.begin(); eIt != m_edgeAverageNormals.end(); ++eIt )
+	{
+		eIt->second /= 2.0f;
+	}
 }
 
 bool MeshPrimitiveEvaluator::signedDistance( const Imath::V3f &p, float &distance ) const
@@ -766,13 +805,11 @@ bool MeshPrimitiveEvaluator::closestPoint( const V3f &p, PrimitiveEvaluator::Res
 		return false;
 	}
 
-	assert( m_tree );
-
 	Result *mr = static_cast<Result *>( result );
 
 	float maxDistSqrd = limits<float>::max();
 
-	closestPointWalk( m_tree->rootIndex(), p, maxDistSqrd, mr );
+	closestPointQuery( p, maxDistSqrd, mr );
 
 	return true;
 }
@@ -802,8 +839,6 @@ bool MeshPrimitiveEvaluator::intersectionPoint( const Imath::V3f &origin, const
 		return false;
 	}
 
-	assert( m_tree );
-
 	Result *mr = static_cast<Result *>( result );
 
 	float maxDistSqrd = maxDistance * maxDistance;
@@ -812,10 +847,7 @@ bool MeshPrimitiveEvaluator::intersectionPoint( const Imath::V3f &origin, const
 	ray.pos = origin;
 	ray.dir = direction.normalized();
 
-	bool hit = false;
-
-	intersectionPointWalk( m_tree->rootIndex(), ray, maxDistSqrd, mr, hit );
-	return hit;
+	return intersectionPointQuery( ray, maxDistSqrd, mr );
 }
 
 int MeshPrimitiveEvaluator::intersectionPoints( const Imath::V3f &origin, const Imath::V3f &direction,
@@ -828,15 +860,13 @@ int MeshPrimitiveEvaluator::intersectionPoints( const Imath::V3f &origin, const
 		return 0;
 	}
 
-	assert( m_tree );
-
 	float maxDistSqrd = maxDistance * maxDistance;
 
 	Imath::Line3f ray;
 	ray.pos = origin;
 	ray.dir = direction.normalized();
 
-	intersectionPointsWalk( m_tree->rootIndex(), ray, maxDistSqrd, results );
+	intersectionPointsQuery( ray, maxDistSqrd, results );
 
 	return results.size();
 }
@@ -875,58 +905,148 @@ bool MeshPrimitiveEvaluator::barycentricPosition( unsigned int triangleIndex, co
 	return true;
 }
 
-void MeshPrimitiveEvaluator::closestPointWalk( TriangleBoundTree::NodeIndex nodeIndex, const V3f &p, float &closestDistanceSqrd, Result *result ) const
+struct MeshPrimitiveEvaluator::ClosestPointsFn
 {
-	assert( m_tree );
+	ClosestPointsFn( const MeshPrimitiveEvaluator *evaluator, const V3f *points, int *triangleIndices, V3f *barycentricCoordinates, float *distances, V3f *resultPoints )
+		:	m_evaluator( evaluator ), m_points( points ), m_triangleIndices( triangleIndices ),
+			m_barycentricCoordinates( barycentricCoordinates ), m_distances( distances ), m_resultPoints( resultPoints )
+	{
+	}
 
-	const TriangleBoundTree::Node &node = m_tree->node( nodeIndex );
-	if( node.isLeaf() )
+	void operator()( const tbb::blocked_range<size_t> &r ) const
 	{
-		TriangleBoundTree::Iterator *permLast = node.permLast();
-		for( TriangleBoundTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		// One Result serves the whole range, rather than one per query.
+		ResultPtr result = new Result;
+		for( size_t i = r.begin(); i != r.end(); ++i )
 		{
-			size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
-			size_t vertIdOffset = triangleIndex * 3;
-			Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
-			
-			assert( vertexIds[0] < (int)( m_verts->readable().size() ) );
-			assert( vertexIds[1] < (int)( m_verts->readable().size() ) );
-			assert( vertexIds[2] < (int)( m_verts->readable().size() ) );
-
-			V3f bary;
-			float dSqrd = triangleClosestBarycentric(
-				m_verts->readable()[vertexIds[0]],
-				m_verts->readable()[vertexIds[1]],
-				m_verts->readable()[vertexIds[2]],
-				p,
-				bary );
-
-			if (dSqrd < closestDistanceSqrd)
+			float closestDistanceSqrd = limits<float>::max();
+			m_evaluator->closestPointQuery( m_points[i], closestDistanceSqrd, result.get() );
+
+			if( m_triangleIndices )
+			{
+				m_triangleIndices[i] = result->m_triangleIdx;
+			}
+			if( m_barycentricCoordinates )
+			{
+				m_barycentricCoordinates[i] = result->m_bary;
+			}
+			if( m_distances )
+			{
+				m_distances[i] = sqrtf( closestDistanceSqrd );
+			}
+			if( m_resultPoints )
 			{
-				closestDistanceSqrd = dSqrd;
+				m_resultPoints[i] = result->m_p;
+			}
+		}
+	}
 
-				result->m_bary = bary;
-				result->m_vertexIds = vertexIds;
-				result->m_triangleIdx = triangleIndex;
+	const MeshPrimitiveEvaluator *m_evaluator;
+	const V3f *m_points;
+	int *m_triangleIndices;
+	V3f *m_barycentricCoordinates;
+	float *m_distances;
+	V3f *m_resultPoints;
+};
 
-				if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
-				{
-					result->m_uv = V2f(
-						result->floatPrimVar( m_u ),
-						result->floatPrimVar( m_v )
-					);
-				}
+void MeshPrimitiveEvaluator::closestPoints( const V3f *points, size_t numPoints, int *triangleIndices, V3f *barycentricCoordinates, float *distances, V3f *resultPoints ) const
+{
+	if( m_triangles.size() == 0 )
+	{
+		if( triangleIndices )
+		{
+			std::fill( triangleIndices, triangleIndices + numPoints, -1 );
+		}
+		return;
+	}
 
-				const Imath::V3f &p0 = m_verts->readable()[vertexIds[0]];
-				const Imath::V3f &p1 = m_verts->readable()[vertexIds[1]];
-				const Imath::V3f &p2 = m_verts->readable()[vertexIds[2]];
+	ClosestPointsFn fn( this, points, triangleIndices, barycentricCoordinates, distances, resultPoints );
+	tbb::parallel_for( tbb::blocked_range<size_t>( 0, numPoints, 64 ), fn );
+}
 
-				result->m_p = trianglePoint( p0, p1, p2, result->m_bary );
+struct MeshPrimitiveEvaluator::RayIntersectionsFn
+{
+	RayIntersectionsFn( const MeshPrimitiveEvaluator *evaluator, const V3f *origins, const V3f *directions, float maxDistance,
+		int *triangleIndices, V3f *barycentricCoordinates, float *distances, V3f *resultPoints )
+		:	m_evaluator( evaluator ), m_origins( origins ), m_directions( directions ), m_maxDistance( maxDistance ),
+			m_triangleIndices( triangleIndices ), m_barycentricCoordinates( barycentricCoordinates ),
+			m_distances( distances ), m_resultPoints( resultPoints )
+	{
+	}
 
-				result->m_n = triangleNormal( p0, p1, p2 );
+	void operator()( const tbb::blocked_range<size_t> &r ) const
+	{
+		ResultPtr result = new Result;
+		Imath::Line3f ray;
+		for( size_t i = r.begin(); i != r.end(); ++i )
+		{
+			ray.pos = m_origins[i];
+			ray.dir = m_directions[i].normalized();
+
+			float maxDistSqrd = m_maxDistance * m_maxDistance;
+			if( !m_evaluator->intersectionPointQuery( ray, maxDistSqrd, result.get() ) )
+			{
+				if( m_triangleIndices )
+				{
+					m_triangleIndices[i] = -1;
+				}
+				continue;
+			}
+
+			if( m_triangleIndices )
+			{
+				m_triangleIndices[i] = result->m_triangleIdx;
+			}
+			if( m_barycentricCoordinates )
+			{
+				m_barycentricCoordinates[i] = result->m_bary;
+			}
+			if( m_distances )
+			{
+				m_distances[i] = sqrtf( maxDistSqrd );
+			}
+			if( m_resultPoints )
+			{
+				m_resultPoints[i] = result->m_p;
 			}
 		}
 	}
+
+	const MeshPrimitiveEvaluator *m_evaluator;
+	const V3f *m_origins;
+	const V3f *m_directions;
+	float m_maxDistance;
+	int *m_triangleIndices;
+	V3f *m_barycentricCoordinates;
+	float *m_distances;
+	V3f *m_resultPoints;
+};
+
+void MeshPrimitiveEvaluator::rayIntersections( const V3f *origins, const V3f *directions, size_t numRays, int *triangleIndices,
+	V3f *barycentricCoordinates, float *distances, V3f *resultPoints, float maxDistance ) const
+{
+	if( m_triangles.size() == 0 )
+	{
+		if( triangleIndices )
+		{
+			std::fill( triangleIndices, triangleIndices + numRays, -1 );
+		}
+		return;
+	}
+
+	RayIntersectionsFn fn( this, origins, directions, maxDistance, triangleIndices, barycentricCoordinates, distances, resultPoints );
+	tbb::parallel_for( tbb::blocked_range<size_t>( 0, numRays, 64 ), fn );
+}
+
+void MeshPrimitiveEvaluator::closestPointWalk( TriangleBoundTree::NodeIndex nodeIndex, const V3f &p, float &closestDistanceSqrd, Result *result ) const
+{
+	assert( m_tree );
+
+	const TriangleBoundTree::Node &node = m_tree->node( nodeIndex );
+	if( node.isLeaf() )
+	{
+		closestPointLeaf( node.permFirst(), node.permLast(), p, closestDistanceSqrd, result );
+	}
 	else
 	{
 		/// Descend into the closest box first
@@ -1044,57 +1164,12 @@ bool MeshPrimitiveEvaluator::intersectionPointWalk( TriangleBoundTree::NodeIndex
 
 	if( node.isLeaf() )
 	{
-		TriangleBoundTree::Iterator *permLast = node.permLast();
-		bool intersects = false;
-
-		for( TriangleBoundTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
+		if( intersectionPointLeaf( node.permFirst(), node.permLast(), ray, maxDistSqrd, result ) )
 		{
-			size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
-			size_t vertIdOffset = triangleIndex * 3;
-			Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
-
-			assert( vertexIds[0] < (int)( m_verts->readable().size() ) );
-			assert( vertexIds[1] < (int)( m_verts->readable().size() ) );
-			assert( vertexIds[2] < (int)( m_verts->readable().size() ) );
-
-			const Imath::V3f &p0 = m_verts->readable()[ vertexIds[0] ];
-			const Imath::V3f &p1 = m_verts->readable()[ vertexIds[1] ];
-			const Imath::V3f &p2 = m_verts->readable()[ vertexIds[2] ];
-
-			V3f hitPoint, bary;
-			bool front;
-
-			if ( triangleRayIntersection( p0, p1, p2, ray.pos, ray.dir, hitPoint, bary, front ) )
-			{
-				float dSqrd = vecDistance2( hitPoint, ray.pos );
-
-				if (dSqrd < maxDistSqrd)
-				{
-					maxDistSqrd = dSqrd;
-
-					result->m_bary = bary;
-					result->m_vertexIds = vertexIds;
-					result->m_triangleIdx = triangleIndex;
-
-					result->m_p = hitPoint;
-
-					if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
-					{
-						result->m_uv = V2f(
-							result->floatPrimVar( m_u ),
-							result->floatPrimVar( m_v )
-						);
-					}
-
-					result->m_n = triangleNormal( p0, p1, p2 );
-
-					intersects = true;
-					hit = true;
-				}
-			}
+			hit = true;
+			return true;
 		}
-
-		return intersects;
+		return false;
 	}
 	else
 	{
@@ -1204,53 +1279,7 @@ void MeshPrimitiveEvaluator::intersectionPointsWalk( TriangleBoundTree::NodeInde
 
 	if( node.isLeaf() )
 	{
-		TriangleBoundTree::Iterator *permLast = node.permLast();
-
-		for( TriangleBoundTree::Iterator *perm = node.permFirst(); perm!=permLast; perm++ )
-		{
-			size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
-			size_t vertIdOffset = triangleIndex * 3;
-			Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
-
-			assert( vertexIds[0] < (int)( m_verts->readable().size() ) );
-			assert( vertexIds[1] < (int)( m_verts->readable().size() ) );
-			assert( vertexIds[2] < (int)( m_verts->readable().size() ) );
-
-			const Imath::V3f &p0 =  m_verts->readable()[ vertexIds[0] ];
-			const Imath::V3f &p1 =  m_verts->readable()[ vertexIds[1] ];
-			const Imath::V3f &p2 =  m_verts->readable()[ vertexIds[2] ];
-
-			V3f hitPoint, bary;
-			bool front;
-
-			if ( triangleRayIntersection( p0, p1, p2, ray.pos, ray.dir, hitPoint, bary, front ) )
-			{
-				float dSqrd = vecDistance2( hitPoint, ray.pos );
-
-				if (dSqrd < maxDistSqrd)
-				{
-					ResultPtr result = new Result();
-
-					result->m_bary = bary;
-					result->m_vertexIds = vertexIds;
-					result->m_triangleIdx = triangleIndex;
-
-					result->m_p = hitPoint;
-
-					if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
-					{
-						result->m_uv = V2f(
-							result->floatPrimVar( m_u ),
-							result->floatPrimVar( m_v )
-						);
-					}
-
-					result->m_n = triangleNormal( p0, p1, p2 );
-
-					results.push_back( result );
-				}
-			}
-		}
+		intersectionPointsLeaf( node.permFirst(), node.permLast(), ray, maxDistSqrd, results );
 	}
 	else
 	{
@@ -1284,6 +1313,261 @@ void MeshPrimitiveEvaluator::intersectionPointsWalk( TriangleBoundTree::NodeInde
 	}
 }
 
+void MeshPrimitiveEvaluator::closestPointLeaf( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, const V3f &p, float &closestDistanceSqrd, Result *result ) const
+{
+	for( const TriangleBoundVector::iterator *perm = permFirst; perm!=permLast; perm++ )
+	{
+		size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
+		size_t vertIdOffset = triangleIndex * 3;
+		Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
+		
+		assert( vertexIds[0] < (int)( m_verts->readable().size() ) );
+		assert( vertexIds[1] < (int)( m_verts->readable().size() ) );
+		assert( vertexIds[2] < (int)( m_verts->readable().size() ) );
+
+		V3f bary;
+		float dSqrd = triangleClosestBarycentric(
+			m_verts->readable()[vertexIds[0]],
+			m_verts->readable()[vertexIds[1]],
+			m_verts->readable()[vertexIds[2]],
+			p,
+			bary );
+
+		if (dSqrd < closestDistanceSqrd)
+		{
+			closestDistanceSqrd = dSqrd;
+
+			result->m_bary = bary;
+			result->m_vertexIds = vertexIds;
+			result->m_triangleIdx = triangleIndex;
+
+			if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
+			{
+				result->m_uv = V2f(
+					result->floatPrimVar( m_u ),
+					result->floatPrimVar( m_v )
+				);
+			}
+
+			const Imath::V3f &p0 = m_verts->readable()[vertexIds[0]];
+			const Imath::V3f &p1 = m_verts->readable()[vertexIds[1]];
+			const Imath::V3f &p2 = m_verts->readable()[vertexIds[2]];
+
+			result->m_p = trianglePoint( p0, p1, p2, result->m_bary );
+
+			result->m_n = triangleNormal( p0, p1, p2 );
+		}
+	}
+}
+
+bool MeshPrimitiveEvaluator::intersectionPointLeaf( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, const Imath::Line3f &ray, float &maxDistSqrd, Result *result ) const
+{
+	bool intersects = false;
+	for( const TriangleBoundVector::iterator *perm = permFirst; perm!=permLast; perm++ )
+	{
+		size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
+		size_t vertIdOffset = triangleIndex * 3;
+		Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
+
+		assert( vertexIds[0] < (int)( m_verts->readable().size() ) );
+		assert( vertexIds[1] < (int)( m_verts->readable().size() ) );
+		assert( vertexIds[2] < (int)( m_verts->readable().size() ) );
+
+		const Imath::V3f &p0 = m_verts->readable()[ vertexIds[0] ];
+		const Imath::V3f &p1 = m_verts->readable()[ vertexIds[1] ];
+		const Imath::V3f &p2 = m_verts->readable()[ vertexIds[2] ];
+
+		V3f hitPoint, bary;
+		bool front;
+
+		if ( triangleRayIntersection( p0, p1, p2, ray.pos, ray.dir, hitPoint, bary, front ) )
+		{
+			float dSqrd = vecDistance2( hitPoint, ray.pos );
+
+			if (dSqrd < maxDistSqrd)
+			{
+				maxDistSqrd = dSqrd;
+
+				result->m_bary = bary;
+				result->m_vertexIds = vertexIds;
+				result->m_triangleIdx = triangleIndex;
+
+				result->m_p = hitPoint;
+
+				if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
+				{
+					result->m_uv = V2f(
+						result->floatPrimVar( m_u ),
+						result->floatPrimVar( m_v )
+					);
+				}
+
+				result->m_n = triangleNormal( p0, p1, p2 );
+
+				intersects = true;
+			}
+		}
+	}
+
+	return intersects;
+}
+
+void MeshPrimitiveEvaluator::intersectionPointsLeaf( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, const Imath::Line3f &ray, float maxDistSqrd, std::vector<PrimitiveEvaluator::ResultPtr> &results ) const
+{
+	for( const TriangleBoundVector::iterator *perm = permFirst; perm!=permLast; perm++ )
+	{
+		size_t triangleIndex = *perm - m_triangles.begin(); // triangle index is just the distance of the triangle from the beginning of the vector
+		size_t vertIdOffset = triangleIndex * 3;
+		Imath::V3i vertexIds( (*m_meshVertexIds)[vertIdOffset], (*m_meshVertexIds)[vertIdOffset+1], (*m_meshVertexIds)[vertIdOffset+2] );
+
+		assert( vertexIds[0] < (int)( m_verts->readable().size() ) );
+		assert( vertexIds[1] < (int)( m_verts->readable().size() ) );
+		assert( vertexIds[2] < (int)( m_verts->readable().size() ) );
+
+		const Imath::V3f &p0 =  m_verts->readable()[ vertexIds[0] ];
+		const Imath::V3f &p1 =  m_verts->readable()[ vertexIds[1] ];
+		const Imath::V3f &p2 =  m_verts->readable()[ vertexIds[2] ];
+
+		V3f hitPoint, bary;
+		bool front;
+
+		if ( triangleRayIntersection( p0, p1, p2, ray.pos, ray.dir, hitPoint, bary, front ) )
+		{
+			float dSqrd = vecDistance2( hitPoint, ray.pos );
+
+			if (dSqrd < maxDistSqrd)
+			{
+				ResultPtr result = new Result();
+
+				result->m_bary = bary;
+				result->m_vertexIds = vertexIds;
+				result->m_triangleIdx = triangleIndex;
+
+				result->m_p = hitPoint;
+
+				if ( m_u.interpolation != PrimitiveVariable::Invalid && m_v.interpolation != PrimitiveVariable::Invalid )
+				{
+					result->m_uv = V2f(
+						result->floatPrimVar( m_u ),
+						result->floatPrimVar( m_v )
+					);
+				}
+
+				result->m_n = triangleNormal( p0, p1, p2 );
+
+				results.push_back( result );
+			}
+		}
+	}
+}
+
+struct MeshPrimitiveEvaluator::ClosestPointLeafFn
+{
+	ClosestPointLeafFn( const MeshPrimitiveEvaluator *evaluator, const V3f &p, Result *result )
+		:	m_evaluator( evaluator ), m_p( p ), m_result( result )
+	{
+	}
+
+	void operator()( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, float &closestDistanceSqrd )
+	{
+		m_evaluator->closestPointLeaf( permFirst, permLast, m_p, closestDistanceSqrd, m_result );
+	}
+
+	const MeshPrimitiveEvaluator *m_evaluator;
+	const V3f &m_p;
+	Result *m_result;
+};
+
+struct MeshPrimitiveEvaluator::IntersectionPointLeafFn
+{
+	IntersectionPointLeafFn( const MeshPrimitiveEvaluator *evaluator, const Imath::Line3f &ray, float &maxDistSqrd, Result *result )
+		:	m_evaluator( evaluator ), m_ray( ray ), m_maxDistSqrd( maxDistSqrd ), m_result( result ), m_hit( false )
+	{
+	}
+
+	// The hierarchy measures distance along the ray, whereas the leaf
+	// test works with squared distances, so we keep the two in sync.
+	void operator()( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, float &maxDistance )
+	{
+		if( m_evaluator->intersectionPointLeaf( permFirst, permLast, m_ray, m_maxDistSqrd, m_result ) )
+		{
+			maxDistance = sqrtf( m_maxDistSqrd );
+			m_hit = true;
+		}
+	}
+
+	const MeshPrimitiveEvaluator *m_evaluator;
+	const Imath::Line3f &m_ray;
+	float &m_maxDistSqrd;
+	Result *m_result;
+	bool m_hit;
+};
+
+struct MeshPrimitiveEvaluator::IntersectionPointsLeafFn
+{
+	IntersectionPointsLeafFn( const MeshPrimitiveEvaluator *evaluator, const Imath::Line3f &ray, float maxDistSqrd, std::vector<PrimitiveEvaluator::ResultPtr> &results )
+		:	m_evaluator( evaluator ), m_ray( ray ), m_maxDistSqrd( maxDistSqrd ), m_results( results )
+	{
+	}
+
+	void operator()( const TriangleBoundVector::iterator *permFirst, const TriangleBoundVector::iterator *permLast, float & )
+	{
+		m_evaluator->intersectionPointsLeaf( permFirst, permLast, m_ray, m_maxDistSqrd, m_results );
+	}
+
+	const MeshPrimitiveEvaluator *m_evaluator;
+	const Imath::Line3f &m_ray;
+	float m_maxDistSqrd;
+	std::vector<PrimitiveEvaluator::ResultPtr> &m_results;
+};
+
+void MeshPrimitiveEvaluator::closestPointQuery( const V3f &p, float &closestDistanceSqrd, Result *result ) const
+{
+	if( m_bvh )
+	{
+		ClosestPointLeafFn fn( this, p, result );
+		m_bvh->closestLeaves( p, closestDistanceSqrd, fn );
+	}
+	else
+	{
+		assert( m_tree );
+		closestPointWalk( m_tree->rootIndex(), p, closestDistanceSqrd, result );
+	}
+}
+
+bool MeshPrimitiveEvaluator::intersectionPointQuery( const Imath::Line3f &ray, float &maxDistSqrd, Result *result ) const
+{
+	if( m_bvh )
+	{
+		IntersectionPointLeafFn fn( this, ray, maxDistSqrd, result );
+		float maxDistance = sqrtf( maxDistSqrd );
+		m_bvh->rayLeaves( ray.pos, ray.dir, maxDistance, fn );
+		return fn.m_hit;
+	}
+	else
+	{
+		assert( m_tree );
+		bool hit = false;
+		intersectionPointWalk( m_tree->rootIndex(), ray, maxDistSqrd, result, hit );
+		return hit;
+	}
+}
+
+void MeshPrimitiveEvaluator::intersectionPointsQuery( const Imath::Line3f &ray, float maxDistSqrd, std::vector<PrimitiveEvaluator::ResultPtr> &results ) const
+{
+	if( m_bvh )
+	{
+		IntersectionPointsLeafFn fn( this, ray, maxDistSqrd, results );
+		float maxDistance = sqrtf( maxDistSqrd );
+		m_bvh->rayLeaves( ray.pos, ray.dir, maxDistance, fn );
+	}
+	else
+	{
+		assert( m_tree );
+		intersectionPointsWalk( m_tree->rootIndex(), ray, maxDistSqrd, results );
+	}
+}
+
 const Imath::Box2f MeshPrimitiveEvaluator::uvBound() const
 {
 	if( !m_uvTree )
@@ -1303,6 +1587,11 @@ const MeshPrimitiveEvaluator::TriangleBoundTree *MeshPrimitiveEvaluator::triangl
 	return m_tree;
 }
 
+const MeshPrimitiveEvaluator::TriangleBVH *MeshPrimitiveEvaluator::triangleBVH() const
+{
+	return m_bvh;
+}
+
 const MeshPrimitiveEvaluator::UVBoundVector *MeshPrimitiveEvaluator::uvBounds() const
 {
 	return m_uvTree ? &m_uvTriangles : 0;
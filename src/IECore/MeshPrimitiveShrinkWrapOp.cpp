@@ -34,13 +34,16 @@
 
 #include "boost/format.hpp"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
 #include "IECore/ObjectParameter.h"
 #include "IECore/CompoundParameter.h"
 #include "IECore/CompoundObject.h"
 #include "IECore/VectorTypedData.h"
 #include "IECore/RunTimeTyped.h"
 #include "IECore/MeshPrimitiveShrinkWrapOp.h"
-#include "IECore/PrimitiveEvaluator.h"
+#include "IECore/MeshPrimitiveEvaluator.h"
 #include "IECore/VectorOps.h"
 #include "IECore/TriangulateOp.h"
 #include "IECore/DespatchTypedData.h"
@@ -164,18 +167,52 @@ const FloatParameter * MeshPrimitiveShrinkWrapOp::triangulationToleranceParamete
 	return m_triangulationToleranceParameter.get();
 }
 
+namespace
+{
+
+// Computes ray directions from the normals at the closest points on the source mesh.
+struct NormalDirectionsFn
+{
+	NormalDirectionsFn( const MeshPrimitiveEvaluator *evaluator, const PrimitiveVariable &nPrimVar, const int *triangleIndices, const V3f *barycentricCoordinates, V3f *directions )
+		:	m_evaluator( evaluator ), m_nPrimVar( nPrimVar ), m_triangleIndices( triangleIndices ), m_barycentricCoordinates( barycentricCoordinates ), m_directions( directions )
+	{
+	}
+
+	void operator()( const tbb::blocked_range<size_t> &r ) const
+	{
+		PrimitiveEvaluator::ResultPtr result = m_evaluator->createResult();
+		for ( size_t i = r.begin(); i != r.end(); ++i )
+		{
+			if ( m_triangleIndices[i] < 0 || !m_evaluator->barycentricPosition( m_triangleIndices[i], m_barycentricCoordinates[i], result.get() ) )
+			{
+				m_directions[i] = V3f( 0.0f );
+				continue;
+			}
+			m_directions[i] = result->vectorPrimVar( m_nPrimVar ).normalized();
+		}
+	}
+
+	const MeshPrimitiveEvaluator *m_evaluator;
+	const PrimitiveVariable &m_nPrimVar;
+	const int *m_triangleIndices;
+	const V3f *m_barycentricCoordinates;
+	V3f *m_directions;
+};
+
+} // namespace
+
 struct MeshPrimitiveShrinkWrapOp::ShrinkWrapFn
 {
 	typedef void ReturnType;
 
 	PrimitivePtr m_sourceMesh;
-	const Primitive * m_targetMesh;
+	const MeshPrimitive * m_targetMesh;
 	const Data * m_directionData;
 	Direction m_direction;
 	Method m_method;
 	float m_tolerance;
 
-	ShrinkWrapFn( Primitive * sourceMesh, const Primitive * targetMesh, const Data * directionData, Direction direction, Method method, float tolerance )
+	ShrinkWrapFn( Primitive * sourceMesh, const MeshPrimitive * targetMesh, const Data * directionData, Direction direction, Method method, float tolerance )
 	: m_sourceMesh( sourceMesh ), m_targetMesh( targetMesh ), m_directionData( directionData ), m_direction( direction ), m_method( method ), m_tolerance( tolerance )
 	{
 	}
@@ -215,115 +252,102 @@ struct MeshPrimitiveShrinkWrapOp::ShrinkWrapFn
 		op->toleranceParameter()->setNumericValue( m_tolerance );
 		MeshPrimitivePtr triangulatedSourcePrimitive = runTimeCast< MeshPrimitive > ( op->operate() );
 
-		PrimitiveEvaluatorPtr sourceEvaluator = 0;
-		PrimitiveEvaluator::ResultPtr sourceResult = 0;
-
-		if ( m_method == Normal )
+		const size_t numVertices = vertices.size();
+		if ( !numVertices )
 		{
-			sourceEvaluator = PrimitiveEvaluator::create( triangulatedSourcePrimitive );
-			assert( sourceEvaluator );
-			sourceResult = sourceEvaluator->createResult();
-			assert( sourceResult );
+			return;
 		}
 
-		PrimitiveEvaluatorPtr targetEvaluator = PrimitiveEvaluator::create( m_targetMesh );
-		assert( targetEvaluator );
-		PrimitiveEvaluator::ResultPtr insideResult = targetEvaluator->createResult();
-		PrimitiveEvaluator::ResultPtr outsideResult = targetEvaluator->createResult();
-		assert( insideResult );
-		assert( outsideResult );
-
-		PrimitiveVariableMap::const_iterator it = triangulatedSourcePrimitive->variables.find( "N" );
-		if (it == m_sourceMesh->variables.end())
+		// Gather the ray origins and directions up front, so that all the queries
+		// can be made in parallel using the batched evaluator methods.
+		std::vector<V3f> origins( numVertices );
+		std::vector<V3f> directions( numVertices );
+		for ( size_t i = 0; i < numVertices; ++i )
 		{
-			throw InvalidArgumentException("MeshPrimitiveShrinkWrapOp: MeshPrimitive has no primitive variable \"N\"" );
+			origins[i] = V3f( vertices[i] );
 		}
 
-		const PrimitiveVariable &nPrimVar = it->second;
-
-		typename T::ValueType::size_type vertexId = 0;
-		for ( typename T::ValueType::iterator pit = vertices.begin(); pit != vertices.end(); ++pit, ++vertexId )
+		if ( m_method == Normal )
 		{
-			Vec &vertexPosition = *pit;
-
-			Vec rayDirection;
-
-			if ( m_method == Normal )
-			{
-				assert( sourceEvaluator );
-				assert( sourceResult );
-				sourceEvaluator->closestPoint( vertexPosition, sourceResult.get() );
-				rayDirection = sourceResult->vectorPrimVar( nPrimVar ).normalized();
-			}
-			else if ( m_method == XAxis )
+			PrimitiveVariableMap::const_iterator it = triangulatedSourcePrimitive->variables.find( "N" );
+			if (it == triangulatedSourcePrimitive->variables.end())
 			{
-				rayDirection = Vec( 1.0, 0.0, 0.0 );
+				throw InvalidArgumentException("MeshPrimitiveShrinkWrapOp: MeshPrimitive has no primitive variable \"N\"" );
 			}
-			else if ( m_method == YAxis )
+
+			const PrimitiveVariable &nPrimVar = it->second;
+
+			MeshPrimitiveEvaluatorPtr sourceEvaluator = new MeshPrimitiveEvaluator( triangulatedSourcePrimitive, PrimitiveEvaluator::BVHAcceleration );
+			std::vector<int> triangleIndices( numVertices );
+			std::vector<V3f> barycentricCoordinates( numVertices );
+			sourceEvaluator->closestPoints( &origins[0], numVertices, &triangleIndices[0], &barycentricCoordinates[0] );
+
+			NormalDirectionsFn fn( sourceEvaluator.get(), nPrimVar, &triangleIndices[0], &barycentricCoordinates[0], &directions[0] );
+			tbb::parallel_for( tbb::blocked_range<size_t>( 0, numVertices, 1024 ), fn );
+		}
+		else if ( m_method == DirectionMesh )
+		{
+			assert( directionVerticesData );
+			const typename T::ValueType &directionVertices = directionVerticesData->readable();
+			for ( size_t i = 0; i < numVertices; ++i )
 			{
-				rayDirection = Vec( 0.0, 1.0, 0.0 );
+				directions[i] = V3f( ( directionVertices[i] - vertices[i] ).normalized() );
 			}
-			else if ( m_method == ZAxis )
+		}
+		else
+		{
+			V3f axis( 0.0f );
+			axis[ m_method == XAxis ? 0 : ( m_method == YAxis ? 1 : 2 ) ] = 1.0f;
+			std::fill( directions.begin(), directions.end(), axis );
+		}
+
+		MeshPrimitiveEvaluatorPtr targetEvaluator = new MeshPrimitiveEvaluator( m_targetMesh, PrimitiveEvaluator::BVHAcceleration );
+
+		std::vector<int> insideTriangles;
+		std::vector<float> insideDistances;
+		std::vector<V3f> insidePoints;
+		if ( m_direction != Outside )
+		{
+			std::vector<V3f> insideDirections( numVertices );
+			for ( size_t i = 0; i < numVertices; ++i )
 			{
-				rayDirection = Vec( 0.0, 0.0, 1.0 );
+				insideDirections[i] = -directions[i];
 			}
-			else
-			{
-				assert( m_method == DirectionMesh );
-				assert( directionVerticesData );
-				assert( vertexId < directionVerticesData->readable().size() );
 
-				rayDirection = ( directionVerticesData->readable()[ vertexId ] - vertexPosition ).normalized();
-			}
+			insideTriangles.resize( numVertices );
+			insideDistances.resize( numVertices );
+			insidePoints.resize( numVertices );
+			targetEvaluator->rayIntersections( &origins[0], &insideDirections[0], numVertices, &insideTriangles[0], 0, &insideDistances[0], &insidePoints[0] );
+		}
 
-			bool hit = false;
+		std::vector<int> outsideTriangles;
+		std::vector<float> outsideDistances;
+		std::vector<V3f> outsidePoints;
+		if ( m_direction != Inside )
+		{
+			outsideTriangles.resize( numVertices );
+			outsideDistances.resize( numVertices );
+			outsidePoints.resize( numVertices );
+			targetEvaluator->rayIntersections( &origins[0], &directions[0], numVertices, &outsideTriangles[0], 0, &outsideDistances[0], &outsidePoints[0] );
+		}
+
+		for ( size_t i = 0; i < numVertices; ++i )
+		{
+			bool insideHit = m_direction != Outside && insideTriangles[i] >= 0;
+			bool outsideHit = m_direction != Inside && outsideTriangles[i] >= 0;
 
-			if ( m_direction == Inside )
+			/// Choose the closest, or the only, intersection
+			if ( insideHit && outsideHit )
 			{
-				hit = targetEvaluator->intersectionPoint( vertexPosition, -rayDirection, insideResult.get() );
-				if ( hit )
-				{
-					vertexPosition = insideResult->point();
-				}
+				vertices[i] = insideDistances[i] < outsideDistances[i] ? Vec( insidePoints[i] ) : Vec( outsidePoints[i] );
 			}
-			else if ( m_direction == Outside )
+			else if ( insideHit )
 			{
-				hit = targetEvaluator->intersectionPoint( vertexPosition, rayDirection, outsideResult.get() );
-				if ( hit )
-				{
-					vertexPosition = outsideResult->point();
-				}
+				vertices[i] = insidePoints[i];
 			}
-			else
+			else if ( outsideHit )
 			{
-				assert( m_direction == Both );
-
-				bool insideHit  = targetEvaluator->intersectionPoint( vertexPosition, -rayDirection, insideResult.get()  );
-				bool outsideHit = targetEvaluator->intersectionPoint( vertexPosition,  rayDirection, outsideResult.get() );
-
-				/// Choose the closest, or the only, intersection
-				if ( insideHit && outsideHit )
-				{
-					typename Vec::BaseType insideDist  = vecDistance2( vertexPosition, Vec( insideResult->point()  ) );
-					typename Vec::BaseType outsideDist = vecDistance2( vertexPosition, Vec( outsideResult->point() ) );
-
-					if ( insideDist < outsideDist )
-					{
-						vertexPosition = insideResult->point();
-					}
-					else
-					{
-						vertexPosition = outsideResult->point();
-					}
-				}
-				else if ( insideHit )
-				{
-					vertexPosition = insideResult->point();
-				}
-				else if ( outsideHit )
-				{
-					vertexPosition = outsideResult->point();
-				}
+				vertices[i] = outsidePoints[i];
 			}
 		}
 	}
@@ -38,6 +38,9 @@
 
 #include "boost/format.hpp"
 
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
 #include "IECore/Reader.h"
 #include "IECore/ImagePrimitive.h"
 
@@ -205,55 +208,98 @@ const StringParameter * PointRepulsionOp::weightsNameParameter() const
 	return m_weightsNameParameter.get();
 }
 
-void PointRepulsionOp::getNearestPointsAndDensities( ImagePrimitiveEvaluator * imageEvaluator, const PrimitiveVariable &densityPrimVar, MeshPrimitiveEvaluator * meshEvaluator, const PrimitiveVariable &sPrimVar, const PrimitiveVariable &tPrimVar, std::vector<Imath::V3f> &points, std::vector<float> &densities )
+namespace
 {
-	densities.resize( points.size() );
 
-	PrimitiveEvaluator::ResultPtr meshResult = meshEvaluator->createResult();
-	PrimitiveEvaluator::ResultPtr imageResult = imageEvaluator->createResult();
+// Looks up the density at each of the closest points found on the mesh.
+struct DensityFn
+{
+	DensityFn(
+		ImagePrimitiveEvaluator *imageEvaluator, const PrimitiveVariable &densityPrimVar,
+		MeshPrimitiveEvaluator *meshEvaluator, const PrimitiveVariable &sPrimVar, const PrimitiveVariable &tPrimVar,
+		const int *triangleIndices, const V3f *barycentricCoordinates, float *densities
+	)
+		:	m_imageEvaluator( imageEvaluator ), m_densityPrimVar( densityPrimVar ),
+			m_meshEvaluator( meshEvaluator ), m_sPrimVar( sPrimVar ), m_tPrimVar( tPrimVar ),
+			m_triangleIndices( triangleIndices ), m_barycentricCoordinates( barycentricCoordinates ), m_densities( densities )
+	{
+	}
 
-	for ( std::vector<Imath::V3f>::size_type p = 0; p < points.size(); p++ )
+	void operator()( const tbb::blocked_range<size_t> &r ) const
 	{
-		bool found = meshEvaluator->closestPoint( points[p], meshResult.get() );
-		if ( !found )
+		PrimitiveEvaluator::ResultPtr meshResult = m_meshEvaluator->createResult();
+		PrimitiveEvaluator::ResultPtr imageResult = m_imageEvaluator->createResult();
+
+		for ( size_t p = r.begin(); p != r.end(); ++p )
 		{
-			throw InvalidArgumentException( "PointRepulsionOp: Invaid mesh - closest point is undefined" );
-		}
+			m_meshEvaluator->barycentricPosition( m_triangleIndices[p], m_barycentricCoordinates[p], meshResult.get() );
 
-		points[p] = meshResult->point();
+			Imath::V2f uv(
+			        meshResult->floatPrimVar( m_sPrimVar ),
+			        meshResult->floatPrimVar( m_tPrimVar )
+			);
 
-		Imath::V2f uv(
-		        meshResult->floatPrimVar( sPrimVar ),
-		        meshResult->floatPrimVar( tPrimVar )
-		);
+			/// \todo Texture repeat
+			float repeatU = 1.0;
+			float repeatV = 1.0;
 
-		/// \todo Texture repeat
-		float repeatU = 1.0;
-		float repeatV = 1.0;
+			/// \todo Wrap modes
+			bool wrapU = true;
+			bool wrapV = true;
 
-		/// \todo Wrap modes
-		bool wrapU = true;
-		bool wrapV = true;
+			Imath::V2f placedUv(
+			        uv.x * repeatU,
+			        uv.y * repeatV
+			);
 
-		Imath::V2f placedUv(
-		        uv.x * repeatU,
-		        uv.y * repeatV
-		);
+			if ( wrapU )
+			{
+				placedUv.x = fmodf( placedUv.x, 1.0f );
+			}
 
-		if ( wrapU )
-		{
-			placedUv.x = fmodf( placedUv.x, 1.0f );
-		}
+			if ( wrapV )
+			{
+				placedUv.y = fmodf( placedUv.y, 1.0f );
+			}
 
-		if ( wrapV )
-		{
-			placedUv.y = fmodf( placedUv.y, 1.0f );
+			m_imageEvaluator->pointAtUV( placedUv, imageResult.get() );
+
+			m_densities[p] = imageResult->floatPrimVar( m_densityPrimVar );
 		}
+	}
+
+	ImagePrimitiveEvaluator *m_imageEvaluator;
+	const PrimitiveVariable &m_densityPrimVar;
+	MeshPrimitiveEvaluator *m_meshEvaluator;
+	const PrimitiveVariable &m_sPrimVar;
+	const PrimitiveVariable &m_tPrimVar;
+	const int *m_triangleIndices;
+	const V3f *m_barycentricCoordinates;
+	float *m_densities;
+};
 
-		imageEvaluator->pointAtUV( placedUv, imageResult.get() );
+} // namespace
 
-		densities[p] = imageResult->floatPrimVar( densityPrimVar );
+void PointRepulsionOp::getNearestPointsAndDensities( ImagePrimitiveEvaluator * imageEvaluator, const PrimitiveVariable &densityPrimVar, MeshPrimitiveEvaluator * meshEvaluator, const PrimitiveVariable &sPrimVar, const PrimitiveVariable &tPrimVar, std::vector<Imath::V3f> &points, std::vector<float> &densities )
+{
+	const size_t numPoints = points.size();
+	densities.resize( numPoints );
+	if ( !numPoints )
+	{
+		return;
 	}
+
+	std::vector<int> triangleIndices( numPoints );
+	std::vector<V3f> barycentricCoordinates( numPoints );
+	meshEvaluator->closestPoints( &points[0], numPoints, &triangleIndices[0], &barycentricCoordinates[0], 0, &points[0] );
+
+	if ( std::find( triangleIndices.begin(), triangleIndices.end(), -1 ) != triangleIndices.end() )
+	{
+		throw InvalidArgumentException( "PointRepulsionOp: Invaid mesh - closest point is undefined" );
+	}
+
+	DensityFn fn( imageEvaluator, densityPrimVar, meshEvaluator, sPrimVar, tPrimVar, &triangleIndices[0], &barycentricCoordinates[0], &densities[0] );
+	tbb::parallel_for( tbb::blocked_range<size_t>( 0, numPoints, 256 ), fn );
 }
 
 void PointRepulsionOp::calculateForces( std::vector<V3f> &points, std::vector<float> &radii, std::vector<Imath::Box3f> &bounds, std::vector<Imath::V3f> &forces, Imath::Rand48 &generator, std::vector<float> &densities, float densityInv )
@@ -428,7 +474,7 @@ void PointRepulsionOp::modify( Object * object, const CompoundObject * operands
 	ImagePrimitiveEvaluatorPtr imageEvaluator = new ImagePrimitiveEvaluator( image );
 	PrimitiveEvaluator::ResultPtr imageResult = imageEvaluator->createResult();
 
-	MeshPrimitiveEvaluatorPtr meshEvaluator = new MeshPrimitiveEvaluator( mesh );
+	MeshPrimitiveEvaluatorPtr meshEvaluator = new MeshPrimitiveEvaluator( mesh, PrimitiveEvaluator::BVHAcceleration );
 	PrimitiveEvaluator::ResultPtr meshResult = meshEvaluator->createResult();
 
 
@@ -653,9 +699,16 @@ void PointRepulsionOp::modify( Object * object, const CompoundObject * operands
 
 		assert( sData || tData );
 
+		std::vector<int> triangleIndices( numPoints );
+		std::vector<V3f> barycentricCoordinates( numPoints );
+		if ( numPoints )
+		{
+			meshEvaluator->closestPoints( &points[0], numPoints, &triangleIndices[0], &barycentricCoordinates[0] );
+		}
+
 		for ( PointArray::size_type p = 0; p < numPoints; p++ )
 		{
-			bool found = meshEvaluator->closestPoint( points[p], meshResult.get() );
+			bool found = meshEvaluator->barycentricPosition( triangleIndices[p], barycentricCoordinates[p], meshResult.get() );
 			assert( found );
 			( void ) found;
 
@@ -33,6 +33,10 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <cassert>
+#include <algorithm>
+
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 
 #include "IECore/Primitive.h"
 #include "IECore/VectorTypedData.h"
@@ -53,6 +57,8 @@ static IndexedIO::EntryID g_variablesEntry("variables");
 static IndexedIO::EntryID g_interpolationEntry("interpolation");
 static IndexedIO::EntryID g_dataEntry("data");
 const unsigned int Primitive::m_ioVersion = 1;
+// Primitives with at least this many vertices have their data hashed in parallel.
+static const size_t g_parallelHashThreshold = 10000;
 IE_CORE_DEFINEABSTRACTOBJECTTYPEDESCRIPTION( Primitive );
 
 Primitive::Primitive()
@@ -193,9 +199,71 @@ void Primitive::memoryUsage( Object::MemoryAccumulator &a ) const
 	}
 }
 
+namespace
+{
+
+// Computes the hashes of the data of a primitive. The data caches its own
+// hash, so after this has run, Primitive::hash() just needs to combine them.
+// The element past the end of the data range is used for the topology.
+class PrecomputeDataHashes
+{
+	public :
+
+		PrecomputeDataHashes( const Primitive *primitive, const std::vector<const Data *> &data )
+			:	m_primitive( primitive ), m_data( data )
+		{
+		}
+
+		void operator()( const tbb::blocked_range<size_t> &r ) const
+		{
+			for( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				MurmurHash h;
+				if( i < m_data.size() )
+				{
+					if( m_data[i] )
+					{
+						m_data[i]->hash( h );
+					}
+				}
+				else
+				{
+					m_primitive->topologyHash( h );
+				}
+			}
+		}
+
+	private :
+
+		const Primitive *m_primitive;
+		const std::vector<const Data *> &m_data;
+
+};
+
+} // namespace
+
 void Primitive::hash( MurmurHash &h ) const
 {
 	VisibleRenderable::hash( h );
+
+	// Hashing the data of a large primitive for the first time (or after modification)
+	// requires a pass over all of its memory. In that case we compute the data hashes in
+	// parallel up front, so that the serial loop below only combines the cached results.
+	if( variableSize( PrimitiveVariable::Vertex ) >= g_parallelHashThreshold )
+	{
+		std::vector<const Data *> data;
+		data.reserve( variables.size() );
+		for( PrimitiveVariableMap::const_iterator it=variables.begin(); it!=variables.end(); it++ )
+		{
+			data.push_back( it->second.data.get() );
+		}
+		// data may be shared between variables, but should only be hashed once
+		std::sort( data.begin(), data.end() );
+		data.erase( std::unique( data.begin(), data.end() ), data.end() );
+
+		tbb::parallel_for( tbb::blocked_range<size_t>( 0, data.size() + 1, 1 ), PrecomputeDataHashes( this, data ) );
+	}
+
 	for( PrimitiveVariableMap::const_iterator it=variables.begin(); it!=variables.end(); it++ )
 	{
 		h.append( it->first );
@@ -34,6 +34,11 @@
 
 #include"boost/tuple/tuple.hpp"
 #include "tbb/concurrent_hash_map.h"
+#include "tbb/task.h"
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "tbb/task_group.h"
+#include "tbb/mutex.h"
 
 #include "OpenEXR/ImathBoxAlgo.h"
 
@@ -719,6 +724,10 @@ class SceneCache::ReaderImplementation : public SceneCache::Implementation
 			return location;
 		}
 
+		/// Queues a background task that loads the object and transform samples required
+		/// by the given locations at the given times, so they are stored in the shared caches.
+		void prefetch( const std::vector<Path> &paths, const std::vector<double> &times );
+
 		void hash( HashType hashType, double time, MurmurHash &h, bool ignoreSceneHash = false ) const
 		{
 			size_t s0, s1;
@@ -810,6 +819,56 @@ class SceneCache::ReaderImplementation : public SceneCache::Implementation
 			}
 		}
 
+		/// Loads the object and transform samples for one location. Errors are ignored,
+		/// as they will be reported when the data is actually read.
+		void prefetchLocation( const Path &path, const std::vector<double> &times )
+		{
+			try
+			{
+				ReaderImplementationPtr location = static_cast< ReaderImplementation * >( scene( path, NullIfMissing ).get() );
+				if ( !location )
+				{
+					return;
+				}
+
+				const bool hasObject = location->hasObject();
+				const bool hasTransform = location->m_indexedIO->hasEntry( transformEntry );
+
+				for ( std::vector<double>::const_iterator it = times.begin(); it != times.end(); ++it )
+				{
+					size_t sample1, sample2;
+					double x;
+					if ( hasObject )
+					{
+						x = location->objectSampleInterval( *it, sample1, sample2 );
+						if ( x != 1 )
+						{
+							location->readObjectAtSample( sample1 );
+						}
+						if ( x != 0 )
+						{
+							location->readObjectAtSample( sample2 );
+						}
+					}
+					if ( hasTransform )
+					{
+						x = location->transformSampleInterval( *it, sample1, sample2 );
+						if ( x != 1 )
+						{
+							location->readTransformAtSample( sample1 );
+						}
+						if ( x != 0 )
+						{
+							location->readTransformAtSample( sample2 );
+						}
+					}
+				}
+			}
+			catch ( ... )
+			{
+			}
+		}
+
 		static ReaderImplementation *reader( Implementation *impl, bool throwException = true )
 		{
 			ReaderImplementation *reader = dynamic_cast< ReaderImplementation* >( impl );
@@ -821,6 +880,9 @@ class SceneCache::ReaderImplementation : public SceneCache::Implementation
 		}
 
 	private :
+
+		class PrefetchLocations;
+		class PrefetchTask;
 	
 		// \todo Consider using concurrent_vector for constant access time.
 		typedef tbb::concurrent_hash_map< uint64_t, SampleTimes > SampleTimesMap;
@@ -1106,6 +1168,63 @@ class SceneCache::ReaderImplementation : public SceneCache::Implementation
 
 SceneCache::ReaderImplementation::Defaults SceneCache::ReaderImplementation::g_defaults;
 
+class SceneCache::ReaderImplementation::PrefetchLocations
+{
+	public :
+
+		PrefetchLocations( ReaderImplementation *reader, const std::vector<Path> &paths, const std::vector<double> &times )
+			:	m_reader( reader ), m_paths( paths ), m_times( times )
+		{
+		}
+
+		void operator()( const tbb::blocked_range<size_t> &r ) const
+		{
+			for ( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				m_reader->prefetchLocation( m_paths[i], m_times );
+			}
+		}
+
+	private :
+
+		ReaderImplementation *m_reader;
+		const std::vector<Path> &m_paths;
+		const std::vector<double> &m_times;
+};
+
+/// Background task used by ReaderImplementation::prefetch(). It holds a reference to the
+/// reader, which keeps the whole scene (and its shared caches) alive until it completes.
+class SceneCache::ReaderImplementation::PrefetchTask : public tbb::task
+{
+	public :
+
+		PrefetchTask( ReaderImplementation *reader, const std::vector<Path> &paths, const std::vector<double> &times )
+			:	m_reader( reader ), m_paths( paths ), m_times( times )
+		{
+		}
+
+		virtual tbb::task *execute()
+		{
+			tbb::parallel_for( tbb::blocked_range<size_t>( 0, m_paths.size() ), PrefetchLocations( m_reader.get(), m_paths, m_times ) );
+			return 0;
+		}
+
+	private :
+
+		ReaderImplementationPtr m_reader;
+		std::vector<Path> m_paths;
+		std::vector<double> m_times;
+};
+
+void SceneCache::ReaderImplementation::prefetch( const std::vector<Path> &paths, const std::vector<double> &times )
+{
+	if ( paths.empty() || times.empty() )
+	{
+		return;
+	}
+	tbb::task::enqueue( *new( tbb::task::allocate_root() ) PrefetchTask( this, paths, times ) );
+}
+
 /// Writer implementation for SceneCache
 /// Each location keeps refcount pointers to their child locations, so they can always return the same (unfinished child) and when the root is destroyed, it
 /// can trigger the recursive computation of bounding boxes and the global storage of all sampleTime vectors used in the file.
@@ -1115,7 +1234,7 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 
 		IE_CORE_DECLAREPTR( WriterImplementation )
 
-		WriterImplementation( IndexedIOPtr io, Implementation *parent = 0) : SceneCache::Implementation( io ), m_parent(static_cast< WriterImplementation* >( parent ))
+		WriterImplementation( IndexedIOPtr io, Implementation *parent = 0) : SceneCache::Implementation( io ), m_parent(static_cast< WriterImplementation* >( parent )), m_boundsComputed( false )
 		{
 			if ( m_parent )
 			{
@@ -1599,13 +1718,51 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 		}
 
 		// Called from the destructor of the root location. 
-		// It triggers flush recursivelly on all the child locations.
-		// It also sets m_sampleTimesMap to NULL which prevents further modification on this and all child scene interface objects through their call to writable().
-		// Responsible for writing missing data such as all the sample 
-		// times from object,transform,attributes and bounds. And also computes the 
-		// animated bounding boxes in case they were not explicitly writen.
-		//
+		// It triggers flushLocation() recursivelly on all the child locations, while the
+		// animated bounding boxes are computed in parallel by a background task.
+		// The file is only written from the calling thread, and in the same order as
+		// a serial flush would, so the results are identical.
 		void flush()
+		{
+			tbb::task_group boundsTask;
+			boundsTask.run( ComputeBounds( this ) );
+
+			try
+			{
+				flushLocation();
+			}
+			catch ( ... )
+			{
+				boundsTask.cancel();
+				boundsTask.wait();
+				throw;
+			}
+
+			boundsTask.wait();
+
+			// deallocate children since we now computed everything from them anyways...
+			// (we can't do it in flushLocation() as the bounds task may still be running).
+			m_children.clear();
+
+			if ( m_sampleTimesMap )
+			{
+				// we are at the root...
+				// deallocate samples map stored in the root object.
+				delete m_sampleTimesMap;
+				// and make sure the cache does not contain this file, forcing it to reload it.
+				if ( m_indexedIO->typeId() == FileIndexedIOTypeId )
+				{
+					SharedSceneInterfaces::erase( static_cast< FileIndexedIO * >( m_indexedIO.get() )->fileName() );
+				}
+			}
+			m_sampleTimesMap = 0;
+		}
+
+		// Writes the missing data for this location and all of its children, such as all the sample 
+		// times from object,transform,attributes and bounds, and the bounding boxes computed
+		// by computeLocationBounds().
+		// It also sets m_sampleTimesMap to NULL which prevents further modification on this and all child scene interface objects through their call to writable().
+		void flushLocation()
 		{
 			if ( m_parent )
 			{
@@ -1617,7 +1774,7 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 			/// first call flush recursively on children...
 			for ( std::map< SceneCache::Name, WriterImplementationPtr >::const_iterator cit = m_children.begin(); cit != m_children.end(); cit++ )
 			{
-				cit->second->flush();
+				cit->second->flushLocation();
 			}
 
 			IndexedIOPtr io;
@@ -1667,6 +1824,86 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 				storeSampleTimes( m_objectSampleTimes, io );				
 			}
 			
+			// make sure the bounding boxes for this location have been computed (possibly by the background task started in flush()).
+			computeLocationBounds();
+			
+
+			if ( m_boundSampleTimes.size() )
+			{
+				// save the bound sample times
+				io = m_indexedIO->subdirectory( boundEntry, IndexedIO::CreateIfMissing );
+				storeSampleTimes( m_boundSampleTimes, io );
+
+				// store computed bounds in file
+				uint64_t sampleIndex = 0;
+				for ( BoxSamples::const_iterator bit = m_boundSamples.begin(); bit != m_boundSamples.end(); bit++, sampleIndex++ )
+				{
+					io->write( sampleEntry(sampleIndex), bit->min.getValue(), 6 );
+				}
+			}
+
+			if ( m_parent )
+			{
+				NameList tags;
+				// propagate tags to parent
+				readTags( tags, SceneInterface::LocalTag | SceneInterface::DescendantTag );
+				m_parent->writeTags( tags, SceneInterface::DescendantTag );
+			}
+
+			if ( m_parent )
+			{
+				m_sampleTimesMap = 0;
+			}
+		}
+
+		// Computes the bounding boxes of all locations in the hierarchy, with sibling
+		// locations processed in parallel. Doesn't access the file.
+		class ComputeBounds
+		{
+			public :
+
+				ComputeBounds( WriterImplementation *location ) : m_location( location )
+				{
+				}
+
+				void operator()() const
+				{
+					computeBounds( m_location );
+				}
+
+				void operator()( const tbb::blocked_range<size_t> &r ) const
+				{
+					std::map< SceneCache::Name, WriterImplementationPtr >::const_iterator cit = m_location->m_children.begin();
+					std::advance( cit, r.begin() );
+					for ( size_t i = r.begin(); i != r.end(); ++i, ++cit )
+					{
+						computeBounds( cit->second.get() );
+					}
+				}
+
+			private :
+
+				static void computeBounds( WriterImplementation *location )
+				{
+					tbb::parallel_for( tbb::blocked_range<size_t>( 0, location->m_children.size() ), ComputeBounds( location ) );
+					location->computeLocationBounds();
+				}
+
+				WriterImplementation *m_location;
+		};
+
+		// Computes the bounding box over time for this location, from its object and the
+		// bounding boxes of its children, which must have been computed already.
+		// It's safe to call it concurrently from the flushLocation() and ComputeBounds,
+		// and only the first call does the work.
+		void computeLocationBounds()
+		{
+			tbb::mutex::scoped_lock lock( m_boundsMutex );
+			if ( m_boundsComputed )
+			{
+				return;
+			}
+
 			// We have to compute the bounding box over time for the object and each child.
 			for ( std::map< SceneCache::Name, WriterImplementationPtr >::const_iterator cit = m_children.begin(); cit != m_children.end(); cit++ )
 			{
@@ -1821,45 +2058,8 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 				// union all the bounding box samples from the child and also from the optional object stored in this location
 				accumulateBoxSamples( m_objectSampleTimes, m_objectSamples );
 			}
-			
-
-			if ( m_boundSampleTimes.size() )
-			{
-				// save the bound sample times
-				io = m_indexedIO->subdirectory( boundEntry, IndexedIO::CreateIfMissing );
-				storeSampleTimes( m_boundSampleTimes, io );
-
-				// store computed bounds in file
-				uint64_t sampleIndex = 0;
-				for ( BoxSamples::const_iterator bit = m_boundSamples.begin(); bit != m_boundSamples.end(); bit++, sampleIndex++ )
-				{
-					io->write( sampleEntry(sampleIndex), bit->min.getValue(), 6 );
-				}
-			}
-
-			if ( m_parent )
-			{
-				NameList tags;
-				// propagate tags to parent
-				readTags( tags, SceneInterface::LocalTag | SceneInterface::DescendantTag );
-				m_parent->writeTags( tags, SceneInterface::DescendantTag );
-			}
-
-			// deallocate children since we now computed everything from them anyways...
-			m_children.clear();
 
-			if ( !m_parent && m_sampleTimesMap )
-			{
-				// we are at the root...
-				// deallocate samples map stored in the root object.
-				delete m_sampleTimesMap;
-				// and make sure the cache does not contain this file, forcing it to reload it.
-				if ( m_indexedIO->typeId() == FileIndexedIOTypeId )
-				{
-					SharedSceneInterfaces::erase( static_cast< FileIndexedIO * >( m_indexedIO.get() )->fileName() );
-				}
-			}
-			m_sampleTimesMap = 0;
+			m_boundsComputed = true;
 		}
 
 		/// This functions transforms the bounding boxes with the animated transforms and also scales the bounding boxes in a way that it
@@ -1995,6 +2195,9 @@ class SceneCache::WriterImplementation : public SceneCache::Implementation
 		typedef std::map< SceneCache::Name, SampleTimes > AttributeSamplesMap;
 
 		SampleTimesMap *m_sampleTimesMap;
+		// guards the bounding box computation in computeLocationBounds()
+		tbb::mutex m_boundsMutex;
+		bool m_boundsComputed;
 		SampleTimes m_boundSampleTimes;		// implicit or explicit bound sample times
 		SampleTimes m_transformSampleTimes;
 		AttributeSamplesMap m_attributeSampleTimes;
@@ -2399,6 +2602,15 @@ ConstSceneInterfacePtr SceneCache::scene( const Path &path, SceneCache::MissingB
 	return duplicate( impl );
 }
 
+void SceneCache::prefetch( const std::vector<Path> &paths, const std::vector<double> &times ) const
+{
+	ReaderImplementation *reader = ReaderImplementation::reader( m_implementation.get(), false );
+	if ( reader )
+	{
+		reader->prefetch( paths, times );
+	}
+}
+
 void SceneCache::hash( HashType hashType, double time, MurmurHash &h ) const
 {
 	SceneInterface::hash( hashType, time, h );
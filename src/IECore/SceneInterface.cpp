@@ -119,6 +119,10 @@ SceneInterface::~SceneInterface()
 {
 }
 
+void SceneInterface::prefetch( const std::vector<Path> &paths, const std::vector<double> &times ) const
+{
+}
+
 void SceneInterface::hash( HashType hashType, double time, MurmurHash &h ) const
 {
 	h.append( typeId() );
@@ -35,21 +35,30 @@
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
 #include <algorithm>
+#include <cstring>
 #include <list>
 #include <iostream>
 #include <cassert>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "boost/tokenizer.hpp"
 #include "boost/optional.hpp"
 #include "boost/format.hpp"
+#include "boost/iostreams/copy.hpp"
+#include "boost/iostreams/device/back_inserter.hpp"
 #include "boost/iostreams/device/file.hpp"
 #include "boost/iostreams/filtering_streambuf.hpp"
 #include "boost/iostreams/filtering_stream.hpp"
 #include "boost/iostreams/stream.hpp"
 #include "boost/iostreams/filter/gzip.hpp"
+#include "boost/iostreams/filter/zlib.hpp"
 #include "tbb/spin_rw_mutex.h"
+#include "tbb/mutex.h"
+#include "tbb/task.h"
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 
 #include "IECore/ByteOrder.h"
 #include "IECore/MemoryStream.h"
@@ -60,6 +69,7 @@
 
 #define HARDLINK				127
 #define SUBINDEX_DIR			126
+#define COMPRESSED_DATA			64
 
 static const Imf::Int64 g_unversionedMagicNumber = 0x0B00B1E5;
 static const Imf::Int64 g_versionedMagicNumber = 0xB00B1E50;
@@ -69,8 +79,12 @@ static const Imf::Int64 g_versionedMagicNumber = 0xB00B1E50;
 /// Version 5: introduced subindex as zipped data blocks (to reduce size of the main index). 
 ///            Hard links are represented as regular data nodes, that points to same data on file (no removal of data ever). 
 ///            Removed the linkCount field on the data nodes.
+/// Version 6: data nodes can store their data compressed (files written with IndexedIO::Compressed), flagged in the DataType.
 /// \todo Store SubIndexSize and NodeCount as unsigned 64bit integers
-static const Imf::Int64 g_currentVersion = 5;
+static const Imf::Int64 g_currentVersion = 6;
+
+/// Data blocks smaller than this are never compressed.
+static const size_t g_minCompressedDataSize = 64;
 
 /// FileFormat ::= Data Index IndexOffset Version MagicNumber
 /// Data ::= DataEntry*
@@ -79,7 +93,9 @@ static const Imf::Int64 g_currentVersion = 5;
 /// DataEntry ::= Stores data from nodes: 
 ///                [Data nodes] binary data indexed by DataOffset/DataSize and 
 ///                [Subindex]   SubIndexSize zip(NodeCount NodeTree*) indexed by SubIndexOffset.
+///                [Compressed data nodes] UncompressedSize zlib(binary data) indexed by DataOffset/DataSize.
 /// SubIndexSize :: = uint32 - number of bytes in the zipped subindex that follows
+/// UncompressedSize :: = int64 - number of bytes in the data once decompressed
 
 /// StringCache ::= NumStrings String*
 /// NumStrings ::= int64
@@ -92,7 +108,7 @@ static const Imf::Int64 g_currentVersion = 5;
 ///			 EntryType EntryStringCacheID SubIndexOffset ( If EntryType == SUBINDEX_DIR )
 /// EntryType ::= char ( value from IndexedIO::EntryType )
 /// EntryStringCacheID ::= int64 ( index in StringCache )
-/// DataType ::= char ( value from IndexedIO::DataType )
+/// DataType ::= char ( value from IndexedIO::DataType, or'ed with COMPRESSED_DATA if the data block is compressed )
 /// ArrayLength ::= int64 ( if DataType is array, then this tells how long they are )
 /// NodeID ::= int64 ( unique Id of this node in the file )
 /// ParentNodeID ::= int64 ( Id for the parent node )
@@ -140,6 +156,125 @@ void readLittleEndian( F &f, T &n )
 	}
 }
 
+/// Input stream reading from a block of memory, used for parsing decompressed indexes without the
+/// overhead of going through a filtering stream for every field.
+class MemoryReader
+{
+	public :
+
+		MemoryReader( const char *data, size_t size ) : m_next( data ), m_end( data + size )
+		{
+		}
+
+		void read( char *buffer, size_t size )
+		{
+			if ( size > (size_t)( m_end - m_next ) )
+			{
+				throw IOException( "StreamIndexedIO: Unexpected end of index data!" );
+			}
+			memcpy( buffer, m_next, size );
+			m_next += size;
+		}
+
+	private :
+
+		const char *m_next;
+		const char *m_end;
+
+};
+
+// Returns the uncompressed size of a block written by compressBlock().
+static Imf::Int64 uncompressedSize( const char *data, size_t size )
+{
+	Imf::Int64 result = 0;
+	if ( size < sizeof( result ) )
+	{
+		throw IOException( "StreamIndexedIO: Invalid compressed block!" );
+	}
+	memcpy( &result, data, sizeof( result ) );
+	return asLittleEndian( result );
+}
+
+// Compresses a block of data, prefixing it with its uncompressed size. Used for
+// compressed data nodes.
+static void compressBlock( const char *data, size_t size, MemoryStreamSink &sink )
+{
+	writeLittleEndian<MemoryStreamSink, Imf::Int64>( sink, size );
+
+	io::filtering_ostream compressingStream;
+	compressingStream.push( io::zlib_compressor( io::zlib::best_speed ) );
+	compressingStream.push( sink );
+	assert( compressingStream.is_complete() );
+
+	compressingStream.write( data, size );
+
+	compressingStream.pop();
+	compressingStream.pop();
+}
+
+// Decompresses a block written by compressBlock() into dst, which must hold dstSize bytes.
+static void decompressData( const char *data, size_t size, char *dst, size_t dstSize )
+{
+	if ( uncompressedSize( data, size ) != dstSize )
+	{
+		throw IOException( "StreamIndexedIO: Unexpected size for compressed data!" );
+	}
+
+	io::filtering_istream decompressingStream;
+	MemoryStreamSource source( const_cast<char *>( data ) + sizeof( Imf::Int64 ), size - sizeof( Imf::Int64 ), false );
+	decompressingStream.push( io::zlib_decompressor() );
+	decompressingStream.push( source );
+	assert( decompressingStream.is_complete() );
+
+	decompressingStream.read( dst, dstSize );
+	if ( decompressingStream.gcount() != (std::streamsize)dstSize )
+	{
+		throw IOException( "StreamIndexedIO: Failed to decompress data!" );
+	}
+}
+
+// Compresses the index or a subindex into the zip format, at the fastest level. The
+// fields are written to memory first, so they don't each go through the filtering stream.
+static void zipIndex( const char *data, size_t size, MemoryStreamSink &sink )
+{
+	io::filtering_ostream compressingStream;
+	compressingStream.push( io::gzip_compressor( io::gzip_params( io::gzip::best_speed ) ) );
+	compressingStream.push( sink );
+	assert( compressingStream.is_complete() );
+
+	compressingStream.write( data, size );
+
+	compressingStream.pop();
+	compressingStream.pop();
+}
+
+// Decompresses a whole zipped index or subindex into buffer, so it can be parsed with a MemoryReader.
+static void unzipIndex( const char *data, size_t size, std::vector<char> &buffer )
+{
+	io::filtering_istream decompressingStream;
+	MemoryStreamSource source( const_cast<char *>( data ), size, false );
+	decompressingStream.push( io::gzip_decompressor() );
+	decompressingStream.push( source );
+	assert( decompressingStream.is_complete() );
+
+	buffer.clear();
+	io::copy( decompressingStream, io::back_inserter( buffer ) );
+}
+
+// Returns the plain contents of a block read from the file, decompressing it into buffer if required.
+static const char *uncompressedData( const char *data, size_t size, bool compressed, std::vector<char> &buffer )
+{
+	if ( !compressed )
+	{
+		return data;
+	}
+
+	Imf::Int64 dataSize = uncompressedSize( data, size );
+	buffer.resize( std::max<Imf::Int64>( dataSize, 1 ) );
+	decompressData( data, size, &buffer[0], dataSize );
+	return &buffer[0];
+}
+
 class StreamIndexedIO::StringCache
 {
 	public:
@@ -347,12 +482,17 @@ class SmallDataNode : public NodeBase
 		static const size_t maxArrayLength = UINT16_MAX;
 		static const size_t maxSize = UINT32_MAX;
 		
-		SmallDataNode( IndexedIO::EntryID name, IndexedIO::DataType dataType, Imf::Int64 arrayLength, Imf::Int64 size, Imf::Int64 offset ) : 
-			NodeBase(NodeBase::SmallData, name), m_dataType(dataType), m_arrayLength((Length)arrayLength), m_size((Size)size), m_offset(offset) {}
+		SmallDataNode( IndexedIO::EntryID name, IndexedIO::DataType dataType, bool compressed, Imf::Int64 arrayLength, Imf::Int64 size, Imf::Int64 offset ) : 
+			NodeBase(NodeBase::SmallData, name), m_dataType( compressed ? dataType | COMPRESSED_DATA : dataType ), m_arrayLength((Length)arrayLength), m_size((Size)size), m_offset(offset) {}
 
 		inline IndexedIO::DataType dataType() 
 		{
-			return static_cast<IndexedIO::DataType>(m_dataType);
+			return static_cast<IndexedIO::DataType>(m_dataType & ~COMPRESSED_DATA);
+		}
+
+		inline bool compressed()
+		{
+			return m_dataType & COMPRESSED_DATA;
 		}
 
 		inline Imf::Int64 arrayLength()
@@ -372,7 +512,7 @@ class SmallDataNode : public NodeBase
 
 	protected :
 
-		/// data fields from IndexedIO::Entry
+		/// data fields from IndexedIO::Entry, plus the COMPRESSED_DATA flag
 		// using char instead of enum to compact members in one word
 		const char m_dataType;
 
@@ -393,12 +533,17 @@ class DataNode : public NodeBase
 		static const size_t maxArrayLength = UINT64_MAX;
 		static const size_t maxSize = UINT64_MAX;
 		
-		DataNode( IndexedIO::EntryID name, IndexedIO::DataType dataType, Imf::Int64 arrayLength, Imf::Int64 size, Imf::Int64 offset ) : 
-			NodeBase(NodeBase::Data, name), m_dataType(dataType), m_arrayLength(arrayLength), m_size(size), m_offset(offset) {}
+		DataNode( IndexedIO::EntryID name, IndexedIO::DataType dataType, bool compressed, Imf::Int64 arrayLength, Imf::Int64 size, Imf::Int64 offset ) : 
+			NodeBase(NodeBase::Data, name), m_dataType( compressed ? dataType | COMPRESSED_DATA : dataType ), m_arrayLength(arrayLength), m_size(size), m_offset(offset) {}
 
 		inline IndexedIO::DataType dataType() 
 		{
-			return m_dataType;
+			return static_cast<IndexedIO::DataType>(m_dataType & ~COMPRESSED_DATA);
+		}
+
+		inline bool compressed()
+		{
+			return m_dataType & COMPRESSED_DATA;
 		}
 
 		inline Imf::Int64 arrayLength()
@@ -426,8 +571,8 @@ class DataNode : public NodeBase
 
 	protected :
 
-		/// data fields from IndexedIO::Entry
-		IndexedIO::DataType m_dataType;
+		/// data fields from IndexedIO::Entry, plus the COMPRESSED_DATA flag
+		char m_dataType;
 
 		/// data fields from IndexedIO::Entry
 		Imf::Int64 m_arrayLength;
@@ -579,10 +724,10 @@ class StreamIndexedIO::Node
 		// Returns the named child directory node or NULL if not existent. Loads the subindex for the child nodes (if applicable).
 		DirectoryNode* directoryChild( const IndexedIO::EntryID &name ) const;
 		/// returns information about the Data node
-		inline bool dataChildInfo( const IndexedIO::EntryID &name, size_t &offset, size_t &size ) const;
+		inline bool dataChildInfo( const IndexedIO::EntryID &name, size_t &offset, size_t &size, bool &compressed ) const;
 
 		DirectoryNode* addChild( const IndexedIO::EntryID & childName );
-		void addDataChild( const IndexedIO::EntryID & childName, IndexedIO::DataType dataType, size_t arrayLen, size_t offset, size_t size );
+		void addDataChild( const IndexedIO::EntryID & childName, IndexedIO::DataType dataType, bool compressed, size_t arrayLen, size_t offset, size_t size );
 
 		void removeChild( const IndexedIO::EntryID &childName, bool throwException = true );
 
@@ -625,12 +770,25 @@ class StreamIndexedIO::Index : public RefCounted
 		/// \param prefixSize If true than it will prepend to the block, the size of it
 		Imf::Int64 writeUniqueData( const char *data, size_t size, bool prefixSize = false );
 
+		/// Writes the data block of a data node with writeUniqueData(), compressing it first if the
+		/// file was opened with IndexedIO::Compressed and compression makes the block smaller.
+		/// Returns the offset of the block, and its size and compression state on file.
+		Imf::Int64 writeNodeData( const char *data, size_t size, size_t &storedSize, bool &compressed );
+
 		/// flushes the children of the given directory node to a subindex in the file
 		void commitNodeToSubIndex( DirectoryNode *n );
 
-		/// read the subindex that contains the children of the given node
+		/// read the subindex that contains the children of the given node.
+		/// The file is accessed with positional reads, so different subindexes can be
+		/// decompressed and parsed concurrently by different threads.
 		void readNodeFromSubIndex( DirectoryNode *n );
 
+		/// loads the subindexes for the whole hierarchy below the given node, in parallel.
+		void prefetch( DirectoryNode *n );
+
+		/// launches prefetch() as a background task and returns immediately.
+		void prefetchInBackground( DirectoryNode *n );
+
 		typedef tbb::spin_rw_mutex Mutex;
 		typedef Mutex::scoped_lock MutexLock;
 		/// Returns an appropriate mutex scoped lock to access the given Directory node.
@@ -639,11 +797,22 @@ class StreamIndexedIO::Index : public RefCounted
 
 	protected:
 
+		class PrefetchChildren;
+		class PrefetchTask;
+
 		static const int MAX_MUTEXES = 11;
 
+		/// returns the index of the mutex from the pools below used for the given Directory node.
+		static unsigned int mutexIndex( const DirectoryNode *n );
+
 		/// defines a pool of mutexes for thread-safe access to the Node hierarchy
 		mutable Mutex m_mutexes[ MAX_MUTEXES ];
 
+		/// defines a pool of mutexes that guarantee each subindex is loaded only once.
+		/// Loading can take a while, so we use blocking mutexes rather than spinning ones.
+		typedef tbb::mutex SubIndexMutex;
+		SubIndexMutex m_subindexMutexes[ MAX_MUTEXES ];
+
 		DirectoryNode *m_root;
 
 		/// we keep all the removed nodes alive until the Index destruction
@@ -653,6 +822,9 @@ class StreamIndexedIO::Index : public RefCounted
 
 		bool m_hasChanged;
 
+		/// true if the data nodes should be written compressed
+		bool m_compressData;
+
 		Imf::Int64 m_offset;
 		Imf::Int64 m_next;
 
@@ -721,6 +893,10 @@ class StreamIndexedIO::Index : public RefCounted
 		/// Returns a newly created Node.
 		template < typename F >
 		NodeBase *readNode( F &f );
+
+		/// Reads the child nodes of a directory stored in a subindex.
+		template < typename F >
+		void readNodeChildren( DirectoryNode *n, F &f );
 };
 
 ///////////////////////////////////////////////
@@ -915,7 +1091,7 @@ DirectoryNode* StreamIndexedIO::Node::directoryChild( const IndexedIO::EntryID &
 	return 0;
 }
 
-bool StreamIndexedIO::Node::dataChildInfo( const IndexedIO::EntryID &name, size_t &offset, size_t &size ) const
+bool StreamIndexedIO::Node::dataChildInfo( const IndexedIO::EntryID &name, size_t &offset, size_t &size, bool &compressed ) const
 {
 	Index::MutexLock lock;
 	m_idx->lockDirectory( lock, m_node );
@@ -930,6 +1106,7 @@ bool StreamIndexedIO::Node::dataChildInfo( const IndexedIO::EntryID &name, size_
 			DataNode *n = static_cast< DataNode *>( p );
 			offset = n->offset();
 			size = n->size();
+			compressed = n->compressed();
 			return true;
 		}
 		else if ( p->nodeType() == NodeBase::SmallData )
@@ -937,6 +1114,7 @@ bool StreamIndexedIO::Node::dataChildInfo( const IndexedIO::EntryID &name, size_
 			SmallDataNode *n = static_cast< SmallDataNode *>( p );
 			offset = n->offset();
 			size = n->size();
+			compressed = n->compressed();
 			return true;
 		}
 	}
@@ -969,7 +1147,7 @@ DirectoryNode* StreamIndexedIO::Node::addChild( const IndexedIO::EntryID &childN
 	return child;
 }
 
-void StreamIndexedIO::Node::addDataChild( const IndexedIO::EntryID &childName, IndexedIO::DataType dataType, size_t arrayLen, size_t offset, size_t size )
+void StreamIndexedIO::Node::addDataChild( const IndexedIO::EntryID &childName, IndexedIO::DataType dataType, bool compressed, size_t arrayLen, size_t offset, size_t size )
 {
 	if ( m_node->subindex() )
 	{
@@ -985,7 +1163,7 @@ void StreamIndexedIO::Node::addDataChild( const IndexedIO::EntryID &childName, I
 
 	if ( arrayLen <= SmallDataNode::maxArrayLength && size <= SmallDataNode::maxSize )
 	{
-		SmallDataNode* child = new SmallDataNode(childName, dataType, arrayLen, size, offset);
+		SmallDataNode* child = new SmallDataNode(childName, dataType, compressed, arrayLen, size, offset);
 		if ( !child )
 		{
 			throw Exception( "Failed to allocate node!" );
@@ -994,7 +1172,7 @@ void StreamIndexedIO::Node::addDataChild( const IndexedIO::EntryID &childName, I
 	}
 	else
 	{
-		DataNode* child = new DataNode(childName, dataType, arrayLen, size, offset);
+		DataNode* child = new DataNode(childName, dataType, compressed, arrayLen, size, offset);
 		if ( !child )
 		{
 			throw Exception( "Failed to allocate node!" );
@@ -1077,6 +1255,7 @@ void StreamIndexedIO::Node::removeChild( const IndexedIO::EntryID &childName, bo
 
 StreamIndexedIO::Index::Index( StreamIndexedIO::StreamFilePtr stream ) : m_root(0), m_version(g_currentVersion), m_hasChanged(false), m_offset(0), m_next(0), m_stream(stream)
 {
+	m_compressData = ( m_stream->openMode() & IndexedIO::Compressed ) && ( m_stream->openMode() & ( IndexedIO::Write | IndexedIO::Append ) );
 	m_stringCache.add(IndexedIO::rootName);
 }
 
@@ -1151,15 +1330,14 @@ void StreamIndexedIO::Index::openStream()
 
 		if (m_version >= 2 )
 		{
-			io::filtering_istream decompressingStream;
-			char *compressedIndex = new char[ end - m_offset ];
-			f.read( compressedIndex, end - m_offset );
-			MemoryStreamSource source( compressedIndex, end - m_offset, true );
-			decompressingStream.push( io::gzip_decompressor() );
-			decompressingStream.push( source );
-			assert( decompressingStream.is_complete() );
+			std::vector<char> compressedIndex( end - m_offset );
+			f.read( &compressedIndex[0], compressedIndex.size() );
 
-			read( decompressingStream );
+			std::vector<char> buffer;
+			unzipIndex( &compressedIndex[0], compressedIndex.size(), buffer );
+			MemoryReader reader( buffer.empty() ? 0 : &buffer[0], buffer.size() );
+
+			read( reader );
 		}
 		else
 		{
@@ -1272,7 +1450,7 @@ NodeBase *StreamIndexedIO::Index::readNodeV4( F &f )
 				readLittleEndian(f,linkCount);
 			}
 		}
-		DataNode *n = new DataNode( *id, dataType, arrayLength, size, offset );
+		DataNode *n = new DataNode( *id, dataType, false, arrayLength, size, offset );
 		result = n;
 	}
 	else // Directory
@@ -1337,7 +1515,8 @@ NodeBase *StreamIndexedIO::Index::readNode( F &f )
 		IndexedIO::DataType dataType = IndexedIO::Invalid;
 		Imf::Int64 arrayLength = 0;
 		f.read( &t, sizeof(char) );
-		dataType = (IndexedIO::DataType)t;
+		bool compressed = t & COMPRESSED_DATA;
+		dataType = (IndexedIO::DataType)( t & ~COMPRESSED_DATA );
 	
 		if ( IndexedIO::Entry::isArray( dataType ) )
 		{
@@ -1350,12 +1529,12 @@ NodeBase *StreamIndexedIO::Index::readNode( F &f )
 
 		if ( arrayLength <= SmallDataNode::maxArrayLength && size <= SmallDataNode::maxSize )
 		{
-			SmallDataNode *n = new SmallDataNode( m_stringCache.findById( stringId ), dataType, arrayLength, size, offset );
+			SmallDataNode *n = new SmallDataNode( m_stringCache.findById( stringId ), dataType, compressed, arrayLength, size, offset );
 			return n;
 		}
 		else
 		{
-			DataNode *n = new DataNode( m_stringCache.findById( stringId ), dataType, arrayLength, size, offset );
+			DataNode *n = new DataNode( m_stringCache.findById( stringId ), dataType, compressed, arrayLength, size, offset );
 			return n;
 		}
 	}
@@ -1388,6 +1567,20 @@ NodeBase *StreamIndexedIO::Index::readNode( F &f )
 	}
 }
 
+template < typename F >
+void StreamIndexedIO::Index::readNodeChildren( DirectoryNode *n, F &f )
+{
+	uint32_t nodeCount = 0;
+
+	readLittleEndian( f, nodeCount );
+
+	for ( uint32_t i = 0; i < nodeCount; i++ )
+	{
+		NodeBase *child = readNode( f );
+		n->registerChild( child );
+	}
+}
+
 template < typename F >
 void StreamIndexedIO::Index::read( F &f )
 {
@@ -1498,6 +1691,10 @@ void StreamIndexedIO::Index::writeDataNode( D *node, F &f )
 	writeLittleEndian( f, id );
 
 	t = node->dataType();
+	if ( node->compressed() )
+	{
+		t |= COMPRESSED_DATA;
+	}
 	f.write( &t, sizeof(char) );
 
 	if ( IndexedIO::Entry::isArray(node->dataType()) )
@@ -1593,38 +1790,34 @@ Imf::Int64 StreamIndexedIO::Index::write()
 	m_offset = indexStart;
 
 	MemoryStreamSink sink;
-	io::filtering_ostream compressingStream;
-	compressingStream.push( io::gzip_compressor() );
-	compressingStream.push( sink );
-	assert( compressingStream.is_complete() );
 
-	m_stringCache.write( compressingStream );
+	m_stringCache.write( sink );
 
-	writeNode( m_root, compressingStream );
+	writeNode( m_root, sink );
 
 	assert( m_freePagesOffset.size() == m_freePagesSize.size() );
 	Imf::Int64 numFreePages = m_freePagesSize.size();
 
 	// Write out number of free "pages"
-	writeLittleEndian( compressingStream, numFreePages);
+	writeLittleEndian( sink, numFreePages);
 
 	/// Write out each free page
 	for ( FreePagesSizeMap::const_iterator it = m_freePagesSize.begin(); it != m_freePagesSize.end(); ++it)
 	{
-		writeLittleEndian( compressingStream, it->second->m_offset );
-		writeLittleEndian( compressingStream, it->second->m_size );
+		writeLittleEndian( sink, it->second->m_offset );
+		writeLittleEndian( sink, it->second->m_size );
 	}
 
-	/// To synchronize/close, etc.
-	compressingStream.pop();
-	compressingStream.pop();
-
 	char *data=0;
 	std::streamsize sz;
 	sink.get( data, sz );
 	assert( data );
 	assert( sz > 0 );
 
+	MemoryStreamSink compressedSink;
+	zipIndex( data, sz, compressedSink );
+	compressedSink.get( data, sz );
+
 	f.write( data, sz );
 
 	writeLittleEndian( f, m_offset );
@@ -1879,6 +2072,34 @@ Imf::Int64 StreamIndexedIO::Index::writeUniqueData( const char *data, size_t siz
 	return loc;
 }
 
+Imf::Int64 StreamIndexedIO::Index::writeNodeData( const char *data, size_t size, size_t &storedSize, bool &compressed )
+{
+	storedSize = size;
+	compressed = false;
+
+	if ( !m_compressData || size < g_minCompressedDataSize )
+	{
+		return writeUniqueData( data, size );
+	}
+
+	MemoryStreamSink sink;
+	compressBlock( data, size, sink );
+
+	char *compressedData = 0;
+	std::streamsize compressedSize;
+	sink.get( compressedData, compressedSize );
+
+	if ( (size_t)compressedSize >= size )
+	{
+		// not worth it
+		return writeUniqueData( data, size );
+	}
+
+	storedSize = compressedSize;
+	compressed = true;
+	return writeUniqueData( compressedData, compressedSize );
+}
+
 void StreamIndexedIO::Index::deallocateWalk( NodeBase* n )
 {
 	assert(n);
@@ -1915,19 +2136,20 @@ void StreamIndexedIO::Index::commitNodeToSubIndex( DirectoryNode *n )
 	if ( n->subindex() == DirectoryNode::NoSubIndex )
 	{
 		MemoryStreamSink sink;
-		io::filtering_ostream compressingStream;
-		compressingStream.push( io::gzip_compressor() );
-		compressingStream.push( sink );
-		assert( compressingStream.is_complete() );
-
-		writeNodeChildren( n, compressingStream );
-
-		compressingStream.pop();
-		compressingStream.pop();
+		writeNodeChildren( n, sink );
 
 		char *data=0;
 		std::streamsize sz;
 		sink.get( data, sz );
+
+		MemoryStreamSink compressedSink;
+		zipIndex( data, sz, compressedSink );
+		compressedSink.get( data, sz );
+
+		if ( sz >= UINT32_MAX )
+		{
+			throw IOException( "StreamIndexedIO: Subindex size too long!" );
+		}
 		uint32_t subindexSize = sz;
 
 		// tell the Directory node that it's contents have been written as a subindex		
@@ -1937,36 +2159,37 @@ void StreamIndexedIO::Index::commitNodeToSubIndex( DirectoryNode *n )
 
 void StreamIndexedIO::Index::readNodeFromSubIndex( DirectoryNode *n )
 {
-	/// guarantees thread safe access to the file and also to the m_subindex variable
-	StreamFile::MutexLock lock( m_stream->mutex() );
+	/// guarantees the subindex is only loaded once, without blocking threads loading other subindexes
+	SubIndexMutex::scoped_lock lock( m_subindexMutexes[ mutexIndex( n ) ] );
 
 	if ( n->subindex() == DirectoryNode::LoadedSubIndex )
 	{
 		return;
 	}
 
-	m_stream->seekg( n->offset(), std::ios::beg );
-
 	uint32_t subindexSize = 0;
-	readLittleEndian( *m_stream, subindexSize );
+	MemoryReader sizeReader( m_stream->readBuffer( sizeof( subindexSize ), n->offset() ), sizeof( subindexSize ) );
+	readLittleEndian( sizeReader, subindexSize );
 
-	char *data = m_stream->ioBuffer(subindexSize);
-	m_stream->read( data, subindexSize );
+	const char *data = m_stream->readBuffer( subindexSize, n->offset() + sizeof( subindexSize ) );
 
-	io::filtering_istream decompressingStream;
-	MemoryStreamSource source( data, subindexSize, false );
-	decompressingStream.push( io::gzip_decompressor() );
-	decompressingStream.push( source );
-	assert( decompressingStream.is_complete() );
-
-	uint32_t nodeCount = 0;
+	try
+	{
+		std::vector<char> buffer;
+		unzipIndex( data, subindexSize, buffer );
+		MemoryReader reader( buffer.empty() ? 0 : &buffer[0], buffer.size() );
 
-	readLittleEndian( decompressingStream, nodeCount );
-	
-	for ( uint32_t i = 0; i < nodeCount; i++ )
+		readNodeChildren( n, reader );
+	}
+	catch ( ... )
 	{
-		NodeBase *child = readNode( decompressingStream );
-		n->registerChild( child );
+		// leave the node unloaded, so that a later access reports the error again
+		for ( DirectoryNode::ChildMap::const_iterator it = n->children().begin(); it != n->children().end(); ++it )
+		{
+			NodeBase::destroy( *it );
+		}
+		n->children().clear();
+		throw;
 	}
 
 	/// make sure the children is sorted to avoid non-thread safe sorting happening later...
@@ -1976,15 +2199,90 @@ void StreamIndexedIO::Index::readNodeFromSubIndex( DirectoryNode *n )
 	n->recoveredSubIndex();
 }
 
+/// Loads the subindexes of a range of child directories, recursing into their hierarchies.
+class StreamIndexedIO::Index::PrefetchChildren
+{
+	public :
+
+		PrefetchChildren( Node &node, const IndexedIO::EntryIDList &names ) : m_node( node ), m_names( names )
+		{
+		}
+
+		void operator()( const tbb::blocked_range<size_t> &r ) const
+		{
+			for ( size_t i = r.begin(); i != r.end(); ++i )
+			{
+				DirectoryNode *child = m_node.directoryChild( m_names[i] );
+				if ( child )
+				{
+					m_node.m_idx->prefetch( child );
+				}
+			}
+		}
+
+	private :
+
+		Node &m_node;
+		const IndexedIO::EntryIDList &m_names;
+};
+
+void StreamIndexedIO::Index::prefetch( DirectoryNode *n )
+{
+	Node node( this, n );
+
+	IndexedIO::EntryIDList names;
+	node.childNames( names, IndexedIO::Directory );
+
+	tbb::parallel_for( tbb::blocked_range<size_t>( 0, names.size() ), PrefetchChildren( node, names ) );
+}
+
+/// Task used by prefetchInBackground(). It holds a reference to the Index,
+/// so it is safe for the StreamIndexedIO to be destroyed while it runs.
+class StreamIndexedIO::Index::PrefetchTask : public tbb::task
+{
+	public :
+
+		PrefetchTask( Index *index, DirectoryNode *node ) : m_index( index ), m_node( node )
+		{
+		}
+
+		virtual tbb::task *execute()
+		{
+			try
+			{
+				m_index->prefetch( m_node );
+			}
+			catch ( ... )
+			{
+				// nothing to do - any error will be reported when the
+				// affected location is accessed for real.
+			}
+			return 0;
+		}
+
+	private :
+
+		IndexPtr m_index;
+		DirectoryNode *m_node;
+};
+
+void StreamIndexedIO::Index::prefetchInBackground( DirectoryNode *n )
+{
+	tbb::task::enqueue( *new( tbb::task::allocate_root() ) PrefetchTask( this, n ) );
+}
+
+unsigned int StreamIndexedIO::Index::mutexIndex( const DirectoryNode *n )
+{
+	// choose one of the mutexes from the pool (in a deterministic way)
+	size_t v = (size_t)n / sizeof(DirectoryNode*);
+	return ( (v + 1) / 3 ) % MAX_MUTEXES;
+}
+
 void StreamIndexedIO::Index::lockDirectory( MutexLock &lock, const DirectoryNode *n, bool writeAccess ) const
 {
 	if ( n->subindexChildren() )
 	{
-		// choose one of the mutexes from the pool (in a deterministic way)
-		size_t v = (size_t)n / sizeof(DirectoryNode*);
-		unsigned int m = ( (v + 1) / 3 ) % MAX_MUTEXES;
-
-		lock.acquire( m_mutexes[ m ], writeAccess );
+		lock.acquire( m_mutexes[ mutexIndex( n ) ], writeAccess );
 	}
 }
 
@@ -2047,6 +2345,16 @@ char *StreamIndexedIO::StreamFile::ioBuffer( unsigned long size )
 	return m_ioBuffer;
 }
 
+char *StreamIndexedIO::StreamFile::threadIOBuffer( unsigned long size )
+{
+	std::vector<char> &buffer = m_threadIOBuffers.local();
+	if ( buffer.size() < size )
+	{
+		buffer.resize( size );
+	}
+	return buffer.empty() ? 0 : &buffer[0];
+}
+
 StreamIndexedIO::StreamFile::Mutex & StreamIndexedIO::StreamFile::mutex()
 {
 	return m_mutex;
@@ -2113,6 +2421,20 @@ void StreamIndexedIO::StreamFile::write( const char *buffer, size_t size )
 	m_stream->write( buffer, size );
 }
 
+void StreamIndexedIO::StreamFile::read( char *buffer, size_t size, size_t pos )
+{
+	MutexLock lock( m_mutex );
+	m_stream->seekg( pos, std::ios::beg );
+	m_stream->read( buffer, size );
+}
+
+const char *StreamIndexedIO::StreamFile::readBuffer( size_t size, size_t pos )
+{
+	char *data = threadIOBuffer( size );
+	read( data, size, pos );
+	return data;
+}
+
 ///////////////////////////////////////////////
 //
 // StreamIndexedIO::StreamFile (end)
@@ -2449,6 +2771,23 @@ void StreamIndexedIO::commit()
 	m_node->m_idx->commitNodeToSubIndex( m_node->m_node );
 }
 
+void StreamIndexedIO::prefetchIndex( bool wait ) const
+{
+	if ( !( openMode() & IndexedIO::Read ) )
+	{
+		return;
+	}
+
+	if ( wait )
+	{
+		m_node->m_idx->prefetch( m_node->m_node );
+	}
+	else
+	{
+		m_node->m_idx->prefetchInBackground( m_node->m_node );
+	}
+}
+
 void StreamIndexedIO::write(const IndexedIO::EntryID &name, const InternedString *x, unsigned long arrayLength)
 {
 	writable(name);
@@ -2473,9 +2812,11 @@ void StreamIndexedIO::write(const IndexedIO::EntryID &name, const InternedString
 
 	IndexedIO::DataFlattenTraits<Imf::Int64*>::flatten(constIds, arrayLength, data);
 
-	size_t offset = index->writeUniqueData( data, size );
+	size_t storedSize = 0;
+	bool compressed = false;
+	size_t offset = index->writeNodeData( data, size, storedSize, compressed );
 
-	m_node->addDataChild( name, dataType, arrayLength, offset, size );
+	m_node->addDataChild( name, dataType, compressed, arrayLength, offset, storedSize );
 
 	delete [] ids;
 }
@@ -2486,8 +2827,9 @@ void StreamIndexedIO::read(const IndexedIO::EntryID &name, InternedString *&x, u
 	readable(name);
 
 	Imf::Int64 dataOffset(0), dataSize(0);
+	bool compressed = false;
 
-	if ( !m_node->dataChildInfo( name, dataOffset, dataSize ) )
+	if ( !m_node->dataChildInfo( name, dataOffset, dataSize, compressed ) )
 	{
 		throw IOException( "StreamIndexedIO::read : Data entry not found '" + name.value() + "'" );
 	}
@@ -2495,18 +2837,20 @@ void StreamIndexedIO::read(const IndexedIO::EntryID &name, InternedString *&x, u
 	Imf::Int64 *ids = new Imf::Int64[arrayLength];
 
 	StreamIndexedIO::StreamFile &f = streamFile();
-	{
-		StreamFile::MutexLock lock( f.mutex() );
-		f.seekg( dataOffset, std::ios::beg );
 
 #ifdef IE_CORE_LITTLE_ENDIAN
-		// raw read
-		f.read( (char*)ids, dataSize );
+	// raw read
+	if ( compressed )
+	{
+		decompressData( f.readBuffer( dataSize, dataOffset ), dataSize, (char*)ids, arrayLength * sizeof( Imf::Int64 ) );
 	}
-#else
-		char *data = f.ioBuffer(dataSize);
-		f.read( data, dataSize );
+	else
+	{
+		f.read( (char*)ids, dataSize, dataOffset );
 	}
+#else
+	std::vector<char> buffer;
+	const char *data = uncompressedData( f.readBuffer( dataSize, dataOffset ), dataSize, compressed, buffer );
 	IndexedIO::DataFlattenTraits<Imf::Int64*>::unflatten( data, ids, arrayLength );
 #endif
 
@@ -2536,9 +2880,11 @@ void StreamIndexedIO::write(const IndexedIO::EntryID &name, const T *x, unsigned
 	assert(data);
 	IndexedIO::DataFlattenTraits<T*>::flatten(x, arrayLength, data);
 
-	Imf::Int64 offset = m_node->m_idx->writeUniqueData( data, size );
+	size_t storedSize = 0;
+	bool compressed = false;
+	Imf::Int64 offset = m_node->m_idx->writeNodeData( data, size, storedSize, compressed );
 
-	m_node->addDataChild( name, dataType, arrayLength, offset, size );
+	m_node->addDataChild( name, dataType, compressed, arrayLength, offset, storedSize );
 }
 
 template<typename T>
@@ -2550,9 +2896,11 @@ void StreamIndexedIO::rawWrite(const IndexedIO::EntryID &name, const T *x, unsig
 	unsigned long size = IndexedIO::DataSizeTraits<T*>::size(x, arrayLength);
 	IndexedIO::DataType dataType = IndexedIO::DataTypeTraits<T*>::type();
 
-	Imf::Int64 offset =  m_node->m_idx->writeUniqueData( (char*)x, size );
+	size_t storedSize = 0;
+	bool compressed = false;
+	Imf::Int64 offset = m_node->m_idx->writeNodeData( (char*)x, size, storedSize, compressed );
 
-	m_node->addDataChild( name, dataType, arrayLength, offset, size );
+	m_node->addDataChild( name, dataType, compressed, arrayLength, offset, storedSize );
 }
 
 template<typename T>
@@ -2568,9 +2916,11 @@ void StreamIndexedIO::write(const IndexedIO::EntryID &name, const T &x)
 	assert(data);
 	IndexedIO::DataFlattenTraits<T>::flatten(x, data);
 
-	Imf::Int64 offset =  m_node->m_idx->writeUniqueData( data, size );
+	size_t storedSize = 0;
+	bool compressed = false;
+	Imf::Int64 offset = m_node->m_idx->writeNodeData( data, size, storedSize, compressed );
 
-	m_node->addDataChild( name, dataType, 0, offset, size );
+	m_node->addDataChild( name, dataType, compressed, 0, offset, storedSize );
 }
 
 template<typename T>
@@ -2582,9 +2932,11 @@ void StreamIndexedIO::rawWrite(const IndexedIO::EntryID &name, const T &x)
 	unsigned long size = IndexedIO::DataSizeTraits<T>::size(x);
 	IndexedIO::DataType dataType = IndexedIO::DataTypeTraits<T>::type();
 
-	Imf::Int64 offset = m_node->m_idx->writeUniqueData( (char*)&x, size );
+	size_t storedSize = 0;
+	bool compressed = false;
+	Imf::Int64 offset = m_node->m_idx->writeNodeData( (char*)&x, size, storedSize, compressed );
 
-	m_node->addDataChild( name, dataType, 0, offset, size );
+	m_node->addDataChild( name, dataType, compressed, 0, offset, storedSize );
 }
 
 template<typename T>
@@ -2594,20 +2946,17 @@ void StreamIndexedIO::read(const IndexedIO::EntryID &name, T *&x, unsigned long
 	readable(name);
 
 	Imf::Int64 dataOffset(0), dataSize(0);
+	bool compressed = false;
 
-	if ( !m_node->dataChildInfo( name, dataOffset, dataSize ) )
+	if ( !m_node->dataChildInfo( name, dataOffset, dataSize, compressed ) )
 	{
 		throw IOException( "StreamIndexedIO::read: Data entry not found '" + name.value() + "'" );
 	}
 
 	StreamIndexedIO::StreamFile &f = streamFile();
-	{
-		StreamFile::MutexLock lock( f.mutex() );
-		char *data = f.ioBuffer(dataSize);
-		f.seekg( dataOffset, std::ios::beg );
-		f.read( data, dataSize );
-		IndexedIO::DataFlattenTraits<T*>::unflatten( data, x, arrayLength );
-	}
+	std::vector<char> buffer;
+	const char *data = uncompressedData( f.readBuffer( dataSize, dataOffset ), dataSize, compressed, buffer );
+	IndexedIO::DataFlattenTraits<T*>::unflatten( data, x, arrayLength );
 }
 
 template<typename T>
@@ -2617,8 +2966,9 @@ void StreamIndexedIO::rawRead(const IndexedIO::EntryID &name, T *&x, unsigned lo
 	readable(name);
 
 	Imf::Int64 dataOffset(0), dataSize(0);
+	bool compressed = false;
 
-	if ( !m_node->dataChildInfo( name, dataOffset, dataSize ) )
+	if ( !m_node->dataChildInfo( name, dataOffset, dataSize, compressed ) )
 	{
 		throw IOException( "StreamIndexedIO::rawRead: Data entry not found '" + name.value() + "'" );
 	}
@@ -2629,10 +2979,13 @@ void StreamIndexedIO::rawRead(const IndexedIO::EntryID &name, T *&x, unsigned lo
 	}
 
 	StreamIndexedIO::StreamFile &f = streamFile();
+	if ( compressed )
+	{
+		decompressData( f.readBuffer( dataSize, dataOffset ), dataSize, (char*)x, arrayLength * sizeof( T ) );
+	}
+	else
 	{
-		StreamFile::MutexLock lock( f.mutex() );
-		f.seekg( dataOffset, std::ios::beg );
-		f.read( (char*)x, dataSize );
+		f.read( (char*)x, dataSize, dataOffset );
 	}
 }
 
@@ -2643,20 +2996,17 @@ void StreamIndexedIO::read(const IndexedIO::EntryID &name, T &x) const
 	readable(name);
 
 	Imf::Int64 dataOffset(0), dataSize(0);
+	bool compressed = false;
 
-	if ( !m_node->dataChildInfo( name, dataOffset, dataSize ) )
+	if ( !m_node->dataChildInfo( name, dataOffset, dataSize, compressed ) )
 	{
 		throw IOException( "StreamIndexedIO::read Data entry not found '" + name.value() + "'" );
 	}
 
 	StreamIndexedIO::StreamFile &f = streamFile();
-	{
-		StreamFile::MutexLock lock( f.mutex() );
-		char *data = f.ioBuffer(dataSize);
-		f.seekg( dataOffset, std::ios::beg );
-		f.read( data, dataSize );
-		IndexedIO::DataFlattenTraits<T>::unflatten( data, x );
-	}
+	std::vector<char> buffer;
+	const char *data = uncompressedData( f.readBuffer( dataSize, dataOffset ), dataSize, compressed, buffer );
+	IndexedIO::DataFlattenTraits<T>::unflatten( data, x );
 }
 
 template<typename T>
@@ -2666,17 +3016,21 @@ void StreamIndexedIO::rawRead(const IndexedIO::EntryID &name, T &x) const
 	readable(name);
 
 	Imf::Int64 dataOffset(0), dataSize(0);
+	bool compressed = false;
 
-	if ( !m_node->dataChildInfo( name, dataOffset, dataSize ) )
+	if ( !m_node->dataChildInfo( name, dataOffset, dataSize, compressed ) )
 	{
 		throw IOException( "StreamIndexedIO::rawRead: Data entry not found '" + name.value() + "'" );
 	}
 
 	StreamIndexedIO::StreamFile &f = streamFile();
+	if ( compressed )
+	{
+		decompressData( f.readBuffer( dataSize, dataOffset ), dataSize, (char*)&x, sizeof( T ) );
+	}
+	else
 	{
-		StreamFile::MutexLock lock( f.mutex() );
-		f.seekg( dataOffset, std::ios::beg );
-		f.read( (char*)&x, dataSize );
+		f.read( (char*)&x, dataSize, dataOffset );
 	}
 }
 
@@ -180,7 +180,7 @@ bool TIFFImageReader::isComplete()
 		/// compression methods support random access to the image data.
 		ScopedTIFFErrorHandler errorHandler;
 
-		readBuffer();
+		readBuffer( m_dataWindow );
 
 		return !errorHandler.hasError();
 	}
@@ -311,22 +311,23 @@ DataPtr TIFFImageReader::readTypedChannel( const std::string &name, const Box2i
 	data.resize( area );
 
 	int dataWidth = 1 + dataWindow.size().x;
-	int bufferDataWidth = 1 + m_dataWindow.size().x;
+	int bufferDataWidth = 1 + m_bufferWindow.size().x;
 
 	ScaledDataConversion<T, V> converter;
 
+	const T* buf = reinterpret_cast< T* >( & m_buffer[0] );
+	assert( buf );
+
+	// \todo Currently, we only support PLANARCONFIG_CONTIG for TIFFTAG_PLANARCONFIG.
+	assert( m_planarConfig ==  PLANARCONFIG_CONTIG );
+
 	int dataY = 0;
-	for ( int y = dataWindow.min.y - m_dataWindow.min.y ; y <= dataWindow.max.y - m_dataWindow.min.y ; ++y, ++dataY )
+	for ( int y = dataWindow.min.y - m_bufferWindow.min.y ; y <= dataWindow.max.y - m_bufferWindow.min.y ; ++y, ++dataY )
 	{
 		int dataX = 0;
 
-		for ( int x = dataWindow.min.x - m_dataWindow.min.x;  x <= dataWindow.max.x - m_dataWindow.min.x ; ++x, ++dataX  )
+		for ( int x = dataWindow.min.x - m_bufferWindow.min.x;  x <= dataWindow.max.x - m_bufferWindow.min.x ; ++x, ++dataX  )
 		{
-			const T* buf = reinterpret_cast< T* >( & m_buffer[0] );
-			assert( buf );
-
-			// \todo Currently, we only support PLANARCONFIG_CONTIG for TIFFTAG_PLANARCONFIG.
-			assert( m_planarConfig ==  PLANARCONFIG_CONTIG );
 			typename TargetVector::ValueType::size_type dataOffset = dataY * dataWidth + dataX;
 			assert( dataOffset < data.size() );
 
@@ -341,9 +342,11 @@ DataPtr TIFFImageReader::readChannel( const std::string &name, const Imath::Box2
 {
 	readCurrentDirectory( true );
 
-	if ( m_buffer.size() == 0 )
+	// we keep the last buffer around, because doOperation() reads the channels
+	// one by one from the same region.
+	if ( m_buffer.size() == 0 || boxIntersection( m_bufferWindow, dataWindow ) != dataWindow )
 	{
-		readBuffer();
+		readBuffer( dataWindow );
 	}
 
 	if ( m_sampleFormat == SAMPLEFORMAT_IEEEFP )
@@ -408,25 +411,30 @@ DataPtr TIFFImageReader::readChannel( const std::string &name, const Imath::Box2
 	}
 }
 
-void TIFFImageReader::readBuffer()
+void TIFFImageReader::readBuffer( const Imath::Box2i &region )
 {
 	assert( m_tiffImage );
 	assert( m_haveDirectory );
+	assert( boxIntersection( m_dataWindow, region ) == region );
+
+	// the region we want, relative to the origin of the image data
+	const Box2i imageRegion( region.min - m_dataWindow.min, region.max - m_dataWindow.min );
 
-	int width = boxSize( m_dataWindow ).x + 1;
-	int height = boxSize( m_dataWindow ).y + 1;
+	int width = boxSize( region ).x + 1;
+	int height = boxSize( region ).y + 1;
 
 	// \todo Currently, we only support PLANARCONFIG_CONTIG for TIFFTAG_PLANARCONFIG.
 	assert( m_planarConfig ==  PLANARCONFIG_CONTIG );
-	std::vector<unsigned char>::size_type bufLineSize = (size_t)( (float)m_bitsPerSample / 8 * m_samplesPerPixel * width );
+	std::vector<unsigned char>::size_type pixelSize = (size_t)( (float)m_bitsPerSample / 8 * m_samplesPerPixel );
+	std::vector<unsigned char>::size_type bufLineSize = pixelSize * width;
 	std::vector<unsigned char>::size_type bufSize = bufLineSize * height;
 	assert( bufSize );
-	m_buffer.resize( bufSize, 0 );
+	// we decode into a temporary so that m_buffer is only updated if we succeed
+	std::vector<unsigned char> buffer( bufSize, 0 );
 
 	if ( TIFFIsTiled( m_tiffImage ) )
 	{
 		tsize_t tileSize = TIFFTileSize( m_tiffImage );
-		ttile_t numTiles = TIFFNumberOfTiles( m_tiffImage );
 
 		/// Create a buffer to hold an individual tile
 		int tileWidth = tiffField<uint32>( TIFFTAG_TILEWIDTH );
@@ -441,66 +449,80 @@ void TIFFImageReader::readBuffer()
 			throw IOException( ( boost::format("TIFFImageReader: Unsupported value (%d) for TIFFTAG_TILELENGTH while reading %s") % tileLength % fileName() ).str() );
 		}
 
-		std::vector<unsigned char>::size_type pixelSize = (size_t)( (float)m_bitsPerSample / 8 * m_samplesPerPixel );
 		std::vector<unsigned char>::size_type tileLineSize = pixelSize * tileWidth;
 		std::vector<unsigned char>::size_type tileBufSize = tileLineSize * tileLength;
 		std::vector<unsigned char> tileBuffer;
 		tileBuffer.resize( tileBufSize, 0 );
 
-		int x = 0;
-		int y = 0;
-
-		/// Read each tile
-		for ( ttile_t tile = 0; tile < numTiles; tile++ )
+		/// Read only the tiles which overlap the region
+		for ( int y = ( imageRegion.min.y / tileLength ) * tileLength; y <= imageRegion.max.y; y += tileLength )
 		{
-			tsize_t imageOffset = y * bufLineSize + x * ( bufLineSize / width );
-			int result = TIFFReadEncodedTile( m_tiffImage, tile, &tileBuffer[0], tileSize );
-
-			if ( result == -1 )
-			{
-				throw IOException( (boost::format( "TIFFImageReader: Error on tile number %d while reading %s") % tile % fileName() ).str() );
-			}
-
-			/// Copy the tile into its rightful place in the image buffer.
-			/// We have to be careful here as the image might not be an exact
-			/// multiple of tiles, in which case we can't copy the tiles round the
-			/// edges in their entirety as that would give us buffer overruns.
-			int rowsToCopy = min( tileLength, height - y );
-			int columnsToCopy = min( (int)tileWidth, width - x );
-			tsize_t tileOffset = 0;
-			for ( int l = 0; l < rowsToCopy; l ++)
+			for ( int x = ( imageRegion.min.x / tileWidth ) * tileWidth; x <= imageRegion.max.x; x += tileWidth )
 			{
-				memcpy( &m_buffer[0] + imageOffset, &tileBuffer[0] + tileOffset, pixelSize * columnsToCopy );
-				imageOffset += bufLineSize;
-				tileOffset += tileLineSize;
-			}
+				ttile_t tile = TIFFComputeTile( m_tiffImage, x, y, 0, 0 );
+				int result = TIFFReadEncodedTile( m_tiffImage, tile, &tileBuffer[0], tileSize );
 
-			x = x + tileWidth;
+				if ( result == -1 )
+				{
+					throw IOException( (boost::format( "TIFFImageReader: Error on tile number %d while reading %s") % tile % fileName() ).str() );
+				}
 
-			if ( x >= width )
-			{
-				x = 0;
-				y += tileLength;
+				/// Copy the part of the tile inside the region into its rightful place in the
+				/// buffer. This also takes care of tiles round the edges of images which
+				/// aren't an exact multiple of the tile size.
+				int minX = max( x, imageRegion.min.x );
+				int maxX = min( x + tileWidth - 1, imageRegion.max.x );
+				int minY = max( y, imageRegion.min.y );
+				int maxY = min( y + tileLength - 1, imageRegion.max.y );
+
+				tsize_t imageOffset = ( minY - imageRegion.min.y ) * bufLineSize + ( minX - imageRegion.min.x ) * pixelSize;
+				tsize_t tileOffset = ( minY - y ) * tileLineSize + ( minX - x ) * pixelSize;
+				for ( int l = minY; l <= maxY; l++ )
+				{
+					memcpy( &buffer[0] + imageOffset, &tileBuffer[0] + tileOffset, pixelSize * ( maxX - minX + 1 ) );
+					imageOffset += bufLineSize;
+					tileOffset += tileLineSize;
+				}
 			}
 		}
 	}
 	else
 	{
+		int imageHeight = boxSize( m_dataWindow ).y + 1;
+		int rowsPerStrip = min( tiffFieldDefaulted<uint32>( TIFFTAG_ROWSPERSTRIP ), (uint32)imageHeight );
+		std::vector<unsigned char>::size_type stripLineSize = pixelSize * ( boxSize( m_dataWindow ).x + 1 );
+
 		tsize_t stripSize = TIFFStripSize( m_tiffImage );
-		tsize_t imageOffset = 0;
-		tstrip_t numStrips = TIFFNumberOfStrips( m_tiffImage );
-		for ( tstrip_t strip = 0; strip < numStrips; strip++ )
+		std::vector<unsigned char> stripBuffer;
+		stripBuffer.resize( stripSize, 0 );
+
+		/// Read only the strips which overlap the region
+		for ( int y = ( imageRegion.min.y / rowsPerStrip ) * rowsPerStrip; y <= imageRegion.max.y; y += rowsPerStrip )
 		{
-			tsize_t result = TIFFReadEncodedStrip( m_tiffImage, strip, &m_buffer[0] + imageOffset, stripSize );
+			tstrip_t strip = TIFFComputeStrip( m_tiffImage, y, 0 );
+			tsize_t result = TIFFReadEncodedStrip( m_tiffImage, strip, &stripBuffer[0], stripSize );
 
 			if ( result == -1 )
 			{
 				throw IOException( (boost::format( "TIFFImageReader: Error on strip number %d while reading %s") % strip % fileName() ).str() );
 			}
 
-			imageOffset += result;
+			int minY = max( y, imageRegion.min.y );
+			int maxY = min( y + rowsPerStrip - 1, imageRegion.max.y );
+
+			tsize_t imageOffset = ( minY - imageRegion.min.y ) * bufLineSize;
+			tsize_t stripOffset = ( minY - y ) * stripLineSize + imageRegion.min.x * pixelSize;
+			for ( int l = minY; l <= maxY; l++ )
+			{
+				memcpy( &buffer[0] + imageOffset, &stripBuffer[0] + stripOffset, bufLineSize );
+				imageOffset += bufLineSize;
+				stripOffset += stripLineSize;
+			}
 		}
 	}
+
+	m_buffer.swap( buffer );
+	m_bufferWindow = region;
 }
 
 bool TIFFImageReader::open( bool throwOnFailure )
@@ -37,6 +37,11 @@
 #include "IECore/DespatchTypedData.h"
 #include "IECore/TypeTraits.h"
 #include "IECore/CompoundParameter.h"
+#include "IECore/CompoundObject.h"
+#include "IECore/MurmurHash.h"
+
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 
 using namespace IECore;
 using namespace Imath;
@@ -77,6 +82,17 @@ WarpOp::WarpOp( const std::string &description )
 
 	parameters()->addParameter( m_boundModeParameter );
 
+	m_cacheWarpMapParameter = new BoolParameter(
+		"cacheWarpMap",
+		"When on, the warp map computed for one operation is kept and reused by subsequent operations "
+		"for which the parameters other than the input are unchanged, and for which the input image "
+		"has the same data and display windows. This avoids recomputing the warp for every frame of "
+		"an image sequence.",
+		false
+	);
+
+	parameters()->addParameter( m_cacheWarpMapParameter );
+
 }
 
 WarpOp::~WarpOp()
@@ -93,134 +109,303 @@ const IntParameter * WarpOp::filterParameter() const
 	return m_filterParameter.get();
 }
 
-struct WarpOp::Warp
+BoolParameter * WarpOp::cacheWarpMapParameter()
+{
+	return m_cacheWarpMapParameter.get();
+}
+
+const BoolParameter * WarpOp::cacheWarpMapParameter() const
+{
+	return m_cacheWarpMapParameter.get();
+}
+
+class WarpOp::WarpMap : public RefCounted
+{
+	public :
+
+		/// Identifies the parameter values and image windows the map was computed for.
+		MurmurHash hash;
+		Imath::Box2i outputDataWindow;
+		WarpOp::FilterType filter;
+		/// For each output pixel, the indices of the input pixels which contribute to it - one
+		/// per pixel for the None filter and four per pixel for the Bilinear filter. Indices of
+		/// -1 refer to pixels outside the input image, which are black.
+		std::vector<int> indices;
+		/// For the Bilinear filter, the x and y interpolation ratios for each output pixel.
+		std::vector<float> ratios;
+};
+
+struct WarpOp::ComputeWarpMap
 {
-	typedef void ReturnType;
 
-	Warp( WarpOp * warp, WarpOp::FilterType filter, WarpOp::BoundMode boundMode, const Imath::Box2i &warpedDataWindow, const Imath::Box2i &originalDataWindow )
-		:	m_warpOp( warp ), m_filter( filter ), m_boundMode( boundMode ), m_outputDataWindow( warpedDataWindow ), m_inputDataWindow( originalDataWindow )
+	ComputeWarpMap( const WarpOp *warpOp, WarpOp::BoundMode boundMode, const Imath::Box2i &inputDataWindow, WarpMap *warpMap )
+		:	m_warpOp( warpOp ), m_boundMode( boundMode ), m_inputDataWindow( inputDataWindow ), m_warpMap( warpMap )
 	{
 	}
 
-	inline void computePixelCoordinates( float x, float y, int &x1, int &y1, int &x2, int &y2, float &ratioX, float &ratioY )
+	void operator()( const tbb::blocked_range<int> &r ) const
 	{
-		Imath::V2f inPos = m_warpOp->warp( Imath::V2f( x, y ) );
-		x1 = int(inPos.x);
-		y1 = int(inPos.y);
-		if ( x1 > inPos.x )
-		{
-			ratioX = x1 - inPos.x;
-			x2 = x1;
-			x1--;
-		}
-		else
-		{
-			x2 = x1 + 1;
-			ratioX = inPos.x - x1;
-		}
-		if ( y1 > inPos.y )
-		{
-			ratioY = y1 - inPos.y;
-			y2 = y1;
-			y1--;
-		}
-		else
+		const Imath::Box2i &outputDataWindow = m_warpMap->outputDataWindow;
+		const int outputWidth = outputDataWindow.size().x + 1;
+		const int tapsPerPixel = m_warpMap->filter == WarpOp::Bilinear ? 4 : 1;
+
+		for( int y = r.begin(); y != r.end(); ++y )
 		{
-			y2 = y1 + 1;
-			ratioY = inPos.y - y1;
+			size_t pixelIndex = (size_t)( y - outputDataWindow.min.y ) * outputWidth;
+			int *indices = &(m_warpMap->indices[pixelIndex * tapsPerPixel]);
+			float *ratios = m_warpMap->filter == WarpOp::Bilinear ? &(m_warpMap->ratios[pixelIndex * 2]) : 0;
+
+			for( int x = outputDataWindow.min.x; x <= outputDataWindow.max.x; ++x )
+			{
+				Imath::V2f inPos = m_warpOp->warp( Imath::V2f( x, y ) );
+				if( m_warpMap->filter == WarpOp::None )
+				{
+					*indices++ = index( int(inPos.x) - m_inputDataWindow.min.x, int(inPos.y) - m_inputDataWindow.min.y );
+					continue;
+				}
+
+				int x1 = int(inPos.x);
+				int y1 = int(inPos.y);
+				int x2, y2;
+				float ratioX, ratioY;
+				if ( x1 > inPos.x )
+				{
+					ratioX = x1 - inPos.x;
+					x2 = x1;
+					x1--;
+				}
+				else
+				{
+					x2 = x1 + 1;
+					ratioX = inPos.x - x1;
+				}
+				if ( y1 > inPos.y )
+				{
+					ratioY = y1 - inPos.y;
+					y2 = y1;
+					y1--;
+				}
+				else
+				{
+					y2 = y1 + 1;
+					ratioY = inPos.y - y1;
+				}
+				x1 -= m_inputDataWindow.min.x;
+				y1 -= m_inputDataWindow.min.y;
+				x2 -= m_inputDataWindow.min.x;
+				y2 -= m_inputDataWindow.min.y;
+
+				*indices++ = index( x1, y1 );
+				*indices++ = index( x2, y1 );
+				*indices++ = index( x1, y2 );
+				*indices++ = index( x2, y2 );
+				*ratios++ = ratioX;
+				*ratios++ = ratioY;
+			}
 		}
-		x1 -= m_inputDataWindow.min.x;
-		y1 -= m_inputDataWindow.min.y;
-		x2 -= m_inputDataWindow.min.x;
-		y2 -= m_inputDataWindow.min.y;
 	}
 
-	template<typename V>
-	inline V clampXY( const std::vector<V> &buffer, int x, int y, int width, int height ) const
-	{
-		if( m_boundMode == WarpOp::SetToBlack )
+	private :
+
+		inline int index( int x, int y ) const
 		{
-			if( x < 0 || x >= width || y < 0 || y >= height )
+			const int width = m_inputDataWindow.size().x + 1;
+			const int height = m_inputDataWindow.size().y + 1;
+			if( m_boundMode == WarpOp::SetToBlack )
 			{
-				return 0;
+				if( x < 0 || x >= width || y < 0 || y >= height )
+				{
+					return -1;
+				}
+				return x + y * width;
 			}
-			return buffer[ x + y * width ];
+
+			x = ( x < 0 ? 0 : ( x >= width ? width - 1 : x ));
+			y = ( y < 0 ? 0 : ( y >= height ? height - 1 : y ));
+			return x + y * width;
 		}
 
-		x = ( x < 0 ? 0 : ( x >= width ? width - 1 : x ));
-		y = ( y < 0 ? 0 : ( y >= height ? height - 1 : y ));
-		return buffer[ x + y * width ];
+		const WarpOp *m_warpOp;
+		WarpOp::BoundMode m_boundMode;
+		Imath::Box2i m_inputDataWindow;
+		WarpMap *m_warpMap;
+
+};
+
+namespace
+{
+
+template<typename V>
+struct ApplyWarpMap
+{
+
+	ApplyWarpMap( WarpOp::FilterType filter, const int *indices, const float *ratios, const std::vector<V> &inBuffer, std::vector<V> &outBuffer, int outputWidth )
+		:	m_filter( filter ), m_indices( indices ), m_ratios( ratios ), m_inBuffer( inBuffer ), m_outBuffer( outBuffer ), m_outputWidth( outputWidth )
+	{
 	}
 
-	template<typename T>
-	ReturnType operator()( T * data )
+	void operator()( const tbb::blocked_range<int> &r ) const
 	{
-		typedef typename T::ValueType Container;
-		typedef typename Container::value_type V;
-		typename T::Ptr inData = data->copy();
-		const Container &inBuffer = inData->readable();
-		unsigned int outputWidth = m_outputDataWindow.size().x + 1;
-		unsigned int inputWidth = m_inputDataWindow.size().x + 1;
-		unsigned int inputHeight = m_inputDataWindow.size().y + 1;
-		Container &outBuffer = data->writable();
-		outBuffer.resize( outputWidth * (m_outputDataWindow.size().y + 1) );
-		int x1, x2, y1, y2;
-		float ratioX, ratioY;
-		unsigned pixelIndex=0;
-		double r1, r2, r;
+		const size_t beginPixel = (size_t)r.begin() * m_outputWidth;
+		const size_t endPixel = (size_t)r.end() * m_outputWidth;
 
 		switch( m_filter )
 		{
-		case WarpOp::None:
-			for( int y=m_outputDataWindow.min.y; y<=m_outputDataWindow.max.y; y++ )
-			{
-				for( int x=m_outputDataWindow.min.x; x<=m_outputDataWindow.max.x; x++, pixelIndex++ )
+			case WarpOp::None :
+				for( size_t pixelIndex = beginPixel; pixelIndex < endPixel; ++pixelIndex )
 				{
-					Imath::V2f inPos = m_warpOp->warp( Imath::V2f( x, y ) );
-					x1 = int(inPos.x) - m_inputDataWindow.min.x;
-					y1 = int(inPos.y) - m_inputDataWindow.min.y;
-					outBuffer[pixelIndex] = clampXY<V>( inBuffer, x1, y1, inputWidth, inputHeight);
+					m_outBuffer[pixelIndex] = value( m_indices[pixelIndex] );
 				}
-			}
-			break;
+				break;
 
-		case WarpOp::Bilinear:
-			for( int y=m_outputDataWindow.min.y; y<=m_outputDataWindow.max.y; y++ )
+			case WarpOp::Bilinear :
 			{
-				for( int x=m_outputDataWindow.min.x; x<=m_outputDataWindow.max.x; x++, pixelIndex++ )
+				LinearInterpolator<double> lerp;
+				double r1, r2, r;
+				for( size_t pixelIndex = beginPixel; pixelIndex < endPixel; ++pixelIndex )
 				{
-					computePixelCoordinates( x, y, x1, y1, x2, y2, ratioX, ratioY );
-					LinearInterpolator<double>()( (double)clampXY<V>( inBuffer, x1, y1, inputWidth, inputHeight ),
-												  (double)clampXY<V>( inBuffer, x2, y1, inputWidth, inputHeight ), ratioX, r1 );
-					LinearInterpolator<double>()( (double)clampXY<V>( inBuffer, x1, y2, inputWidth, inputHeight ),
-												  (double)clampXY<V>( inBuffer, x2, y2, inputWidth, inputHeight ), ratioX, r2 );
-					LinearInterpolator<double>()( r1, r2, ratioY, r );
-					outBuffer[pixelIndex] = (V)r;
+					const int *indices = m_indices + pixelIndex * 4;
+					const float *ratios = m_ratios + pixelIndex * 2;
+					lerp( (double)value( indices[0] ), (double)value( indices[1] ), ratios[0], r1 );
+					lerp( (double)value( indices[2] ), (double)value( indices[3] ), ratios[0], r2 );
+					lerp( r1, r2, ratios[1], r );
+					m_outBuffer[pixelIndex] = (V)r;
 				}
+				break;
 			}
-			break;
 
-		default:
-			throw Exception("Invalid filter type!");
+			default :
+				break;
 		}
 	}
 
 	private :
-		WarpOp * m_warpOp;
+
+		inline V value( int index ) const
+		{
+			return index < 0 ? V( 0 ) : m_inBuffer[index];
+		}
+
 		WarpOp::FilterType m_filter;
-		WarpOp::BoundMode m_boundMode;
-		Imath::Box2i m_outputDataWindow;
-		Imath::Box2i m_inputDataWindow;
+		const int *m_indices;
+		const float *m_ratios;
+		const std::vector<V> &m_inBuffer;
+		std::vector<V> &m_outBuffer;
+		int m_outputWidth;
+
 };
 
-void WarpOp::modifyTypedPrimitive( ImagePrimitive * image, const CompoundObject * operands )
+} // namespace
+
+struct WarpOp::Warp
 {
-	Imath::Box2i originalDataWindow = image->getDataWindow();
+	typedef void ReturnType;
+
+	Warp( const WarpMap *warpMap )
+		:	m_warpMap( warpMap )
+	{
+	}
+
+	template<typename T>
+	ReturnType operator()( T * data )
+	{
+		typedef typename T::ValueType Container;
+		typedef typename Container::value_type V;
+
+		const Imath::Box2i &outputDataWindow = m_warpMap->outputDataWindow;
+		const int outputWidth = outputDataWindow.size().x + 1;
+		const int outputHeight = outputDataWindow.size().y + 1;
+
+		Container inBuffer;
+		inBuffer.swap( data->writable() );
+		Container &outBuffer = data->writable();
+		outBuffer.resize( (size_t)outputWidth * outputHeight );
+		if( !outBuffer.size() )
+		{
+			return;
+		}
+
+		const float *ratios = m_warpMap->ratios.size() ? &(m_warpMap->ratios[0]) : 0;
+		ApplyWarpMap<V> apply( m_warpMap->filter, &(m_warpMap->indices[0]), ratios, inBuffer, outBuffer, outputWidth );
+		tbb::parallel_for( tbb::blocked_range<int>( 0, outputHeight ), apply );
+	}
+
+	private :
+
+		const WarpMap *m_warpMap;
+};
+
+WarpOp::ConstWarpMapPtr WarpOp::warpMap( const ImagePrimitive *image, const CompoundObject *operands )
+{
+	const FilterType filter = (FilterType)m_filterParameter->getNumericValue();
+	if( filter != None && filter != Bilinear )
+	{
+		throw Exception("Invalid filter type!");
+	}
+
+	const bool cache = m_cacheWarpMapParameter->getTypedValue();
+	MurmurHash hash;
+	if( cache )
+	{
+		hash.append( image->getDataWindow() );
+		hash.append( image->getDisplayWindow() );
+		for( CompoundObject::ObjectMap::const_iterator it = operands->members().begin(); it != operands->members().end(); ++it )
+		{
+			if( it->first.string() == inputParameter()->name() )
+			{
+				continue;
+			}
+			hash.append( it->first );
+			it->second->hash( hash );
+		}
+
+		if( m_warpMap && m_warpMap->hash == hash )
+		{
+			return m_warpMap;
+		}
+	}
+
+	const Imath::Box2i originalDataWindow = image->getDataWindow();
 
 	begin( operands );
-	Imath::Box2i newDataWindow = warpedDataWindow( originalDataWindow );
+
+	WarpMapPtr result = new WarpMap;
+	result->hash = hash;
+	result->outputDataWindow = warpedDataWindow( originalDataWindow );
+	result->filter = filter;
+
+	const size_t numPixels = (size_t)( result->outputDataWindow.size().x + 1 ) * ( result->outputDataWindow.size().y + 1 );
+	result->indices.resize( numPixels * ( filter == Bilinear ? 4 : 1 ) );
+	if( filter == Bilinear )
+	{
+		result->ratios.resize( numPixels * 2 );
+	}
+
+	ComputeWarpMap compute( this, (BoundMode)m_boundModeParameter->getNumericValue(), originalDataWindow, result.get() );
+	tbb::parallel_for( tbb::blocked_range<int>( result->outputDataWindow.min.y, result->outputDataWindow.max.y + 1 ), compute );
+
+	end();
+
+	// only keep the map if we've been asked to, so as not to hold
+	// on to the memory unnecessarily.
+	if( cache )
+	{
+		m_warpMap = result;
+	}
+	else
+	{
+		m_warpMap = 0;
+	}
+
+	return result;
+}
+
+void WarpOp::modifyTypedPrimitive( ImagePrimitive * image, const CompoundObject * operands )
+{
+	ConstWarpMapPtr map = warpMap( image, operands );
+
 	std::string error;
-	Warp w( this, (FilterType)m_filterParameter->getNumericValue(), (BoundMode)m_boundModeParameter->getNumericValue(), newDataWindow, originalDataWindow );
+	Warp w( map.get() );
 	for( PrimitiveVariableMap::iterator it = image->variables.begin(); it != image->variables.end(); it++ )
 	{
 		if( it->second.interpolation!=PrimitiveVariable::Vertex &&
@@ -236,8 +421,7 @@ void WarpOp::modifyTypedPrimitive( ImagePrimitive * image, const CompoundObject
 		}
 		despatchTypedData<Warp, TypeTraits::IsNumericVectorTypedData>( it->second.data.get(), w );
 	}
-	end();
-	image->setDataWindow( newDataWindow );
+	image->setDataWindow( map->outputDataWindow );
 }
 
 Imath::Box2i WarpOp::warpedDataWindow( const Imath::Box2i &dataWindow ) const
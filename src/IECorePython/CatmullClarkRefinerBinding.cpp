@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+// This include needs to be the very first to prevent problems with warnings
+// regarding redefinition of _POSIX_C_SOURCE
+#include "boost/python.hpp"
+
+#include "IECore/CatmullClarkRefiner.h"
+#include "IECorePython/CatmullClarkRefinerBinding.h"
+#include "IECorePython/RefCountedBinding.h"
+#include "IECorePython/ScopedGILRelease.h"
+
+using namespace boost::python;
+using namespace IECore;
+
+namespace IECorePython
+{
+
+static MeshPrimitivePtr refineMesh( const CatmullClarkRefiner &r, ConstMeshPrimitivePtr mesh )
+{
+	ScopedGILRelease gilRelease;
+	return r.refine( mesh.get() );
+}
+
+static PrimitiveVariable refinePrimitiveVariable( const CatmullClarkRefiner &r, const PrimitiveVariable &primitiveVariable )
+{
+	ScopedGILRelease gilRelease;
+	return r.refine( primitiveVariable );
+}
+
+static CatmullClarkRefinerPtr shared( ConstMeshPrimitivePtr mesh, unsigned levels )
+{
+	ConstCatmullClarkRefinerPtr result;
+	{
+		ScopedGILRelease gilRelease;
+		result = CatmullClarkRefiner::shared( mesh.get(), levels );
+	}
+	return boost::const_pointer_cast<CatmullClarkRefiner>( result );
+}
+
+void bindCatmullClarkRefiner()
+{
+	RefCountedClass<CatmullClarkRefiner, RefCounted>( "CatmullClarkRefiner" )
+		.def( init<const MeshPrimitive *, optional<unsigned> >( ( arg( "mesh" ), arg( "levels" ) = 1 ) ) )
+		.def( "levels", &CatmullClarkRefiner::levels )
+		.def( "topologyHash", &CatmullClarkRefiner::topologyHash, return_value_policy<copy_const_reference>() )
+		.def( "refine", &refinePrimitiveVariable )
+		.def( "refine", &refineMesh )
+		.def( "memoryUsage", &CatmullClarkRefiner::memoryUsage )
+		.def( "shared", &shared, ( arg( "mesh" ), arg( "levels" ) = 1 ) ).staticmethod( "shared" )
+	;
+}
+
+}
@@ -80,6 +80,13 @@ class ColorTransformOpWrap : public ColorTransformOp, public Wrapper<ColorTransf
 			}
 		};
 
+		virtual bool canTransformConcurrently() const
+		{
+			// python implementations of transform() would otherwise be
+			// called on many threads, all contending for the GIL.
+			return false;
+		}
+
 		virtual void end()
 		{
 			ScopedGILLock gilLock;
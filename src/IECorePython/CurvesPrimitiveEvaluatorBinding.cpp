@@ -71,7 +71,7 @@ static IntVectorDataPtr varyingDataOffsets( const CurvesPrimitiveEvaluator &e )
 void bindCurvesPrimitiveEvaluator()
 {
 	scope s = RunTimeTypedClass<CurvesPrimitiveEvaluator>()
-		.def( init<CurvesPrimitivePtr>() )
+		.def( init<CurvesPrimitivePtr, optional<PrimitiveEvaluator::AccelerationStructure> >() )
 		.def( "pointAtV", &pointAtV )
 		.def( "curveLength", &CurvesPrimitiveEvaluator::curveLength,
 			(
@@ -52,6 +52,18 @@ static StringVectorDataPtr channelNames( DeepImageReader &that )
 	return result;
 }
 
+static tuple readScanline( DeepImageReader &that, int y )
+{
+	DeepScanline scanline;
+	that.readScanline( y, scanline );
+	
+	return make_tuple(
+		UIntVectorDataPtr( new UIntVectorData( scanline.sampleCounts ) ),
+		FloatVectorDataPtr( new FloatVectorData( scanline.depths ) ),
+		FloatVectorDataPtr( new FloatVectorData( scanline.channelData ) )
+	);
+}
+
 void bindDeepImageReader()
 {
 	RunTimeTypedClass<DeepImageReader>()
@@ -62,6 +74,7 @@ void bindDeepImageReader()
 		.def( "worldToCameraMatrix", &DeepImageReader::worldToCameraMatrix )
 		.def( "worldToNDCMatrix", &DeepImageReader::worldToNDCMatrix )
 		.def( "readPixel", &DeepImageReader::readPixel, ( arg_( "x" ), arg_( "y" ) ) )
+		.def( "readScanline", &readScanline, ( arg_( "y" ) ) )
 	;
 }
 
@@ -35,7 +35,9 @@
 #include "boost/python.hpp"
 
 #include "IECore/DeepImageWriter.h"
+#include "IECore/Exception.h"
 #include "IECore/FileNameParameter.h"
+#include "IECore/VectorTypedData.h"
 #include "IECorePython/DeepImageWriterBinding.h"
 #include "IECorePython/RunTimeTypedBinding.h"
 
@@ -71,10 +73,29 @@ static list supportedExtensions( TypeId typeId )
 	return result;
 }
 
+static void writeScanline( DeepImageWriter &that, int y, const UIntVectorData *sampleCounts, const FloatVectorData *depths, const FloatVectorData *channelData )
+{
+	const std::vector<unsigned> &counts = sampleCounts->readable();
+	
+	DeepScanline scanline( counts.size(), that.channelNamesParameter()->getTypedValue().size() );
+	scanline.sampleCounts = counts;
+	scanline.allocateSamples();
+	
+	if ( depths->readable().size() != scanline.depths.size() || channelData->readable().size() != scanline.channelData.size() )
+	{
+		throw InvalidArgumentException( "Sample data does not match the sample counts." );
+	}
+	
+	scanline.depths = depths->readable();
+	scanline.channelData = channelData->readable();
+	that.writeScanline( y, scanline );
+}
+
 void bindDeepImageWriter()
 {
 	RunTimeTypedClass<DeepImageWriter>()
 		.def( "writePixel", &DeepImageWriter::writePixel, ( arg_( "x" ), arg_( "y" ), arg_( "pixel" ) ) )
+		.def( "writeScanline", &writeScanline, ( arg_( "y" ), arg_( "sampleCounts" ), arg_( "depths" ), arg_( "channelData" ) ) )
 		.def( "create", &DeepImageWriter::create ).staticmethod( "create" )
 		.def( "supportedExtensions", ( list(*)( ) )&supportedExtensions )
 		.def( "supportedExtensions", ( list(*)( TypeId ) )&supportedExtensions )
@@ -63,27 +63,18 @@ static ImageDisplayDriverPtr imageDisplayDriverConstructor( const Imath::Box2i &
 
 static ImagePrimitivePtr image( ImageDisplayDriverPtr dd )
 {
-	return dd->image()->copy();
+	// image() always returns a fresh copy, so there's no need to copy it again
+	return boost::const_pointer_cast<ImagePrimitive>( dd->image() );
 }
 
 static ImagePrimitivePtr storedImage( const std::string &handle )
 {
-	ConstImagePrimitivePtr i = ImageDisplayDriver::storedImage( handle );
-	if( i )
-	{
-		return i->copy();
-	}
-	return 0;
+	return boost::const_pointer_cast<ImagePrimitive>( ImageDisplayDriver::storedImage( handle ) );
 }
 
 static ImagePrimitivePtr removeStoredImage( const std::string &handle )
 {
-	ConstImagePrimitivePtr i = ImageDisplayDriver::removeStoredImage( handle );
-	if( i )
-	{
-		return i->copy();
-	}
-	return 0;
+	return boost::const_pointer_cast<ImagePrimitive>( ImageDisplayDriver::removeStoredImage( handle ) );
 }
 
 void bindImageDisplayDriver()
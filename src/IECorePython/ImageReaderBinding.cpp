@@ -64,6 +64,8 @@ void bindImageReader()
 		.def( "displayWindow", &ImageReader::displayWindow )
 		.def( "readChannel", (DataPtr (ImageReader::*)( const std::string &, bool ))&ImageReader::readChannel, ( arg_("name"), arg_( "raw" ) = false ) )
 		.def( "sourceColorSpace", &ImageReader::sourceColorSpace )
+		.def( "numBands", &ImageReader::numBands, ( arg_( "bandHeight" ) ) )
+		.def( "readBand", &ImageReader::readBand, ( arg_( "bandIndex" ), arg_( "bandHeight" ) ) )
 	;
 
 }
@@ -306,6 +306,8 @@ void bindIndexedIOBase()
 			.value("Append", IndexedIO::Append)
 			.value("Shared", IndexedIO::Shared)
 			.value("Exclusive", IndexedIO::Exclusive)
+			.value("MemoryMapped", IndexedIO::MemoryMapped)
+			.value("Compressed", IndexedIO::Compressed)
 			.export_values()
 		;
 
@@ -408,7 +410,9 @@ void bindIndexedIOBase()
 
 void bindStreamIndexedIO()
 {
-	IECorePython::RunTimeTypedClass<StreamIndexedIO>();
+	IECorePython::RunTimeTypedClass<StreamIndexedIO>()
+		.def( "prefetchIndex", &StreamIndexedIO::prefetchIndex, ( arg( "wait" ) = true ) )
+	;
 }
 
 void bindFileIndexedIO()
@@ -35,9 +35,11 @@
 #include "boost/python.hpp"
 
 #include "IECore/MeshPrimitiveEvaluator.h"
+#include "IECore/VectorTypedData.h"
 #include "IECorePython/MeshPrimitiveEvaluatorBinding.h"
 #include "IECorePython/RunTimeTypedBinding.h"
 #include "IECorePython/RefCountedBinding.h"
+#include "IECorePython/ScopedGILRelease.h"
 
 using namespace IECore;
 using namespace boost::python;
@@ -52,11 +54,67 @@ static bool barycentricPosition( const MeshPrimitiveEvaluator &e, unsigned int t
 	return e.barycentricPosition( t, b, r );
 }
 
+static tuple closestPoints( const MeshPrimitiveEvaluator &e, const V3fVectorData *points )
+{
+	const std::vector<Imath::V3f> &p = points->readable();
+
+	IntVectorDataPtr triangleIndices = new IntVectorData( std::vector<int>( p.size(), -1 ) );
+	V3fVectorDataPtr barycentricCoordinates = new V3fVectorData( std::vector<Imath::V3f>( p.size(), Imath::V3f( 0 ) ) );
+	FloatVectorDataPtr distances = new FloatVectorData( std::vector<float>( p.size(), 0 ) );
+	V3fVectorDataPtr resultPoints = new V3fVectorData( std::vector<Imath::V3f>( p.size(), Imath::V3f( 0 ) ) );
+
+	if( p.size() )
+	{
+		ScopedGILRelease gilRelease;
+		e.closestPoints(
+			&p[0], p.size(), &triangleIndices->writable()[0], &barycentricCoordinates->writable()[0],
+			&distances->writable()[0], &resultPoints->writable()[0]
+		);
+	}
+
+	return make_tuple( triangleIndices, barycentricCoordinates, distances, resultPoints );
+}
+
+static tuple rayIntersections( const MeshPrimitiveEvaluator &e, const V3fVectorData *origins, const V3fVectorData *directions, float maxDistance )
+{
+	const std::vector<Imath::V3f> &o = origins->readable();
+	const std::vector<Imath::V3f> &d = directions->readable();
+	if( o.size() != d.size() )
+	{
+		throw InvalidArgumentException( "Number of origins and directions must match" );
+	}
+
+	IntVectorDataPtr triangleIndices = new IntVectorData( std::vector<int>( o.size(), -1 ) );
+	V3fVectorDataPtr barycentricCoordinates = new V3fVectorData( std::vector<Imath::V3f>( o.size(), Imath::V3f( 0 ) ) );
+	FloatVectorDataPtr distances = new FloatVectorData( std::vector<float>( o.size(), 0 ) );
+	V3fVectorDataPtr resultPoints = new V3fVectorData( std::vector<Imath::V3f>( o.size(), Imath::V3f( 0 ) ) );
+
+	if( o.size() )
+	{
+		ScopedGILRelease gilRelease;
+		e.rayIntersections(
+			&o[0], &d[0], o.size(), &triangleIndices->writable()[0], &barycentricCoordinates->writable()[0],
+			&distances->writable()[0], &resultPoints->writable()[0], maxDistance
+		);
+	}
+
+	return make_tuple( triangleIndices, barycentricCoordinates, distances, resultPoints );
+}
+
+static bool updatePositions( MeshPrimitiveEvaluator &e, const MeshPrimitive *mesh )
+{
+	ScopedGILRelease gilRelease;
+	return e.updatePositions( mesh );
+}
+
 void bindMeshPrimitiveEvaluator()
 {
 	object m = RunTimeTypedClass<MeshPrimitiveEvaluator>()
-		.def( init< MeshPrimitivePtr > () )
+		.def( init< MeshPrimitivePtr, optional<PrimitiveEvaluator::AccelerationStructure> > () )
 		.def( "barycentricPosition", &barycentricPosition )
+		.def( "closestPoints", &closestPoints, ( arg( "points" ) ) )
+		.def( "rayIntersections", &rayIntersections, ( arg( "origins" ), arg( "directions" ), arg( "maxDistance" ) = Imath::limits<float>::max() ) )
+		.def( "updatePositions", &updatePositions )
 		.def( "uvBound", &MeshPrimitiveEvaluator::uvBound )	
 	;
 
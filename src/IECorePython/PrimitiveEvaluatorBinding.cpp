@@ -189,6 +189,12 @@ void bindPrimitiveEvaluator()
 
 	{
 		scope ps( p );
+
+		enum_<PrimitiveEvaluator::AccelerationStructure>( "AccelerationStructure" )
+			.value( "BoundedKDTreeAcceleration", PrimitiveEvaluator::BoundedKDTreeAcceleration )
+			.value( "BVHAcceleration", PrimitiveEvaluator::BVHAcceleration )
+		;
+
 		RefCountedClass<PrimitiveEvaluator::Result, RefCounted>( "Result" )
 			.def( "point", &PrimitiveEvaluator::Result::point )
 			.def( "normal", &PrimitiveEvaluator::Result::normal )
@@ -207,6 +207,26 @@ ObjectPtr readObject( SceneInterface &m, double time )
 	return 0;
 }
 
+static void prefetch( const SceneInterface &m, list pathList, list timeList )
+{
+	std::vector<SceneInterface::Path> paths;
+	int numPaths = IECorePython::len( pathList );
+	paths.resize( numPaths );
+	for ( int i = 0; i < numPaths; i++ )
+	{
+		listToSceneInterfaceNameList( extract<list>( pathList[i] ), paths[i] );
+	}
+
+	std::vector<double> times;
+	int numTimes = IECorePython::len( timeList );
+	for ( int i = 0; i < numTimes; i++ )
+	{
+		times.push_back( extract<double>( timeList[i] ) );
+	}
+
+	m.prefetch( paths, times );
+}
+
 static MurmurHash sceneHash( SceneInterface &m, SceneInterface::HashType hashType, double time )
 {
 	MurmurHash h;
@@ -281,6 +301,7 @@ void bindSceneInterface()
 		.def( "child", nonConstChild, ( arg( "name" ), arg( "missingBehaviour" ) = SceneInterface::ThrowIfMissing ) )
 		.def( "createChild", &SceneInterface::createChild )
 		.def( "scene", &nonConstScene, ( arg( "path" ), arg( "missingBehaviour" ) = SceneInterface::ThrowIfMissing ) )
+		.def( "prefetch", &prefetch )
 		.def( "hash", &sceneHash )
 
 		.def( "pathToString", pathToString ).staticmethod("pathToString")
@@ -145,6 +145,7 @@
 #include "IECorePython/TypedPrimitiveOpBinding.h"
 #include "IECorePython/PrimitiveEvaluatorBinding.h"
 #include "IECorePython/MeshPrimitiveEvaluatorBinding.h"
+#include "IECorePython/CatmullClarkRefinerBinding.h"
 #include "IECorePython/TriangulateOpBinding.h"
 #include "IECorePython/InternedStringBinding.h"
 #include "IECorePython/SpherePrimitiveBinding.h"
@@ -423,6 +424,7 @@ BOOST_PYTHON_MODULE(_IECore)
 	bindTypedPrimitiveOp();
 	bindPrimitiveEvaluator();
 	bindMeshPrimitiveEvaluator();
+	bindCatmullClarkRefiner();
 	bindTriangulateOp();
 	bindInternedString();
 	bindSpherePrimitive();
@@ -110,6 +110,7 @@ from MatrixMultiplyOp import *
 from PointBoundsOp import *
 from PrimitiveEvaluator import *
 from MeshPrimitiveEvaluator import *
+from CatmullClarkRefinerTest import CatmullClarkRefinerTest
 from InternedStringTest import InternedStringTest
 from Writer import *
 from TriangulateOp import *
@@ -259,6 +260,7 @@ from DisplayDriverServerTest import DisplayDriverServerTest
 if IECore.withDeepEXR() :
 	from EXRDeepImageReaderTest import EXRDeepImageReaderTest
 	from EXRDeepImageWriterTest import EXRDeepImageWriterTest
+	from DeepImageConverterTest import DeepImageConverterTest
 
 if IECore.withASIO() :
 	from DisplayDriverTest import *
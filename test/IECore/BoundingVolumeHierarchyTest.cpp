@@ -0,0 +1,357 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "tbb/tick_count.h"
+
+#include "OpenEXR/ImathRandom.h"
+#include "OpenEXR/ImathBoxAlgo.h"
+
+#include "IECore/BoundingVolumeHierarchy.h"
+#include "IECore/BoundedKDTree.h"
+#include "IECore/BoxOps.h"
+#include "IECore/MeshPrimitive.h"
+#include "IECore/MeshPrimitiveEvaluator.h"
+
+#include "BoundingVolumeHierarchyTest.h"
+
+using namespace boost;
+using namespace boost::unit_test;
+using namespace tbb;
+using namespace Imath;
+
+namespace IECore
+{
+
+struct BoundingVolumeHierarchyTest
+{
+
+	typedef std::vector<Box3f> BoundVector;
+	typedef BoundVector::const_iterator BoundIterator;
+
+	static void makeBounds( unsigned numBounds, BoundVector &bounds )
+	{
+		Rand32 rand;
+		bounds.clear();
+		for( unsigned i = 0; i < numBounds; ++i )
+		{
+			V3f center( rand.nextf(), rand.nextf(), rand.nextf() );
+			// Cluster a third of the bounds tightly, so that the
+			// distribution is far from uniform.
+			if( i % 3 == 0 )
+			{
+				center = V3f( 0.5f ) + ( center - V3f( 0.5f ) ) * 0.01f;
+			}
+			const V3f size = V3f( rand.nextf(), rand.nextf(), rand.nextf() ) * 0.01f;
+			bounds.push_back( Box3f( center - size, center + size ) );
+		}
+	}
+
+	struct ClosestBound
+	{
+		ClosestBound( const V3f &p ) : m_p( p )
+		{
+		}
+
+		void operator()( const BoundIterator *first, const BoundIterator *last, float &maxDistanceSquared )
+		{
+			for( ; first != last; ++first )
+			{
+				const float d2 = ( closestPointInBox( m_p, **first ) - m_p ).length2();
+				if( d2 < maxDistanceSquared )
+				{
+					maxDistanceSquared = d2;
+				}
+			}
+		}
+
+		V3f m_p;
+	};
+
+	struct FirstHit
+	{
+		FirstHit( const V3f &origin, const V3f &direction ) : m_origin( origin ), m_direction( direction )
+		{
+		}
+
+		void operator()( const BoundIterator *first, const BoundIterator *last, float &maxDistance )
+		{
+			for( ; first != last; ++first )
+			{
+				V3f hitPoint;
+				if( boxIntersects( **first, m_origin, m_direction, hitPoint ) )
+				{
+					const float d = ( hitPoint - m_origin ).length();
+					if( d < maxDistance )
+					{
+						maxDistance = d;
+					}
+				}
+			}
+		}
+
+		V3f m_origin;
+		V3f m_direction;
+	};
+
+	void testIntersectingBounds()
+	{
+		BoundVector bounds;
+		makeBounds( 10000, bounds );
+		Box3fBVH bvh( bounds.begin(), bounds.end() );
+
+		Rand32 rand;
+		std::vector<BoundIterator> found;
+		for( unsigned i = 0; i < 100; ++i )
+		{
+			const V3f p( rand.nextf(), rand.nextf(), rand.nextf() );
+			const Box3f query( p - V3f( 0.05f ), p + V3f( 0.05f ) );
+			bvh.intersectingBounds( query, found );
+			std::sort( found.begin(), found.end() );
+
+			std::vector<BoundIterator> expected;
+			for( BoundIterator it = bounds.begin(); it != bounds.end(); ++it )
+			{
+				if( it->intersects( query ) )
+				{
+					expected.push_back( it );
+				}
+			}
+
+			BOOST_CHECK( found == expected );
+		}
+	}
+
+	void testClosestLeaves()
+	{
+		BoundVector bounds;
+		makeBounds( 10000, bounds );
+		Box3fBVH bvh( bounds.begin(), bounds.end() );
+
+		Rand32 rand;
+		for( unsigned i = 0; i < 100; ++i )
+		{
+			const V3f p( rand.nextf( -0.5f, 1.5f ), rand.nextf( -0.5f, 1.5f ), rand.nextf( -0.5f, 1.5f ) );
+
+			float d2 = limits<float>::max();
+			ClosestBound closestBound( p );
+			bvh.closestLeaves( p, d2, closestBound );
+
+			float expected = limits<float>::max();
+			for( BoundIterator it = bounds.begin(); it != bounds.end(); ++it )
+			{
+				expected = std::min( expected, ( closestPointInBox( p, *it ) - p ).length2() );
+			}
+
+			BOOST_CHECK_EQUAL( d2, expected );
+		}
+	}
+
+	void testRayLeaves()
+	{
+		BoundVector bounds;
+		makeBounds( 10000, bounds );
+		Box3fBVH bvh( bounds.begin(), bounds.end() );
+
+		Rand32 rand;
+		for( unsigned i = 0; i < 100; ++i )
+		{
+			const V3f origin( rand.nextf( -0.5f, 1.5f ), rand.nextf( -0.5f, 1.5f ), -1.0f );
+			const V3f direction = ( V3f( rand.nextf(), rand.nextf(), rand.nextf() ) - origin ).normalized();
+
+			float d = limits<float>::max();
+			FirstHit firstHit( origin, direction );
+			bvh.rayLeaves( origin, direction, d, firstHit );
+
+			float expected = limits<float>::max();
+			for( BoundIterator it = bounds.begin(); it != bounds.end(); ++it )
+			{
+				V3f hitPoint;
+				if( boxIntersects( *it, origin, direction, hitPoint ) )
+				{
+					expected = std::min( expected, ( hitPoint - origin ).length() );
+				}
+			}
+
+			BOOST_CHECK_CLOSE( d, expected, 0.001f );
+		}
+	}
+
+	void testDegenerateBounds()
+	{
+		// All the bounds share a centroid, so no split can separate them.
+		BoundVector bounds( 1000, Box3f( V3f( -1 ), V3f( 1 ) ) );
+		Box3fBVH bvh( bounds.begin(), bounds.end(), 4 );
+
+		size_t numBounds = 0;
+		for( Box3fBVH::NodeIndex i = 0; i < bvh.numNodes(); ++i )
+		{
+			const Box3fBVH::Node &node = bvh.node( i );
+			if( node.isLeaf() )
+			{
+				numBounds += bvh.permLast( node ) - bvh.permFirst( node );
+			}
+		}
+		BOOST_CHECK_EQUAL( numBounds, bounds.size() );
+
+		std::vector<BoundIterator> found;
+		BOOST_CHECK_EQUAL( bvh.intersectingBounds( Box3f( V3f( 0 ) ), found ), bounds.size() );
+
+		BoundVector empty;
+		Box3fBVH emptyBVH( empty.begin(), empty.end() );
+		BOOST_CHECK_EQUAL( emptyBVH.numNodes(), 0u );
+		BOOST_CHECK_EQUAL( emptyBVH.intersectingBounds( Box3f( V3f( 0 ) ), found ), 0u );
+	}
+
+	static MeshPrimitivePtr makeMesh( unsigned numTriangles )
+	{
+		Rand32 rand;
+
+		IntVectorDataPtr verticesPerFaceData = new IntVectorData;
+		verticesPerFaceData->writable().resize( numTriangles, 3 );
+		IntVectorDataPtr vertexIdsData = new IntVectorData;
+		std::vector<int> &vertexIds = vertexIdsData->writable();
+		V3fVectorDataPtr pData = new V3fVectorData;
+		std::vector<V3f> &p = pData->writable();
+
+		for( unsigned i = 0; i < numTriangles; ++i )
+		{
+			// Mix large and small triangles, as is typical of
+			// adaptively tessellated geometry.
+			const float size = i % 10 ? 0.001f : 0.05f;
+			const V3f center( rand.nextf(), rand.nextf(), rand.nextf() );
+			for( int j = 0; j < 3; ++j )
+			{
+				vertexIds.push_back( p.size() );
+				p.push_back( center + V3f( rand.nextf( -1, 1 ), rand.nextf( -1, 1 ), rand.nextf( -1, 1 ) ) * size );
+			}
+		}
+
+		return new MeshPrimitive( verticesPerFaceData, vertexIdsData, "linear", pData );
+	}
+
+	/// Runs the same queries against MeshPrimitiveEvaluators using each
+	/// acceleration structure, and checks that they find the same answers.
+	/// Build and query rates are reported if requested.
+	static void compareAccelerationStructures( unsigned numTriangles, size_t numQueries, bool reportRates )
+	{
+		MeshPrimitivePtr mesh = makeMesh( numTriangles );
+
+		Rand32 rand;
+		std::vector<V3f> points( numQueries );
+		std::vector<V3f> directions( numQueries );
+		for( size_t i = 0; i < numQueries; ++i )
+		{
+			points[i] = V3f( rand.nextf(), rand.nextf(), rand.nextf() );
+			directions[i] = V3f( rand.nextf( -1, 1 ), rand.nextf( -1, 1 ), rand.nextf( -1, 1 ) );
+		}
+
+		const char *names[] = { "BoundedKDTree", "BVH" };
+		const PrimitiveEvaluator::AccelerationStructure structures[] = { PrimitiveEvaluator::BoundedKDTreeAcceleration, PrimitiveEvaluator::BVHAcceleration };
+
+		std::vector<float> closestDistances[2];
+		std::vector<int> hitTriangles[2];
+		for( int s = 0; s < 2; ++s )
+		{
+			tick_count t0 = tick_count::now();
+			MeshPrimitiveEvaluatorPtr evaluator = new MeshPrimitiveEvaluator( mesh, structures[s] );
+			tick_count t1 = tick_count::now();
+
+			std::vector<int> triangleIndices( numQueries );
+			std::vector<V3f> barycentricCoordinates( numQueries );
+			closestDistances[s].resize( numQueries );
+			evaluator->closestPoints( &points[0], numQueries, &triangleIndices[0], &barycentricCoordinates[0], &closestDistances[s][0] );
+			tick_count t2 = tick_count::now();
+
+			hitTriangles[s].resize( numQueries );
+			evaluator->rayIntersections( &points[0], &directions[0], numQueries, &hitTriangles[s][0], &barycentricCoordinates[0] );
+			tick_count t3 = tick_count::now();
+
+			if( reportRates )
+			{
+				BOOST_TEST_MESSAGE( "MeshPrimitiveEvaluator with " << names[s] << " : build " << ( t1 - t0 ).seconds() << "s" );
+				BOOST_TEST_MESSAGE( "MeshPrimitiveEvaluator with " << names[s] << " : " << numQueries / ( t2 - t1 ).seconds() << " closest points/s" );
+				BOOST_TEST_MESSAGE( "MeshPrimitiveEvaluator with " << names[s] << " : " << numQueries / ( t3 - t2 ).seconds() << " rays/s" );
+			}
+		}
+
+		// Both structures must find the same answers.
+		for( size_t i = 0; i < numQueries; ++i )
+		{
+			BOOST_CHECK_CLOSE( closestDistances[0][i], closestDistances[1][i], 0.001f );
+			BOOST_CHECK_EQUAL( hitTriangles[0][i] == -1, hitTriangles[1][i] == -1 );
+		}
+	}
+
+	void testMeshPrimitiveEvaluator()
+	{
+		compareAccelerationStructures( 2000, 1000, false );
+	}
+
+	void testMeshPrimitiveEvaluatorBenchmark()
+	{
+		compareAccelerationStructures( 200000, 100000, true );
+	}
+
+};
+
+struct BoundingVolumeHierarchyTestSuite : public boost::unit_test::test_suite
+{
+
+	BoundingVolumeHierarchyTestSuite() : boost::unit_test::test_suite( "BoundingVolumeHierarchyTestSuite" )
+	{
+		boost::shared_ptr<BoundingVolumeHierarchyTest> instance( new BoundingVolumeHierarchyTest() );
+
+		add( BOOST_CLASS_TEST_CASE( &BoundingVolumeHierarchyTest::testIntersectingBounds, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &BoundingVolumeHierarchyTest::testClosestLeaves, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &BoundingVolumeHierarchyTest::testRayLeaves, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &BoundingVolumeHierarchyTest::testDegenerateBounds, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &BoundingVolumeHierarchyTest::testMeshPrimitiveEvaluator, instance ) );
+
+		// the benchmark takes a while, so is only run on request
+		if( getenv( "IECORE_BVH_BENCHMARK" ) )
+		{
+			add( BOOST_CLASS_TEST_CASE( &BoundingVolumeHierarchyTest::testMeshPrimitiveEvaluatorBenchmark, instance ) );
+		}
+	}
+};
+
+void addBoundingVolumeHierarchyTest( boost::unit_test::test_suite *test )
+{
+	test->add( new BoundingVolumeHierarchyTestSuite() );
+}
+
+} // namespace IECore
@@ -0,0 +1,186 @@
+##########################################################################
+#
+#  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of Image Engine Design nor the names of any
+#       other contributors to this software may be used to endorse or
+#       promote products derived from this software without specific prior
+#       written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+import os
+import sys
+import subprocess
+import unittest
+from IECore import *
+
+class CatmullClarkRefinerTest( unittest.TestCase ) :
+
+	def testCube( self ) :
+
+		m = MeshPrimitive.createBox( Box3f( V3f( -1 ), V3f( 1 ) ) )
+		r = CatmullClarkRefiner( m )
+		self.assertEqual( r.levels(), 1 )
+		self.assertEqual( r.topologyHash(), m.topologyHash() )
+
+		s = r.refine( m )
+		self.failUnless( s.arePrimitiveVariablesValid() )
+		self.assertEqual( s.numFaces(), 24 )
+		self.assertEqual( s.verticesPerFace, IntVectorData( [ 4 ] * 24 ) )
+		self.assertEqual( s.variableSize( PrimitiveVariable.Interpolation.Vertex ), 26 )
+		self.assertEqual( s.interpolation, m.interpolation )
+
+		# vertex points keep their indices, and are followed
+		# by the 12 edge points and then the 6 face points.
+		p = s["P"].data
+		for i in range( 0, 8 ) :
+			self.failUnless( p[i].equalWithAbsError( m["P"].data[i] * 5.0 / 9.0, 0.00001 ) )
+		for i in range( 8, 20 ) :
+			c = sorted( [ abs( p[i][j] ) for j in range( 0, 3 ) ] )
+			for a, b in zip( c, [ 0, 0.75, 0.75 ] ) :
+				self.assertAlmostEqual( a, b, 5 )
+		for i in range( 20, 26 ) :
+			c = sorted( [ abs( p[i][j] ) for j in range( 0, 3 ) ] )
+			for a, b in zip( c, [ 0, 0, 1 ] ) :
+				self.assertAlmostEqual( a, b, 5 )
+
+	def testLevels( self ) :
+
+		m = MeshPrimitive.createBox( Box3f( V3f( -1 ), V3f( 1 ) ) )
+		s = m
+		for levels in range( 1, 4 ) :
+			r = CatmullClarkRefiner( m, levels )
+			self.assertEqual( r.levels(), levels )
+			# refining in one go must match refining level by level
+			s = CatmullClarkRefiner( s ).refine( s )
+			t = r.refine( m )
+			self.assertEqual( t.numFaces(), 6 * 4 ** levels )
+			self.assertEqual( t.verticesPerFace, s.verticesPerFace )
+			self.assertEqual( t.vertexIds, s.vertexIds )
+			for a, b in zip( t["P"].data, s["P"].data ) :
+				self.failUnless( a.equalWithAbsError( b, 0.00001 ) )
+			self.failUnless( m.bound().contains( t.bound() ) )
+
+	def testPlaneBoundary( self ) :
+
+		m = MeshPrimitive.createPlane( Box2f( V2f( -1 ), V2f( 1 ) ), V2i( 2 ) )
+		s = CatmullClarkRefiner( m, 2 ).refine( m )
+		self.failUnless( s.arePrimitiveVariablesValid() )
+
+		# corners are kept fixed
+		for i in ( 0, 2, 6, 8 ) :
+			self.assertEqual( s["P"].data[i], m["P"].data[i] )
+		# boundary vertices only slide along the boundary
+		for i in ( 1, 3, 5, 7 ) :
+			self.failUnless( s["P"].data[i].equalWithAbsError( m["P"].data[i], 0.00001 ) )
+		for p in s["P"].data :
+			self.assertEqual( p.z, 0 )
+			self.failUnless( m.bound().intersects( p ) )
+
+		# facevarying uvs are interpolated bilinearly, so stay in range
+		self.assertEqual( len( s["s"].data ), len( s.vertexIds ) )
+		for n in ( "s", "t" ) :
+			for v in s[n].data :
+				self.failUnless( v >= 0 and v <= 1 )
+
+	def testDeformingMesh( self ) :
+
+		m = MeshPrimitive.createBox( Box3f( V3f( -1 ), V3f( 1 ) ) )
+		r = CatmullClarkRefiner( m, 2 )
+		s = r.refine( m )
+
+		d = m.copy()
+		d["P"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, V3fVectorData( [ p * 2 + V3f( 1, 2, 3 ) for p in m["P"].data ] ) )
+		t = r.refine( d )
+		for a, b in zip( t["P"].data, s["P"].data ) :
+			self.failUnless( a.equalWithAbsError( b * 2 + V3f( 1, 2, 3 ), 0.0001 ) )
+
+		self.assertRaises( Exception, r.refine, MeshPrimitive.createPlane( Box2f( V2f( -1 ), V2f( 1 ) ) ) )
+
+	def testPrimitiveVariables( self ) :
+
+		m = MeshPrimitive.createBox( Box3f( V3f( -1 ), V3f( 1 ) ) )
+		m["constant"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Constant, StringData( "a" ) )
+		m["uniform"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Uniform, IntVectorData( range( 0, 6 ) ) )
+		m["varying"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Varying, Color3fVectorData( [ Color3f( i ) for i in range( 0, 8 ) ] ) )
+		m["faceVarying"] = PrimitiveVariable( PrimitiveVariable.Interpolation.FaceVarying, FloatVectorData( range( 0, 24 ) ) )
+		m["vertexNames"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, StringVectorData( [ str( i ) for i in range( 0, 8 ) ] ) )
+
+		r = CatmullClarkRefiner( m )
+		s = r.refine( m )
+		self.failUnless( s.arePrimitiveVariablesValid() )
+
+		self.assertEqual( s["constant"], m["constant"] )
+		self.assertEqual( s["uniform"].data, IntVectorData( [ i for i in range( 0, 6 ) for j in range( 0, 4 ) ] ) )
+		self.assertEqual( s["vertexNames"].data[:8], m["vertexNames"].data )
+
+		# varying values are the averages of the face and edge corners
+		for i in range( 0, 8 ) :
+			self.assertEqual( s["varying"].data[i], Color3f( i ) )
+		for i in range( 20, 26 ) :
+			self.failUnless( s["varying"].data[i][0] > 0 and s["varying"].data[i][0] < 7 )
+
+		# facevarying values for each child face's corner are the original corner values
+		fv = s["faceVarying"].data
+		for i in range( 0, 24 ) :
+			self.assertAlmostEqual( fv[i*4], m["faceVarying"].data[i], 5 )
+
+		p = r.refine( m["uniform"] )
+		self.assertEqual( p.interpolation, PrimitiveVariable.Interpolation.Uniform )
+		self.assertEqual( p.data, s["uniform"].data )
+
+		self.assertRaises( Exception, r.refine, PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ 1, 2 ] ) ) )
+
+	def testShared( self ) :
+
+		m = MeshPrimitive.createBox( Box3f( V3f( -1 ), V3f( 1 ) ) )
+		m2 = MeshPrimitive.createBox( Box3f( V3f( -2 ), V3f( 2 ) ) )
+
+		r = CatmullClarkRefiner.shared( m )
+		self.failUnless( r.isSame( CatmullClarkRefiner.shared( m2 ) ) )
+		self.failIf( r.isSame( CatmullClarkRefiner.shared( m, 2 ) ) )
+		self.assertEqual( CatmullClarkRefiner.shared( m, levels = 2 ).levels(), 2 )
+		self.failUnless( r.memoryUsage() > 0 )
+
+	def testInvalidCacheMemory( self ) :
+
+		# the cache is created on first use, so we need a fresh process
+		# to see the effect of the environment variable.
+		env = os.environ.copy()
+		env["IECORE_CATMULLCLARKREFINER_CACHE_MEMORY"] = "lots"
+		p = subprocess.Popen(
+			[ sys.executable, "-c", "import IECore; print IECore.CatmullClarkRefiner.shared( IECore.MeshPrimitive.createBox( IECore.Box3f( IECore.V3f( -1 ), IECore.V3f( 1 ) ) ) ).levels()" ],
+			env = env, stdout = subprocess.PIPE, stderr = subprocess.PIPE
+		)
+		out, err = p.communicate()
+
+		self.assertEqual( p.returncode, 0 )
+		self.assertEqual( out.strip(), "1" )
+		self.failUnless( "IECORE_CATMULLCLARKREFINER_CACHE_MEMORY" in err )
+
+if __name__ == "__main__":
+	unittest.main()
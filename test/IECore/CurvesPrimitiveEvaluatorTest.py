@@ -1221,6 +1221,31 @@ class CurvesPrimitiveEvaluatorTest( unittest.TestCase ) :
 						self.failUnless( abs( (p2 - p).length() ) < 0.05 )
 						self.assertEqual( c2, c )
 
+	def testClosestPointAccelerationStructures( self ) :
+
+		rand = IECore.Rand32()
+
+		p = IECore.V3fVectorData()
+		vertsPerCurve = IECore.IntVectorData()
+		for c in range( 0, 100 ) :
+			vertsPerCurve.append( 10 )
+			for i in range( 0, 10 ) :
+				p.append( rand.nextV3f() )
+
+		curves = IECore.CurvesPrimitive( vertsPerCurve, IECore.CubicBasisf.catmullRom(), False, p )
+
+		kdTreeEvaluator = IECore.CurvesPrimitiveEvaluator( curves, IECore.PrimitiveEvaluator.AccelerationStructure.BoundedKDTreeAcceleration )
+		bvhEvaluator = IECore.CurvesPrimitiveEvaluator( curves, IECore.PrimitiveEvaluator.AccelerationStructure.BVHAcceleration )
+		kdTreeResult = kdTreeEvaluator.createResult()
+		bvhResult = bvhEvaluator.createResult()
+
+		for i in range( 0, 1000 ) :
+
+			p = rand.nextV3f() * 2 - IECore.V3f( 0.5 )
+			self.failUnless( kdTreeEvaluator.closestPoint( p, kdTreeResult ) )
+			self.failUnless( bvhEvaluator.closestPoint( p, bvhResult ) )
+			self.assertAlmostEqual( ( kdTreeResult.point() - p ).length(), ( bvhResult.point() - p ).length(), 5 )
+
 	def testTopologyMethods( self ) :
 	
 		c = IECore.CurvesPrimitive( IECore.IntVectorData( [ 6, 6 ] ), IECore.CubicBasisf.linear(), False, IECore.V3fVectorData( [ IECore.V3f( 0 ) ] * 12 ) )
@@ -36,12 +36,15 @@
 #define IE_CORE_DATACONVERSIONTEST_H
 
 #include <cassert>
+#include <cmath>
 #include <limits.h>
 
 #include "boost/test/unit_test.hpp"
 #include "boost/test/floating_point_comparison.hpp"
 #include "boost/random.hpp"
 
+#include "OpenEXR/halfLimits.h"
+
 #include "IECore/HalfTypeTraits.h"
 #include "IECore/IECore.h"
 #include "IECore/ScaledDataConversion.h"
@@ -51,7 +54,13 @@
 #include "IECore/LinearToSRGBDataConversion.h"
 #include "IECore/Rec709ToLinearDataConversion.h"
 #include "IECore/LinearToRec709DataConversion.h"
+#include "IECore/PanalogToLinearDataConversion.h"
+#include "IECore/LinearToPanalogDataConversion.h"
+#include "IECore/AlexaLogcToLinearDataConversion.h"
+#include "IECore/LinearToAlexaLogcDataConversion.h"
 #include "IECore/CompoundDataConversion.h"
+#include "IECore/LookupDataConversion.h"
+#include "IECore/VectorTypedData.h"
 
 using namespace Imath;
 
@@ -131,6 +140,112 @@ struct DataConversionTest
 			BOOST_CHECK_CLOSE( double( f_fi(i) ), double( i ), 1.e-4 );
 		}
 	}
+
+	/// Verifies that values inside and outside the range tabulated by a LookupDataConversion
+	/// match the original conversion to within tolerance, allowing also for rounding to ToType.
+	template<typename Func>
+	void checkLookup( double tolerance )
+	{
+		typedef typename Func::FromType F;
+		typedef typename Func::ToType T;
+
+		Func f;
+		LookupDataConversion<Func> l( f, F( 0 ), F( 1 ) );
+
+		for ( int i = -100; i <= 1100; i++ )
+		{
+			F x = F( i / 1000.0f );
+			double expected = f( x );
+			double result = l( x );
+			if( expected != expected )
+			{
+				// NaNs are passed through to the original conversion
+				BOOST_CHECK( result != result );
+				continue;
+			}
+			BOOST_CHECK_SMALL( result - expected, tolerance + 2.0 * double( std::numeric_limits<T>::epsilon() ) * fabs( expected ) );
+		}
+	}
+
+	template<typename T>
+	void testSRGBLookup()
+	{
+		checkLookup< SRGBToLinearDataConversion< T, T > >( 1.e-5 );
+		checkLookup< LinearToSRGBDataConversion< T, T > >( 1.e-5 );
+	}
+
+	template<typename T>
+	void testRec709Lookup()
+	{
+		// the two segments of the Rec709 curve don't quite meet at the cutoff, so
+		// interpolating across it is less accurate than for the other conversions.
+		checkLookup< Rec709ToLinearDataConversion< T, T > >( 5.e-4 );
+		checkLookup< LinearToRec709DataConversion< T, T > >( 5.e-4 );
+	}
+
+	template<typename T>
+	void testPanalogLookup()
+	{
+		checkLookup< PanalogToLinearDataConversion< T, T > >( 1.e-5 );
+		checkLookup< LinearToPanalogDataConversion< T, T > >( 1.e-5 );
+	}
+
+	template<typename T>
+	void testAlexaLogcLookup()
+	{
+		// linear values reach 55 at the top of the range, where the curve is steep
+		// enough that the precision of the input dominates
+		checkLookup< AlexaLogcToLinearDataConversion< T, T > >( 1.e-4 );
+		checkLookup< LinearToAlexaLogcDataConversion< T, T > >( 1.e-5 );
+	}
+
+	void testDataLookup()
+	{
+		std::vector<FloatVectorDataPtr> channels;
+		// the first two channels are too small to be worth a table on their own, but together
+		// with the third they are converted with one
+		channels.push_back( new FloatVectorData( std::vector<float>( 10, 0.5f ) ) );
+		channels.push_back( new FloatVectorData( std::vector<float>( 1000, 0.25f ) ) );
+		channels.push_back( new FloatVectorData( std::vector<float>( 65536 ) ) );
+		std::vector<float> &large = channels[2]->writable();
+		for( size_t i = 0; i < large.size(); i++ )
+		{
+			large[i] = float( i ) / float( large.size() - 1 );
+		}
+		std::vector<FloatVectorDataPtr> original;
+		for( size_t i = 0; i < channels.size(); i++ )
+		{
+			original.push_back( channels[i]->copy() );
+		}
+
+		LinearToSRGBDataConversion<float, float> f;
+		convertDataWithLookup( f, channels.begin(), channels.end() );
+
+		for( size_t c = 0; c < channels.size(); c++ )
+		{
+			const std::vector<float> &converted = channels[c]->readable();
+			const std::vector<float> &values = original[c]->readable();
+			BOOST_CHECK_EQUAL( converted.size(), values.size() );
+			for( size_t i = 0; i < values.size(); i++ )
+			{
+				BOOST_CHECK_SMALL( converted[i] - f( values[i] ), 1.e-5f );
+			}
+		}
+	}
+
+	void testIntegralLookup()
+	{
+		typedef CineonToLinearDataConversion< unsigned short, float > Func;
+
+		Func f;
+		LookupDataConversion<Func> l( f, 0, 1023 );
+
+		/// Verify that the table is exact for integral types
+		for ( unsigned short i = 0; i < 1024; i++ )
+		{
+			BOOST_CHECK_EQUAL( l( i ), f( i ) );
+		}
+	}
 };
 
 struct DataConversionTestSuite : public boost::unit_test::test_suite
@@ -144,6 +259,7 @@ struct DataConversionTestSuite : public boost::unit_test::test_suite
 		testSRGBLinear( instance );
 		testRec709Linear( instance );
 		testSignedScaled( instance );
+		testLookup( instance );
 	}
 
 	void testCineonLinear( boost::shared_ptr<DataConversionTest> instance )
@@ -217,6 +333,24 @@ struct DataConversionTestSuite : public boost::unit_test::test_suite
 		add( BOOST_CLASS_TEST_CASE( fn, instance ) );
 	}
 
+	void testLookup( boost::shared_ptr<DataConversionTest> instance )
+	{
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testSRGBLookup<float>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testSRGBLookup<double>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testSRGBLookup<half>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testRec709Lookup<float>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testRec709Lookup<double>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testRec709Lookup<half>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testPanalogLookup<float>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testPanalogLookup<double>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testPanalogLookup<half>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testAlexaLogcLookup<float>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testAlexaLogcLookup<double>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testAlexaLogcLookup<half>, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testDataLookup, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &DataConversionTest::testIntegralLookup, instance ) );
+	}
+
 };
 
 }
@@ -0,0 +1,83 @@
+##########################################################################
+#
+#  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are
+#  met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#
+#     * Neither the name of Image Engine Design nor the names of any
+#       other contributors to this software may be used to endorse or
+#       promote products derived from this software without specific prior
+#       written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+#  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+##########################################################################
+
+import os
+import unittest
+
+from IECore import *
+
+class DeepImageConverterTest( unittest.TestCase ) :
+
+	__output = "test/IECore/data/exrFiles/deepConverted.exr"
+
+	def testOffsetDataWindow( self ) :
+
+		input = "test/IECore/data/exrFiles/deepOffsetDataWindow.exr"
+		DeepImageConverter()( inputFile = input, outputFile = DeepImageConverterTest.__output )
+
+		original = DeepImageReader.create( input )
+		converted = DeepImageReader.create( DeepImageConverterTest.__output )
+
+		# the data window is moved to the origin
+		self.assertEqual( original.dataWindow(), Box2i( V2i( 10, 5 ), V2i( 73, 68 ) ) )
+		self.assertEqual( converted.dataWindow(), Box2i( V2i( 0 ), V2i( 63 ) ) )
+		self.assertEqual( converted.channelNames(), original.channelNames() )
+
+		totalSamples = 0
+		for y in range( 0, 64 ) :
+			for x in range( 0, 64 ) :
+
+				a = original.readPixel( x + 10, y + 5 )
+				b = converted.readPixel( x, y )
+				if a is None :
+					self.assertEqual( b, None )
+					continue
+
+				self.assertEqual( b.numSamples(), a.numSamples() )
+				for i in range( 0, a.numSamples() ) :
+					self.assertEqual( b.getDepth( i ), a.getDepth( i ) )
+					for ca, cb in zip( a.channelData( i ), b.channelData( i ) ) :
+						self.assertAlmostEqual( ca, cb, 3 )
+
+				totalSamples += a.numSamples()
+
+		self.failUnless( totalSamples > 0 )
+
+	def tearDown( self ) :
+
+		if os.path.isfile( DeepImageConverterTest.__output ) :
+			os.remove( DeepImageConverterTest.__output )
+
+if __name__ == "__main__":
+	unittest.main()
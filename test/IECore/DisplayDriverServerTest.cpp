@@ -0,0 +1,242 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "boost/lexical_cast.hpp"
+
+#include "tbb/tbb.h"
+
+#include "IECore/DisplayDriverServer.h"
+#include "IECore/ClientDisplayDriver.h"
+#include "IECore/ImageDisplayDriver.h"
+#include "IECore/SimpleTypedData.h"
+#include "IECore/CompoundData.h"
+
+#include "DisplayDriverServerTest.h"
+
+using namespace boost;
+using namespace boost::unit_test;
+using namespace tbb;
+using namespace Imath;
+
+namespace IECore
+{
+
+struct DisplayDriverServerTest
+{
+
+	struct SendBuckets
+	{
+		public :
+
+			SendBuckets( int port, int imageSize, int bucketSize, size_t numChannels )
+				:	m_port( port ), m_imageSize( imageSize ), m_bucketSize( bucketSize ), m_numChannels( numChannels )
+			{
+			}
+
+			void operator()( const blocked_range<size_t> &r ) const
+			{
+				for( size_t i=r.begin(); i!=r.end(); ++i )
+				{
+					CompoundDataPtr parameters = new CompoundData;
+					parameters->writable()["displayHost"] = new StringData( "localhost" );
+					parameters->writable()["displayPort"] = new StringData( lexical_cast<std::string>( m_port ) );
+					parameters->writable()["remoteDisplayType"] = new StringData( "ImageDisplayDriver" );
+					parameters->writable()["handle"] = new StringData( handle( i ) );
+
+					std::vector<std::string> channelNames;
+					for( size_t c = 0; c < m_numChannels; ++c )
+					{
+						channelNames.push_back( "C" + lexical_cast<std::string>( c ) );
+					}
+
+					const Box2i window( V2i( 0 ), V2i( m_imageSize - 1 ) );
+					ClientDisplayDriverPtr driver = new ClientDisplayDriver( window, window, channelNames, parameters );
+
+					// every value identifies its client, bucket and channel, so
+					// we can tell if any get mixed up between connections.
+					std::vector<float> data( m_bucketSize * m_bucketSize * m_numChannels );
+					for( int y = 0; y < m_imageSize; y += m_bucketSize )
+					{
+						for( int x = 0; x < m_imageSize; x += m_bucketSize )
+						{
+							for( size_t j = 0; j < data.size(); ++j )
+							{
+								data[j] = value( i, x, y, j % m_numChannels );
+							}
+							const Box2i bucket( V2i( x, y ), V2i( x + m_bucketSize - 1, y + m_bucketSize - 1 ) );
+							driver->imageData( bucket, &data[0], data.size() );
+						}
+					}
+
+					driver->imageClose();
+				}
+			}
+
+			float value( size_t client, int x, int y, size_t channel ) const
+			{
+				const int bucketIndex = ( y / m_bucketSize ) * ( m_imageSize / m_bucketSize ) + x / m_bucketSize;
+				return ( client * 10000 + bucketIndex ) * m_numChannels + channel;
+			}
+
+			static std::string handle( size_t i )
+			{
+				return "DisplayDriverServerTest" + lexical_cast<std::string>( i );
+			}
+
+		private :
+
+			int m_port;
+			int m_imageSize;
+			int m_bucketSize;
+			size_t m_numChannels;
+
+	};
+
+	/// Checks that buckets sent from several concurrent clients to a
+	/// multithreaded server each arrive intact in the right image.
+	void testConcurrentClients()
+	{
+		const size_t numClients = 8;
+		const int imageSize = 128;
+		const int bucketSize = 16;
+		const size_t numChannels = 4;
+
+		DisplayDriverServerPtr server = new DisplayDriverServer( 0, 4 );
+
+		// make sure all the clients are sending at once
+		task_scheduler_init scheduler( numClients );
+
+		const SendBuckets sendBuckets( server->portNumber(), imageSize, bucketSize, numChannels );
+		parallel_for( blocked_range<size_t>( 0, numClients, 1 ), sendBuckets );
+
+		for( size_t i = 0; i < numClients; ++i )
+		{
+			ConstImagePrimitivePtr image = ImageDisplayDriver::removeStoredImage( SendBuckets::handle( i ) );
+			BOOST_REQUIRE( image );
+
+			for( size_t c = 0; c < numChannels; ++c )
+			{
+				const FloatVectorData *channel = image->getChannel<float>( "C" + lexical_cast<std::string>( c ) );
+				BOOST_REQUIRE( channel );
+				const std::vector<float> &values = channel->readable();
+				BOOST_REQUIRE_EQUAL( values.size(), size_t( imageSize * imageSize ) );
+
+				size_t numWrong = 0;
+				for( int y = 0; y < imageSize; ++y )
+				{
+					for( int x = 0; x < imageSize; ++x )
+					{
+						if( values[y * imageSize + x] != sendBuckets.value( i, x, y, c ) )
+						{
+							numWrong++;
+						}
+					}
+				}
+				BOOST_CHECK_EQUAL( numWrong, 0u );
+			}
+		}
+	}
+
+	/// Measures the rate at which a server receives buckets from several
+	/// concurrent clients, as its number of threads increases.
+	void testBucketThroughput()
+	{
+		const size_t numClients = 8;
+		const int imageSize = 512;
+		const int bucketSize = 16;
+		const size_t numChannels = 4;
+		const size_t numBuckets = numClients * ( imageSize / bucketSize ) * ( imageSize / bucketSize );
+
+		const int maxThreads = task_scheduler_init::default_num_threads();
+		for( int numThreads = 1; ; numThreads = std::min( numThreads * 2, maxThreads ) )
+		{
+			DisplayDriverServerPtr server = new DisplayDriverServer( 0, numThreads );
+
+			// make sure all the clients are sending at once
+			task_scheduler_init scheduler( numClients );
+
+			const SendBuckets sendBuckets( server->portNumber(), imageSize, bucketSize, numChannels );
+
+			tick_count t0 = tick_count::now();
+			parallel_for( blocked_range<size_t>( 0, numClients, 1 ), sendBuckets );
+			tick_count t1 = tick_count::now();
+
+			BOOST_TEST_MESSAGE( "DisplayDriverServer with " << numThreads << " threads : " << numBuckets / ( t1 - t0 ).seconds() << " buckets/s" );
+
+			for( size_t i = 0; i < numClients; ++i )
+			{
+				ConstImagePrimitivePtr image = ImageDisplayDriver::removeStoredImage( SendBuckets::handle( i ) );
+				BOOST_REQUIRE( image );
+				const FloatVectorData *channel = image->getChannel<float>( "C0" );
+				BOOST_REQUIRE( channel );
+				BOOST_CHECK_EQUAL( channel->readable().front(), sendBuckets.value( i, 0, 0, 0 ) );
+				BOOST_CHECK_EQUAL( channel->readable().back(), sendBuckets.value( i, imageSize - 1, imageSize - 1, 0 ) );
+			}
+
+			if( numThreads == maxThreads )
+			{
+				break;
+			}
+		}
+	}
+
+};
+
+struct DisplayDriverServerTestSuite : public boost::unit_test::test_suite
+{
+
+	DisplayDriverServerTestSuite() : boost::unit_test::test_suite( "DisplayDriverServerTestSuite" )
+	{
+		boost::shared_ptr<DisplayDriverServerTest> instance( new DisplayDriverServerTest() );
+
+		add( BOOST_CLASS_TEST_CASE( &DisplayDriverServerTest::testConcurrentClients, instance ) );
+
+		// the benchmark takes a while, so is only run on request
+		if( getenv( "IECORE_DISPLAYDRIVERSERVER_BENCHMARK" ) )
+		{
+			add( BOOST_CLASS_TEST_CASE( &DisplayDriverServerTest::testBucketThroughput, instance ) );
+		}
+	}
+};
+
+void addDisplayDriverServerTest( boost::unit_test::test_suite* test )
+{
+	test->add( new DisplayDriverServerTestSuite( ) );
+}
+
+} // namespace IECore
@@ -39,6 +39,9 @@ import gc
 import glob
 import sys
 import time
+import socket
+import struct
+import threading
 from IECore import *
 
 class TestImageDisplayDriver(unittest.TestCase):
@@ -134,7 +137,60 @@ class TestImageDisplayDriver(unittest.TestCase):
 		
 		i = dd.image()
 		self.assertEqual( i["Y"].data, y )
-		
+
+	def testBuckets( self ) :
+
+		img = Reader.create( "test/IECore/data/tiff/bluegreen_noise.400x300.tif" )()
+		dataWindow = img.dataWindow
+		idd = ImageDisplayDriver( img.displayWindow, dataWindow, [ "R", "G", "B" ], CompoundData() )
+
+		width = dataWindow.max.x - dataWindow.min.x + 1
+		bucketSize = 48
+		buckets = []
+		for y in range( dataWindow.min.y, dataWindow.max.y + 1, bucketSize ) :
+			for x in range( dataWindow.min.x, dataWindow.max.x + 1, bucketSize ) :
+				buckets.append( Box2i( V2i( x, y ), V2i( min( x + bucketSize - 1, dataWindow.max.x ), min( y + bucketSize - 1, dataWindow.max.y ) ) ) )
+
+		# send the buckets in reverse order, to make sure nothing depends on scanline order
+		for bucket in reversed( buckets ) :
+			buf = FloatVectorData()
+			for y in range( bucket.min.y, bucket.max.y + 1 ) :
+				for x in range( bucket.min.x, bucket.max.x + 1 ) :
+					i = ( y - dataWindow.min.y ) * width + ( x - dataWindow.min.x )
+					buf.append( img["R"].data[i] )
+					buf.append( img["G"].data[i] )
+					buf.append( img["B"].data[i] )
+			idd.imageData( bucket, buf )
+
+		idd.imageClose()
+		self.assertEqual( idd.image(), img )
+
+	def testInvalidBox( self ) :
+
+		window = Box2i( V2i( 0 ), V2i( 15 ) )
+		dd = ImageDisplayDriver( window, window, [ "Y" ], CompoundData() )
+
+		self.assertRaises( RuntimeError, dd.imageData, Box2i( V2i( 8 ), V2i( 16 ) ), FloatVectorData( [ 1 ] * 9 * 9 ) )
+		self.assertRaises( RuntimeError, dd.imageData, Box2i( V2i( 0 ), V2i( 3 ) ), FloatVectorData( [ 1 ] * 15 ) )
+
+	def testImageCopiesAreUnaffectedByLaterBuckets( self ) :
+
+		window = Box2i( V2i( 0 ), V2i( 15 ) )
+		dd = ImageDisplayDriver( window, window, [ "Y" ], CompoundData() )
+
+		dd.imageData( Box2i( V2i( 0 ), V2i( 7, 15 ) ), FloatVectorData( [ 1 ] * 8 * 16 ) )
+		i1 = dd.image()
+		h1 = i1.hash()
+
+		dd.imageData( Box2i( V2i( 8, 0 ), V2i( 15 ) ), FloatVectorData( [ 2 ] * 8 * 16 ) )
+		dd.imageClose()
+		i2 = dd.image()
+
+		self.assertEqual( i1["Y"].data, FloatVectorData( ( [ 1 ] * 8 + [ 0 ] * 8 ) * 16 ) )
+		self.assertEqual( i1.hash(), h1 )
+		self.assertEqual( i2["Y"].data, FloatVectorData( ( [ 1 ] * 8 + [ 2 ] * 8 ) * 16 ) )
+		self.assertNotEqual( i2.hash(), h1 )
+
 class TestClientServerDisplayDriver(unittest.TestCase):
 
 	def setUp( self ):
@@ -191,6 +247,54 @@ class TestClientServerDisplayDriver(unittest.TestCase):
 		img.blindData().clear()
 		self.assertEqual( newImg, img )
 
+	def testBucketEncodings( self ) :
+
+		img = Reader.create( "test/IECore/data/tiff/bluegreen_noise.400x300.tif" )()
+		red = img['R'].data
+		green = img['G'].data
+		blue = img['B'].data
+		width = img.dataWindow.max.x - img.dataWindow.min.x + 1
+
+		for encoding in ( "float", "half", "compressedFloat", "compressedHalf" ) :
+
+			params = CompoundData()
+			params['displayHost'] = StringData('localhost')
+			params['displayPort'] = StringData( '1559' )
+			params["remoteDisplayType"] = StringData( "ImageDisplayDriver" )
+			params["handle"] = StringData( "myHandle" )
+			params["bucketEncoding"] = StringData( encoding )
+			idd = ClientDisplayDriver( img.displayWindow, img.dataWindow, list( img.channelNames() ), params )
+
+			buf = FloatVectorData( width * 3 )
+			for i in xrange( 0, img.dataWindow.max.y - img.dataWindow.min.y + 1 ):
+				self.__prepareBuf( buf, width, i*width, red, green, blue )
+				idd.imageData( Box2i( V2i( img.dataWindow.min.x, i + img.dataWindow.min.y ), V2i( img.dataWindow.max.x, i + img.dataWindow.min.y) ), buf )
+			idd.imageClose()
+
+			newImg = ImageDisplayDriver.removeStoredImage( "myHandle" )
+			newImg.blindData().clear()
+			img.blindData().clear()
+
+			if "half" in encoding.lower() :
+				# half precision is good to around 3 decimal places
+				for c in ( "R", "G", "B" ) :
+					for a, b in zip( newImg[c].data, img[c].data ) :
+						self.assertAlmostEqual( a, b, 3 )
+			else :
+				self.assertEqual( newImg, img )
+
+	def testInvalidBucketEncoding( self ) :
+
+		parameters = CompoundData( {
+			"displayHost" : "localhost",
+			"displayPort" : "1559",
+			"remoteDisplayType" : "ImageDisplayDriver",
+			"bucketEncoding" : "jpeg",
+		} )
+
+		dw = Box2i( V2i( 0 ), V2i( 255 ) )
+		self.assertRaises( RuntimeError, ClientDisplayDriver, dw, dw, [ "R", "G", "B" ], parameters )
+
 	def testWrongSocketException( self ) :
 	
 		parameters = CompoundData( {
@@ -255,6 +359,110 @@ class TestClientServerDisplayDriver(unittest.TestCase):
 		i = ImageDisplayDriver.removeStoredImage( "myHandle" )
 		self.assertEqual( i["Y"].data, y )
 
+	def testInvalidBucketsAreRejected( self ) :
+
+		window = Box2i( V2i( 0 ), V2i( 1023 ) )
+		parameters = CompoundData( {
+			"displayHost" : "localhost",
+			"displayPort" : "1559",
+			"remoteDisplayType" : "ImageDisplayDriver",
+			"handle" : "myHandle",
+			"bucketEncoding" : "compressedFloat",
+		} )
+
+		# a bucket outside the data window, and a bucket claiming far more
+		# data than was sent. the server must drop the connection rather
+		# than try to decode either.
+		for box in ( Box2i( V2i( 0 ), V2i( 1 << 20 ) ), window ) :
+
+			dd = ClientDisplayDriver( window, window, [ "Y" ], parameters )
+			dd.imageData( box, FloatVectorData( [ 1 ] * 16 ) )
+			self.assertRaises( Exception, dd.imageClose )
+			del dd
+
+			ImageDisplayDriver.removeStoredImage( "myHandle" )
+
+		# and it must still serve well behaved clients
+		dd = ClientDisplayDriver( window, window, [ "Y" ], parameters )
+		dd.imageData( Box2i( V2i( 0 ), V2i( 15 ) ), FloatVectorData( [ 1 ] * 16 * 16 ) )
+		dd.imageClose()
+
+		image = ImageDisplayDriver.removeStoredImage( "myHandle" )
+		self.assertEqual( image["Y"].data[0], 1 )
+		self.assertEqual( image["Y"].data[16], 0 )
+
+	def testFirstVersionServer( self ) :
+
+		# a server which only speaks the first version of the protocol,
+		# closing the connection on any header it doesn't understand.
+		listener = socket.socket( socket.AF_INET, socket.SOCK_STREAM )
+		listener.setsockopt( socket.SOL_SOCKET, socket.SO_REUSEADDR, 1 )
+		listener.bind( ( "localhost", 1561 ) )
+		listener.listen( 1 )
+
+		messages = []
+		def serve() :
+
+			connection = listener.accept()[0]
+
+			def receive( size ) :
+				data = ""
+				while len( data ) < size :
+					chunk = connection.recv( size - len( data ) )
+					if not chunk :
+						raise EOFError
+					data += chunk
+				return data
+
+			def send( messageType, data ) :
+				connection.sendall( struct.pack( "<BBBI", 0x82, 1, messageType, len( data ) ) + data )
+
+			try :
+				while True :
+					magic, version, messageType, size = struct.unpack( "<BBBI", receive( 7 ) )
+					if magic != 0x82 or version != 1 or messageType not in ( 1, 2, 3 ) :
+						break
+					receive( size )
+					messages.append( messageType )
+					if messageType == 1 :
+						# scanLineOrderOnly and acceptsRepeatedData
+						send( 1, "\x00" )
+						send( 1, "\x01" )
+					elif messageType == 3 :
+						send( 3, "" )
+						break
+			except EOFError :
+				pass
+
+			connection.close()
+
+		thread = threading.Thread( target = serve )
+		thread.start()
+
+		window = Box2i( V2i( 0 ), V2i( 15 ) )
+		dd = ClientDisplayDriver(
+			window, window,
+			[ "Y" ],
+			CompoundData( {
+				"displayHost" : "localhost",
+				"displayPort" : "1561",
+				"remoteDisplayType" : "ImageDisplayDriver",
+				"bucketEncoding" : "compressedHalf",
+			} )
+		)
+
+		self.assertEqual( dd.acceptsRepeatedData(), True )
+
+		dd.imageData( Box2i( V2i( 0 ), V2i( 15, 7 ) ), FloatVectorData( [ 1 ] * 16 * 8 ) )
+		dd.imageData( Box2i( V2i( 0, 8 ), V2i( 15 ) ), FloatVectorData( [ 1 ] * 16 * 8 ) )
+		dd.imageClose()
+
+		thread.join()
+		listener.close()
+
+		# the buckets must have been sent as imageData messages
+		self.assertEqual( messages, [ 1, 2, 2, 3 ] )
+
 	def tearDown( self ):
 		
 		self.server = None
@@ -113,6 +113,37 @@ class EXRDeepImageReaderTest(unittest.TestCase):
 		self.assertEqual( d.getDepth(7), 9.751317024230957 )
 		self.assertEqual( d.getDepth(8), 9.7521572113037109 )
 
+	def testReadScanline( self ) :
+
+		reader = DeepImageReader.create( "test/IECoreRI/data/exr/primitives.exr" )
+		dataWindow = reader.dataWindow()
+		numChannels = len( reader.channelNames() )
+
+		sampleCounts, depths, channelData = reader.readScanline( 285 )
+		self.assertEqual( len( sampleCounts ), dataWindow.size().x + 1 )
+		self.assertEqual( len( depths ), sum( sampleCounts ) )
+		self.assertEqual( len( channelData ), len( depths ) * numChannels )
+
+		offset = 0
+		for i, numSamples in enumerate( sampleCounts ) :
+
+			pixel = reader.readPixel( dataWindow.min.x + i, 285 )
+			if not numSamples :
+				self.failUnless( pixel is None )
+				continue
+
+			self.assertEqual( pixel.numSamples(), numSamples )
+			self.assertEqual( pixel.channelNames(), tuple( reader.channelNames() ) )
+
+			# scanline samples are in file order, whereas pixel samples are sorted by depth
+			scanlineSamples = [ ( depths[offset+s], ) + tuple( channelData[(offset+s)*numChannels:(offset+s+1)*numChannels] ) for s in range( 0, numSamples ) ]
+			pixelSamples = [ ( pixel.getDepth( s ), ) + tuple( pixel.channelData( s ) ) for s in range( 0, numSamples ) ]
+			self.assertEqual( sorted( scanlineSamples ), sorted( pixelSamples ) )
+
+			offset += numSamples
+
+		self.assertRaises( RuntimeError, reader.readScanline, dataWindow.max.y + 1 )
+
 if __name__ == "__main__":
 	unittest.main()
 
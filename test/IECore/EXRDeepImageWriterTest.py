@@ -129,6 +129,73 @@ class EXRDeepImageWriterTest(unittest.TestCase):
 		self.assertEqual( dict( zip( rp3.channelNames(), rp3[1] ) ), { "R" : 0.0625,  "G" : 0.25, "A" : 0.0625 } )
 		self.failUnless( reader.readPixel( 1, 0 ) is None )
 	
+	def testWriteScanline( self ) :
+
+		writer = EXRDeepImageWriter( EXRDeepImageWriterTest.__output )
+		writer.parameters()['channelNames'].setValue( StringVectorData( [ "R", "G", "A" ] ) )
+		writer.parameters()['halfPrecisionChannels'].setValue( StringVectorData( [ "R", "A" ] ) )
+		writer.parameters()['resolution'].setTypedValue( V2i( 3, 2 ) )
+
+		writer.writeScanline(
+			0,
+			UIntVectorData( [ 1, 0, 2 ] ),
+			FloatVectorData( [ 1, 2, 1 ] ),
+			FloatVectorData( [ 0.25, 0.25, 0.5, 0.0625, 0.25, 0.0625, 0.25, 0.125, 0.125 ] ),
+		)
+
+		self.assertRaises( Exception, writer.writeScanline, 1, UIntVectorData( [ 1, 0 ] ), FloatVectorData( [ 1 ] ), FloatVectorData( [ 0.25, 0.25, 0.5 ] ) )
+		self.assertRaises( Exception, writer.writeScanline, 1, UIntVectorData( [ 1, 0, 0 ] ), FloatVectorData( [ 1 ] ), FloatVectorData( [ 0.25, 0.25 ] ) )
+
+		writer.writeScanline( 1, UIntVectorData( [ 0, 1, 0 ] ), FloatVectorData( [ 3 ] ), FloatVectorData( [ 0.125, 0.0625, 0.25 ] ) )
+		self.assertRaises( Exception, writer.writeScanline, 0, UIntVectorData( [ 0, 0, 0 ] ), FloatVectorData(), FloatVectorData() )
+		del writer
+
+		reader = EXRDeepImageReader( EXRDeepImageWriterTest.__output )
+		self.assertEqual( reader.channelNames(), StringVectorData( [ "A", "G", "R" ] ) )
+
+		rp = reader.readPixel( 0, 0 )
+		self.assertEqual( rp.numSamples(), 1 )
+		self.assertEqual( rp.getDepth( 0 ), 1 )
+		self.assertEqual( dict( zip( rp.channelNames(), rp[0] ) ), { "R" : 0.25, "G" : 0.25, "A" : 0.5 } )
+
+		self.failUnless( reader.readPixel( 1, 0 ) is None )
+
+		rp = reader.readPixel( 2, 0 )
+		self.assertEqual( rp.numSamples(), 2 )
+		self.assertEqual( rp.getDepth( 0 ), 1 )
+		self.assertEqual( rp.getDepth( 1 ), 2 )
+		self.assertEqual( dict( zip( rp.channelNames(), rp[0] ) ), { "R" : 0.25, "G" : 0.125, "A" : 0.125 } )
+		self.assertEqual( dict( zip( rp.channelNames(), rp[1] ) ), { "R" : 0.0625, "G" : 0.25, "A" : 0.0625 } )
+
+		rp = reader.readPixel( 1, 1 )
+		self.assertEqual( rp.numSamples(), 1 )
+		self.assertEqual( rp.getDepth( 0 ), 3 )
+		self.assertEqual( dict( zip( rp.channelNames(), rp[0] ) ), { "R" : 0.125, "G" : 0.0625, "A" : 0.25 } )
+
+		self.failUnless( reader.readPixel( 0, 1 ) is None )
+		self.failUnless( reader.readPixel( 2, 1 ) is None )
+
+	def testCompositeSamplesAtEqualDepth( self ) :
+
+		writer = EXRDeepImageWriter( EXRDeepImageWriterTest.__output )
+		writer.parameters()['channelNames'].setValue( StringVectorData( [ "R", "G", "B", "A" ] ) )
+		writer.parameters()['halfPrecisionChannels'].setValue( StringVectorData() )
+		writer.parameters()['resolution'].setTypedValue( V2i( 1, 1 ) )
+
+		# samples at the same depth composite differently depending on their
+		# order, so the reader must order them just as DeepPixel does.
+		channelData = []
+		for i in range( 0, 5 ) :
+			channelData.extend( [ 0.1 * i, 0.05 * i, 0.5 - 0.1 * i, 0.5 ] )
+		writer.writeScanline( 0, UIntVectorData( [ 5 ] ), FloatVectorData( [ 1 ] * 5 ), FloatVectorData( channelData ) )
+		del writer
+
+		reader = EXRDeepImageReader( EXRDeepImageWriterTest.__output )
+		image = reader.read()
+		pixel = reader.readPixel( 0, 0 )
+		for name, value in zip( pixel.channelNames(), pixel.composite() ) :
+			self.assertEqual( image[name].data[0], value )
+
 	def tearDown( self ) :
 		
 		if os.path.isfile( EXRDeepImageWriterTest.__output ) :
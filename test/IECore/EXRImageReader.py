@@ -158,6 +158,18 @@ class TestEXRReader(unittest.TestCase):
 			cd = r.readChannel( c )
 			self.assertEqual( i[c].data, cd )
 
+	def testReadCroppedChannelsMatchIndividualChannels( self ) :
+
+		r = EXRImageReader( "test/IECore/data/exrFiles/manyChannels.exr" )
+		w = r.dataWindow()
+		r.parameters()["dataWindow"].setTypedValue( Box2i( w.min + V2i( 3, 2 ), w.max - V2i( 5, 1 ) ) )
+		i = r.read()
+
+		self.assert_( i.arePrimitiveVariablesValid() )
+		self.assertEqual( set( i.keys() ), set( r.channelNames() ) )
+		for c in i.keys() :
+			self.assertEqual( i[c].data, r.readChannel( c ) )
+
 	def testReadWithChangedDisplayWindow( self ) :
 
 		r = EXRImageReader( "test/IECore/data/exrFiles/uvMap.256x256.exr" )
@@ -324,6 +336,58 @@ class TestEXRReader(unittest.TestCase):
 		self.assertEqual( m.messages[1].level, Msg.Level.Warning )
 		self.assertEqual( m.messages[2].level, Msg.Level.Warning )
 
+	def testReadTiledRegions( self ) :
+
+		# a 100x80 image with 32x32 tiles, where R, G and B hold
+		# x, y and x*y respectively.
+		r = EXRImageReader( "test/IECore/data/exrFiles/tiled.100x80.exr" )
+		iWhole = r.read()
+		self.assert_( iWhole.arePrimitiveVariablesValid() )
+		self.assertEqual( iWhole["R"].data[99], 99 )
+		self.assertEqual( iWhole["G"].data[100*79], 79 )
+		self.assertEqual( iWhole["B"].data[100*79+99], 99 * 79 )
+
+		# repeated region reads reuse the open file
+		for window in [
+			Box2i( V2i( 10, 5 ), V2i( 70, 60 ) ),
+			Box2i( V2i( 33, 0 ), V2i( 33, 79 ) ),
+			Box2i( V2i( 64, 64 ), V2i( 99, 79 ) ),
+			Box2i( V2i( 0, 31 ), V2i( 98, 32 ) ),
+		] :
+			r.parameters()["dataWindow"].setTypedValue( window )
+			iCropped = r.read()
+			self.assertEqual( iCropped.dataWindow, window )
+			self.assert_( iCropped.arePrimitiveVariablesValid() )
+
+			width = window.size().x + 1
+			for c in [ "R", "G", "B" ] :
+				whole = iWhole[c].data
+				cropped = iCropped[c].data
+				for y in range( window.min.y, window.max.y + 1 ) :
+					i = ( y - window.min.y ) * width
+					self.assertEqual( cropped[i:i+width], whole[y*100+window.min.x:y*100+window.max.x+1] )
+
+	def testReadCroppedIncompleteImage( self ) :
+
+		with CapturingMessageHandler() as m :
+
+			r = EXRImageReader( "test/IECore/data/exrFiles/incomplete.exr" )
+			iWhole = r.read()
+
+			r.parameters()["dataWindow"].setTypedValue( Box2i( V2i( 10, 0 ), V2i( 109, 199 ) ) )
+			iCropped = r.read()
+
+		self.assertEqual( len( m.messages ), 6 )
+		self.assert_( iCropped.arePrimitiveVariablesValid() )
+
+		# every scanline decoded before the missing data must be kept,
+		# even though cropped reads decode many scanlines at a time.
+		for c in [ "R", "G", "B" ] :
+			whole = iWhole[c].data
+			cropped = iCropped[c].data
+			for y in range( 0, 200 ) :
+				self.assertEqual( cropped[y*100:(y+1)*100], whole[y*200+10:y*200+110] )
+
 	def testHeaderToBlindData( self ) :
 
 		dictHeader = {
@@ -101,6 +101,34 @@ class TestGradeColorTransformOp( unittest.TestCase ) :
 		imgNew = grade( input = rampImg )
 		self.assertEqual( rampImg, imgNew )
 
+	def testLargePrimitive( self ) :
+
+		# enough elements to be split into many batches
+		# and transformed concurrently.
+		n = 100000
+		p = PointsPrimitive( n )
+		p["R"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ float( i ) / n for i in range( 0, n ) ] ) )
+		p["G"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ 1.0 - float( i ) / n for i in range( 0, n ) ] ) )
+		p["B"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ 0.5 ] * n ) )
+		p["A"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ 0.5 + 0.5 * ( i % 2 ) for i in range( 0, n ) ] ) )
+
+		for gamma in ( 1, 2 ) :
+
+			grade = Grade()
+			grade['multiply'] = Color3f( 0.5, 2, 1 )
+			grade['offset'] = Color3f( 0.1, 0, 0.2 )
+			grade['gamma'] = Color3f( gamma, gamma, gamma )
+			grade['blackClamp'] = False
+			grade['whiteClamp'] = False
+
+			pp = grade( input = p )
+
+			for i in range( 0, n, 997 ) :
+				a = p["A"].data[i]
+				for c, m, o in ( ( "R", 0.5, 0.1 ), ( "G", 2, 0 ), ( "B", 1, 0.2 ) ) :
+					expected = ( ( p[c].data[i] / a ) * m + o ) ** ( 1.0 / gamma ) * a
+					self.assertAlmostEqual( pp[c].data[i], expected, 5 )
+
 	def tearDown( self ):
 		if os.path.exists( self.testImgName ):
 			os.remove( self.testImgName )
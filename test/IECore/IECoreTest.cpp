@@ -76,6 +76,9 @@
 #include "CompoundObjectTest.h"
 #include "ComputationCacheTest.h"
 #include "SceneCacheThreadingTest.h"
+#include "DisplayDriverServerTest.h"
+#include "ImageDisplayDriverTest.h"
+#include "BoundingVolumeHierarchyTest.h"
 
 using namespace boost::unit_test;
 using boost::test_tools::output_test_stream;
@@ -119,6 +122,9 @@ test_suite* init_unit_test_suite( int argc, char* argv[] )
 		addCompoundObjectTest(test);
 		addComputationCacheTest(test);
 		addSceneCacheThreadingTest(test);
+		addDisplayDriverServerTest(test);
+		addImageDisplayDriverTest(test);
+		addBoundingVolumeHierarchyTest(test);
 	}
 	catch (std::exception &ex)
 	{
@@ -100,6 +100,73 @@ class ImageCompositeOpTest( unittest.TestCase ) :
 
 		self.__test( ImageCompositeOp.Operation.Multiply, "test/IECore/data/expectedResults/imageCompositeOpMultiply.exr" )
 
+	def __image( self, dataWindow, displayWindow, channels ) :
+
+		image = ImagePrimitive( dataWindow, displayWindow )
+		for name, f in channels.items() :
+			data = FloatVectorData()
+			for y in range( dataWindow.min.y, dataWindow.max.y + 1 ) :
+				for x in range( dataWindow.min.x, dataWindow.max.x + 1 ) :
+					data.append( f( x, y ) )
+			image[name] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, data )
+
+		return image
+
+	def testKnownValues( self ) :
+
+		displayWindow = Box2i( V2i( 0 ), V2i( 99, 149 ) )
+		aDataWindow = Box2i( V2i( 10, 5 ), V2i( 79, 139 ) )
+		bDataWindow = Box2i( V2i( 0 ), V2i( 59, 99 ) )
+
+		aChannels = {
+			"R" : lambda x, y : ( ( x + y ) % 7 ) / 7.0,
+			"G" : lambda x, y : ( x % 3 ) / 3.0,
+			"A" : lambda x, y : ( x % 4 ) / 4.0,
+		}
+
+		bChannels = {
+			"R" : lambda x, y : ( ( x * y ) % 5 ) / 5.0,
+			"G" : lambda x, y : ( y % 9 ) / 9.0,
+			"A" : lambda x, y : ( y % 3 ) / 2.0,
+		}
+
+		def value( channels, dataWindow, name, x, y ) :
+			# pixels outside the data window are black, with zero alpha
+			if x < dataWindow.min.x or x > dataWindow.max.x or y < dataWindow.min.y or y > dataWindow.max.y :
+				return 0
+			return channels[name]( x, y )
+
+		for operation, expectedDataWindow, fn in [
+			( ImageCompositeOp.Operation.Over, Box2i( V2i( 0 ), V2i( 79, 139 ) ), lambda a, aAlpha, b, bAlpha : a + b * ( 1 - aAlpha ) ),
+			( ImageCompositeOp.Operation.Max, Box2i( V2i( 0 ), V2i( 79, 139 ) ), lambda a, aAlpha, b, bAlpha : max( a, b ) ),
+			( ImageCompositeOp.Operation.Min, Box2i( V2i( 10, 5 ), V2i( 59, 99 ) ), lambda a, aAlpha, b, bAlpha : min( a, b ) ),
+			( ImageCompositeOp.Operation.Multiply, Box2i( V2i( 10, 5 ), V2i( 59, 99 ) ), lambda a, aAlpha, b, bAlpha : a * b ),
+		] :
+
+			result = ImageCompositeOp()(
+				input = self.__image( bDataWindow, displayWindow, bChannels ),
+				imageA = self.__image( aDataWindow, displayWindow, aChannels ),
+				channels = StringVectorData( [ "R", "G" ] ),
+				operation = operation
+			)
+
+			self.assertEqual( result.dataWindow, expectedDataWindow )
+			self.assert_( result.arePrimitiveVariablesValid() )
+
+			for name in ( "R", "G" ) :
+				data = result[name].data
+				i = 0
+				for y in range( expectedDataWindow.min.y, expectedDataWindow.max.y + 1 ) :
+					for x in range( expectedDataWindow.min.x, expectedDataWindow.max.x + 1 ) :
+						expected = fn(
+							value( aChannels, aDataWindow, name, x, y ),
+							value( aChannels, aDataWindow, "A", x, y ),
+							value( bChannels, bDataWindow, name, x, y ),
+							value( bChannels, bDataWindow, "A", x, y ),
+						)
+						self.assertAlmostEqual( data[i], expected, 5 )
+						i += 1
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,200 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2015, Image Engine Design Inc. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are
+//  met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of Image Engine Design nor the names of any
+//       other contributors to this software may be used to endorse or
+//       promote products derived from this software without specific prior
+//       written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+//  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+//  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+//  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+//  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+//  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+//  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+//  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include <vector>
+#include <algorithm>
+
+#include "boost/lexical_cast.hpp"
+
+#include "tbb/tbb.h"
+
+#include "IECore/ImageDisplayDriver.h"
+#include "IECore/CompoundData.h"
+
+#include "ImageDisplayDriverTest.h"
+
+using namespace boost;
+using namespace boost::unit_test;
+using namespace tbb;
+using namespace Imath;
+
+namespace IECore
+{
+
+struct ImageDisplayDriverTest
+{
+
+	static const int g_imageSize = 256;
+	static const int g_bucketSize = 16;
+	static const int g_bucketsPerRow = g_imageSize / g_bucketSize;
+	static const size_t g_numChannels = 3;
+
+	static Box2i bucketBox( size_t i )
+	{
+		const V2i min( ( i % g_bucketsPerRow ) * g_bucketSize, ( i / g_bucketsPerRow ) * g_bucketSize );
+		return Box2i( min, min + V2i( g_bucketSize - 1 ) );
+	}
+
+	// Returns which buckets the image has received, and sets consistent to false
+	// if any bucket has been received only in part.
+	static std::vector<bool> receivedBuckets( const ImagePrimitive *image, bool &consistent )
+	{
+		consistent = true;
+		std::vector<bool> result( g_bucketsPerRow * g_bucketsPerRow, false );
+		for( size_t i = 0; i < result.size(); ++i )
+		{
+			const Box2i box = bucketBox( i );
+			size_t numReceived = 0;
+			for( size_t c = 0; c < g_numChannels; ++c )
+			{
+				const std::vector<float> &data = image->getChannel<float>( "C" + lexical_cast<std::string>( c ) )->readable();
+				for( int y = box.min.y; y <= box.max.y; ++y )
+				{
+					for( int x = box.min.x; x <= box.max.x; ++x )
+					{
+						numReceived += data[y * g_imageSize + x] == float( i + 1 );
+					}
+				}
+			}
+			result[i] = numReceived != 0;
+			consistent = consistent && ( numReceived == 0 || numReceived == g_bucketSize * g_bucketSize * g_numChannels );
+		}
+		return result;
+	}
+
+	struct Snapshot
+	{
+		ConstImagePrimitivePtr image;
+		size_t lastBucket;
+		std::vector<bool> receivedBuckets;
+		bool consistent;
+	};
+
+	typedef concurrent_vector<Snapshot> Snapshots;
+
+	// Sends buckets to the driver, periodically taking a copy of the image
+	// while other threads are still sending.
+	struct SendBuckets
+	{
+		public :
+
+			SendBuckets( ImageDisplayDriver *driver, Snapshots &snapshots )
+				:	m_driver( driver ), m_snapshots( snapshots )
+			{
+			}
+
+			void operator()( const blocked_range<size_t> &r ) const
+			{
+				std::vector<float> data( g_bucketSize * g_bucketSize * g_numChannels );
+				for( size_t i=r.begin(); i!=r.end(); ++i )
+				{
+					std::fill( data.begin(), data.end(), float( i + 1 ) );
+					m_driver->imageData( bucketBox( i ), &data[0], data.size() );
+
+					if( i % 4 == 0 )
+					{
+						Snapshot snapshot;
+						snapshot.image = m_driver->image();
+						snapshot.lastBucket = i;
+						snapshot.receivedBuckets = receivedBuckets( snapshot.image.get(), snapshot.consistent );
+						m_snapshots.push_back( snapshot );
+					}
+				}
+			}
+
+		private :
+
+			ImageDisplayDriver *m_driver;
+			Snapshots &m_snapshots;
+
+	};
+
+	void testImageWhileReceivingBuckets()
+	{
+		std::vector<std::string> channelNames;
+		for( size_t c = 0; c < g_numChannels; ++c )
+		{
+			channelNames.push_back( "C" + lexical_cast<std::string>( c ) );
+		}
+
+		const Box2i window( V2i( 0 ), V2i( g_imageSize - 1 ) );
+		ImageDisplayDriverPtr driver = new ImageDisplayDriver( window, window, channelNames, new CompoundData );
+
+		// make sure several threads are sending at once, even on a single core
+		task_scheduler_init scheduler( 8 );
+
+		Snapshots snapshots;
+		const size_t numBuckets = g_bucketsPerRow * g_bucketsPerRow;
+		parallel_for( blocked_range<size_t>( 0, numBuckets, 1 ), SendBuckets( driver.get(), snapshots ) );
+		driver->imageClose();
+
+		BOOST_CHECK( snapshots.size() );
+		for( Snapshots::const_iterator it = snapshots.begin(); it != snapshots.end(); ++it )
+		{
+			// each copy must hold whole buckets only, including the one sent just before it was made
+			BOOST_CHECK( it->consistent );
+			BOOST_CHECK( it->receivedBuckets[it->lastBucket] );
+
+			// and mustn't have been affected by the buckets that arrived after it was made
+			bool consistent = false;
+			BOOST_CHECK( receivedBuckets( it->image.get(), consistent ) == it->receivedBuckets );
+			BOOST_CHECK( consistent );
+		}
+
+		bool consistent = false;
+		std::vector<bool> received = receivedBuckets( driver->image().get(), consistent );
+		BOOST_CHECK( consistent );
+		BOOST_CHECK( std::find( received.begin(), received.end(), false ) == received.end() );
+	}
+
+};
+
+struct ImageDisplayDriverTestSuite : public boost::unit_test::test_suite
+{
+
+	ImageDisplayDriverTestSuite() : boost::unit_test::test_suite( "ImageDisplayDriverTestSuite" )
+	{
+		boost::shared_ptr<ImageDisplayDriverTest> instance( new ImageDisplayDriverTest() );
+
+		add( BOOST_CLASS_TEST_CASE( &ImageDisplayDriverTest::testImageWhileReceivingBuckets, instance ) );
+	}
+};
+
+void addImageDisplayDriverTest( boost::unit_test::test_suite* test )
+{
+	test->add( new ImageDisplayDriverTestSuite( ) );
+}
+
+} // namespace IECore
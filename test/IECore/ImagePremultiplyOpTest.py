@@ -60,6 +60,35 @@ class ImagePremultiplyOpTest( unittest.TestCase ) :
 		diff = diffOp( imageA = result, imageB = expectedResult ).value
 		self.failIf( diff )
 
+	def testRoundTrip( self ) :
+
+		# an offset data window, tall enough for the rows to be shared between threads
+		w = Box2i( V2i( -10, 20 ), V2i( 89, 219 ) )
+		img = ImagePrimitive( w, w )
+
+		n = 100 * 200
+		r = FloatVectorData( [ ( i % 11 ) / 10.0 for i in range( n ) ] )
+		a = FloatVectorData( [ ( i % 4 + 1 ) / 4.0 for i in range( n ) ] )
+		img["R"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, r )
+		img["A"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, a )
+
+		premultiplied = ImagePremultiplyOp()(
+			input = img,
+			channels = StringVectorData( [ "R" ] ),
+			alphaChannelName = "A"
+		)
+
+		unpremultiplied = ImageUnpremultiplyOp()(
+			input = premultiplied,
+			channels = StringVectorData( [ "R" ] ),
+			alphaChannelName = "A"
+		)
+
+		for i in range( n ) :
+			self.assertAlmostEqual( premultiplied["R"].data[i], r[i] * a[i], 5 )
+			self.assertAlmostEqual( unpremultiplied["R"].data[i], r[i], 5 )
+
+		self.assertEqual( unpremultiplied["A"].data, a )
 
 
 if __name__ == "__main__":
@@ -60,6 +60,21 @@ class ImageUnpremultiplyOpTest( unittest.TestCase ) :
 		diff = diffOp( imageA = result, imageB = expectedResult ).value
 		self.failIf( diff )
 
+	def testZeroAlpha( self ) :
+
+		w = Box2i( V2i( 0 ), V2i( 1, 0 ) )
+		img = ImagePrimitive( w, w )
+		img["R"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ 0.25, 0.25 ] ) )
+		img["A"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ 0.0, 0.5 ] ) )
+
+		result = ImageUnpremultiplyOp()(
+			input = img,
+			channels = StringVectorData( [ "R" ] ),
+			alphaChannelName = "A"
+		)
+
+		# pixels with no alpha are left alone
+		self.assertEqual( result["R"].data, FloatVectorData( [ 0.25, 0.5 ] ) )
 
 
 if __name__ == "__main__":
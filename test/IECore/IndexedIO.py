@@ -35,6 +35,7 @@
 
 """Unit test for IndexedIO binding"""
 import os
+import shutil
 import unittest
 import math
 import random
@@ -573,6 +574,136 @@ class TestFileIndexedIO(unittest.TestCase):
 		self.failIf(fv is gv)
 		self.assertEqual(fv, gv)
 
+	def testMemoryMapped( self ) :
+		"""Test FileIndexedIO read with MemoryMapped mode"""
+
+		f = FileIndexedIO("./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Write)
+		g = f.subdirectory("sub1", IndexedIO.MissingBehaviour.CreateIfMissing )
+
+		fv = FloatVectorData( [ n * math.sin( n ) for n in range( 0, 1000 ) ] )
+		iv = IntVectorData( range( 0, 1000 ) )
+		pv = V3fVectorData( [ V3f( n, n + 1, n + 2 ) for n in range( 0, 1000 ) ] )
+		sv = StringVectorData( [ "a", "bb", "ccc" ] )
+
+		g.write( "floats", fv )
+		g.write( "ints", iv )
+		g.write( "string", "hello" )
+		g.write( "strings", sv )
+		pv.save( g, "points" )
+		del f, g
+
+		self.assertRaises( RuntimeError, FileIndexedIO, "./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Write | IndexedIO.OpenMode.MemoryMapped )
+
+		f = FileIndexedIO("./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Read | IndexedIO.OpenMode.MemoryMapped )
+		self.assertTrue( f.openMode() & IndexedIO.OpenMode.MemoryMapped )
+
+		g = f.subdirectory( "sub1" )
+		self.assertEqual( g.read( "floats" ), fv )
+		self.assertEqual( g.read( "ints" ), iv )
+		self.assertEqual( g.read( "string" ).value, "hello" )
+		self.assertEqual( g.read( "strings" ), sv )
+		self.assertEqual( Object.load( g, "points" ), pv )
+
+	def testCompressed( self ) :
+		"""Test FileIndexedIO read/write with Compressed mode"""
+
+		iv = IntVectorData( [ n % 100 for n in range( 0, 10000 ) ] )
+		sv = StringVectorData( [ "abc" ] * 1000 )
+		pv = V3fVectorData( [ V3f( n % 10, 1, 2 ) for n in range( 0, 1000 ) ] )
+
+		fileSizes = []
+		for mode in ( IndexedIO.OpenMode.Write, IndexedIO.OpenMode.Write | IndexedIO.OpenMode.Compressed ) :
+
+			f = FileIndexedIO("./test/FileIndexedIO.fio", [], mode )
+			g = f.subdirectory("sub1", IndexedIO.MissingBehaviour.CreateIfMissing )
+			g.write( "ints", iv )
+			g.write( "strings", sv )
+			g.write( "string", "hello" )
+			g.write( "float", 1.5 )
+			pv.save( g, "points" )
+			del f, g
+
+			fileSizes.append( os.path.getsize( "./test/FileIndexedIO.fio" ) )
+
+			f = FileIndexedIO("./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Read )
+			g = f.subdirectory( "sub1" )
+			self.assertEqual( g.read( "ints" ), iv )
+			self.assertEqual( g.read( "strings" ), sv )
+			self.assertEqual( g.read( "string" ).value, "hello" )
+			self.assertEqual( g.read( "float" ).value, 1.5 )
+			self.assertEqual( Object.load( g, "points" ), pv )
+			self.assertEqual( g.entry( "ints" ).dataType(), IndexedIO.DataType.IntArray )
+			self.assertEqual( g.entry( "ints" ).arrayLength(), 10000 )
+
+		self.assertTrue( fileSizes[1] < fileSizes[0] )
+
+	def testPrefetchIndex( self ) :
+		"""Test FileIndexedIO.prefetchIndex"""
+
+		f = FileIndexedIO("./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Write)
+		for i in range( 0, 20 ) :
+			g = f.subdirectory( str( i ), IndexedIO.MissingBehaviour.CreateIfMissing )
+			for j in range( 0, 20 ) :
+				h = g.subdirectory( str( j ), IndexedIO.MissingBehaviour.CreateIfMissing )
+				h.write( "value", i * j )
+				h.commit()
+			g.commit()
+		# no effect on files opened for writing
+		f.prefetchIndex()
+		del f, g, h
+
+		for wait in ( True, False ) :
+
+			f = FileIndexedIO("./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Read )
+			f.prefetchIndex( wait )
+
+			self.assertEqual( len( f.entryIds() ), 20 )
+			for i in range( 0, 20 ) :
+				g = f.subdirectory( str( i ) )
+				self.assertEqual( len( g.entryIds() ), 20 )
+				for j in range( 0, 20 ) :
+					self.assertEqual( g.subdirectory( str( j ) ).read( "value" ).value, i * j )
+
+			del f, g
+
+	def testAppendToPreviousVersion( self ) :
+		"""Test appending subindexes to a file written by a previous version"""
+
+		def contents( f ) :
+			result = {}
+			for name in f.entryIds() :
+				if f.entry( name ).entryType() == IndexedIO.EntryType.Directory :
+					result[name] = contents( f.subdirectory( name ) )
+				else :
+					result[name] = f.read( name )
+			return result
+
+		# this file is version 5, and stores its locations in gzipped subindexes
+		shutil.copy( "test/IECore/data/sccFiles/animatedSpheres.scc", "./test/FileIndexedIO.fio" )
+		f = FileIndexedIO( "./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Read )
+		original = contents( f )
+		del f
+
+		f = FileIndexedIO( "./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Append )
+		g = f.subdirectory( "appended", IndexedIO.MissingBehaviour.CreateIfMissing )
+		for i in range( 0, 20 ) :
+			h = g.subdirectory( str( i ), IndexedIO.MissingBehaviour.CreateIfMissing )
+			h.write( "value", i )
+			h.commit()
+		g.commit()
+		del f, g, h
+
+		f = FileIndexedIO( "./test/FileIndexedIO.fio", [], IndexedIO.OpenMode.Read )
+		g = f.subdirectory( "appended" )
+		self.assertEqual( len( g.entryIds() ), 20 )
+		for i in range( 0, 20 ) :
+			self.assertEqual( g.subdirectory( str( i ) ).read( "value" ).value, i )
+		del g
+
+		appended = contents( f )
+		del appended["appended"]
+		self.assertEqual( appended, original )
+
 	def setUp( self ):
 
 		if os.path.isfile("./test/FileIndexedIO.fio") :
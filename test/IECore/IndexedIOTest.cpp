@@ -33,11 +33,20 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include "tbb/tbb.h"
+
+#include "boost/lexical_cast.hpp"
+#include "boost/filesystem/operations.hpp"
 
 #include "IECore/FileIndexedIO.h"
 
 #include "IndexedIOTest.h"
 
+using namespace tbb;
+
 
 namespace IECore
 {
@@ -388,9 +397,188 @@ unsigned short* IndexedIOTestDataTraits<unsigned short*>::value()
 	return v;
 }
 
+struct IndexedIOThreadingTest
+{
+
+	static const size_t numEntries = 64;
+	static const size_t entrySize = 256 * 1024;
+
+	// A reasonably compressible pattern, resembling point positions on a grid.
+	static float value( size_t entry, size_t index )
+	{
+		return (float)entry + (float)( index % 512 ) * 0.5f;
+	}
+
+	struct ReadEntries
+	{
+		public :
+
+			ReadEntries( ConstIndexedIOPtr io ) : m_io( io ), m_errors( 0 )
+			{
+			}
+
+			ReadEntries( ReadEntries &that, tbb::split ) : m_io( that.m_io ), m_errors( 0 )
+			{
+			}
+
+			void operator()( const blocked_range<size_t> &r ) const
+			{
+				std::vector<float> data( entrySize );
+				for( size_t i=r.begin(); i!=r.end(); ++i )
+				{
+					size_t entry = i % numEntries;
+					float *d = &data[0];
+					m_io->read( boost::lexical_cast<std::string>( entry ), d, entrySize );
+					// can't use boost unit test assertions from threads
+					if( data[0] != value( entry, 0 ) || data[entrySize-1] != value( entry, entrySize-1 ) )
+					{
+						m_errors++;
+					}
+				}
+			}
+
+			void join( const ReadEntries &that )
+			{
+				m_errors += that.m_errors;
+			}
+
+			size_t errors() const
+			{
+				return m_errors;
+			}
+
+		private :
+
+			ConstIndexedIOPtr m_io;
+			mutable size_t m_errors;
+
+	};
+
+	IndexedIOThreadingTest() : m_fileName( "./test/IECore/IndexedIOThreadingTest.fio" )
+	{
+	}
+
+	void writeFile( IndexedIO::OpenMode mode = IndexedIO::Write )
+	{
+		IndexedIOPtr io = new FileIndexedIO( m_fileName, IndexedIO::rootPath, mode );
+		std::vector<float> data( entrySize );
+		for( size_t i = 0; i < numEntries; ++i )
+		{
+			for( size_t j = 0; j < entrySize; ++j )
+			{
+				data[j] = value( i, j );
+			}
+			io->write( boost::lexical_cast<std::string>( i ), &data[0], entrySize );
+		}
+	}
+
+	double readFile( int numThreads, size_t numReads = numEntries * 20, IndexedIO::OpenMode mode = IndexedIO::Read )
+	{
+		task_scheduler_init scheduler( numThreads );
+
+		ConstIndexedIOPtr io = new FileIndexedIO( m_fileName, IndexedIO::rootPath, mode );
+		ReadEntries task( io );
+
+		tick_count t0 = tick_count::now();
+		parallel_reduce( blocked_range<size_t>( 0, numReads ), task );
+		double elapsed = ( tick_count::now() - t0 ).seconds();
+
+		BOOST_CHECK_EQUAL( task.errors(), 0u );
+		return elapsed;
+	}
+
+	void testConcurrentReads()
+	{
+		writeFile();
+		readFile( task_scheduler_init::default_num_threads(), numEntries * 2 );
+		boost::filesystem::remove( m_fileName );
+	}
+
+	void testReadThroughput()
+	{
+		writeFile();
+
+		int numThreads = task_scheduler_init::default_num_threads();
+		double bytesRead = numEntries * 20 * entrySize * sizeof( float ) / ( 1024.0 * 1024.0 );
+
+		// read once to warm the file system cache, so the timings measure the reading code only.
+		readFile( numThreads );
+
+		double serialTime = readFile( 1 );
+		double parallelTime = readFile( numThreads );
+
+		BOOST_TEST_MESSAGE( "FileIndexedIO read throughput with 1 thread : " << bytesRead / serialTime << " MB/s" );
+		BOOST_TEST_MESSAGE( "FileIndexedIO read throughput with " << numThreads << " threads : " << bytesRead / parallelTime << " MB/s" );
+
+		boost::filesystem::remove( m_fileName );
+	}
+
+	void testCompressedReads()
+	{
+		writeFile( IndexedIO::Write );
+		uintmax_t rawSize = boost::filesystem::file_size( m_fileName );
+
+		writeFile( IndexedIO::Write | IndexedIO::Compressed );
+		uintmax_t compressedSize = boost::filesystem::file_size( m_fileName );
+		readFile( task_scheduler_init::default_num_threads(), numEntries * 2 );
+
+		BOOST_CHECK( compressedSize < rawSize );
+
+		boost::filesystem::remove( m_fileName );
+	}
+
+	void testCompressedReadThroughput()
+	{
+		int numThreads = task_scheduler_init::default_num_threads();
+		double bytesRead = numEntries * 20 * entrySize * sizeof( float ) / ( 1024.0 * 1024.0 );
+
+		const char *names[] = { "raw", "compressed" };
+		IndexedIO::OpenMode writeModes[] = { IndexedIO::Write, IndexedIO::Write | IndexedIO::Compressed };
+
+		for( int i = 0; i < 2; ++i )
+		{
+			writeFile( writeModes[i] );
+			uintmax_t fileSize = boost::filesystem::file_size( m_fileName );
+
+			readFile( numThreads );
+			double serialTime = readFile( 1 );
+			double parallelTime = readFile( numThreads );
+
+			BOOST_TEST_MESSAGE( "FileIndexedIO " << names[i] << " file size : " << fileSize / ( 1024.0 * 1024.0 ) << " MB" );
+			BOOST_TEST_MESSAGE( "FileIndexedIO " << names[i] << " read throughput with 1 thread : " << bytesRead / serialTime << " MB/s" );
+			BOOST_TEST_MESSAGE( "FileIndexedIO " << names[i] << " read throughput with " << numThreads << " threads : " << bytesRead / parallelTime << " MB/s" );
+		}
+
+		boost::filesystem::remove( m_fileName );
+	}
+
+	std::string m_fileName;
+
+};
+
+struct IndexedIOThreadingTestSuite : public boost::unit_test::test_suite
+{
+
+	IndexedIOThreadingTestSuite() : boost::unit_test::test_suite( "IndexedIOThreadingTestSuite" )
+	{
+		boost::shared_ptr<IndexedIOThreadingTest> instance( new IndexedIOThreadingTest() );
+
+		add( BOOST_CLASS_TEST_CASE( &IndexedIOThreadingTest::testConcurrentReads, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &IndexedIOThreadingTest::testCompressedReads, instance ) );
+
+		// the benchmarks take a while, so are only run on request
+		if( getenv( "IECORE_INDEXEDIO_BENCHMARK" ) )
+		{
+			add( BOOST_CLASS_TEST_CASE( &IndexedIOThreadingTest::testReadThroughput, instance ) );
+			add( BOOST_CLASS_TEST_CASE( &IndexedIOThreadingTest::testCompressedReadThroughput, instance ) );
+		}
+	}
+};
+
 void addIndexedIOTest(boost::unit_test::test_suite* test)
 {
 	test->add( new IndexedIOTestSuite<FileIndexedIO>() );
+	test->add( new IndexedIOThreadingTestSuite() );
 }
 
 }
@@ -33,6 +33,9 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
 
 #include "tbb/tbb.h"
 
@@ -80,6 +83,117 @@ struct InternedStringTest
 		parallel_for( blocked_range<size_t>( 0, numIterations ), Constructor() );
 	}
 
+	struct Lookup
+	{
+		public :
+		
+			Lookup( const std::vector<std::string> &strings )
+				:	m_strings( strings )
+			{
+			}
+			
+			void operator()( const blocked_range<size_t> &r ) const
+			{
+				for( size_t i=r.begin(); i!=r.end(); ++i )
+				{
+					InternedString ss( m_strings[i % m_strings.size()] );
+				}
+			}
+
+		private :
+
+			const std::vector<std::string> &m_strings;
+			
+	};
+
+	struct CheckedLookup
+	{
+		public :
+
+			CheckedLookup( const std::vector<std::string> &strings, const std::vector<const char *> &expected, tbb::atomic<size_t> &numErrors )
+				:	m_strings( strings ), m_expected( expected ), m_numErrors( numErrors )
+			{
+			}
+
+			void operator()( const blocked_range<size_t> &r ) const
+			{
+				for( size_t i=r.begin(); i!=r.end(); ++i )
+				{
+					// look up a string which is already in the table
+					const size_t index = i % m_strings.size();
+					InternedString ss( m_strings[index] );
+					if( ss.c_str() != m_expected[index] || ss.string() != m_strings[index] )
+					{
+						++m_numErrors;
+					}
+
+					// and intern one which other threads may be adding at the same time
+					const std::string n = "concurrent" + lexical_cast<std::string>( i % 1000 );
+					if( InternedString( n ).string() != n )
+					{
+						++m_numErrors;
+					}
+				}
+			}
+
+		private :
+
+			const std::vector<std::string> &m_strings;
+			const std::vector<const char *> &m_expected;
+			tbb::atomic<size_t> &m_numErrors;
+
+	};
+
+	/// Checks that lookups made concurrently with insertions always
+	/// find the single value interned for each string.
+	void testConcurrentLookup()
+	{
+		std::vector<std::string> strings;
+		std::vector<const char *> expected;
+		for( size_t i = 0; i < 10000; ++i )
+		{
+			strings.push_back( "lookup" + lexical_cast<std::string>( i ) );
+			expected.push_back( InternedString( strings.back() ).c_str() );
+		}
+
+		tbb::atomic<size_t> numErrors;
+		numErrors = 0;
+		parallel_for( blocked_range<size_t>( 0, 1000000 ), CheckedLookup( strings, expected, numErrors ) );
+		BOOST_CHECK_EQUAL( numErrors, 0u );
+	}
+
+	/// Measures the throughput of constructing InternedStrings from values
+	/// that are already in the table, as the number of threads increases.
+	void testLookupScaling()
+	{
+		std::vector<std::string> strings;
+		for( size_t i = 0; i < 10000; ++i )
+		{
+			strings.push_back( "location" + lexical_cast<std::string>( i ) );
+			InternedString ss( strings.back() );
+		}
+
+		const size_t numLookups = 10000000;
+		const int maxThreads = task_scheduler_init::default_num_threads();
+		for( int numThreads = 1; ; numThreads = std::min( numThreads * 2, maxThreads ) )
+		{
+			task_scheduler_init scheduler( numThreads );
+
+			tick_count t0 = tick_count::now();
+			parallel_for( blocked_range<size_t>( 0, numLookups ), Lookup( strings ) );
+			tick_count t1 = tick_count::now();
+
+			BOOST_TEST_MESSAGE( "InternedString lookups with " << numThreads << " threads : " << numLookups / ( t1 - t0 ).seconds() << " lookups/s" );
+
+			if( numThreads == maxThreads )
+			{
+				break;
+			}
+		}
+
+		BOOST_CHECK( InternedString( strings[0] ) == InternedString( "location0" ) );
+	}
+
 	void testRangeConstruction()
 	{
 
@@ -107,6 +221,13 @@ struct InternedStringTestSuite : public boost::unit_test::test_suite
 
 		add( BOOST_CLASS_TEST_CASE( &InternedStringTest::testConcurrentConstruction, instance ) );
 		add( BOOST_CLASS_TEST_CASE( &InternedStringTest::testRangeConstruction, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &InternedStringTest::testConcurrentLookup, instance ) );
+
+		// the benchmark takes a while, so is only run on request
+		if( getenv( "IECORE_INTERNEDSTRING_BENCHMARK" ) )
+		{
+			add( BOOST_CLASS_TEST_CASE( &InternedStringTest::testLookupScaling, instance ) );
+		}
 
 	}
 };
@@ -32,15 +32,81 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include <cstdlib>
+
+#include "tbb/tick_count.h"
+
 #include "KDTreeTest.h"
 
+using namespace Imath;
+using namespace tbb;
+
 namespace IECore
 {
 
+namespace
+{
+
+void testKDTreeBenchmark()
+{
+	const size_t numPoints = 2000000;
+	const size_t numQueries = 200000;
+
+	Rand32 r( 1 );
+	std::vector<V3f> points( numPoints );
+	for( size_t i = 0; i < numPoints; ++i )
+	{
+		points[i] = V3f( r.nextf(), r.nextf(), r.nextf() );
+	}
+
+	std::vector<V3f> queries( numQueries );
+	for( size_t i = 0; i < numQueries; ++i )
+	{
+		queries[i] = V3f( r.nextf(), r.nextf(), r.nextf() );
+	}
+
+	tick_count t0 = tick_count::now();
+	V3fTree tree( points.begin(), points.end() );
+	tick_count t1 = tick_count::now();
+
+	std::vector<V3fTree::Neighbour> neighbours;
+	for( size_t i = 0; i < numQueries; ++i )
+	{
+		tree.nearestNNeighbours( queries[i], 8, neighbours );
+	}
+	tick_count t2 = tick_count::now();
+
+	std::vector<std::vector<V3fTree::Neighbour> > batchNeighbours;
+	tree.nearestNNeighbours( queries.begin(), queries.end(), 8, batchNeighbours );
+	tick_count t3 = tick_count::now();
+
+	std::vector<std::vector<V3fTree::Iterator> > batchRadiusNeighbours;
+	tree.nearestNeighbours( queries.begin(), queries.end(), 0.01f, batchRadiusNeighbours );
+	tick_count t4 = tick_count::now();
+
+	BOOST_CHECK_EQUAL( batchNeighbours.size(), numQueries );
+	BOOST_CHECK_EQUAL( batchRadiusNeighbours.size(), numQueries );
+
+	BOOST_TEST_MESSAGE( "KDTree with " << numPoints << " points : build " << ( t1 - t0 ).seconds() << "s" );
+	BOOST_TEST_MESSAGE( "KDTree with " << numPoints << " points : " << numQueries / ( t2 - t1 ).seconds() << " 8 nearest neighbour queries/s" );
+	BOOST_TEST_MESSAGE( "KDTree with " << numPoints << " points : " << numQueries / ( t3 - t2 ).seconds() << " batched 8 nearest neighbour queries/s" );
+	BOOST_TEST_MESSAGE( "KDTree with " << numPoints << " points : " << numQueries / ( t4 - t3 ).seconds() << " batched radius queries/s" );
+}
+
+} // namespace
+
 void addKDTreeTest(boost::unit_test::test_suite* test)
 {
 	test->add( new KDTreeTestSuite<10>() );
 	test->add( new KDTreeTestSuite<1500>() );
+	// large enough for the tree to be built in parallel
+	test->add( new KDTreeTestSuite<20000>() );
+
+	// the benchmark takes a while, so is only run on request
+	if( getenv( "IECORE_KDTREE_BENCHMARK" ) )
+	{
+		test->add( BOOST_TEST_CASE( &testKDTreeBenchmark ) );
+	}
 }
 
 }
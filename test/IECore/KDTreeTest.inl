@@ -192,4 +192,35 @@ void KDTreeTest<T>::testNearestNNeighours()
 
 }
 
+template<typename T>
+void KDTreeTest<T>::testBatchQueries()
+{
+	// The batch queries should give exactly the same results as
+	// the equivalent individual queries.
+
+	typename T::BaseType radius = 0.05;
+	std::vector<IteratorVector> batchNeighbours;
+	m_tree->nearestNeighbours( m_points.begin(), m_points.end(), radius, batchNeighbours );
+	BOOST_CHECK_EQUAL( batchNeighbours.size(), m_points.size() );
+
+	std::vector<NeighbourVector> batchNNeighbours;
+	m_tree->nearestNNeighbours( m_points.begin(), m_points.end(), 4, batchNNeighbours );
+	BOOST_CHECK_EQUAL( batchNNeighbours.size(), m_points.size() );
+
+	IteratorVector nearNeighbours;
+	NeighbourVector nearNNeighbours;
+	for( size_t i=0; i<m_points.size(); i++ )
+	{
+		m_tree->nearestNeighbours( m_points[i], radius, nearNeighbours );
+		BOOST_CHECK( nearNeighbours == batchNeighbours[i] );
+
+		m_tree->nearestNNeighbours( m_points[i], 4, nearNNeighbours );
+		BOOST_CHECK_EQUAL( nearNNeighbours.size(), batchNNeighbours[i].size() );
+		for( size_t j=0; j<nearNNeighbours.size() && j<batchNNeighbours[i].size(); j++ )
+		{
+			BOOST_CHECK( nearNNeighbours[j].point == batchNNeighbours[i][j].point );
+		}
+	}
+}
+
 }
@@ -245,6 +245,44 @@ class LRUCacheTest( unittest.TestCase ) :
 		for i in range( 1, 8 ) :
 			self.failUnless( i in keys )
 	
+	def testRecentlyUsedItemsSurvive( self ) :
+
+		def getter( key ) :
+
+			return ( key * 2, 1 )
+
+		removed = []
+		def removalCallback( key, value ) :
+
+			removed.append( key )
+
+		c = IECore.LRUCache( getter, removalCallback, 4 )
+		for i in range( 1, 5 ) :
+			c.get( i )
+
+		# reuse the two oldest items, so they get a second chance
+		# when room is needed for new items.
+		c.get( 1 )
+		c.get( 2 )
+
+		c.get( 5 )
+		self.assertEqual( removed, [ 3 ] )
+		c.get( 6 )
+		self.assertEqual( removed, [ 3, 4 ] )
+
+		for i in ( 1, 2, 5, 6 ) :
+			self.failUnless( c.cached( i ) )
+		for i in ( 3, 4 ) :
+			self.failIf( c.cached( i ) )
+
+		# the second chance is used up, so without further use
+		# the reused items go in the order they were moved to
+		# the back of the queue - after 5, which was already
+		# queued when they were given their second chance.
+		c.get( 7 )
+		c.get( 8 )
+		self.assertEqual( removed, [ 3, 4, 5, 1 ] )
+
 	def testSet( self ) :
 	
 		def getter( key ) :
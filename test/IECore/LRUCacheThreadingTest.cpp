@@ -33,6 +33,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <algorithm>
 
 #include "tbb/tbb.h"
 
@@ -88,6 +89,65 @@ struct LRUCacheThreadingTest
 		
 		parallel_for( blocked_range<size_t>( 0, 10000 ), GetFromCache( cache ) );
 	}
+
+	struct GetHitsFromCache
+	{
+		public :
+		
+			GetHitsFromCache( LRUCache<int, IntDataPtr> &cache, size_t numValues )
+				:	m_cache( cache ), m_numValues( numValues )
+			{
+			}
+			
+			void operator()( const blocked_range<size_t> &r ) const
+			{
+				for( size_t i=r.begin(); i!=r.end(); ++i )
+				{
+					IntDataPtr k = m_cache.get( i % m_numValues );
+					assert( k->readable() == (int)( i % m_numValues ) );
+				}
+			}
+			
+		private :
+		
+			LRUCache<int, IntDataPtr> &m_cache;
+			size_t m_numValues;
+			
+	};
+
+	/// Measures the throughput of cache hits as the number of threads increases.
+	void testHitThroughput()
+	{
+		const size_t numValues = 1000;
+		const size_t numGets = 4000000;
+
+		LRUCache<int, IntDataPtr> cache( get, numValues * 10 );
+		for( size_t i = 0; i < numValues; ++i )
+		{
+			cache.get( i );
+		}
+		BOOST_CHECK_EQUAL( cache.currentCost(), numValues * 10 );
+
+		const int maxThreads = task_scheduler_init::default_num_threads();
+		for( int numThreads = 1; ; numThreads = std::min( numThreads * 2, maxThreads ) )
+		{
+			task_scheduler_init scheduler( numThreads );
+
+			tick_count t0 = tick_count::now();
+			parallel_for( blocked_range<size_t>( 0, numGets ), GetHitsFromCache( cache, numValues ) );
+			tick_count t1 = tick_count::now();
+
+			BOOST_TEST_MESSAGE( "LRUCache hits with " << numThreads << " threads : " << numGets / ( t1 - t0 ).seconds() << " gets/s" );
+
+			if( numThreads == maxThreads )
+			{
+				break;
+			}
+		}
+
+		// all the gets were hits, so nothing should have been removed.
+		BOOST_CHECK_EQUAL( cache.currentCost(), numValues * 10 );
+	}
 };
 
 
@@ -99,6 +159,7 @@ struct LRUCacheThreadingTestSuite : public boost::unit_test::test_suite
 		boost::shared_ptr<LRUCacheThreadingTest> instance( new LRUCacheThreadingTest() );
 
 		add( BOOST_CLASS_TEST_CASE( &LRUCacheThreadingTest::test, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &LRUCacheThreadingTest::testHitThroughput, instance ) );
 	}
 };
 
@@ -66,4 +66,39 @@ class LensDistortOpTest(unittest.TestCase):
 		img2 = r.read()		
 
 		self.assertEqual( img.displayWindow, img2.displayWindow )
+
+	def testCacheWarpMap( self ) :
+
+		o = CompoundObject()
+		o["lensModel"] = StringData( "StandardRadialLensModel" )
+		o["distortion"] = DoubleData( 0.2 )
+		o["anamorphicSqueeze"] = DoubleData( 1. )
+		o["curvatureX"] = DoubleData( 0.2 )
+		o["curvatureY"] = DoubleData( 0.5 )
+		o["quarticDistortion"] = DoubleData( .1 )
+
+		img = EXRImageReader( "test/IECore/data/exrFiles/uvMapWithDataWindow.100x100.exr" ).read()
+		img2 = img.copy()
+		img2["R"] = img2["G"]
+
+		op = LensDistortOp()
+		op["mode"] = LensModel.Undistort
+		op["lensModel"].setValue( o )
+		expected = op( input = img )
+		expected2 = op( input = img2 )
+
+		# the cached map should give the same results, even for
+		# a different image with the same windows.
+		op["cacheWarpMap"].setTypedValue( True )
+		self.assertEqual( op( input = img ), expected )
+		self.assertEqual( op( input = img2 ), expected2 )
+		self.assertEqual( op( input = img ), expected )
+
+		# changing the lens must invalidate the map
+		o["distortion"] = DoubleData( 0.1 )
+		op["lensModel"].setValue( o )
+		cached = op( input = img )
+		op["cacheWarpMap"].setTypedValue( False )
+		self.assertEqual( cached, op( input = img ) )
+		self.assertNotEqual( cached, expected )
 		
@@ -150,6 +150,22 @@ class TestMeshPrimitive( unittest.TestCase ) :
 		m["primVar"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Constant, IntData( 10 ) )
 		self.assertNotEqual( m.hash(), h )
 		self.assertEqual( m.topologyHash(), t )
+
+	def testHashLargeMesh( self ) :
+
+		# large enough for the data to be hashed in parallel
+		m = MeshPrimitive.createPlane( Box2f( V2f( 0 ), V2f( 1 ) ), V2i( 200 ) )
+		m["s"] = PrimitiveVariable( PrimitiveVariable.Interpolation.Vertex, FloatVectorData( [ 0 ] * m.variableSize( PrimitiveVariable.Interpolation.Vertex ) ) )
+		m["t"] = m["s"]
+		h = m.hash()
+		t = m.topologyHash()
+
+		self.assertEqual( m.hash(), h )
+		self.assertEqual( m.copy().hash(), h )
+
+		m["s"].data[0] = 1
+		self.assertNotEqual( m.hash(), h )
+		self.assertEqual( m.topologyHash(), t )
 	
 	def testBox( self ) :
 		
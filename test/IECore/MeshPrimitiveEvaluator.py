@@ -374,6 +374,130 @@ class TestMeshPrimitiveEvaluator( unittest.TestCase ) :
 					hits = mpe.intersectionPoints( origin, direction )
 					self.failIf( hits )
 
+	def testBatchedQueries( self ) :
+		""" Testing MeshPrimitiveEvaluator batched queries against individual ones"""
+
+		m = Reader.create( "test/IECore/data/cobFiles/pSphereShape1.cob" ).read()
+		mpe = PrimitiveEvaluator.create( m )
+		r = mpe.createResult()
+
+		random.seed( 2 )
+
+		points = V3fVectorData( [ 3 * V3f( random.uniform(-1, 1), random.uniform(-1, 1), random.uniform(-1, 1) ) for i in range( 0, 1000 ) ] )
+		triangleIndices, barycentricCoordinates, distances, resultPoints = mpe.closestPoints( points )
+
+		self.assertEqual( len( triangleIndices ), len( points ) )
+		for i, p in enumerate( points ) :
+
+			self.failUnless( mpe.closestPoint( p, r ) )
+			self.assertEqual( triangleIndices[i], r.triangleIndex() )
+			self.assertEqual( barycentricCoordinates[i], r.barycentricCoordinates() )
+			self.assertEqual( resultPoints[i], r.point() )
+			self.assertAlmostEqual( distances[i], ( p - r.point() ).length(), 5 )
+
+		# Rays from the origin all hit the sphere, and those pointing away from it from the outside all miss.
+		origins = V3fVectorData( [ V3f( 0 ) ] * len( points ) + list( points ) )
+		directions = V3fVectorData( list( points ) + [ p * 1000 for p in points ] )
+		for i, p in enumerate( points ) :
+			if p.length() < 1.5 :
+				origins[len(points)+i] = p.normalized() * 1.5
+
+		triangleIndices, barycentricCoordinates, distances, resultPoints = mpe.rayIntersections( origins, directions )
+
+		for i in range( 0, len( origins ) ) :
+
+			hit = mpe.intersectionPoint( origins[i], directions[i], r )
+			self.assertEqual( hit, i < len( points ) )
+			if not hit :
+				self.assertEqual( triangleIndices[i], -1 )
+				continue
+
+			self.assertEqual( triangleIndices[i], r.triangleIndex() )
+			self.assertEqual( barycentricCoordinates[i], r.barycentricCoordinates() )
+			self.assertEqual( resultPoints[i], r.point() )
+			self.assertAlmostEqual( distances[i], ( origins[i] - r.point() ).length(), 5 )
+
+		# maxDistance should prevent the hits.
+		triangleIndices = mpe.rayIntersections( origins, directions, 0.5 )[0]
+		self.assertEqual( triangleIndices, IntVectorData( [ -1 ] * len( origins ) ) )
+
+		self.assertRaises( Exception, mpe.rayIntersections, origins, V3fVectorData() )
+
+	def testAccelerationStructures( self ) :
+		""" Testing MeshPrimitiveEvaluator gives the same results with each acceleration structure"""
+
+		m = Reader.create( "test/IECore/data/cobFiles/pSphereShape1.cob" ).read()
+		kdTreeEvaluator = MeshPrimitiveEvaluator( m, PrimitiveEvaluator.AccelerationStructure.BoundedKDTreeAcceleration )
+		bvhEvaluator = MeshPrimitiveEvaluator( m, PrimitiveEvaluator.AccelerationStructure.BVHAcceleration )
+
+		random.seed( 3 )
+
+		points = V3fVectorData( [ 3 * V3f( random.uniform(-1, 1), random.uniform(-1, 1), random.uniform(-1, 1) ) for i in range( 0, 1000 ) ] )
+		kdTreeResult = kdTreeEvaluator.closestPoints( points )
+		bvhResult = bvhEvaluator.closestPoints( points )
+		for i in range( 0, len( points ) ) :
+			self.assertAlmostEqual( kdTreeResult[2][i], bvhResult[2][i], 5 )
+
+		origins = V3fVectorData( [ V3f( 0 ) ] * len( points ) )
+		kdTreeResult = kdTreeEvaluator.rayIntersections( origins, points )
+		bvhResult = bvhEvaluator.rayIntersections( origins, points )
+		for i in range( 0, len( points ) ) :
+			self.assertEqual( kdTreeResult[0][i] == -1, bvhResult[0][i] == -1 )
+			self.assertAlmostEqual( kdTreeResult[2][i], bvhResult[2][i], 5 )
+
+		kr = kdTreeEvaluator.createResult()
+		br = bvhEvaluator.createResult()
+		for p in points[:100] :
+			self.failUnless( kdTreeEvaluator.closestPoint( p, kr ) )
+			self.failUnless( bvhEvaluator.closestPoint( p, br ) )
+			self.failUnless( kr.point().equalWithAbsError( br.point(), 0.00001 ) )
+			self.assertEqual( len( kdTreeEvaluator.intersectionPoints( V3f( 0 ), p ) ), len( bvhEvaluator.intersectionPoints( V3f( 0 ), p ) ) )
+
+	def testUpdatePositions( self ) :
+		""" Testing MeshPrimitiveEvaluator.updatePositions"""
+
+		m = Reader.create( "test/IECore/data/cobFiles/pSphereShape1.cob" ).read()
+		deformed = m.copy()
+		deformed["P"] = PrimitiveVariable(
+			PrimitiveVariable.Interpolation.Vertex,
+			V3fVectorData( [ V3f( p.x * 2, p.y, p.z * 0.5 ) + V3f( 0.25 ) for p in m["P"].data ] )
+		)
+
+		random.seed( 5 )
+		points = V3fVectorData( [ 3 * V3f( random.uniform(-1, 1), random.uniform(-1, 1), random.uniform(-1, 1) ) for i in range( 0, 500 ) ] )
+		origins = V3fVectorData( [ V3f( 0.25 ) ] * len( points ) )
+
+		for accelerationStructure in ( PrimitiveEvaluator.AccelerationStructure.BoundedKDTreeAcceleration, PrimitiveEvaluator.AccelerationStructure.BVHAcceleration ) :
+
+			updated = MeshPrimitiveEvaluator( m, accelerationStructure )
+			# make sure the cached normals exist, so that they must be updated too
+			updated.signedDistance( V3f( 0 ) )
+			updated.volume()
+			self.failUnless( updated.updatePositions( deformed ) )
+
+			rebuilt = MeshPrimitiveEvaluator( deformed, accelerationStructure )
+
+			self.assertAlmostEqual( updated.volume(), rebuilt.volume(), 4 )
+			self.assertAlmostEqual( updated.surfaceArea(), rebuilt.surfaceArea(), 4 )
+
+			updatedResult = updated.closestPoints( points )
+			rebuiltResult = rebuilt.closestPoints( points )
+			for i in range( 0, len( points ) ) :
+				self.assertAlmostEqual( updatedResult[2][i], rebuiltResult[2][i], 5 )
+
+			updatedResult = updated.rayIntersections( origins, points )
+			rebuiltResult = rebuilt.rayIntersections( origins, points )
+			for i in range( 0, len( points ) ) :
+				self.assertEqual( updatedResult[0][i] == -1, rebuiltResult[0][i] == -1 )
+				self.assertAlmostEqual( updatedResult[2][i], rebuiltResult[2][i], 5 )
+
+			for p in points[:100] :
+				self.assertAlmostEqual( updated.signedDistance( p ), rebuilt.signedDistance( p ), 5 )
+
+			# different topology can't be updated, and leaves the evaluator untouched
+			self.failIf( updated.updatePositions( MeshPrimitive.createPlane( Box2f( V2f( -1 ), V2f( 1 ) ) ) ) )
+			self.assertAlmostEqual( updated.volume(), rebuilt.volume(), 4 )
+
 if __name__ == "__main__":
 	unittest.main()
 
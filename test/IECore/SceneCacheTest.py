@@ -35,6 +35,7 @@
 import gc
 import sys
 import math
+import time
 import unittest
 
 import IECore
@@ -823,6 +824,79 @@ class SceneCacheTest( unittest.TestCase ) :
 			self.assertAlmostEqual( r[1], 0.1 * i * math.pi * 0.5, 9 )
 			self.assertAlmostEqual( t[0], 5 + 0.5 * i, 9 )
 		
+	def testPrefetch( self ) :
+
+		s = IECore.SceneCache( "/tmp/test.scc", IECore.IndexedIO.OpenMode.Write )
+		for i in range( 0, 10 ) :
+			c = s.createChild( str( i ) )
+			c.writeTransform( IECore.M44dData( IECore.M44d.createTranslated( IECore.V3d( i, 0, 0 ) ) ), 0.0 )
+			c.writeTransform( IECore.M44dData( IECore.M44d.createTranslated( IECore.V3d( i, 1, 0 ) ) ), 1.0 )
+			c.writeObject( IECore.SpherePrimitive( i + 1 ), 0.0 )
+			c.writeObject( IECore.SpherePrimitive( i + 2 ), 1.0 )
+		# no effect when writing
+		s.prefetch( [ [ "0" ] ], [ 0.0 ] )
+		del s, c
+
+		s = IECore.SceneCache( "/tmp/test.scc", IECore.IndexedIO.OpenMode.Read )
+		# missing locations are ignored
+		s.prefetch( [ [ str( i ) ] for i in range( 0, 12 ) ], [ 0.0, 0.5, 1.0 ] )
+
+		for i in range( 0, 10 ) :
+			c = s.child( str( i ) )
+			self.assertEqual( c.readObject( 0.0 ), IECore.SpherePrimitive( i + 1 ) )
+			self.assertEqual( c.readObject( 1.0 ), IECore.SpherePrimitive( i + 2 ) )
+			self.assertEqual( c.readTransformAsMatrix( 0.0 ), IECore.M44d.createTranslated( IECore.V3d( i, 0, 0 ) ) )
+			self.assertEqual( c.readTransformAsMatrix( 1.0 ), IECore.M44d.createTranslated( IECore.V3d( i, 1, 0 ) ) )
+
+	def testPrefetchLoadsInBackground( self ) :
+
+		def sphere( i, t ) :
+			return IECore.SpherePrimitive( 1000 * ( t + 1 ) + i + 0.25 )
+
+		def transform( i, t ) :
+			return IECore.M44dData( IECore.M44d.createTranslated( IECore.V3d( i + 0.25, t + 1000, 0 ) ) )
+
+		s = IECore.SceneCache( "/tmp/test.scc", IECore.IndexedIO.OpenMode.Write )
+		for i in range( 0, 10 ) :
+			c = s.createChild( str( i ) )
+			for t in ( 0, 1 ) :
+				c.writeTransform( transform( i, t ), t )
+				c.writeObject( sphere( i, t ), t )
+		del s, c
+
+		# the prefetched samples end up in the object pool, which lets us
+		# see what has been loaded without reading it ourselves.
+		pool = IECore.ObjectPool.defaultObjectPool()
+		pool.clear()
+
+		s = IECore.SceneCache( "/tmp/test.scc", IECore.IndexedIO.OpenMode.Read )
+
+		# nothing to do without any times
+		s.prefetch( [ [ str( i ) ] for i in range( 0, 10 ) ], [] )
+
+		# five locations at a single time
+		s.prefetch( [ [ str( i ) ] for i in range( 0, 5 ) ], [ 0.0 ] )
+
+		expected = [ sphere( i, 0 ).hash() for i in range( 0, 5 ) ] + [ transform( i, 0 ).hash() for i in range( 0, 5 ) ]
+		timeout = time.time() + 10
+		while not all( pool.contains( h ) for h in expected ) :
+			self.failUnless( time.time() < timeout, "Prefetch did not load the requested samples" )
+			time.sleep( 0.01 )
+
+		# give any stray loading a chance to happen before checking
+		# that nothing else was loaded.
+		time.sleep( 0.1 )
+		for i in range( 0, 10 ) :
+			self.assertEqual( pool.contains( sphere( i, 1 ).hash() ), False )
+			self.assertEqual( pool.contains( transform( i, 1 ).hash() ), False )
+			if i >= 5 :
+				self.assertEqual( pool.contains( sphere( i, 0 ).hash() ), False )
+				self.assertEqual( pool.contains( transform( i, 0 ).hash() ), False )
+
+		# and the prefetched samples are the ones read
+		for i in range( 0, 5 ) :
+			self.assertEqual( s.child( str( i ) ).readObject( 0.0 ), sphere( i, 0 ) )
+
 	def testHashes( self ):
 
 		m = IECore.SceneCache( "test/IECore/data/sccFiles/animatedSpheres.scc", IECore.IndexedIO.OpenMode.Read )
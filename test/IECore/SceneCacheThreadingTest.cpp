@@ -32,12 +32,20 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include <cstdlib>
 #include <vector>
 #include <iostream>
 
 #include "tbb/tbb.h"
 
+#include "boost/lexical_cast.hpp"
+#include "boost/filesystem.hpp"
+
 #include "IECore/SharedSceneInterfaces.h"
+#include "IECore/SceneCache.h"
+#include "IECore/PointsPrimitive.h"
+#include "IECore/VectorTypedData.h"
+#include "IECore/SimpleTypedData.h"
 
 #include "SceneCacheThreadingTest.h"
 
@@ -123,6 +131,132 @@ struct SceneCacheThreadingTest
  		BOOST_CHECK( task.errors() == 100000 );
 	}
 
+	/// Writes an animated hierarchy using the given number of threads, so
+	/// the bounds are computed either serially or by the parallel background
+	/// task started when the root is flushed.
+	static void writeAnimatedHierarchy( const std::string &fileName, int numThreads )
+	{
+		task_scheduler_init scheduler( numThreads );
+
+		SceneCachePtr root = new SceneCache( fileName, IndexedIO::Write );
+		for ( size_t i = 0; i < 20; i++ )
+		{
+			SceneInterfacePtr parent = root->createChild( lexical_cast<std::string>( i ) );
+			for ( size_t t = 0; t < 3; t++ )
+			{
+				parent->writeTransform( new M44dData( Imath::M44d().setTranslation( Imath::V3d( i, t * 0.1, 0 ) ).rotate( Imath::V3d( 0, t * 0.3, i * 0.01 ) ) ), t );
+			}
+			for ( size_t j = 0; j < 200; j++ )
+			{
+				SceneInterfacePtr child = parent->createChild( lexical_cast<std::string>( j ) );
+				for ( size_t t = 0; t < 3; t++ )
+				{
+					child->writeTransform( new M44dData( Imath::M44d().setTranslation( Imath::V3d( 0, j * 0.37, t * 0.5 ) ) ), t );
+				}
+				for ( size_t t = 0; t < 2; t++ )
+				{
+					V3fVectorDataPtr p = new V3fVectorData;
+					for ( size_t k = 0; k < 10; k++ )
+					{
+						p->writable().push_back( Imath::V3f( k * 0.13f + t, j * 0.01f, ( i + k ) * 0.07f ) );
+					}
+					child->writeObject( new PointsPrimitive( p ), t * 1.5 );
+				}
+			}
+		}
+	}
+
+	/// The bounds computed in parallel must be identical to those of a serial flush.
+	void testParallelBoundsMatchSerial()
+	{
+		const std::string serialFileName = "./test/IECore/SceneCacheThreadingTestSerial.scc";
+		const std::string parallelFileName = "./test/IECore/SceneCacheThreadingTestParallel.scc";
+
+		writeAnimatedHierarchy( serialFileName, 1 );
+		writeAnimatedHierarchy( parallelFileName, 8 );
+
+		{
+			ConstSceneCachePtr serial = new SceneCache( serialFileName, IndexedIO::Read );
+			ConstSceneCachePtr parallel = new SceneCache( parallelFileName, IndexedIO::Read );
+
+			SceneInterface::NameList parentNames;
+			serial->childNames( parentNames );
+			BOOST_CHECK_EQUAL( parentNames.size(), 20u );
+			for ( double t = -0.5; t < 3.0; t += 0.25 )
+			{
+				BOOST_CHECK( serial->readBound( t ) == parallel->readBound( t ) );
+			}
+			for ( SceneInterface::NameList::const_iterator it = parentNames.begin(); it != parentNames.end(); ++it )
+			{
+				ConstSceneInterfacePtr serialParent = serial->child( *it );
+				ConstSceneInterfacePtr parallelParent = parallel->child( *it );
+				SceneInterface::NameList childNames;
+				serialParent->childNames( childNames );
+				for ( SceneInterface::NameList::const_iterator cit = childNames.begin(); cit != childNames.end(); ++cit )
+				{
+					ConstSceneInterfacePtr serialChild = serialParent->child( *cit );
+					ConstSceneInterfacePtr parallelChild = parallelParent->child( *cit );
+					for ( double t = -0.5; t < 3.0; t += 0.25 )
+					{
+						BOOST_CHECK( serialChild->readBound( t ) == parallelChild->readBound( t ) );
+					}
+				}
+				for ( double t = -0.5; t < 3.0; t += 0.25 )
+				{
+					BOOST_CHECK( serialParent->readBound( t ) == parallelParent->readBound( t ) );
+				}
+			}
+		}
+
+		boost::filesystem::remove( serialFileName );
+		boost::filesystem::remove( parallelFileName );
+	}
+
+	/// Measures the time taken to open a cache with a million locations and
+	/// traverse its hierarchy, which is dominated by loading the index and subindexes.
+	void testLargeHierarchyOpen()
+	{
+		const std::string fileName = "./test/IECore/SceneCacheThreadingTest.scc";
+		const size_t numParents = 1000;
+		const size_t numChildren = 1000;
+
+		{
+			SceneCachePtr root = new SceneCache( fileName, IndexedIO::Write );
+			for ( size_t i = 0; i < numParents; i++ )
+			{
+				SceneInterfacePtr parent = root->createChild( lexical_cast<std::string>( i ) );
+				for ( size_t j = 0; j < numChildren; j++ )
+				{
+					parent->createChild( lexical_cast<std::string>( j ) );
+				}
+			}
+		}
+
+		tbb::tick_count t0 = tbb::tick_count::now();
+
+		ConstSceneCachePtr root = new SceneCache( fileName, IndexedIO::Read );
+
+		tbb::tick_count t1 = tbb::tick_count::now();
+
+		size_t numLocations = 0;
+		SceneInterface::NameList parentNames;
+		root->childNames( parentNames );
+		for ( SceneInterface::NameList::const_iterator it = parentNames.begin(); it != parentNames.end(); ++it )
+		{
+			SceneInterface::NameList childNames;
+			root->child( *it )->childNames( childNames );
+			numLocations += childNames.size();
+		}
+
+		tbb::tick_count t2 = tbb::tick_count::now();
+
+		BOOST_CHECK_EQUAL( numLocations, numParents * numChildren );
+		BOOST_TEST_MESSAGE( "SceneCache open : " << ( t1 - t0 ).seconds() << "s" );
+		BOOST_TEST_MESSAGE( "SceneCache hierarchy traversal of " << numLocations << " locations : " << ( t2 - t1 ).seconds() << "s" );
+
+		boost::filesystem::remove( fileName );
+	}
+
 };
 
 struct SceneCacheThreadingTestSuite : public boost::unit_test::test_suite
@@ -134,6 +268,13 @@ struct SceneCacheThreadingTestSuite : public boost::unit_test::test_suite
 
 		add( BOOST_CLASS_TEST_CASE( &SceneCacheThreadingTest::testAttributeRead, instance ) );
 		add( BOOST_CLASS_TEST_CASE( &SceneCacheThreadingTest::testFakeAttributeRead, instance ) );
+		add( BOOST_CLASS_TEST_CASE( &SceneCacheThreadingTest::testParallelBoundsMatchSerial, instance ) );
+
+		// the benchmark takes a while, so is only run on request
+		if( getenv( "IECORE_SCENECACHE_BENCHMARK" ) )
+		{
+			add( BOOST_CLASS_TEST_CASE( &SceneCacheThreadingTest::testLargeHierarchyOpen, instance ) );
+		}
 	}
 };
 
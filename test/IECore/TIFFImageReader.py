@@ -406,6 +406,61 @@ class TestTIFFReader(unittest.TestCase):
 
 		self.failIf( res.value )
 		
+	def testReadRegions( self ) :
+
+		for f in [ "test/IECore/data/tiff/tilesWithLeftovers.tif", "test/IECore/data/tiff/uvMap.512x256.16bit.tif" ] :
+
+			r = TIFFImageReader( f )
+			r["rawChannels"].setTypedValue( True )
+			whole = r.read()
+			w = whole.dataWindow
+
+			# a region which straddles tile and strip boundaries
+			region = Box2i( w.min + V2i( 5, 3 ), w.max - V2i( 7, 11 ) )
+			r["dataWindow"].setTypedValue( region )
+			cropped = r.read()
+			self.assertEqual( cropped.dataWindow, region )
+			self.assert_( cropped.arePrimitiveVariablesValid() )
+
+			wholeWidth = w.size().x + 1
+			croppedWidth = region.size().x + 1
+			for c in r.channelNames() :
+				for y in range( region.min.y, region.max.y + 1 ) :
+					wholeStart = ( y - w.min.y ) * wholeWidth + region.min.x - w.min.x
+					croppedStart = ( y - region.min.y ) * croppedWidth
+					self.assertEqual(
+						list( cropped[c].data[croppedStart:croppedStart+croppedWidth] ),
+						list( whole[c].data[wholeStart:wholeStart+croppedWidth] )
+					)
+
+	def testReadBands( self ) :
+
+		r = TIFFImageReader( "test/IECore/data/tiff/tilesWithLeftovers.tif" )
+		whole = r.read()
+		w = whole.dataWindow
+
+		self.assertRaises( Exception, r.numBands, 0 )
+		self.assertEqual( r.numBands( w.size().y + 1 ), 1 )
+		self.assertEqual( r.numBands( 10 ), ( w.size().y + 10 ) / 10 )
+
+		numBands = r.numBands( 10 )
+		self.assertRaises( Exception, r.readBand, numBands, 10 )
+
+		for c in r.channelNames() :
+
+			data = []
+			for i in range( 0, numBands ) :
+				band = r.readBand( i, 10 )
+				self.assertEqual( band.dataWindow.min.x, w.min.x )
+				self.assertEqual( band.dataWindow.max.x, w.max.x )
+				self.failUnless( band.dataWindow.size().y < 10 )
+				data.extend( band[c].data )
+
+			self.assertEqual( data, list( whole[c].data ) )
+
+		# the dataWindow parameter should be untouched
+		self.assertEqual( r["dataWindow"].getTypedValue(), Box2i() )
+
 	def testReadWithIncorrectExtension( self ) :
 	
 		shutil.copyfile( "test/IECore/data/tiff/uvMap.512x256.8bit.tif", "test/IECore/data/tiff/uvMap.512x256.8bit.dpx" )